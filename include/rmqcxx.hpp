@@ -26,12 +26,39 @@ SOFTWARE.
 */
 #pragma once
 
+#include "rmqcxx/AsyncConnector.hpp"
 #include "rmqcxx/Channel.hpp"
+#include "rmqcxx/ChannelPool.hpp"
 #include "rmqcxx/Connection.hpp"
+#include "rmqcxx/ConsumerCancel.hpp"
+#include "rmqcxx/Deduplicator.hpp"
+#include "rmqcxx/DeliveryBuffers.hpp"
+#include "rmqcxx/EncodedTable.hpp"
+#include "rmqcxx/Endpoints.hpp"
 #include "rmqcxx/Envelope.hpp"
+#ifdef __linux__
+#include "rmqcxx/EventLoop.hpp"
+#endif
 #include "rmqcxx/Exchange.hpp"
 #include "rmqcxx/FieldValue.hpp"
+#include "rmqcxx/HeartbeatEngine.hpp"
+#include "rmqcxx/MemoryResource.hpp"
 #include "rmqcxx/Message.hpp"
+#include "rmqcxx/MethodEncoder.hpp"
 #include "rmqcxx/Queue.hpp"
+#include "rmqcxx/RecoveringConnection.hpp"
+#include "rmqcxx/ReleasePolicy.hpp"
+#include "rmqcxx/RetryScheduler.hpp"
+#ifdef __linux__
+#include "rmqcxx/ShardedRuntime.hpp"
+#endif
+#include "rmqcxx/SocketOptions.hpp"
+#include "rmqcxx/StaticTable.hpp"
+#include "rmqcxx/Subscriptions.hpp"
 #include "rmqcxx/Table.hpp"
 #include "rmqcxx/TableEntry.hpp"
+#include "rmqcxx/TableView.hpp"
+#include "rmqcxx/TimingWheel.hpp"
+#include "rmqcxx/Topology.hpp"
+#include "rmqcxx/TopologyBatch.hpp"
+#include "rmqcxx/Wire.hpp"
@@ -0,0 +1,787 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <amqp.h>
+#include <amqp_framing.h>
+
+#include "Connection.hpp"
+#include "Exceptions.hpp"
+#include "Wire.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Opens many connections in parallel
+ *
+ * The TCP connect and the AMQP handshake (protocol header, connection.start/tune/open) of every added broker address
+ * run concurrently over non-blocking sockets driven by a single poll loop, so opening N connections takes about as
+ * long as opening one. The sockets of the successful handshakes are handed over to Connection objects.
+ *
+ * Only plain TCP and the PLAIN SASL method are supported. Name resolution is done by getaddrinfo and blocks.
+ */
+class AsyncConnector final {
+public:
+
+  /**
+   * Constructor
+   *
+   * @param[in] vhost VHost the connections will operate on
+   * @param[in] username Username
+   * @param[in] password Password
+   * @param[in] maxChannels Maximum number of channels for a connection
+   * @param[in] maxFrameSize Maximum size of a single frame for a connection
+   * @param[in] heartbeat Number of seconds between heartbeats to ask from the broker
+   * @param[in] properties Connection properties, they override the default ones with the same key
+   *
+   * @throw Exception When a property can't be encoded
+   */
+  AsyncConnector(
+    std::string vhost, std::string username, std::string password, int maxChannels, int maxFrameSize, int heartbeat,
+    const ::amqp_table_t* properties = nullptr) :
+      vhost_(std::move(vhost)), response_(std::string(1, '\0') + username + '\0' + password), maxChannels_(maxChannels), maxFrameSize_(maxFrameSize), heartbeat_(heartbeat) {
+    encodeProperties(properties);
+  }
+
+  /**
+   * Destructor, closes the sockets that were not taken
+   *
+   * @note The broker sees the connections that were opened but not taken as closed without a connection.close
+   */
+  ~AsyncConnector() noexcept {
+    for (auto& attempt : attempts_)
+      shutdown(attempt);
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  AsyncConnector(const AsyncConnector&) = delete;
+
+  /**
+   * Move constructable
+   */
+  AsyncConnector(AsyncConnector&&) = default;
+
+  /**
+   * Can't be copy assigned
+   */
+  AsyncConnector& operator=(const AsyncConnector&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  AsyncConnector& operator=(AsyncConnector&&) = delete;
+
+  /**
+   * Adds a connection to open
+   *
+   * @param[in] address Address of the RMQ broker
+   * @param[in] port Port of the RMQ broker
+   *
+   * @return Index of the connection
+   */
+  std::size_t add(std::string address, int port) {
+    attempts_.emplace_back(std::move(address), port);
+    return attempts_.size() - 1;
+  }
+
+  /**
+   * Number of added connections
+   * @return Number of added connections
+   */
+  std::size_t size() const noexcept {
+    return attempts_.size();
+  }
+
+  /**
+   * Opens the added connections
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] timeout Maximum duration for all of the connections to complete the handshake, the ones that did not
+   * complete it fail
+   *
+   * @return Number of connections that are ready to be taken
+   *
+   * @throw Exception When polling the sockets fails
+   *
+   * @note Failures of single connections don't throw, they are reported by take
+   */
+  template <typename Duration>
+  std::size_t run(Duration timeout) {
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout);
+    for (auto& attempt : attempts_)
+      if (Step::Idle == attempt.step)
+        guarded(attempt, [this](Attempt& a) { start(a); });
+
+    std::vector<::pollfd> fds;
+    std::vector<Attempt*> polled;
+    for (;;) {
+      fds.clear();
+      polled.clear();
+      for (auto& attempt : attempts_) {
+        if (!active(attempt))
+          continue;
+        short events = POLLIN;
+        if (Step::Connecting == attempt.step || !attempt.out.empty())
+          events = Step::Connecting == attempt.step ? POLLOUT : POLLIN | POLLOUT;
+        fds.push_back(::pollfd{attempt.fd, events, 0});
+        polled.push_back(&attempt);
+      }
+      if (fds.empty())
+        break;
+
+      const auto now = Clock::now();
+      if (now >= deadline) {
+        for (auto attempt : polled)
+          guarded(*attempt, [this](Attempt& a) { fail(a, AMQP_STATUS_TIMEOUT, 0, "Timed out during the handshake"); });
+        break;
+      }
+      const auto& left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+      const int status = ::poll(fds.data(), fds.size(), left > INT_MAX ? INT_MAX : static_cast<int>(left));
+      if (status < 0) {
+        if (EINTR == errno)
+          continue;
+        throw Exception(std::string("Failed to poll the connecting sockets: ") + std::strerror(errno));
+      }
+      for (std::size_t i = 0; i < fds.size(); ++i) {
+        const short revents = fds[i].revents;
+        if (0 != revents)
+          guarded(*polled[i], [this, revents](Attempt& a) { service(a, revents); });
+      }
+    }
+
+    std::size_t ready = 0;
+    for (const auto& attempt : attempts_)
+      if (Step::Ready == attempt.step)
+        ++ready;
+    return ready;
+  }
+
+  /**
+   * Checks if a connection completed the handshake and can be taken
+   *
+   * @param[in] index Index returned by add
+   *
+   * @return True if the connection is ready
+   */
+  bool ready(std::size_t index) const {
+    return Step::Ready == attempts_.at(index).step;
+  }
+
+  /**
+   * Takes an opened connection
+   *
+   * @param[in] index Index returned by add
+   *
+   * @return Connection
+   *
+   * @throw ConnectException When opening the connection failed
+   * @throw Exception When the connection was not opened yet or was already taken
+   * @throw OperationException When the negotiated parameters can't be applied to the connection
+   * @throw SocketException When the socket object can't be allocated
+   */
+  Connection take(std::size_t index) {
+    auto& attempt = attempts_.at(index);
+    if (Step::Failed == attempt.step)
+      std::rethrow_exception(attempt.failure);
+    if (Step::Ready != attempt.step)
+      throw Exception(attempt.address + ':' + std::to_string(attempt.port) + ": Connection is not ready to be taken");
+    const int fd = attempt.fd;
+    attempt.fd = -1;
+    attempt.step = Step::Taken;
+    return Connection(fd, attempt.maxChannels, attempt.maxFrameSize, attempt.heartbeat);
+  }
+
+private:
+
+  /**
+   * Clock used for the timeout
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Largest frame accepted during the handshake
+   */
+  static constexpr std::size_t kMaxHandshakeFrame = 131072;
+
+  /**
+   * Progress of a connection
+   */
+  enum class Step {
+    Idle, ///< Not started yet
+    Connecting, ///< Waiting for the TCP connect to complete
+    Start, ///< Protocol header sent, waiting for connection.start
+    Tune, ///< connection.start-ok sent, waiting for connection.tune
+    OpenOk, ///< connection.tune-ok and connection.open sent, waiting for connection.open-ok
+    Ready, ///< Handshake completed
+    Failed, ///< Failed, the error is stored
+    Taken ///< Handed over to a Connection
+  };
+
+  /**
+   * State of a single connection
+   */
+  struct Attempt {
+    /**
+     * Constructor
+     *
+     * @param[in] address Address of the RMQ broker
+     * @param[in] port Port of the RMQ broker
+     */
+    Attempt(std::string address, int port) :
+      address(std::move(address)), port(port), fd(-1), step(Step::Idle), resolved(nullptr, ::freeaddrinfo), candidate(nullptr), error(0), written(0), maxChannels(0), maxFrameSize(0), heartbeat(0) {}
+
+    /**
+     * Address of the RMQ broker
+     */
+    std::string address;
+
+    /**
+     * Port of the RMQ broker
+     */
+    int port;
+
+    /**
+     * Socket, -1 if none
+     */
+    int fd;
+
+    /**
+     * Progress
+     */
+    Step step;
+
+    /**
+     * Resolved addresses
+     */
+    std::unique_ptr<::addrinfo, void(*)(::addrinfo*)> resolved;
+
+    /**
+     * Address that is being connected to
+     */
+    ::addrinfo* candidate;
+
+    /**
+     * Error of the last failed TCP connect
+     */
+    int error;
+
+    /**
+     * Data to send
+     */
+    WireWriter out;
+
+    /**
+     * Number of bytes of out that were sent
+     */
+    std::size_t written;
+
+    /**
+     * Received data that was not processed yet
+     */
+    std::vector<uint8_t> in;
+
+    /**
+     * Negotiated maximum number of channels
+     */
+    int maxChannels;
+
+    /**
+     * Negotiated maximum frame size
+     */
+    int maxFrameSize;
+
+    /**
+     * Negotiated heartbeat
+     */
+    int heartbeat;
+
+    /**
+     * Reason of the failure
+     */
+    std::exception_ptr failure;
+  };
+
+  /**
+   * Runs a step of a connection and marks the connection as failed if it throws
+   *
+   * @tparam Function Callable object that accepts Attempt&
+   *
+   * @param[in] attempt Connection
+   * @param[in] f Step to run
+   */
+  template <typename Function>
+  void guarded(Attempt& attempt, Function f) noexcept {
+    try {
+      f(attempt);
+    } catch(...) {
+      attempt.failure = std::current_exception();
+      attempt.step = Step::Failed;
+      shutdown(attempt);
+    }
+  }
+
+  /**
+   * Checks if the socket of a connection has to be polled
+   *
+   * @param[in] attempt Connection
+   *
+   * @return True if the connection is still in the handshake
+   */
+  static bool active(const Attempt& attempt) noexcept {
+    return Step::Connecting == attempt.step || Step::Start == attempt.step || Step::Tune == attempt.step || Step::OpenOk == attempt.step;
+  }
+
+  /**
+   * Closes the socket of a connection
+   *
+   * @param[in] attempt Connection
+   */
+  static void shutdown(Attempt& attempt) noexcept {
+    if (attempt.fd >= 0)
+      ::close(attempt.fd);
+    attempt.fd = -1;
+  }
+
+  /**
+   * Fails a connection
+   *
+   * @param[in] attempt Connection
+   * @param[in] status Status describing the failure
+   * @param[in] replyCode Reply code of the connection.close sent by the broker, 0 if none
+   * @param[in] reason Reason of the failure
+   *
+   * @throw ConnectException Always
+   */
+  [[noreturn]] static void fail(const Attempt& attempt, ::amqp_status_enum status, uint16_t replyCode, std::string reason) {
+    throw ConnectException(attempt.address, attempt.port, status, replyCode, std::move(reason));
+  }
+
+  /**
+   * Resolves the address of a connection and starts connecting
+   *
+   * @param[in] attempt Connection
+   *
+   * @throw ConnectException When the address can't be resolved or no resolved address can be connected to
+   */
+  void start(Attempt& attempt) {
+    ::addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    ::addrinfo* result = nullptr;
+    const int status = ::getaddrinfo(attempt.address.c_str(), std::to_string(attempt.port).c_str(), &hints, &result);
+    if (0 != status)
+      fail(attempt, AMQP_STATUS_HOSTNAME_RESOLUTION_FAILED, 0, std::string("Failed to resolve: ") + ::gai_strerror(status));
+    attempt.resolved.reset(result);
+    attempt.candidate = result;
+    dial(attempt);
+  }
+
+  /**
+   * Starts a non-blocking TCP connect to the first resolved address that accepts it
+   *
+   * @param[in] attempt Connection
+   *
+   * @throw ConnectException When none of the remaining addresses can be connected to
+   */
+  void dial(Attempt& attempt) {
+    for (; nullptr != attempt.candidate; attempt.candidate = attempt.candidate->ai_next) {
+      shutdown(attempt);
+      attempt.fd = ::socket(attempt.candidate->ai_family, attempt.candidate->ai_socktype, attempt.candidate->ai_protocol);
+      if (attempt.fd < 0) {
+        attempt.error = errno;
+        continue;
+      }
+      const int one = 1;
+      ::fcntl(attempt.fd, F_SETFD, FD_CLOEXEC);
+      ::fcntl(attempt.fd, F_SETFL, ::fcntl(attempt.fd, F_GETFL) | O_NONBLOCK); // rabbitmq-c expects non-blocking sockets
+      ::setsockopt(attempt.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      if (0 == ::connect(attempt.fd, attempt.candidate->ai_addr, attempt.candidate->ai_addrlen)) {
+        handshake(attempt);
+        return;
+      }
+      if (EINPROGRESS == errno) {
+        attempt.step = Step::Connecting;
+        return;
+      }
+      attempt.error = errno;
+    }
+    shutdown(attempt);
+    fail(attempt, AMQP_STATUS_SOCKET_ERROR, 0, std::string("Failed to connect: ") + std::strerror(attempt.error));
+  }
+
+  /**
+   * Handles the readiness of the socket of a connection
+   *
+   * @param[in] attempt Connection
+   * @param[in] revents Poll events
+   *
+   * @throw ConnectException When the connection fails
+   */
+  void service(Attempt& attempt, short revents) {
+    if (Step::Connecting == attempt.step) {
+      int error = 0;
+      ::socklen_t length = sizeof(error);
+      if (0 != ::getsockopt(attempt.fd, SOL_SOCKET, SO_ERROR, &error, &length))
+        error = errno;
+      if (0 == error) {
+        handshake(attempt);
+        return;
+      }
+      attempt.error = error;
+      attempt.candidate = attempt.candidate->ai_next;
+      dial(attempt);
+      return;
+    }
+    if (0 != (revents & POLLOUT))
+      flush(attempt);
+    if (0 != (revents & (POLLIN | POLLHUP | POLLERR)))
+      receive(attempt);
+  }
+
+  /**
+   * Sends the protocol header on a connected socket
+   *
+   * @param[in] attempt Connection
+   *
+   * @throw ConnectException When sending fails
+   */
+  void handshake(Attempt& attempt) {
+    attempt.resolved.reset();
+    attempt.candidate = nullptr;
+    attempt.step = Step::Start;
+    attempt.out.protocolHeader();
+    flush(attempt);
+  }
+
+  /**
+   * Sends as much of the pending data of a connection as the socket accepts
+   *
+   * @param[in] attempt Connection
+   *
+   * @throw ConnectException When sending fails
+   */
+  void flush(Attempt& attempt) {
+    while (attempt.written < attempt.out.size()) {
+      const auto sent = ::send(attempt.fd, attempt.out.data() + attempt.written, attempt.out.size() - attempt.written, kSendFlags);
+      if (sent < 0) {
+        if (EINTR == errno)
+          continue;
+        if (EAGAIN == errno || EWOULDBLOCK == errno)
+          return;
+        fail(attempt, AMQP_STATUS_SOCKET_ERROR, 0, std::string("Failed to send: ") + std::strerror(errno));
+      }
+      attempt.written += static_cast<std::size_t>(sent);
+    }
+    attempt.out.clear();
+    attempt.written = 0;
+  }
+
+  /**
+   * Receives data on a connection and processes the complete frames
+   *
+   * @param[in] attempt Connection
+   *
+   * @throw ConnectException When receiving fails, the broker closes the connection or sends unexpected data
+   */
+  void receive(Attempt& attempt) {
+    uint8_t chunk[4096];
+    for (;;) {
+      const auto received = ::recv(attempt.fd, chunk, sizeof(chunk), 0);
+      if (received > 0) {
+        attempt.in.insert(attempt.in.end(), chunk, chunk + received);
+        continue;
+      }
+      if (0 == received)
+        fail(attempt, AMQP_STATUS_CONNECTION_CLOSED, 0, "Connection closed by the broker during the handshake");
+      if (EINTR == errno)
+        continue;
+      if (EAGAIN == errno || EWOULDBLOCK == errno)
+        break;
+      fail(attempt, AMQP_STATUS_SOCKET_ERROR, 0, std::string("Failed to receive: ") + std::strerror(errno));
+    }
+
+    if (Step::Start == attempt.step && !attempt.in.empty() && 'A' == attempt.in.front())
+      fail(attempt, AMQP_STATUS_INCOMPATIBLE_AMQP_VERSION, 0, "Broker does not support AMQP 0-9-1");
+
+    std::size_t offset = 0;
+    try {
+      WireFrame frame;
+      while (std::size_t consumed = WireReader::frame(attempt.in.data() + offset, attempt.in.size() - offset, kMaxHandshakeFrame, frame)) {
+        offset += consumed;
+        if (AMQP_FRAME_HEARTBEAT == frame.type)
+          continue;
+        if (Step::Ready == attempt.step)
+          fail(attempt, AMQP_STATUS_BAD_AMQP_DATA, 0, "Unexpected frame after connection.open-ok");
+        process(attempt, frame);
+      }
+    } catch(const ConnectException&) {
+      throw;
+    } catch(const Exception& e) {
+      fail(attempt, AMQP_STATUS_BAD_AMQP_DATA, 0, e.what());
+    }
+    attempt.in.erase(attempt.in.begin(), attempt.in.begin() + offset);
+    if (Step::Ready == attempt.step && !attempt.in.empty())
+      fail(attempt, AMQP_STATUS_BAD_AMQP_DATA, 0, "Unexpected data after connection.open-ok");
+    if (!attempt.out.empty())
+      flush(attempt);
+  }
+
+  /**
+   * Processes a frame received during the handshake
+   *
+   * @param[in] attempt Connection
+   * @param[in] frame Frame
+   *
+   * @throw ConnectException When the frame is not the expected one or the broker closes the connection
+   * @throw Exception When the frame is malformed
+   */
+  void process(Attempt& attempt, const WireFrame& frame) {
+    if (AMQP_FRAME_METHOD != frame.type || 0 != frame.channel)
+      fail(attempt, AMQP_STATUS_BAD_AMQP_DATA, 0, "Unexpected frame of type " + std::to_string(frame.type) + " on channel " + std::to_string(frame.channel));
+    WireReader reader(frame);
+    const ::amqp_method_number_t method = reader.u32();
+    if (AMQP_CONNECTION_CLOSE_METHOD == method) {
+      const uint16_t replyCode = reader.u16();
+      fail(attempt, AMQP_STATUS_CONNECTION_CLOSED, replyCode, "Connection closed by the broker: " + reader.shortString());
+    }
+    switch (attempt.step) {
+      case Step::Start:
+        expect(attempt, method, AMQP_CONNECTION_START_METHOD);
+        started(attempt, reader);
+        break;
+      case Step::Tune:
+        expect(attempt, method, AMQP_CONNECTION_TUNE_METHOD);
+        tuned(attempt, reader);
+        break;
+      case Step::OpenOk:
+        expect(attempt, method, AMQP_CONNECTION_OPEN_OK_METHOD);
+        attempt.step = Step::Ready;
+        break;
+      default:
+        fail(attempt, AMQP_STATUS_UNEXPECTED_STATE, 0, "Unexpected method " + std::to_string(method));
+    }
+  }
+
+  /**
+   * Checks the received method
+   *
+   * @param[in] attempt Connection
+   * @param[in] method Received method
+   * @param[in] expected Expected method
+   *
+   * @throw ConnectException When the methods don't match
+   */
+  static void expect(const Attempt& attempt, ::amqp_method_number_t method, ::amqp_method_number_t expected) {
+    if (method != expected)
+      fail(attempt, AMQP_STATUS_WRONG_METHOD, 0, "Expected method " + std::to_string(expected) + ", received " + std::to_string(method));
+  }
+
+  /**
+   * Handles connection.start, answers with connection.start-ok
+   *
+   * @param[in] attempt Connection
+   * @param[in] reader Reader of the method arguments
+   *
+   * @throw ConnectException When the version or the SASL mechanism is not supported
+   * @throw Exception When the method is malformed
+   */
+  void started(Attempt& attempt, WireReader& reader) {
+    const uint8_t major = reader.u8();
+    const uint8_t minor = reader.u8();
+    if (AMQP_PROTOCOL_VERSION_MAJOR != major || AMQP_PROTOCOL_VERSION_MINOR != minor)
+      fail(attempt, AMQP_STATUS_INCOMPATIBLE_AMQP_VERSION, 0, "Unsupported protocol version " + std::to_string(major) + '.' + std::to_string(minor));
+    reader.skipTable();
+    const std::string& mechanisms = ' ' + reader.longString() + ' ';
+    if (std::string::npos == mechanisms.find(" PLAIN "))
+      fail(attempt, AMQP_STATUS_BROKER_UNSUPPORTED_SASL_METHOD, 0, "Broker does not support the PLAIN SASL method");
+
+    auto& out = attempt.out;
+    const auto frame = out.beginMethod(0, AMQP_CONNECTION_START_OK_METHOD);
+    out.bytes(properties_.data(), properties_.size());
+    out.shortString("PLAIN", 5);
+    out.longString(response_.data(), response_.size());
+    out.shortString("en_US", 5);
+    out.endFrame(frame);
+    attempt.step = Step::Tune;
+  }
+
+  /**
+   * Handles connection.tune, answers with connection.tune-ok and connection.open
+   *
+   * @param[in] attempt Connection
+   * @param[in] reader Reader of the method arguments
+   *
+   * @throw Exception When the method is malformed
+   */
+  void tuned(Attempt& attempt, WireReader& reader) {
+    const int serverChannels = reader.u16();
+    const uint32_t serverFrameSize = reader.u32();
+    const int serverHeartbeat = reader.u16();
+
+    // same negotiation as amqp_login
+    int channels = maxChannels_;
+    if (0 != serverChannels && (serverChannels < channels || 0 == channels))
+      channels = serverChannels;
+    else if (0 == serverChannels && 0 == channels)
+      channels = UINT16_MAX;
+    int frameSize = maxFrameSize_;
+    if (0 != serverFrameSize && serverFrameSize < static_cast<uint32_t>(frameSize))
+      frameSize = static_cast<int>(serverFrameSize);
+    int heartbeat = heartbeat_;
+    if (0 != serverHeartbeat && serverHeartbeat < heartbeat)
+      heartbeat = serverHeartbeat;
+    attempt.maxChannels = channels;
+    attempt.maxFrameSize = frameSize;
+    attempt.heartbeat = heartbeat;
+
+    auto& out = attempt.out;
+    auto frame = out.beginMethod(0, AMQP_CONNECTION_TUNE_OK_METHOD);
+    out.u16(static_cast<uint16_t>(channels));
+    out.u32(static_cast<uint32_t>(frameSize));
+    out.u16(static_cast<uint16_t>(heartbeat));
+    out.endFrame(frame);
+    frame = out.beginMethod(0, AMQP_CONNECTION_OPEN_METHOD);
+    out.shortString(vhost_.data(), vhost_.size());
+    out.shortString("", 0); // capabilities (reserved)
+    out.u8(0); // insist (reserved)
+    out.endFrame(frame);
+    attempt.step = Step::OpenOk;
+  }
+
+  /**
+   * Encodes the client properties sent in connection.start-ok
+   *
+   * @param[in] properties User supplied properties, nullptr if none
+   *
+   * @throw Exception When a property can't be encoded
+   */
+  void encodeProperties(const ::amqp_table_t* properties) {
+    auto bytes = [](const char* s) { return ::amqp_bytes_t{std::strlen(s), const_cast<char*>(s)}; };
+    auto has = [&](const char* key) {
+      for (int i = 0; nullptr != properties && i < properties->num_entries; ++i) {
+        const auto& k = properties->entries[i].key;
+        if (k.len == std::strlen(key) && 0 == std::memcmp(k.bytes, key, k.len))
+          return true;
+      }
+      return false;
+    };
+
+    ::amqp_table_entry_t capabilities[2];
+    capabilities[0].key = bytes("authentication_failure_close");
+    capabilities[1].key = bytes("consumer_cancel_notify");
+    for (auto& capability : capabilities) {
+      capability.value.kind = AMQP_FIELD_KIND_BOOLEAN;
+      capability.value.value.boolean = 1;
+    }
+
+    std::vector<::amqp_table_entry_t> entries;
+    for (int i = 0; nullptr != properties && i < properties->num_entries; ++i)
+      entries.push_back(properties->entries[i]);
+    if (!has("product")) {
+      ::amqp_table_entry_t entry;
+      entry.key = bytes("product");
+      entry.value.kind = AMQP_FIELD_KIND_UTF8;
+      entry.value.value.bytes = bytes("rabbitmq-cxx");
+      entries.push_back(entry);
+    }
+    if (!has("capabilities")) {
+      ::amqp_table_entry_t entry;
+      entry.key = bytes("capabilities");
+      entry.value.kind = AMQP_FIELD_KIND_TABLE;
+      entry.value.value.table = ::amqp_table_t{2, capabilities};
+      entries.push_back(entry);
+    }
+    properties_.table(::amqp_table_t{static_cast<int>(entries.size()), entries.data()});
+  }
+
+  /**
+   * Flags for send, broken connections are reported as errors instead of signals
+   */
+#ifdef MSG_NOSIGNAL
+  static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+  static constexpr int kSendFlags = 0;
+#endif
+
+  /**
+   * VHost
+   */
+  std::string vhost_;
+
+  /**
+   * PLAIN SASL response
+   */
+  std::string response_;
+
+  /**
+   * Requested maximum number of channels
+   */
+  int maxChannels_;
+
+  /**
+   * Requested maximum frame size
+   */
+  int maxFrameSize_;
+
+  /**
+   * Requested heartbeat
+   */
+  int heartbeat_;
+
+  /**
+   * Encoded client properties
+   */
+  WireWriter properties_;
+
+  /**
+   * Connections
+   */
+  std::vector<Attempt> attempts_;
+};
+
+} // namespace rmqcxx
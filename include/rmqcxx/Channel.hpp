@@ -28,7 +28,9 @@ SOFTWARE.
 #pragma once
 
 #include "Connection.hpp"
+#include "MethodEncoder.hpp"
 #include "Table.hpp"
+#include "Topology.hpp"
 
 namespace rmqcxx {
 
@@ -42,18 +44,31 @@ public:
    *
    * @param[in] connection Reference to a Connection object using which this channel will operate on
    * @param[in] channel Id of the channel
+   * @param[in] lazy If set channel.open is sent without waiting for the broker (a rejected open is reported by the
+   * first synchronous method on the channel) and the destructor queues channel.close to be sent in a batch (see
+   * Connection::deferClose), the replies are consumed by Connection::consume
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConnectionException When the channel identifier is still being closed without waiting
    * @throw LibraryException When there is a library exception
+   * @throw OperationException When channel.open can't be sent
    * @throw RPCException For general RPC exception
    */
-  Channel(Connection& connection, ::amqp_channel_t channel) :
+  Channel(Connection& connection, ::amqp_channel_t channel, bool lazy = false) :
     connection_(connection),
     channel_(channel),
     context_(std::string("Channel(") + std::to_string(channel) + "): "),
-    moved_(false) {
-    connection_.rpc(true, this->context_, ::amqp_channel_open, channel_);
+    moved_(false),
+    lazy_(lazy) {
+    if (lazy_) {
+      connection_.open(channel_);
+    } else {
+      connection_.reclaim(channel_);
+      connection_.rpc(true, this->context_, impl::noContext(), ::amqp_channel_open, channel_);
+    }
+    if (nullptr != connection_.topology())
+      connection_.topology()->channelOpened(channel_);
   }
 
   /**
@@ -62,6 +77,12 @@ public:
   ~Channel() noexcept {
       if (moved_)
         return;
+      if (nullptr != connection_.topology())
+        connection_.topology()->channelClosed(channel_);
+      if (lazy_) {
+        connection_.deferClose(channel_);
+        return;
+      }
       try {
         connection_.rpc(::amqp_channel_close, channel_, AMQP_REPLY_SUCCESS);
       }
@@ -78,7 +99,7 @@ public:
   /**
    * Move constructable
    */
-  Channel(Channel&& other) : connection_(other.connection_), channel_(other.channel_), context_(other.context_), moved_(false) {
+  Channel(Channel&& other) : connection_(other.connection_), channel_(other.channel_), context_(other.context_), moved_(false), lazy_(other.lazy_) {
     other.moved_ = true;
   }
 
@@ -92,6 +113,14 @@ public:
    */
   Channel& operator==(Channel&&) noexcept = delete;
 
+  /**
+   * Channel identifier
+   * @return Channel identifier
+   */
+  ::amqp_channel_t id() const noexcept {
+    return channel_;
+  }
+
   /**
    * Acknowledges messages
    *
@@ -104,8 +133,14 @@ public:
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
    * @throw LibraryException When there is a library exception
    * @throw RPCException For general RPC exception
+   * @throw SocketException When writing to the socket fails (native encoding)
    */
   int ack(uint64_t tag, bool multiple) {
+    if (connection_.nativeEncoding_) {
+      const auto channel = channel_;
+      connection_.sendEncoded([channel, tag, multiple] (WireWriter& out) { MethodEncoder::ack(out, channel, tag, multiple); });
+      return AMQP_STATUS_OK;
+    }
     return rpc(::amqp_basic_ack, tag, multiple);
   }
 
@@ -122,8 +157,14 @@ public:
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
    * @throw LibraryException When there is a library exception
    * @throw RPCException For general RPC exception
+   * @throw SocketException When writing to the socket fails (native encoding)
    */
   int nack(uint64_t tag, bool multiple, bool requeue) {
+    if (connection_.nativeEncoding_) {
+      const auto channel = channel_;
+      connection_.sendEncoded([channel, tag, multiple, requeue] (WireWriter& out) { MethodEncoder::nack(out, channel, tag, multiple, requeue); });
+      return AMQP_STATUS_OK;
+    }
     return rpc(::amqp_basic_nack, tag, multiple, requeue);
   }
 
@@ -145,7 +186,7 @@ public:
    */
   template <typename Function, typename... Args>
   auto rpc(const Function& f, Args&&... args) -> decltype(f(::amqp_connection_state_t(), ::amqp_channel_t(), std::forward<Args>(args)...)) {
-   return rpc(this->context_, f, std::forward<Args>(args)...);
+   return rpc(impl::noContext(), f, std::forward<Args>(args)...);
   }
 
   /**
@@ -162,6 +203,8 @@ public:
    */
   void qos(uint16_t prefetchCount, bool perChannel = false, uint32_t prefetchSize = 0) {
     rpc(::amqp_basic_qos, prefetchSize, prefetchCount, perChannel);
+    if (nullptr != connection_.topology())
+      connection_.topology()->qos(channel_, prefetchSize, prefetchCount, perChannel);
   }
 
   /**
@@ -192,6 +235,24 @@ public:
     rpc(::amqp_basic_recover, requeue);
   }
 
+  /**
+   * Cancels a consumer
+   *
+   * @param[in] consumerTag Tag of the consumer to cancel
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   *
+   * @note Messages that were already delivered to the consumer may still arrive before the cancellation completes
+   */
+  void cancel(const std::string& consumerTag) {
+    rpc(::amqp_basic_cancel, bytes(consumerTag));
+    if (nullptr != connection_.topology())
+      connection_.topology()->cancelled(channel_, consumerTag);
+  }
+
   /**
    * Publishes a message on this channel
    *
@@ -207,8 +268,23 @@ public:
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
    * @throw LibraryException When there is a library exception
    * @throw RPCException For general RPC exception
+   * @throw SocketException When writing to the socket fails (native encoding)
    */
   void publish(const std::string& exchange, const std::string& routingKey, bool mandatory, bool immediate, const std::string& body, const ::amqp_basic_properties_t& properties = amqp_basic_properties_t {0}) {
+    if (connection_.nativeEncoding_) {
+      const auto frameMax = static_cast<std::size_t>(::amqp_get_frame_max(static_cast<::amqp_connection_state_t>(connection_)));
+      const auto channel = channel_;
+      try {
+        connection_.sendEncoded([&] (WireWriter& out) {
+          MethodEncoder::publish(out, channel, bytes(exchange), bytes(routingKey), mandatory, immediate, properties, bytes(body), frameMax);
+        });
+      } catch(const SocketException&) {
+        throw;
+      } catch(const Exception& e) {
+        throw ChannelException(connection_, *this, this->context_ + "Failed to encode message for exchange: " + exchange + " with routingKey: " + routingKey + ": " + e.what());
+      }
+      return;
+    }
     switch(rpc(::amqp_basic_publish, bytes(exchange), bytes(routingKey),
       mandatory, immediate, &properties, bytes(body))) {
       case AMQP_STATUS_OK:
@@ -225,6 +301,22 @@ public:
     }
   }
 
+  /**
+   * Sends a method on this channel without waiting for a reply, for methods sent with the nowait flag set
+   *
+   * @param[in] id Method identifier (ie: AMQP_QUEUE_BIND_METHOD)
+   * @param[in] decoded Method structure matching the identifier
+   *
+   * @throw ChannelException When the method can't be sent
+   *
+   * @note The broker reports a failure by closing the channel, that is seen as ChannelCloseException by the next RPC
+   */
+  void send(::amqp_method_number_t id, void* decoded) {
+    const auto status = ::amqp_send_method(static_cast<::amqp_connection_state_t>(connection_), channel_, id, decoded);
+    if (AMQP_STATUS_OK != status)
+      throw ChannelException(connection_, *this, this->context_ + "Failed to send method " + ::amqp_method_name(id) + ": " + ::amqp_error_string2(status));
+  }
+
 private:
 
   /**
@@ -246,10 +338,33 @@ private:
    */
   template <typename Function, typename... Args>
   auto rpc(const std::string& context, const Function& f, Args&&... args) -> decltype(f(::amqp_connection_state_t(), ::amqp_channel_t(), std::forward<Args>(args)...)) {
-    defer g([this] () {
-      ::amqp_maybe_release_buffers_on_channel(static_cast<amqp_connection_state_t>(connection_), channel_);
+    auto g = makeScopeGuard([this] () {
+      connection_.recycle(channel_);
     });
-    return connection_.rpc(false, this->context_ + context, f, channel_, std::forward<Args>(args)...);
+    return connection_.rpc(false, this->context_, context, f, channel_, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Sends a method encoded by the native encoder without waiting for a reply, for methods sent with the nowait flag set
+   *
+   * @tparam Encode Callable object that accepts WireWriter& and ::amqp_channel_t
+   *
+   * @param[in] id Method identifier (ie: AMQP_QUEUE_DECLARE_METHOD)
+   * @param[in] encode Appends the method frame to the buffer
+   *
+   * @throw ChannelException When the method can't be encoded
+   * @throw SocketException When writing to the socket fails
+   */
+  template <typename Encode>
+  void sendEncoded(::amqp_method_number_t id, Encode encode) {
+    const auto channel = channel_;
+    try {
+      connection_.sendEncoded([&encode, channel] (WireWriter& out) { encode(out, channel); });
+    } catch(const SocketException&) {
+      throw;
+    } catch(const Exception& e) {
+      throw ChannelException(connection_, *this, this->context_ + "Failed to encode method " + ::amqp_method_name(id) + ": " + e.what());
+    }
   }
 
   /**
@@ -272,8 +387,15 @@ private:
    */
   bool moved_;
 
+  /**
+   * Flag that tells this object to open and close without waiting for the broker
+   */
+  bool lazy_;
+
+  friend class ChannelPool;
   friend class Exchange;
   friend class Queue;
+  friend class TopologyBatch;
 };
 
 } // namespace rmqcxx
@@ -0,0 +1,429 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <amqp.h>
+#include <amqp_framing.h>
+
+#include "Channel.hpp"
+#include "Connection.hpp"
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Pool of open channels on a connection
+ *
+ * Channel identifiers are allocated from a bitmap up to the channel_max negotiated with the broker, channels are opened
+ * once and leased out with RAII handles, so a short lived operation does not pay for channel.open/channel.close.
+ * Channels closed by the broker are acknowledged (channel.close-ok), their identifiers are recycled and replacements
+ * are opened when they are returned, outside of the next acquire.
+ *
+ * Every returned channel stays open as an idle channel, so the pool keeps as many channels open as were leased at the
+ * same time at its peak (at most channel_max). They are closed when the pool is destroyed.
+ *
+ * @note Not thread safe, like the connection it operates on
+ * @note The pool has to outlive its leases
+ */
+class ChannelPool final {
+public:
+
+  /**
+   * RAII handle of a leased channel, the channel is returned to the pool on destruction
+   */
+  class Lease final {
+  public:
+
+    /**
+     * Destructor, returns the channel to the pool
+     */
+    ~Lease() noexcept {
+      if (!channel_)
+        return;
+      try {
+        pool_->release(std::move(channel_), broken_);
+      } catch(...) {
+        // a replacement channel could not be opened, the next acquire retries
+      }
+    }
+
+    /**
+     * Can't be copy constructed
+     */
+    Lease(const Lease&) = delete;
+
+    /**
+     * Move constructable
+     */
+    Lease(Lease&& other) noexcept : pool_(other.pool_), channel_(std::move(other.channel_)), broken_(other.broken_) {}
+
+    /**
+     * Can't be copy assigned
+     */
+    Lease& operator=(const Lease&) = delete;
+
+    /**
+     * Can't be move assigned
+     */
+    Lease& operator=(Lease&&) = delete;
+
+    /**
+     * Leased channel
+     * @return Reference to the leased channel
+     */
+    Channel& operator*() const noexcept {
+      return *channel_;
+    }
+
+    /**
+     * Leased channel
+     * @return Pointer to the leased channel
+     */
+    Channel* operator->() const noexcept {
+      return channel_.get();
+    }
+
+    /**
+     * Marks the channel as closed by the broker (for example after a ChannelCloseException), it is replaced instead
+     * of being reused
+     */
+    void invalidate() noexcept {
+      broken_ = true;
+    }
+
+  private:
+
+    /**
+     * Constructor
+     *
+     * @param[in] pool Pool the channel belongs to
+     * @param[in] channel Leased channel
+     */
+    Lease(ChannelPool& pool, std::unique_ptr<Channel> channel) noexcept : pool_(&pool), channel_(std::move(channel)), broken_(false) {}
+
+    /**
+     * Pool the channel belongs to
+     */
+    ChannelPool* pool_;
+
+    /**
+     * Leased channel
+     */
+    std::unique_ptr<Channel> channel_;
+
+    /**
+     * Set if the channel was closed by the broker
+     */
+    bool broken_;
+
+    friend class ChannelPool;
+  };
+
+  /**
+   * Constructor
+   *
+   * @param[in] connection Connection the channels are opened on
+   * @param[in] warm Number of channels that are opened upfront, broken idle channels are replaced to keep at least
+   * this many idle channels (returned channels are kept idle regardless of it)
+   *
+   * @throw ChannelCloseException When a channel can't be opened
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw Exception When there are not enough channel identifiers
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  explicit ChannelPool(Connection& connection, std::size_t warm = 0) :
+    connection_(connection), max_(static_cast<::amqp_channel_t>(connection.channelMax())), warm_(warm), used_(1), hint_(0),
+    ids_((static_cast<std::size_t>(max_) + 64) / 64, 0), broken_(ids_.size(), 0) {
+    ids_[0] = 1; // channel 0 is the connection itself
+    const std::size_t tail = (static_cast<std::size_t>(max_) + 1) % 64;
+    if (0 != tail)
+      ids_.back() |= ~((uint64_t(1) << tail) - 1); // identifiers past channel_max are never handed out
+    idle_.reserve(warm_);
+    replenish();
+  }
+
+  /**
+   * Destructor, closes idle channels
+   */
+  ~ChannelPool() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  ChannelPool(const ChannelPool&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  ChannelPool(ChannelPool&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  ChannelPool& operator=(const ChannelPool&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  ChannelPool& operator=(ChannelPool&&) = delete;
+
+  /**
+   * Leases an open channel, an idle one if available, otherwise a channel is opened on a free identifier
+   *
+   * @return Lease of the channel
+   *
+   * @throw ChannelCloseException When a channel can't be opened
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw Exception When all channel identifiers are in use
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  Lease acquire() {
+    if (idle_.empty())
+      return Lease(*this, open());
+    auto channel = std::move(idle_.back());
+    idle_.pop_back();
+    return Lease(*this, std::move(channel));
+  }
+
+  /**
+   * Notifies the pool that the broker closed a channel (ChannelCloseException::channel from a consumer)
+   *
+   * An idle channel is replaced right away, a leased one when its lease ends.
+   *
+   * @param[in] channel Channel identifier
+   *
+   * @throw ChannelCloseException When the replacement channel can't be opened
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  void closed(::amqp_channel_t channel) {
+    if (0 == channel || channel > max_ || !test(ids_, channel))
+      return;
+    for (auto it = idle_.begin(); it != idle_.end(); ++it) {
+      if ((*it)->id() == channel) {
+        auto ch = std::move(*it);
+        idle_.erase(it);
+        discard(std::move(ch));
+        replenish();
+        return;
+      }
+    }
+    set(broken_, channel);
+  }
+
+  /**
+   * Number of idle (open, not leased) channels
+   * @return Number of idle channels
+   */
+  std::size_t idle() const noexcept {
+    return idle_.size();
+  }
+
+  /**
+   * Number of channel identifiers in use (idle and leased channels)
+   * @return Number of used identifiers
+   */
+  std::size_t size() const noexcept {
+    return used_ - 1;
+  }
+
+  /**
+   * Highest channel identifier the pool may use
+   * @return Channel max of the connection
+   */
+  ::amqp_channel_t capacity() const noexcept {
+    return max_;
+  }
+
+private:
+
+  /**
+   * Checks a bit of a bitmap
+   */
+  static bool test(const std::vector<uint64_t>& bitmap, ::amqp_channel_t id) noexcept {
+    return 0 != (bitmap[id / 64] & (uint64_t(1) << (id % 64)));
+  }
+
+  /**
+   * Sets a bit of a bitmap
+   */
+  static void set(std::vector<uint64_t>& bitmap, ::amqp_channel_t id) noexcept {
+    bitmap[id / 64] |= uint64_t(1) << (id % 64);
+  }
+
+  /**
+   * Clears a bit of a bitmap
+   */
+  static void clear(std::vector<uint64_t>& bitmap, ::amqp_channel_t id) noexcept {
+    bitmap[id / 64] &= ~(uint64_t(1) << (id % 64));
+  }
+
+  /**
+   * Allocates the lowest free channel identifier at or after the hint
+   *
+   * @return Channel identifier, 0 if all are in use
+   */
+  ::amqp_channel_t allocate() noexcept {
+    for (std::size_t i = 0; i < ids_.size(); ++i) {
+      const std::size_t word = (hint_ + i) % ids_.size();
+      if (~uint64_t(0) == ids_[word])
+        continue;
+      const auto id = static_cast<::amqp_channel_t>(word * 64 + static_cast<std::size_t>(__builtin_ctzll(~ids_[word])));
+      set(ids_, id);
+      ++used_;
+      hint_ = word;
+      return id;
+    }
+    return 0;
+  }
+
+  /**
+   * Frees a channel identifier
+   *
+   * @param[in] id Channel identifier
+   */
+  void recycle(::amqp_channel_t id) noexcept {
+    clear(ids_, id);
+    clear(broken_, id);
+    --used_;
+  }
+
+  /**
+   * Opens a channel on a free identifier
+   *
+   * @return Open channel
+   *
+   * @throw ChannelCloseException When the channel can't be opened
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw Exception When all channel identifiers are in use
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  std::unique_ptr<Channel> open() {
+    const auto id = allocate();
+    if (0 == id)
+      throw Exception("ChannelPool: All " + std::to_string(max_) + " channels are in use!");
+    try {
+      return std::unique_ptr<Channel>(new Channel(connection_, id));
+    } catch(...) {
+      recycle(id);
+      throw;
+    }
+  }
+
+  /**
+   * Opens channels until there are at least as many idle channels as requested on construction
+   */
+  void replenish() {
+    while (idle_.size() < warm_)
+      idle_.emplace_back(open());
+  }
+
+  /**
+   * Acknowledges the broker's channel.close and recycles the identifier
+   *
+   * @param[in] channel Channel closed by the broker
+   */
+  void discard(std::unique_ptr<Channel> channel) noexcept {
+    const auto id = channel->id();
+    channel->moved_ = true; // the channel is already closed, don't send channel.close
+    if (nullptr != connection_.topology())
+      connection_.topology()->channelClosed(id);
+    ::amqp_channel_close_ok_t closeOk{0};
+    ::amqp_send_method(static_cast<::amqp_connection_state_t>(connection_), id, AMQP_CHANNEL_CLOSE_OK_METHOD, &closeOk);
+    connection_.releaseBuffers(id);
+    recycle(id);
+  }
+
+  /**
+   * Returns a leased channel
+   *
+   * @param[in] channel Channel
+   * @param[in] broken Set if the lease holder saw the channel being closed by the broker
+   *
+   * @throw Same as acquire when a replacement channel can't be opened
+   */
+  void release(std::unique_ptr<Channel> channel, bool broken) {
+    if (broken || test(broken_, channel->id())) {
+      discard(std::move(channel));
+      replenish();
+      return;
+    }
+    idle_.emplace_back(std::move(channel));
+  }
+
+  /**
+   * Connection the channels are opened on
+   */
+  Connection& connection_;
+
+  /**
+   * Highest channel identifier
+   */
+  ::amqp_channel_t max_;
+
+  /**
+   * Minimum number of idle channels
+   */
+  std::size_t warm_;
+
+  /**
+   * Number of set bits in ids_ (including the reserved channel 0)
+   */
+  std::size_t used_;
+
+  /**
+   * Word of ids_ to start the next search at
+   */
+  std::size_t hint_;
+
+  /**
+   * Bitmap of identifiers in use
+   */
+  std::vector<uint64_t> ids_;
+
+  /**
+   * Bitmap of leased channels that were closed by the broker
+   */
+  std::vector<uint64_t> broken_;
+
+  /**
+   * Idle open channels, reused in LIFO order
+   */
+  std::vector<std::unique_ptr<Channel>> idle_;
+};
+
+} // namespace rmqcxx
@@ -27,24 +27,57 @@ SOFTWARE.
 
 #pragma once
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include <amqp.h>
 #include <amqp_framing.h>
 #include <amqp_tcp_socket.h>
 
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ConsumerCancel.hpp"
+#include "DeliveryBuffers.hpp"
+#include "Endpoints.hpp"
 #include "Envelope.hpp"
 #include "Exceptions.hpp"
+#include "MemoryResource.hpp"
 #include "Message.hpp"
+#include "ReleasePolicy.hpp"
 #include "ReturnedMessage.hpp"
+#include "SocketOptions.hpp"
+#include "Wire.hpp"
 #include "util.hpp"
 
 namespace rmqcxx {
 
+class AsyncConnector;
 class Channel;
+class Topology;
+
+/**
+ * Creates the socket object of a connection (std::function<amqp_socket_t*(amqp_connection_state_t)> compatible)
+ *
+ * The socket is opened by the connection, the factory only has to allocate and configure it. This is the extension
+ * point for transports other than plain TCP, the library itself only ships the TCP and TLS sockets of rabbitmq-c.
+ *
+ * @note A custom transport (ie: one submitting its sends and receives through io_uring) implements the socket vtable
+ * of rabbitmq-c's private amqp_socket.h and registers itself with amqp_set_socket like amqp_tcp_socket_new does. That
+ * header is only part of the rabbitmq-c sources this library is built against, not of its installed API, and it names
+ * a vtable member delete, so the transport has to be written in C and rebuilt whenever rabbitmq-c is updated.
+ */
+using SocketFactory = std::function<::amqp_socket_t*(::amqp_connection_state_t)>;
 
 /**
  * RMQ Connection class
@@ -52,6 +85,11 @@ class Channel;
 class Connection final {
 public:
 
+  /**
+   * Number of queued channel.close methods (deferClose) that are sent in one batch
+   */
+  static constexpr std::size_t kCloseBatch = 64;
+
   /**
    * Constructs a connection
    *
@@ -67,7 +105,7 @@ public:
    * @param[in] heartbeat Number of seconds between heartbeats to ask from the broker
    * @param[in] connectTimeout Maximum duration for trying to connect
    * @param[in] handshakeTimeout Maximum duration for trying to do a handshake
-   * @param[in] properties Connection properties
+   * @param[in] properties Connection properties, nullptr if none, the consumer_cancel_notify capability is always announced
    * @param[in] saslMethod AMQP SASL method
    * @param[in] args Login arguments
    *
@@ -84,15 +122,94 @@ public:
   Connection(
     const std::string& address, int port, const std::string& vhost, int maxChannels, int maxFrameSize, int heartbeat,
     ConnectionDuration connectTimeout, const HandshakeDuration* handshakeTimeout, const amqp_table_t *properties, ::amqp_sasl_method_enum saslMethod,
-    Args... args) : connection_(::amqp_new_connection(), ::amqp_destroy_connection), context_(std::string("Connection(") + std::to_string(reinterpret_cast<uint64_t>(connection_.get())) + "): ") {
+    Args... args) :
+      Connection(SocketFactory(::amqp_tcp_socket_new), address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, handshakeTimeout, properties, saslMethod, std::forward<Args>(args)...) {}
+
+  /**
+   * Constructs a connection on a socket created by a socket factory
+   *
+   * @tparam ConnectionDuration Any std::chrono::duration compatible type
+   * @tparam HandshakeDuration Any std::chrono::duration compatible type
+   * @tparam Args TableEntry types
+   *
+   * @param[in] socketFactory Creates the (unopened) socket object of the connection, for example amqp_ssl_socket_new or a custom transport
+   * @param[in] address Address of the RMQ broker
+   * @param[in] port Port of the RMQ broker
+   * @param[in] vhost VHost this connection will operate on
+   * @param[in] maxChannels Maximum number of channels for this connnection
+   * @param[in] maxFrameSize Maximum size of a single frame for this connection
+   * @param[in] heartbeat Number of seconds between heartbeats to ask from the broker
+   * @param[in] connectTimeout Maximum duration for trying to connect
+   * @param[in] handshakeTimeout Maximum duration for trying to do a handshake
+   * @param[in] properties Connection properties, nullptr if none, the consumer_cancel_notify capability is always announced
+   * @param[in] saslMethod AMQP SASL method
+   * @param[in] args Login arguments
+   *
+   * @throw ChannelCloseException When channel for the login RPC should be closed - This should never happen as there is no channel as the point of constructing this
+   * @throw ConnectionCloseException When connection for the login RPC should be closed
+   * @throw Exception When allocating the connection fails
+   * @throw LibraryException When there is a library exception
+   * @throw OperationException When setting the handshake timeout fails
+   * @throw RPCException For general RPC exception on login
+   * @throw SocketException When the socket factory returns nullptr and when socket opening fails
+   *
+   * @note The socket object is owned by the connection state, it is released by amqp_destroy_connection
+   */
+  template <typename ConnectionDuration, typename HandshakeDuration, typename... Args>
+  Connection(
+    const SocketFactory& socketFactory,
+    const std::string& address, int port, const std::string& vhost, int maxChannels, int maxFrameSize, int heartbeat,
+    ConnectionDuration connectTimeout, const HandshakeDuration* handshakeTimeout, const amqp_table_t *properties, ::amqp_sasl_method_enum saslMethod,
+    Args... args) :
+      Connection(socketFactory, SocketOptions(), address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, handshakeTimeout, properties, saslMethod, std::forward<Args>(args)...) {}
+
+  /**
+   * Constructs a connection on a socket created by a socket factory and tuned with socket options
+   *
+   * @tparam ConnectionDuration Any std::chrono::duration compatible type
+   * @tparam HandshakeDuration Any std::chrono::duration compatible type
+   * @tparam Args TableEntry types
+   *
+   * @param[in] socketFactory Creates the (unopened) socket object of the connection, for example amqp_ssl_socket_new or a custom transport
+   * @param[in] socketOptions Options applied to the socket right after it is opened
+   * @param[in] address Address of the RMQ broker
+   * @param[in] port Port of the RMQ broker
+   * @param[in] vhost VHost this connection will operate on
+   * @param[in] maxChannels Maximum number of channels for this connnection
+   * @param[in] maxFrameSize Maximum size of a single frame for this connection
+   * @param[in] heartbeat Number of seconds between heartbeats to ask from the broker
+   * @param[in] connectTimeout Maximum duration for trying to connect
+   * @param[in] handshakeTimeout Maximum duration for trying to do a handshake
+   * @param[in] properties Connection properties, nullptr if none, the consumer_cancel_notify capability is always announced
+   * @param[in] saslMethod AMQP SASL method
+   * @param[in] args Login arguments
+   *
+   * @throw ChannelCloseException When channel for the login RPC should be closed - This should never happen as there is no channel as the point of constructing this
+   * @throw ConnectionCloseException When connection for the login RPC should be closed
+   * @throw Exception When allocating the connection fails
+   * @throw LibraryException When there is a library exception
+   * @throw OperationException When setting the handshake timeout fails
+   * @throw RPCException For general RPC exception on login
+   * @throw SocketException When the socket factory returns nullptr, when socket opening fails and when the socket options can't be applied
+   *
+   * @note The socket object is owned by the connection state, it is released by amqp_destroy_connection
+   */
+  template <typename ConnectionDuration, typename HandshakeDuration, typename... Args>
+  Connection(
+    const SocketFactory& socketFactory, const SocketOptions& socketOptions,
+    const std::string& address, int port, const std::string& vhost, int maxChannels, int maxFrameSize, int heartbeat,
+    ConnectionDuration connectTimeout, const HandshakeDuration* handshakeTimeout, const amqp_table_t *properties, ::amqp_sasl_method_enum saslMethod,
+    Args... args) : connection_(::amqp_new_connection(), ::amqp_destroy_connection), context_(std::string("Connection(") + std::to_string(reinterpret_cast<uint64_t>(connection_.get())) + "): "), serviced_(std::chrono::steady_clock::now()), topology_(nullptr) {
 
     if (!connection_) {
       throw Exception("Failed to allocate connection object!");
     }
-    auto socket = ::amqp_tcp_socket_new(connection_.get());
+    auto socket = socketFactory(connection_.get());
     if (nullptr == socket) {
       throw SocketException(*this, socket, AMQP_STATUS_SOCKET_ERROR, "Failed to allocate socket object!");
     }
+    const auto* factory = socketFactory.target<decltype(&::amqp_tcp_socket_new)>();
+    plainTcp_ = nullptr != factory && &::amqp_tcp_socket_new == *factory;
 
     auto tv = timeValue(connectTimeout);
     auto socketStatus = static_cast<::amqp_status_enum>(::amqp_socket_open_noblock(socket, address.c_str(), port, &tv));
@@ -101,6 +218,14 @@ public:
       throw SocketException(*this, socket, socketStatus, "Failed to open socket!");
     }
 
+    try {
+      if (!socketOptions.empty())
+        socketOptions.apply(fd());
+    } catch(const Exception& e) {
+      close();
+      throw SocketException(*this, socket, AMQP_STATUS_SOCKET_ERROR, e.what());
+    }
+
     if (handshakeTimeout != nullptr) {
       auto hsTv = timeValue(*handshakeTimeout);
       auto status = ::amqp_set_handshake_timeout(connection_.get(), &hsTv);
@@ -110,9 +235,9 @@ public:
       }
     }
 
-    auto reply = nullptr == properties ?
-    ::amqp_login(connection_.get(), vhost.c_str(), maxChannels, maxFrameSize, heartbeat, saslMethod, std::forward<Args>(args)...) :
-    ::amqp_login_with_properties(connection_.get(), vhost.c_str(), maxChannels, maxFrameSize, heartbeat, properties, saslMethod, std::forward<Args>(args)...);
+    std::vector<::amqp_table_entry_t> capabilities, entries;
+    const auto clientProperties = announceCapabilities(properties, capabilities, entries);
+    auto reply = ::amqp_login_with_properties(connection_.get(), vhost.c_str(), maxChannels, maxFrameSize, heartbeat, &clientProperties, saslMethod, std::forward<Args>(args)...);
     try {
       processReply(context_, reply);
     } catch(...) {
@@ -178,6 +303,35 @@ public:
     int heartbeat, Duration timeout) :
       Connection(address, port, vhost, maxChannels, maxFrameSize, heartbeat, timeout, static_cast<const std::chrono::seconds*>(nullptr), nullptr, AMQP_SASL_METHOD_EXTERNAL, info.c_str()) {}
 
+  /**
+   * Connection constructor that races the brokers of a list and uses plain SASL
+   *
+   * Attempts are staggered as configured in the endpoint list, the first one that logs in is kept and the outcome
+   * of every attempt is remembered in the list for the next connect.
+   *
+   * @tparam Duration std::chrono::duration compatible duration type
+   *
+   * @param[in] endpoints Brokers to connect to
+   * @param[in] username Username
+   * @param[in] password Password
+   * @param[in] vhost VHost
+   * @param[in] maxChannels Maximum number of channels for this connnection
+   * @param[in] maxFrameSize Maximum size of a single frame for this connection
+   * @param[in] heartbeat Number of seconds between heartbeats to ask from the broker
+   * @param[in] timeout Connect timeout of a single attempt
+   *
+   * @throw Whatever the attempt on the most preferred endpoint threw when all attempts fail
+   *
+   * @see Endpoints::connect
+   */
+  template <typename Duration>
+  Connection(
+    const Endpoints& endpoints, const std::string& username, const std::string& password, const std::string& vhost,
+    int maxChannels, int maxFrameSize, int heartbeat, Duration timeout) :
+      Connection(endpoints.connect<Connection>([=](const Endpoint& endpoint) {
+        return Connection(endpoint.address, endpoint.port, username, password, vhost, maxChannels, maxFrameSize, heartbeat, timeout);
+      })) {}
+
   /**
    * Destructor
    */
@@ -201,9 +355,80 @@ public:
   Connection& operator=(const Connection&) = delete;
 
   /**
-   * Can't be move assigned
+   * Move assignable, this connection is closed and takes over the other one
+   *
+   * @note Objects referencing this connection (Channel, Queue, ...) keep referencing it, this is what allows
+   * RecoveringConnection to replace a failed connection underneath them
+   */
+  Connection& operator=(Connection&& other) noexcept {
+    if (this == &other)
+      return *this;
+    close();
+    connection_ = std::move(other.connection_);
+    context_ = std::move(other.context_);
+    serviced_ = other.serviced_;
+    topology_ = other.topology_;
+    closes_ = std::move(other.closes_);
+    pending_ = std::move(other.pending_);
+    buffers_ = std::move(other.buffers_);
+    zeroCopy_ = other.zeroCopy_;
+    resource_ = other.resource_;
+    release_ = other.release_;
+    out_ = std::move(other.out_);
+    plainTcp_ = other.plainTcp_;
+    nativeEncoding_ = other.nativeEncoding_;
+    return *this;
+  }
+
+  /**
+   * Makes sure a channel identifier is not being closed before it is opened again
+   *
+   * A queued channel.close is taken out of the queue and the channel is closed synchronously instead.
+   *
+   * @param[in] channel Channel identifier
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConnectionException When channel.close-ok for the channel identifier was not consumed yet
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  void reclaim(::amqp_channel_t channel) {
+    auto it = pending_.find(channel);
+    if (pending_.end() != it && it->second.closeOk)
+      throw ConnectionException(*this, context_ + "Channel " + std::to_string(channel) + " is still being closed, consume pending replies first or use another channel!");
+    auto queued = std::find(closes_.begin(), closes_.end(), channel);
+    if (closes_.end() == queued)
+      return;
+    closes_.erase(queued);
+    rpc(::amqp_channel_close, channel, AMQP_REPLY_SUCCESS);
+  }
+
+  /**
+   * Consumes a channel.open-ok or channel.close-ok that answers a method sent without waiting
+   *
+   * channel.open-ok of a channel that was closed before the reply was consumed is still counted, the channel can be
+   * opened again in the meantime and then more than one channel.open-ok is awaited.
+   *
+   * @param[in] frame Method frame
+   *
+   * @return True if the frame was an awaited reply
    */
-  Connection& operator=(Connection&&) noexcept = delete;
+  bool settle(const ::amqp_frame_t& frame) noexcept {
+    auto it = pending_.find(frame.channel);
+    if (pending_.end() == it)
+      return false;
+    auto& replies = it->second;
+    if (AMQP_CHANNEL_OPEN_OK_METHOD == frame.payload.method.id && replies.openOks > 0)
+      --replies.openOks;
+    else if (AMQP_CHANNEL_CLOSE_OK_METHOD == frame.payload.method.id && replies.closeOk)
+      replies.closeOk = false;
+    else
+      return false;
+    if (0 == replies.openOks && !replies.closeOk)
+      pending_.erase(it);
+    return true;
+  }
 
   /**
    * Does a RPC on this connection.
@@ -223,7 +448,7 @@ public:
    */
   template <typename Function, typename... Args>
   auto rpc(const Function& f, Args&&... args) -> decltype(f(::amqp_connection_state_t(), std::forward<Args>(args)...)) {
-    return rpc(true, "", f, std::forward<Args>(args)...);
+    return rpc(true, impl::noContext(), impl::noContext(), f, std::forward<Args>(args)...);
   }
 
   /**
@@ -243,6 +468,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -258,7 +484,7 @@ public:
     ReturnedMessageCallback returnedMessageCallback,
     AcknowledgeCallback acknowledgeCallback) {
     auto tv = timeValue(timeout);
-    return consumeImpl(&tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback);
+    return consumeImpl(&tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, nullptr);
   }
 
   /**
@@ -274,6 +500,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -285,7 +512,128 @@ public:
     EnvelopeCallback envelopeCallback,
     ReturnedMessageCallback returnedMessageCallback,
     AcknowledgeCallback acknowledgeCallback) {
-    consumeImpl(nullptr, envelopeCallback, returnedMessageCallback, acknowledgeCallback);
+    consumeImpl(nullptr, envelopeCallback, returnedMessageCallback, acknowledgeCallback, nullptr);
+  }
+
+  /**
+   * Consumes broker messages, including consumer cancellations
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+   * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage (std::function<void(rmqcxx::ReturnedMessage)> compatible)
+   * @tparam AcknowledgeCallback Callable object that accepts ::amqp_basic_ack_t (std::function<void(amqp_basic_ack_t)> compatible)
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel (std::function<void(rmqcxx::ConsumerCancel)> compatible)
+   *
+   * @param[in] timeout Duration after which this client times out
+   * @param[in] envelopeCallback Callback to call if an envelope was obtained
+   * @param[in] returnedMessageCallback Callback to call if a returned message was received
+   * @param[in] acknowledgeCallback Callback to call if an acknowledgment was received (publisher confirms)
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled (basic.cancel or basic.cancel-ok was received)
+   *
+   * @return True if frame(s) was(were) consumed, otherwise false (Timeout)
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw FrameException When a frame exception happens
+   * @throw FrameStatusException When an exception occurs while waiting for a frame
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   * @throw SocketException On socket error
+   *
+   * @note This method uses std::chrono::high_resolution_clock which may cause the method to wait less than suggested if the clock changes.
+   */
+  template <typename Duration, typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  bool consume(
+    Duration timeout,
+    EnvelopeCallback envelopeCallback,
+    ReturnedMessageCallback returnedMessageCallback,
+    AcknowledgeCallback acknowledgeCallback,
+    CancelCallback cancelCallback) {
+    auto tv = timeValue(timeout);
+    return consumeImpl(&tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback);
+  }
+
+  /**
+   * Consumes broker messages, including consumer cancellations, by blocking until there is an error or a message
+   *
+   * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+   * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage (std::function<void(rmqcxx::ReturnedMessage)> compatible)
+   * @tparam AcknowledgeCallback Callable object that accepts ::amqp_basic_ack_t (std::function<void(amqp_basic_ack_t)> compatible)
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel (std::function<void(rmqcxx::ConsumerCancel)> compatible)
+   *
+   * @param[in] envelopeCallback Callback to call if an envelope was obtained
+   * @param[in] returnedMessageCallback Callback to call if a returned message was received
+   * @param[in] acknowledgeCallback Callback to call if an acknowledgment was received (publisher confirms)
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled (basic.cancel or basic.cancel-ok was received)
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw FrameException When a frame exception happens
+   * @throw FrameStatusException When an exception occurs while waiting for a frame
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   * @throw SocketException On socket error
+   */
+  template <typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  typename std::enable_if<!impl::isDuration<EnvelopeCallback>::value>::type consume(
+    EnvelopeCallback envelopeCallback,
+    ReturnedMessageCallback returnedMessageCallback,
+    AcknowledgeCallback acknowledgeCallback,
+    CancelCallback cancelCallback) {
+    consumeImpl(nullptr, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback);
+  }
+
+  /**
+   * Consumes a batch of frames: waits for the first one, then consumes the frames that are already buffered
+   *
+   * Blocking counterpart of onReadable: once the first frame arrived the rest of the batch is consumed by onReadable,
+   * which dispatches what the underlying library already read without waiting for more. The underlying library reads
+   * as much as its inbound buffer holds with every read, so at high rates a single read brings in many deliveries.
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+   * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage (std::function<void(rmqcxx::ReturnedMessage)> compatible)
+   * @tparam AcknowledgeCallback Callable object that accepts ::amqp_basic_ack_t (std::function<void(amqp_basic_ack_t)> compatible)
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel, or std::nullptr_t
+   *
+   * @param[in] timeout Maximum duration to wait for the first frame
+   * @param[in] budget Maximum number of frames to consume
+   * @param[in] envelopeCallback Callback to call if an envelope was obtained
+   * @param[in] returnedMessageCallback Callback to call if a returned message was received
+   * @param[in] acknowledgeCallback Callback to call if an acknowledgment was received (publisher confirms)
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled, nullptr to throw ConsumerCancelException instead
+   *
+   * @return Number of consumed frames, 0 on timeout
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer and cancelCallback is nullptr
+   * @throw FrameException When a frame exception happens
+   * @throw FrameStatusException When an exception occurs while waiting for a frame
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   * @throw SocketException On socket error
+   *
+   * @note There is no receive ring and no readv, the socket is read by the underlying library into its fixed size
+   * inbound buffer, one read per refill. Only the size of the kernel receive buffer can be tuned, with
+   * SocketOptions::receiveBuffer when constructing the connection.
+   */
+  template <typename Duration, typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  std::size_t consumeBatch(
+    Duration timeout,
+    std::size_t budget,
+    EnvelopeCallback envelopeCallback,
+    ReturnedMessageCallback returnedMessageCallback,
+    AcknowledgeCallback acknowledgeCallback,
+    CancelCallback cancelCallback) {
+    if (0 == budget)
+      return 0;
+    auto tv = timeValue(timeout);
+    if (!consumeImpl(&tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback))
+      return 0;
+    if (1 == budget || !buffered())
+      return 1;
+    return 1 + onReadable(budget - 1, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback);
   }
 
   /**
@@ -301,6 +649,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -338,6 +687,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -369,6 +719,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -406,6 +757,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -437,6 +789,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -474,6 +827,7 @@ public:
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -526,60 +880,587 @@ public:
   }
 
   /**
-   * Conversion to the raw connection pointer
+   * Applies socket options to the socket of this connection, for example to switch between latency and throughput tuning
+   *
+   * @param[in] options Socket options
+   *
+   * @throw SocketException When an option can't be set
    */
-  inline operator ::amqp_connection_state_t() const noexcept {
-    return connection_.get();
+  void configure(const SocketOptions& options) const {
+    try {
+      options.apply(fd());
+    } catch(const Exception& e) {
+      throw SocketException(*this, ::amqp_get_socket(connection_.get()), AMQP_STATUS_SOCKET_ERROR, e.what());
+    }
   }
 
-private:
+  /**
+   * Maximum number of channels negotiated with the broker
+   * @return Highest usable channel identifier
+   */
+  int channelMax() const noexcept {
+    const int max = ::amqp_get_channel_max(connection_.get());
+    return 0 == max ? 65535 : max; // 0 means no limit other than the protocol one
+  }
 
   /**
-   * Closes the connection if possible
+   * Socket file descriptor of this connection
+   * @return Socket file descriptor, -1 if there is no socket
    */
-  void close() noexcept {
-    if (!connection_)
-      return;
+  int fd() const noexcept {
+    return ::amqp_get_sockfd(connection_.get());
+  }
+
+  /**
+   * Corks the socket so methods sent back to back leave in as few packets as possible
+   *
+   * @return Cork that flushes on destruction, nullptr if the socket can't be corked (the methods are sent uncorked)
+   */
+  std::unique_ptr<Cork> corked() const noexcept {
+    const int fd = this->fd();
+    if (fd < 0)
+      return nullptr;
     try {
-      rpc(false, this->context_, ::amqp_connection_close, AMQP_REPLY_SUCCESS); // gracefully close, the release will be handled by the amqp_destroy_connection upon destruction
+      return std::unique_ptr<Cork>(new Cork(fd));
     } catch(...) {
-
+      return nullptr;
     }
   }
 
   /**
-   * Does a RPC on this connection.
+   * Checks if there is data that was already read from the socket but was not consumed yet
    *
-   * @tparam Function Type of the RPC method to call
-   * @tparam Args Types of arguments of the RPC method
+   * @return True if there are buffered bytes or enqueued frames
    *
-   * @param[in] context String describing the context of the RPC
-   * @param[in] f Method to execute on the broker
-   * @param[in] args Arguments for the method
+   * @note A readiness based poller (epoll, poll, ...) won't report buffered data, consume has to be called while this returns true
+   */
+  bool buffered() const noexcept {
+    return ::amqp_data_in_buffer(connection_.get()) || ::amqp_frames_enqueued(connection_.get());
+  }
+
+  /**
+   * Negotiated heartbeat interval
+   * @return Heartbeat interval, zero if heartbeats are disabled
+   */
+  std::chrono::seconds heartbeat() const noexcept {
+    return std::chrono::seconds(::amqp_get_heartbeat(connection_.get()));
+  }
+
+  /**
+   * Socket readiness a reactor has to watch for
+   */
+  enum class Interest : unsigned {
+    None = 0,
+    Read = 1,
+    Write = 2,
+    ReadWrite = 3
+  };
+
+  /**
+   * Socket readiness this connection needs to make progress
    *
-   * @return Whatever the remote method returns
+   * @return Interest::Read while the socket is open, Interest::None otherwise
    *
-   * @throw ChannelCloseException When channel for the executed RPC should be closed
-   * @throw ConnectionCloseException When connection for the executed RPC should be closed
-   * @throw LibraryException When there is a library exception
-   * @throw RPCException For general RPC exception
+   * @note Frames are written synchronously by the underlying library, so write readiness is never requested
    */
-  template <typename Function, typename... Args>
-  auto rpc(bool maybeRelease, const std::string& context, const Function& f, Args&&... args) -> decltype(f(::amqp_connection_state_t(), std::forward<Args>(args)...)) {
-    const auto& c = connection_.get();
-    defer g{ [this, c, context, maybeRelease] () {
-      processReply(context_ + context, ::amqp_get_rpc_reply(c));
-      // Most of the exposed RPCs (if not all) use amqp_simple_rpc_decoded which leads to the allocation in the pool
-      if (maybeRelease) ::amqp_maybe_release_buffers(c);
-    }};
-    return f(c, std::forward<Args>(args)...);
+  Interest interest() const noexcept {
+    return fd() < 0 ? Interest::None : Interest::Read;
   }
 
   /**
-   * Processes an RPC reply
+   * Processes the data available on the socket, to be called by a reactor when the socket is readable
    *
-   * @param[in] context Context used for Exceptions
-   * @param[in] reply RPC reply
+   * Frames are consumed with a zero timeout until nothing is left in the library buffers or the budget is used up.
+   * If buffered() returns true afterwards, the reactor has to call this again without waiting for readiness.
+   *
+   * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+   * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage (std::function<void(rmqcxx::ReturnedMessage)> compatible)
+   * @tparam AcknowledgeCallback Callable object that accepts ::amqp_basic_ack_t (std::function<void(amqp_basic_ack_t)> compatible)
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel, or std::nullptr_t
+   *
+   * @param[in] budget Maximum number of frames to consume
+   * @param[in] envelopeCallback Callback to call if an envelope was obtained
+   * @param[in] returnedMessageCallback Callback to call if a returned message was received
+   * @param[in] acknowledgeCallback Callback to call if an acknowledgment was received (publisher confirms)
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled, nullptr to throw ConsumerCancelException instead
+   *
+   * @return Number of consumed frames
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer and cancelCallback is nullptr
+   * @throw FrameException When a frame exception happens
+   * @throw FrameStatusException When an exception occurs while waiting for a frame
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   * @throw SocketException On socket error
+   *
+   * @note The callbacks must not destroy the connection
+   * @note The underlying library reads the content frames of a delivery synchronously once its method frame arrived,
+   * a delivery split across several TCP segments can therefore wait for its remaining segments
+   */
+  template <typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  std::size_t onReadable(
+    std::size_t budget,
+    EnvelopeCallback envelopeCallback,
+    ReturnedMessageCallback returnedMessageCallback,
+    AcknowledgeCallback acknowledgeCallback,
+    CancelCallback cancelCallback) {
+    serviced_ = std::chrono::steady_clock::now();
+    std::size_t consumed = 0;
+    while (consumed < budget) {
+      ::timeval tv{.tv_sec = 0, .tv_usec = 0};
+      if (!consumeImpl(&tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback))
+        break;
+      ++consumed;
+      if (!buffered())
+        break;
+    }
+    return consumed;
+  }
+
+  /**
+   * To be called by a reactor when the socket is writable
+   *
+   * @note Nothing to do as long as interest() does not request write readiness
+   */
+  void onWritable() noexcept {}
+
+  /**
+   * Duration until onTimeout has to be called
+   *
+   * @return Remaining time until the heartbeat has to be serviced (half of the negotiated interval after the last
+   * call to onReadable or onTimeout), std::chrono::milliseconds::max() if heartbeats are disabled
+   */
+  std::chrono::milliseconds nextTimeout() const noexcept {
+    const auto& interval = std::chrono::duration_cast<std::chrono::milliseconds>(heartbeat()) / 2;
+    if (interval <= std::chrono::milliseconds::zero())
+      return std::chrono::milliseconds::max();
+    const auto& now = std::chrono::steady_clock::now();
+    const auto& due = serviced_ + interval;
+    if (due <= now)
+      return std::chrono::milliseconds::zero();
+    // round up so the reactor does not wake up before the deadline
+    return std::chrono::duration_cast<std::chrono::milliseconds>(due - now + std::chrono::milliseconds(1) - std::chrono::steady_clock::duration(1));
+  }
+
+  /**
+   * Services heartbeats, to be called by a reactor once nextTimeout elapsed
+   *
+   * Consumes with a zero timeout, which makes the underlying library send a heartbeat when one is due and detect a
+   * missing peer. A frame that arrived in the meantime is dispatched to the callbacks.
+   *
+   * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+   * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage (std::function<void(rmqcxx::ReturnedMessage)> compatible)
+   * @tparam AcknowledgeCallback Callable object that accepts ::amqp_basic_ack_t (std::function<void(amqp_basic_ack_t)> compatible)
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel, or std::nullptr_t
+   *
+   * @param[in] envelopeCallback Callback to call if an envelope was obtained
+   * @param[in] returnedMessageCallback Callback to call if a returned message was received
+   * @param[in] acknowledgeCallback Callback to call if an acknowledgment was received (publisher confirms)
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled, nullptr to throw ConsumerCancelException instead
+   *
+   * @return True if a frame was consumed
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer and cancelCallback is nullptr
+   * @throw FrameException When a frame exception happens
+   * @throw FrameStatusException When an exception occurs while waiting for a frame
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception (including a heartbeat timeout)
+   * @throw SocketException On socket error
+   */
+  template <typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  bool onTimeout(
+    EnvelopeCallback envelopeCallback,
+    ReturnedMessageCallback returnedMessageCallback,
+    AcknowledgeCallback acknowledgeCallback,
+    CancelCallback cancelCallback) {
+    serviced_ = std::chrono::steady_clock::now();
+    ::timeval tv{.tv_sec = 0, .tv_usec = 0};
+    return consumeImpl(&tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback);
+  }
+
+  /**
+   * Topology recorder of this connection
+   * @return Recorder notified about declarations made through Channel, Exchange and Queue, nullptr if none
+   */
+  Topology* topology() const noexcept {
+    return topology_;
+  }
+
+  /**
+   * Sets the topology recorder of this connection
+   *
+   * @param[in] topology Recorder to notify about declarations, nullptr to stop recording
+   */
+  void record(Topology* topology) noexcept {
+    topology_ = topology;
+  }
+
+  /**
+   * Sends channel.open without waiting for channel.open-ok
+   *
+   * The first synchronous method on the channel reports a rejected open (ChannelCloseException), channel.open-ok
+   * itself is consumed by consume() (or the reactor hooks).
+   *
+   * @param[in] channel Channel identifier
+   *
+   * @throw ChannelCloseException When closing the channel identifier synchronously fails (see reclaim)
+   * @throw ConnectionException When channel.close-ok for the channel identifier was not consumed yet
+   * @throw OperationException When channel.open can't be sent
+   */
+  void open(::amqp_channel_t channel) {
+    reclaim(channel);
+    ::amqp_channel_open_t method{::amqp_bytes_t{0, nullptr}};
+    const auto status = ::amqp_send_method(connection_.get(), channel, AMQP_CHANNEL_OPEN_METHOD, &method);
+    if (AMQP_STATUS_OK != status)
+      throw OperationException(*this, status, context_ + "Failed to send channel.open on channel " + std::to_string(channel) + "!");
+    ++pending_[channel].openOks;
+  }
+
+  /**
+   * Queues channel.close to be sent with the next batch of closes
+   *
+   * The batch is sent once it reaches kCloseBatch channels, by flushCloses() and before consuming, channel.close-ok
+   * replies are consumed by consume() (or the reactor hooks). Closes that are still queued when the connection is
+   * closed are never sent, closing the connection closes all of its channels.
+   *
+   * @param[in] channel Channel identifier
+   */
+  void deferClose(::amqp_channel_t channel) noexcept {
+    try {
+      closes_.push_back(channel);
+      if (closes_.size() >= kCloseBatch)
+        flushCloses();
+    } catch(...) {
+      // the channel stays open on the broker until the connection is closed
+    }
+  }
+
+  /**
+   * Sends all queued channel.close methods back to back without waiting for the replies
+   *
+   * @return Number of sent channel.close methods
+   *
+   * @throw OperationException When channel.close can't be sent, the closes that were not sent stay queued
+   */
+  std::size_t flushCloses() {
+    if (closes_.empty())
+      return 0;
+    auto cork = corked();
+    std::size_t sent = 0;
+    for (const auto channel : closes_) {
+      ::amqp_channel_close_t method{AMQP_REPLY_SUCCESS, ::amqp_bytes_t{0, nullptr}, 0, 0};
+      const auto status = ::amqp_send_method(connection_.get(), channel, AMQP_CHANNEL_CLOSE_METHOD, &method);
+      if (AMQP_STATUS_OK != status) {
+        closes_.erase(closes_.begin(), closes_.begin() + sent);
+        throw OperationException(*this, status, context_ + "Failed to send channel.close on channel " + std::to_string(channel) + "!");
+      }
+      pending_[channel].closeOk = true;
+      ++sent;
+    }
+    closes_.clear();
+    return sent;
+  }
+
+  /**
+   * Number of channel.open-ok and channel.close-ok replies that were not consumed yet
+   * @return Number of pending replies
+   */
+  std::size_t pending() const noexcept {
+    std::size_t count = 0;
+    for (const auto& replies : pending_)
+      count += replies.second.openOks + (replies.second.closeOk ? 1 : 0);
+    return count;
+  }
+
+  /**
+   * Checks if a channel identifier is being closed without waiting
+   *
+   * @param[in] channel Channel identifier
+   *
+   * @return True if channel.close is queued or channel.close-ok was not consumed yet
+   */
+  bool closing(::amqp_channel_t channel) const noexcept {
+    auto it = pending_.find(channel);
+    return (pending_.end() != it && it->second.closeOk) || closes_.end() != std::find(closes_.begin(), closes_.end(), channel);
+  }
+
+  /**
+   * Enables or disables zero-copy consuming
+   *
+   * When enabled, consumed envelopes reference the frames received by rabbitmq-c instead of owning a copy. A body that
+   * fits into a single frame is referenced in place, a body that spans several frames is reassembled once into a
+   * reused buffer. The frame buffers of a channel are not recycled as long as an envelope of that channel exists.
+   *
+   * @param[in] enabled True to consume without copying
+   *
+   * @note Borrowed envelopes must be destroyed before the connection is closed and on the thread that consumes
+   * @note The content frames of a delivery must not be interleaved with frames of other channels
+   */
+  void zeroCopy(bool enabled) {
+    if (enabled && !buffers_)
+      buffers_ = std::make_shared<DeliveryBuffers>(connection_.get(), resource_);
+    zeroCopy_ = enabled;
+  }
+
+  /**
+   * Checks if zero-copy consuming is enabled
+   * @return True if consumed envelopes borrow the frame buffers
+   */
+  bool zeroCopy() const noexcept {
+    return zeroCopy_;
+  }
+
+#ifdef RMQCXX_HAS_PMR
+  /**
+   * Sets the memory resource of the consume-side buffers
+   *
+   * The leases and the reassembled bodies of zero-copy envelopes are allocated from the resource, with a
+   * std::pmr::monotonic_buffer_resource the memory of a whole batch is freed in one step by releasing the resource
+   * once its envelopes are destroyed.
+   *
+   * @param[in] resource Memory resource, it has to outlive the envelopes allocated from it
+   *
+   * @throw ConnectionException When envelopes still borrow buffers
+   *
+   * @note The envelopes consumed without zero-copy are allocated by rabbitmq-c, which has no allocator hooks
+   */
+  void memoryResource(MemoryResource* resource) {
+    if (buffers_ && buffers_->pinned())
+      throw ConnectionException(*this, context_ + "Can't change the memory resource while envelopes borrow buffers!");
+    resource_ = resource;
+    if (buffers_)
+      buffers_ = std::make_shared<DeliveryBuffers>(connection_.get(), resource_);
+  }
+
+  /**
+   * Memory resource of the consume-side buffers
+   * @return Memory resource
+   */
+  MemoryResource* memoryResource() const noexcept {
+    return resource_;
+  }
+#endif
+
+  /**
+   * Enables or disables the native encoder for basic.publish, basic.ack and basic.nack
+   *
+   * When enabled, Channel::publish, Channel::ack and Channel::nack encode their frames with MethodEncoder into a
+   * buffer owned by this connection and write it to the socket with a single call, instead of going through the
+   * encoder and the frame pool of rabbitmq-c.
+   *
+   * @param[in] enabled True to use the native encoder
+   *
+   * @throw ConnectionException When enabling it on a socket that is not plain TCP (ie: TLS)
+   */
+  void nativeEncoding(bool enabled) {
+    if (enabled && !plainTcp_)
+      throw ConnectionException(*this, context_ + "Native encoding needs a plain TCP socket!");
+    nativeEncoding_ = enabled;
+  }
+
+  /**
+   * Checks if the native encoder is used
+   * @return True if publish, ack and nack bypass the rabbitmq-c encoder
+   */
+  bool nativeEncoding() const noexcept {
+    return nativeEncoding_;
+  }
+
+  /**
+   * Releases the frame buffers of a channel unless an envelope still borrows them
+   *
+   * @param[in] channel Channel identifier
+   */
+  void releaseBuffers(::amqp_channel_t channel) noexcept {
+    if (!buffers_ || !buffers_->pinned(channel))
+      ::amqp_maybe_release_buffers_on_channel(connection_.get(), channel);
+  }
+
+  /**
+   * Sets the policy that decides when the frame buffers are released after RPCs and consumed frames
+   *
+   * @param[in] policy Release policy, its counters replace the ones of the current policy
+   */
+  void releasePolicy(const ReleasePolicy& policy) noexcept {
+    release_ = policy;
+  }
+
+  /**
+   * Policy that decides when the frame buffers are released
+   * @return Release policy including its counters
+   */
+  const ReleasePolicy& releasePolicy() const noexcept {
+    return release_;
+  }
+
+  /**
+   * Conversion to the raw connection pointer
+   */
+  inline operator ::amqp_connection_state_t() const noexcept {
+    return connection_.get();
+  }
+
+private:
+
+  /**
+   * Constructs a connection on a TCP socket that already completed the AMQP handshake (AsyncConnector)
+   *
+   * @param[in] fd Socket, owned by the connection from this point on, also when this throws
+   * @param[in] maxChannels Negotiated maximum number of channels
+   * @param[in] maxFrameSize Negotiated maximum size of a single frame
+   * @param[in] heartbeat Negotiated number of seconds between heartbeats
+   *
+   * @throw Exception When allocating the connection fails
+   * @throw OperationException When the negotiated parameters can't be applied
+   * @throw SocketException When the socket object can't be allocated
+   */
+  Connection(int fd, int maxChannels, int maxFrameSize, int heartbeat) :
+    connection_(::amqp_new_connection(), ::amqp_destroy_connection), context_(std::string("Connection(") + std::to_string(reinterpret_cast<uint64_t>(connection_.get())) + "): "), serviced_(std::chrono::steady_clock::now()), topology_(nullptr) {
+
+    if (!connection_) {
+      ::close(fd);
+      throw Exception("Failed to allocate connection object!");
+    }
+    auto socket = ::amqp_tcp_socket_new(connection_.get());
+    if (nullptr == socket) {
+      ::close(fd);
+      throw SocketException(*this, socket, AMQP_STATUS_SOCKET_ERROR, "Failed to allocate socket object!");
+    }
+    ::amqp_tcp_socket_set_sockfd(socket, fd);
+    plainTcp_ = true;
+
+    auto status = ::amqp_tune_connection(connection_.get(), maxChannels, maxFrameSize, heartbeat);
+    if (AMQP_STATUS_OK != status) {
+      close();
+      throw OperationException(*this, status, "Failed to tune connection!");
+    }
+  }
+
+  /**
+   * Adds the consumer_cancel_notify capability to the client properties, the broker only sends basic.cancel to clients that announce it
+   *
+   * rabbitmq-c merges the capabilities table with its own defaults, an entry the user already put in it is kept as it is.
+   *
+   * @param[in] properties User supplied properties, nullptr if none
+   * @param[out] capabilities Storage of the capabilities table
+   * @param[out] entries Storage of the properties table
+   *
+   * @return Client properties that reference the storage
+   */
+  static ::amqp_table_t announceCapabilities(const ::amqp_table_t* properties, std::vector<::amqp_table_entry_t>& capabilities, std::vector<::amqp_table_entry_t>& entries) {
+    static const char kCapabilities[] = "capabilities";
+    static const char kCancelNotify[] = "consumer_cancel_notify";
+    auto is = [](const ::amqp_bytes_t& key, const char* name, std::size_t length) {
+      return key.len == length && 0 == std::memcmp(key.bytes, name, length);
+    };
+
+    ::amqp_table_entry_t cancelNotify;
+    cancelNotify.key = ::amqp_bytes_t{sizeof(kCancelNotify) - 1, const_cast<char*>(kCancelNotify)};
+    cancelNotify.value.kind = AMQP_FIELD_KIND_BOOLEAN;
+    cancelNotify.value.value.boolean = 1;
+
+    for (int i = 0; nullptr != properties && i < properties->num_entries; ++i)
+      entries.push_back(properties->entries[i]);
+    const auto found = std::find_if(entries.begin(), entries.end(), [&is](const ::amqp_table_entry_t& entry) {
+      return is(entry.key, kCapabilities, sizeof(kCapabilities) - 1);
+    });
+
+    if (entries.end() == found) {
+      capabilities.push_back(cancelNotify);
+      ::amqp_table_entry_t entry;
+      entry.key = ::amqp_bytes_t{sizeof(kCapabilities) - 1, const_cast<char*>(kCapabilities)};
+      entry.value.kind = AMQP_FIELD_KIND_TABLE;
+      entry.value.value.table = ::amqp_table_t{1, capabilities.data()};
+      entries.push_back(entry);
+    } else if (AMQP_FIELD_KIND_TABLE == found->value.kind) {
+      const auto& table = found->value.value.table;
+      bool announced = false;
+      for (int i = 0; i < table.num_entries; ++i) {
+        capabilities.push_back(table.entries[i]);
+        announced = announced || is(table.entries[i].key, kCancelNotify, sizeof(kCancelNotify) - 1);
+      }
+      if (!announced)
+        capabilities.push_back(cancelNotify);
+      found->value.value.table = ::amqp_table_t{static_cast<int>(capabilities.size()), capabilities.data()};
+    }
+    return ::amqp_table_t{static_cast<int>(entries.size()), entries.data()};
+  }
+
+  /**
+   * Closes the connection if possible
+   */
+  void close() noexcept {
+    closes_.clear();
+    pending_.clear();
+    if (buffers_)
+      buffers_->detach();
+    if (!connection_)
+      return;
+    try {
+      rpc(false, impl::noContext(), impl::noContext(), ::amqp_connection_close, AMQP_REPLY_SUCCESS); // gracefully close, the release will be handled by the amqp_destroy_connection upon destruction
+    } catch(...) {
+
+    }
+  }
+
+  /**
+   * Does a RPC on this connection.
+   *
+   * @tparam Function Type of the RPC method to call
+   * @tparam Args Types of arguments of the RPC method
+   *
+   * @param[in] maybeRelease If set the frame buffers are released after the RPC
+   * @param[in] context String describing the context of the RPC (ie: the channel)
+   * @param[in] detail String appended to the context (ie: the queue)
+   * @param[in] f Method to execute on the broker
+   * @param[in] args Arguments for the method
+   *
+   * @return Whatever the remote method returns
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   *
+   * @note The context strings are referenced, they are only concatenated when an exception is thrown
+   */
+  template <typename Function, typename... Args>
+  auto rpc(bool maybeRelease, const std::string& context, const std::string& detail, const Function& f, Args&&... args) -> decltype(f(::amqp_connection_state_t(), std::forward<Args>(args)...)) {
+    const auto& c = connection_.get();
+    auto g = makeScopeGuard([this, c, &context, &detail, maybeRelease] () {
+      processReply(context, detail, ::amqp_get_rpc_reply(c));
+      // Most of the exposed RPCs (if not all) use amqp_simple_rpc_decoded which leads to the allocation in the pool
+      if (maybeRelease) recycle();
+    });
+    return f(c, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Processes an RPC reply, the context of the exception is only built when the reply is not normal
+   *
+   * @param[in] context Context used for Exceptions, appended to the context of the connection
+   * @param[in] detail Appended to the context
+   * @param[in] reply RPC reply
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  void processReply(const std::string& context, const std::string& detail, const ::amqp_rpc_reply_t& reply) const {
+    if (AMQP_RESPONSE_NORMAL != reply.reply_type)
+      processReply(context_ + context + detail, reply);
+  }
+
+  /**
+   * Processes an RPC reply
+   *
+   * @param[in] context Context used for Exceptions
+   * @param[in] reply RPC reply
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
@@ -614,16 +1495,19 @@ private:
    * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope
    * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage
    * @tparam AcknowledgeCallback Callable object that accepts ::amqp_basic_ack_t
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel or std::nullptr_t
    *
    * @param[in,out] tv Timeout, set to nullptr to block until there is a message or an error
    * @param[in] envelopeCallback Callback to call if an envelope was obtained (std::function<void(rmqcxx::Envelope)> compatible)
    * @param[in] returnedMessageCallback Callback to call if a returned message was received (std::function<void(rmqcxx::ReturnedMessage)> compatible)
    * @param[in] acknowledgeCallback Callback to call if an acknowledgment was received (publisher confirms)  (std::function<void(::amqp_basic_ack_t)> compatible)
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled (std::function<void(rmqcxx::ConsumerCancel)> compatible), nullptr to throw ConsumerCancelException on basic.cancel and to ignore basic.cancel-ok
    *
    * @return True if frame(s) was(were) consumed, otherwise false (Timeout)
    *
    * @throw ChannelCloseException When channel for the executed RPC should be closed
    * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
    * @throw FrameException When a frame exception happens
    * @throw FrameStatusException When an exception occurs while waiting for a frame
    * @throw LibraryException When there is a library exception
@@ -631,14 +1515,40 @@ private:
    * @throw SocketException On socket error
    *
    * @note This method uses std::chrono::high_resolution_clock which may cause the method to wait less than suggested if the clock changes.
-   * @note This method calls amqp_maybe_release_buffers after it has completed. Because of the way rabbitmq-c operates it is not trivial to know when to call this exactly but this seems like a logical place
+   * @note This method calls amqp_maybe_release_buffers after it has completed, when the release policy says so. Because of the way rabbitmq-c operates it is not trivial to know when to call this exactly but this seems like a logical place
    */
-  template <typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback>
-  bool consumeImpl(timeval* tv, EnvelopeCallback envelopeCallback, ReturnedMessageCallback returnedMessageCallback, AcknowledgeCallback acknowledgeCallback) {
-
-    defer g([this] () {
-      ::amqp_maybe_release_buffers(connection_.get()); // Released here because of the calls to amqp_simple_wait_frame_noblock either directly or via amq_consume_message
+  template <typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  bool consumeImpl(timeval* tv, EnvelopeCallback envelopeCallback, ReturnedMessageCallback returnedMessageCallback, AcknowledgeCallback acknowledgeCallback, CancelCallback cancelCallback) {
+    bool idle = false;
+    auto g = makeScopeGuard([this, &idle] () {
+      recycle(idle); // Released here because of the calls to amqp_simple_wait_frame_noblock either directly or via amq_consume_message
     });
+    flushCloses();
+    idle = !consumeNext(tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback);
+    return !idle;
+  }
+
+  /**
+   * Consumes the next envelope or frame
+   *
+   * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+   * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage (std::function<void(rmqcxx::ReturnedMessage)> compatible)
+   * @tparam AcknowledgeCallback Callable object that accepts an ::amqp_basic_ack_t (std::function<void(::amqp_basic_ack_t)> compatible)
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel (std::function<void(rmqcxx::ConsumerCancel)> compatible)
+   *
+   * @param[in] tv Timeout value pointer, nullptr means wait forever
+   * @param[in] envelopeCallback Callback to call if an envelope was obtained
+   * @param[in] returnedMessageCallback Callback to call if a message was returned
+   * @param[in] acknowledgeCallback Callback to call if an acknowledge was received
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled
+   *
+   * @return False if nothing was consumed before the timeout
+   */
+  template <typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  bool consumeNext(timeval* tv, EnvelopeCallback& envelopeCallback, ReturnedMessageCallback& returnedMessageCallback, AcknowledgeCallback& acknowledgeCallback, CancelCallback& cancelCallback) {
+    if (zeroCopy_)
+      return consumeFrame(tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback,
+        ::amqp_rpc_reply_t{AMQP_RESPONSE_LIBRARY_EXCEPTION, ::amqp_method_t{0, nullptr}, AMQP_STATUS_UNEXPECTED_STATE});
 
     Envelope envelope;
     auto start = std::chrono::high_resolution_clock::now();
@@ -647,12 +1557,12 @@ private:
       case AMQP_RESPONSE_NORMAL:
         if (envelope->channel == 0)
           return false;
+        release_.used(envelope->message.body.len);
         envelopeCallback(std::move(envelope));
         return true;
       case AMQP_RESPONSE_LIBRARY_EXCEPTION: {
         switch(reply.library_error) {
           case AMQP_STATUS_UNEXPECTED_STATE: {
-            ::amqp_frame_t frame;
             if (nullptr != tv) {
               const auto& initial = durationValue<std::chrono::microseconds>(*tv);
               const auto& now = std::chrono::high_resolution_clock::now();
@@ -664,38 +1574,8 @@ private:
                 *tv = spent > initial ? ::timeval{.tv_sec = 0, .tv_usec = 0} : timeValue(initial - spent);
               }
             }
-            auto status = ::amqp_simple_wait_frame_noblock(connection_.get(), &frame, tv);
-            switch(status) {
-              case AMQP_STATUS_OK:
-                break;
-              case AMQP_STATUS_TIMEOUT:
-                return false;
-              default:
-                throw FrameStatusException(*this, reply, status, context_ + "Consumer: Received unhandled status when waiting for frame");
-            }
-            if (AMQP_FRAME_METHOD != frame.frame_type)
-              throw FrameException(*this, reply, frame, context_ + "Consumer: Received unhandled frame type!"); // getting the frame failed but we don't know what to do
-
-            switch(frame.payload.method.id) {
-              case AMQP_BASIC_ACK_METHOD:
-                acknowledgeCallback(*static_cast<const ::amqp_basic_ack_t*>(frame.payload.method.decoded));
-                return true;
-              case AMQP_BASIC_RETURN_METHOD: {
-                Message message;
-                processReply(context_ + " Consumer (return method): ", ::amqp_read_message(connection_.get(), frame.channel, static_cast<::amqp_message_t*>(message), 0));
-                returnedMessageCallback(ReturnedMessage(std::move(message), *static_cast<const ::amqp_basic_return_t*>(frame.payload.method.decoded)));
-                return true;
-              }
-              case AMQP_CHANNEL_CLOSE_METHOD:
-                throw ChannelCloseException(*this, frame.channel, static_cast<const ::amqp_channel_close_t*>(frame.payload.method.decoded), context_ + "Consumer: Channel close received!");
-
-              case AMQP_CONNECTION_CLOSE_METHOD:
-                throw ConnectionCloseException(*this, static_cast<const ::amqp_connection_close_t*>(frame.payload.method.decoded), context_ + "Consumer: Connection close received!");
-              default:
-                throw FrameException(*this, reply, frame, context_ + "Consumer: Received unhandled method: " + ::amqp_method_name(frame.payload.method.id));
-            }
+            return consumeFrame(tv, envelopeCallback, returnedMessageCallback, acknowledgeCallback, cancelCallback, reply);
           }
-            break;
           case AMQP_STATUS_TIMEOUT:
             return false;
 
@@ -712,6 +1592,250 @@ private:
     return false;
   }
 
+  /**
+   * Waits for a frame and dispatches it
+   *
+   * @tparam EnvelopeCallback Callable object that accepts an rmqcxx::Envelope
+   * @tparam ReturnedMessageCallback Callable object that accepts an rmqcxx::ReturnedMessage
+   * @tparam AcknowledgeCallback Callable object that accepts ::amqp_basic_ack_t
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel or std::nullptr_t
+   *
+   * @param[in,out] tv Timeout, set to nullptr to block until there is a frame or an error
+   * @param[in] envelopeCallback Callback to call if an envelope was obtained (zero-copy consuming)
+   * @param[in] returnedMessageCallback Callback to call if a returned message was received
+   * @param[in] acknowledgeCallback Callback to call if an acknowledgment was received
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled, nullptr to throw ConsumerCancelException
+   * @param[in] reply Reply used for exceptions
+   *
+   * @return True if frame(s) was(were) consumed, otherwise false (Timeout)
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw ConsumerCancelException When the broker cancelled a consumer (basic.cancel)
+   * @throw FrameException When a frame exception happens
+   * @throw FrameStatusException When an exception occurs while waiting for a frame
+   */
+  template <typename EnvelopeCallback, typename ReturnedMessageCallback, typename AcknowledgeCallback, typename CancelCallback>
+  bool consumeFrame(timeval* tv, EnvelopeCallback& envelopeCallback, ReturnedMessageCallback& returnedMessageCallback, AcknowledgeCallback& acknowledgeCallback, CancelCallback& cancelCallback, const ::amqp_rpc_reply_t& reply) {
+    ::amqp_frame_t frame;
+    auto status = ::amqp_simple_wait_frame_noblock(connection_.get(), &frame, tv);
+    switch(status) {
+      case AMQP_STATUS_OK:
+        break;
+      case AMQP_STATUS_TIMEOUT:
+        return false;
+      default:
+        throw FrameStatusException(*this, reply, status, context_ + "Consumer: Received unhandled status when waiting for frame");
+    }
+    if (AMQP_FRAME_METHOD != frame.frame_type)
+      throw FrameException(*this, reply, frame, context_ + "Consumer: Received unhandled frame type!"); // getting the frame failed but we don't know what to do
+
+    switch(frame.payload.method.id) {
+      case AMQP_BASIC_DELIVER_METHOD:
+        if (!zeroCopy_)
+          throw FrameException(*this, reply, frame, context_ + "Consumer: Received unhandled method: " + ::amqp_method_name(frame.payload.method.id));
+        envelopeCallback(borrow(frame, reply));
+        return true;
+      case AMQP_BASIC_ACK_METHOD:
+        acknowledgeCallback(*static_cast<const ::amqp_basic_ack_t*>(frame.payload.method.decoded));
+        return true;
+      case AMQP_BASIC_RETURN_METHOD: {
+        Message message;
+        processReply(context_ + " Consumer (return method): ", ::amqp_read_message(connection_.get(), frame.channel, static_cast<::amqp_message_t*>(message), 0));
+        release_.used(static_cast<const ::amqp_message_t*>(message)->body.len);
+        returnedMessageCallback(ReturnedMessage(std::move(message), *static_cast<const ::amqp_basic_return_t*>(frame.payload.method.decoded)));
+        return true;
+      }
+      case AMQP_BASIC_CANCEL_METHOD: {
+        const auto* cancel = static_cast<const ::amqp_basic_cancel_t*>(frame.payload.method.decoded);
+        cancelled(cancelCallback, ConsumerCancel(frame.channel, container<std::string>(cancel->consumer_tag), true), reply, frame);
+        return true;
+      }
+      case AMQP_BASIC_CANCEL_OK_METHOD: {
+        const auto* cancelOk = static_cast<const ::amqp_basic_cancel_ok_t*>(frame.payload.method.decoded);
+        cancelled(cancelCallback, ConsumerCancel(frame.channel, container<std::string>(cancelOk->consumer_tag), false), reply, frame);
+        return true;
+      }
+      case AMQP_CHANNEL_OPEN_OK_METHOD:
+      case AMQP_CHANNEL_CLOSE_OK_METHOD:
+        if (!settle(frame))
+          throw FrameException(*this, reply, frame, context_ + "Consumer: Received unexpected method: " + ::amqp_method_name(frame.payload.method.id));
+        return true;
+
+      case AMQP_CHANNEL_CLOSE_METHOD:
+        throw ChannelCloseException(*this, frame.channel, static_cast<const ::amqp_channel_close_t*>(frame.payload.method.decoded), context_ + "Consumer: Channel close received!");
+
+      case AMQP_CONNECTION_CLOSE_METHOD:
+        throw ConnectionCloseException(*this, static_cast<const ::amqp_connection_close_t*>(frame.payload.method.decoded), context_ + "Consumer: Connection close received!");
+      default:
+        throw FrameException(*this, reply, frame, context_ + "Consumer: Received unhandled method: " + ::amqp_method_name(frame.payload.method.id));
+    }
+  }
+
+  /**
+   * Builds an envelope that references the received frames instead of copying them (zero-copy consuming)
+   *
+   * @param[in] deliver Frame holding basic.deliver
+   * @param[in] reply Reply used for exceptions
+   *
+   * @return Envelope that borrows the frame buffers of the channel
+   *
+   * @throw FrameException When the content frames are missing or malformed
+   * @throw FrameStatusException When an exception occurs while waiting for a frame
+   */
+  Envelope borrow(const ::amqp_frame_t& deliver, const ::amqp_rpc_reply_t& reply) {
+    const auto* method = static_cast<const ::amqp_basic_deliver_t*>(deliver.payload.method.decoded);
+    ::amqp_envelope_t envelope{};
+    envelope.channel = deliver.channel;
+    envelope.consumer_tag = method->consumer_tag;
+    envelope.delivery_tag = method->delivery_tag;
+    envelope.redelivered = method->redelivered;
+    envelope.exchange = method->exchange;
+    envelope.routing_key = method->routing_key;
+
+    ::amqp_frame_t frame;
+    content(deliver.channel, AMQP_FRAME_HEADER, frame, reply);
+    envelope.message.properties = *static_cast<const ::amqp_basic_properties_t*>(frame.payload.properties.decoded);
+    const auto size = static_cast<std::size_t>(frame.payload.properties.body_size);
+    std::unique_ptr<DeliveryBuffers::Body> body;
+    if (0 != size) {
+      content(deliver.channel, AMQP_FRAME_BODY, frame, reply);
+      if (frame.payload.body_fragment.len == size) {
+        envelope.message.body = frame.payload.body_fragment; // referenced in place
+      } else {
+        body = buffers_->body(size);
+        for (;;) {
+          const auto* bytes = static_cast<const uint8_t*>(frame.payload.body_fragment.bytes);
+          if (body->size() + frame.payload.body_fragment.len > size)
+            throw FrameException(*this, reply, frame, context_ + "Consumer: Received more content than announced!");
+          body->insert(body->end(), bytes, bytes + frame.payload.body_fragment.len);
+          if (body->size() == size)
+            break;
+          content(deliver.channel, AMQP_FRAME_BODY, frame, reply);
+        }
+        envelope.message.body = ::amqp_bytes_t{body->size(), body->data()};
+      }
+    }
+    release_.used(size);
+    return Envelope(envelope, buffers_->pin(deliver.channel, std::move(body)));
+  }
+
+  /**
+   * Waits for a content frame of a delivery
+   *
+   * @param[in] channel Channel of the delivery
+   * @param[in] type Expected frame type (AMQP_FRAME_HEADER or AMQP_FRAME_BODY)
+   * @param[out] frame Received frame
+   * @param[in] reply Reply used for exceptions
+   *
+   * @throw FrameException When a different frame was received
+   * @throw FrameStatusException When an exception occurs while waiting for the frame
+   */
+  void content(::amqp_channel_t channel, uint8_t type, ::amqp_frame_t& frame, const ::amqp_rpc_reply_t& reply) {
+    const auto status = ::amqp_simple_wait_frame_noblock(connection_.get(), &frame, nullptr);
+    if (AMQP_STATUS_OK != status)
+      throw FrameStatusException(*this, reply, status, context_ + "Consumer: Received unhandled status when waiting for content frame");
+    if (type != frame.frame_type || channel != frame.channel)
+      throw FrameException(*this, reply, frame, context_ + "Consumer: Received unexpected frame while reading content!");
+  }
+
+  /**
+   * Encodes frames into the outgoing buffer and writes them to the socket (native encoding)
+   *
+   * @tparam Encode Callable object that accepts WireWriter&
+   *
+   * @param[in] encode Appends the frames to the buffer
+   *
+   * @throw Exception When encoding fails, nothing is written
+   * @throw SocketException When writing to the socket fails
+   */
+  template <typename Encode>
+  void sendEncoded(Encode encode) {
+    out_.clear();
+    encode(out_);
+    const int fd = this->fd();
+    std::size_t written = 0;
+    while (written < out_.size()) {
+#ifdef MSG_NOSIGNAL
+      const auto sent = ::send(fd, out_.data() + written, out_.size() - written, MSG_NOSIGNAL);
+#else
+      const auto sent = ::send(fd, out_.data() + written, out_.size() - written, 0);
+#endif
+      if (sent >= 0) {
+        written += static_cast<std::size_t>(sent);
+        continue;
+      }
+      if (EINTR == errno)
+        continue;
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        ::pollfd pfd{fd, POLLOUT, 0};
+        if (::poll(&pfd, 1, -1) >= 0 || EINTR == errno)
+          continue; // rabbitmq-c keeps its socket non-blocking, wait until it is writable
+      }
+      throw SocketException(*this, ::amqp_get_socket(connection_.get()), AMQP_STATUS_SOCKET_ERROR, context_ + "Failed to write to socket: " + std::strerror(errno));
+    }
+  }
+
+  /**
+   * Releases the frame buffers of all channels if the release policy says so, unless an envelope still borrows some of them
+   *
+   * @param[in] idle True if nothing was done (ie: consume timed out)
+   */
+  void recycle(bool idle = false) noexcept {
+    if (!release_.due(release_.timed() ? ReleasePolicy::Clock::now() : ReleasePolicy::Clock::time_point(), !idle))
+      return;
+    if (buffers_ && buffers_->pinned()) {
+      release_.skipped();
+      return;
+    }
+    ::amqp_maybe_release_buffers(connection_.get());
+    release_.released();
+  }
+
+  /**
+   * Releases the frame buffers of a channel if the release policy says so, unless an envelope still borrows them
+   *
+   * @param[in] channel Channel identifier
+   */
+  void recycle(::amqp_channel_t channel) noexcept {
+    if (!release_.due(release_.timed() ? ReleasePolicy::Clock::now() : ReleasePolicy::Clock::time_point()))
+      return;
+    if (buffers_ && buffers_->pinned(channel)) {
+      release_.skipped();
+      return;
+    }
+    ::amqp_maybe_release_buffers_on_channel(connection_.get(), channel);
+    release_.releasedChannel();
+  }
+
+  /**
+   * Passes a consumer cancellation to the user callback
+   *
+   * @tparam CancelCallback Callable object that accepts an rmqcxx::ConsumerCancel
+   *
+   * @param[in] cancelCallback Callback to call
+   * @param[in] cancel Cancellation
+   */
+  template <typename CancelCallback>
+  void cancelled(CancelCallback& cancelCallback, ConsumerCancel cancel, const ::amqp_rpc_reply_t&, const ::amqp_frame_t&) {
+    cancelCallback(std::move(cancel));
+  }
+
+  /**
+   * Handles a consumer cancellation when no cancel callback was given
+   *
+   * @param[in] cancel Cancellation
+   * @param[in] reply Reply returned when consuming the message
+   * @param[in] frame Frame holding the cancellation
+   *
+   * @throw ConsumerCancelException When the broker cancelled the consumer
+   */
+  void cancelled(std::nullptr_t, ConsumerCancel cancel, const ::amqp_rpc_reply_t& reply, const ::amqp_frame_t& frame) {
+    if (cancel.fromBroker())
+      throw ConsumerCancelException(*this, reply, frame, cancel.consumerTag(), context_ + "Consumer: Consumer cancelled by the broker!");
+    // basic.cancel-ok only confirms a cancellation requested by this client
+  }
+
   /**
    * Connection storage
    */
@@ -720,8 +1844,79 @@ private:
   /**
    * Context used for logging, exceptions and errors
    */
-  const std::string context_;
+  std::string context_;
+
+  /**
+   * Last time the connection was serviced through the reactor hooks
+   */
+  std::chrono::steady_clock::time_point serviced_;
+
+  /**
+   * Topology recorder (non owning)
+   */
+  Topology* topology_;
+
+  /**
+   * Channels with a queued channel.close
+   */
+  std::vector<::amqp_channel_t> closes_;
+
+  /**
+   * Replies to methods sent without waiting that were not consumed yet on a channel
+   */
+  struct PendingReplies {
+    /**
+     * Number of awaited channel.open-ok replies
+     */
+    std::size_t openOks = 0;
+
+    /**
+     * Set if channel.close-ok is awaited
+     */
+    bool closeOk = false;
+  };
+
+  /**
+   * Replies (channel.open-ok and channel.close-ok) that were not consumed yet by channel
+   */
+  std::unordered_map<::amqp_channel_t, PendingReplies> pending_;
+
+  /**
+   * Buffers borrowed by zero-copy envelopes, created when zero-copy consuming is enabled
+   */
+  std::shared_ptr<DeliveryBuffers> buffers_;
+
+  /**
+   * Zero-copy consuming flag
+   */
+  bool zeroCopy_ = false;
+
+  /**
+   * Memory resource of the consume-side buffers
+   */
+  MemoryResource* resource_ = defaultResource();
+
+  /**
+   * Decides when the frame buffers are released
+   */
+  ReleasePolicy release_;
+
+  /**
+   * Outgoing buffer of the native encoder, reused between calls
+   */
+  WireWriter out_;
+
+  /**
+   * Set if the socket is known to be plain TCP, the native encoder writes to it directly
+   */
+  bool plainTcp_ = false;
+
+  /**
+   * Native encoding flag
+   */
+  bool nativeEncoding_ = false;
 
+  friend class AsyncConnector;
   friend class Channel;
 };
 
@@ -0,0 +1,127 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+#include <amqp.h>
+
+namespace rmqcxx {
+
+/**
+ * Class that describes a consumer cancellation (basic.cancel sent by the broker or basic.cancel-ok)
+ *
+ * The broker cancels a consumer when the queue it consumes from is deleted or when the queue leader moves to another
+ * node (quorum and mirrored queues). Only the cancelled consumer is affected, the channel and the connection stay open.
+ *
+ * @note The broker only sends basic.cancel to clients that announce the consumer_cancel_notify capability in the
+ * client properties of the connection (capabilities table), Connection and AsyncConnector always announce it
+ */
+class ConsumerCancel final {
+public:
+
+  /**
+   * Constructor
+   *
+   * @param[in] channel Channel the consumer was subscribed on
+   * @param[in] consumerTag Tag of the cancelled consumer
+   * @param[in] fromBroker True if the broker cancelled the consumer (basic.cancel), false if this is the confirmation of a client cancel (basic.cancel-ok)
+   */
+  ConsumerCancel(::amqp_channel_t channel, std::string consumerTag, bool fromBroker) noexcept :
+    channel_(channel),
+    consumerTag_(std::move(consumerTag)),
+    fromBroker_(fromBroker) {}
+
+  /**
+   * Destructor
+   */
+  ~ConsumerCancel() noexcept = default;
+
+  /**
+   * Copy constructable
+   */
+  ConsumerCancel(const ConsumerCancel&) = default;
+
+  /**
+   * Move constructable
+   */
+  ConsumerCancel(ConsumerCancel&&) noexcept = default;
+
+  /**
+   * Copy assignable
+   */
+  ConsumerCancel& operator=(const ConsumerCancel&) = default;
+
+  /**
+   * Move assignable
+   */
+  ConsumerCancel& operator=(ConsumerCancel&&) noexcept = default;
+
+  /**
+   * Channel the consumer was subscribed on
+   * @return Channel identifier
+   */
+  ::amqp_channel_t channel() const noexcept {
+    return channel_;
+  }
+
+  /**
+   * Tag of the cancelled consumer
+   * @return Consumer tag
+   */
+  const std::string& consumerTag() const noexcept {
+    return consumerTag_;
+  }
+
+  /**
+   * Checks who initiated the cancellation
+   * @return True if the broker cancelled the consumer, false if this confirms a cancellation requested by the client
+   */
+  bool fromBroker() const noexcept {
+    return fromBroker_;
+  }
+
+private:
+
+  /**
+   * Channel identifier storage
+   */
+  ::amqp_channel_t channel_;
+
+  /**
+   * Consumer tag storage
+   */
+  std::string consumerTag_;
+
+  /**
+   * Cancellation initiator storage
+   */
+  bool fromBroker_;
+};
+
+} // namespace rmqcxx
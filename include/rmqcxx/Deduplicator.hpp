@@ -0,0 +1,572 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <amqp.h>
+
+#include "Channel.hpp"
+#include "Envelope.hpp"
+
+namespace rmqcxx {
+
+namespace impl {
+
+  /**
+   * 64 bit FNV-1a hash with a final avalanche step
+   *
+   * @param[in] data Pointer to the data to hash
+   * @param[in] len Length of the data
+   *
+   * @return Hash value
+   */
+  inline uint64_t hash(const void* data, std::size_t len) noexcept {
+    const auto* p = static_cast<const unsigned char*>(data);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < len; ++i) {
+      h ^= p[i];
+      h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+} // namespace impl
+
+/**
+ * Bounded cache of recently processed deliveries used to skip duplicates
+ *
+ * Deliveries are identified by a 64 bit fingerprint of their message_id property (or of the body when the property
+ * is not set). A pair of rotating bloom filters rejects unknown fingerprints without touching the exact set, which is
+ * a fixed capacity LRU with a time to live. All memory is allocated on construction, so the memory per tracked
+ * delivery is fixed.
+ *
+ * @note Fingerprints are exact 64 bit hashes, two different ids that collide on all 64 bits are treated as the same id
+ */
+class Deduplicator final {
+public:
+
+  /**
+   * Clock used for the time to live
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Constructor
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] capacity Maximum number of tracked deliveries, the least recently seen one is evicted when full
+   * @param[in] ttl Duration after which a tracked delivery is forgotten
+   * @param[in] redeliveredOnly If set only deliveries with the redelivered flag are checked (all are remembered)
+   */
+  template <typename Duration>
+  Deduplicator(std::size_t capacity, Duration ttl, bool redeliveredOnly = true) :
+    ttl_(std::chrono::duration_cast<Clock::duration>(ttl)),
+    redeliveredOnly_(redeliveredOnly),
+    capacity_(capacity == 0 ? 1 : capacity),
+    entries_(capacity_),
+    index_(slotCount(capacity_), uint32_t(kEmpty)),
+    bloomBits_(slotCount(capacity_) * 8),
+    bloom_{std::vector<uint64_t>(bloomBits_ / 64), std::vector<uint64_t>(bloomBits_ / 64)},
+    current_(0),
+    inserted_(0),
+    size_(0),
+    head_(kNone),
+    tail_(kNone),
+    free_(0) {
+    for (std::size_t i = 0; i < capacity_; ++i)
+      entries_[i].next = i + 1 < capacity_ ? static_cast<uint32_t>(i + 1) : uint32_t(kNone);
+  }
+
+  /**
+   * Destructor
+   */
+  ~Deduplicator() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  Deduplicator(const Deduplicator&) = delete;
+
+  /**
+   * Move constructable
+   */
+  Deduplicator(Deduplicator&&) = default;
+
+  /**
+   * Can't be copy assigned
+   */
+  Deduplicator& operator=(const Deduplicator&) = delete;
+
+  /**
+   * Move assignable
+   */
+  Deduplicator& operator=(Deduplicator&&) = default;
+
+  /**
+   * Computes the fingerprint of a delivery
+   *
+   * @param[in] envelope Delivery
+   *
+   * @return Hash of the message_id property if it is set, otherwise hash of the body
+   */
+  static uint64_t fingerprint(const Envelope& envelope) noexcept {
+    const auto& properties = envelope->message.properties;
+    if ((properties._flags & AMQP_BASIC_MESSAGE_ID_FLAG) && properties.message_id.len > 0)
+      return impl::hash(properties.message_id.bytes, properties.message_id.len);
+    const auto& body = envelope->message.body;
+    return impl::hash(body.bytes, body.len) ^ 0x9e3779b97f4a7c15ULL; // keep body and id fingerprints apart
+  }
+
+  /**
+   * Checks if a delivery should be skipped as a duplicate
+   *
+   * @param[in] envelope Delivery
+   * @param[in] now Current point in time
+   *
+   * @return True if the delivery was already processed
+   */
+  bool duplicate(const Envelope& envelope, Clock::time_point now = Clock::now()) noexcept {
+    if (redeliveredOnly_ && !envelope->redelivered)
+      return false;
+    return contains(fingerprint(envelope), now);
+  }
+
+  /**
+   * Checks if a fingerprint is tracked
+   *
+   * @param[in] key Fingerprint
+   * @param[in] now Current point in time
+   *
+   * @return True if the fingerprint is tracked and did not expire
+   */
+  bool contains(uint64_t key, Clock::time_point now = Clock::now()) noexcept {
+    if (!mayContain(key))
+      return false;
+    const auto slot = find(key);
+    if (kEmpty == index_[slot])
+      return false;
+    const uint32_t e = index_[slot];
+    if (entries_[e].expires <= now) {
+      erase(slot);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Remembers a processed delivery
+   *
+   * @param[in] envelope Delivery
+   * @param[in] now Current point in time
+   */
+  void remember(const Envelope& envelope, Clock::time_point now = Clock::now()) noexcept {
+    insert(fingerprint(envelope), now);
+  }
+
+  /**
+   * Remembers a fingerprint, refreshing its time to live if it is already tracked
+   *
+   * @param[in] key Fingerprint
+   * @param[in] now Current point in time
+   */
+  void insert(uint64_t key, Clock::time_point now = Clock::now()) noexcept {
+    auto slot = find(key);
+    if (kEmpty != index_[slot]) {
+      const uint32_t e = index_[slot];
+      entries_[e].expires = now + ttl_;
+      unlink(e);
+      pushFront(e);
+      addToBloom(key, false);
+      return;
+    }
+    if (size_ == capacity_) {
+      erase(find(entries_[tail_].key));
+      slot = find(key);
+    }
+    const uint32_t e = free_;
+    free_ = entries_[e].next;
+    entries_[e].key = key;
+    entries_[e].expires = now + ttl_;
+    pushFront(e);
+    index_[slot] = e;
+    ++size_;
+    addToBloom(key, true);
+  }
+
+  /**
+   * Number of tracked fingerprints (including expired ones that were not evicted yet)
+   * @return Number of tracked fingerprints
+   */
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * Maximum number of tracked fingerprints
+   * @return Capacity
+   */
+  std::size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+private:
+
+  /**
+   * Marks an unused index slot
+   */
+  static constexpr uint32_t kEmpty = 0xffffffff;
+
+  /**
+   * Marks the end of a list
+   */
+  static constexpr uint32_t kNone = 0xffffffff;
+
+  /**
+   * Number of bloom filter probes
+   */
+  static constexpr unsigned kProbes = 4;
+
+  /**
+   * Tracked fingerprint
+   */
+  struct Entry {
+    /**
+     * Fingerprint
+     */
+    uint64_t key;
+
+    /**
+     * Point in time after which the fingerprint is forgotten
+     */
+    Clock::time_point expires;
+
+    /**
+     * Previous (more recently seen) entry
+     */
+    uint32_t prev;
+
+    /**
+     * Next (less recently seen) entry, or next free entry
+     */
+    uint32_t next;
+  };
+
+  /**
+   * Size of the open addressing index, power of two with a load factor of at most 0.5
+   *
+   * @param[in] capacity Capacity of the cache
+   *
+   * @return Number of index slots
+   */
+  static std::size_t slotCount(std::size_t capacity) noexcept {
+    std::size_t r = 64;
+    while (r < capacity * 2)
+      r <<= 1;
+    return r;
+  }
+
+  /**
+   * Finds the index slot of a key (linear probing)
+   *
+   * @param[in] key Fingerprint
+   *
+   * @return Slot holding the key, or the empty slot where it would be inserted
+   */
+  std::size_t find(uint64_t key) const noexcept {
+    const std::size_t mask = index_.size() - 1;
+    std::size_t slot = static_cast<std::size_t>(key) & mask;
+    while (kEmpty != index_[slot] && entries_[index_[slot]].key != key)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  /**
+   * Removes the entry from an index slot (backward shift deletion)
+   *
+   * @param[in] slot Index slot to clear
+   */
+  void erase(std::size_t slot) noexcept {
+    const std::size_t mask = index_.size() - 1;
+    const uint32_t e = index_[slot];
+    unlink(e);
+    entries_[e].next = free_;
+    free_ = e;
+    --size_;
+
+    std::size_t hole = slot;
+    for (std::size_t i = (slot + 1) & mask; kEmpty != index_[i]; i = (i + 1) & mask) {
+      const std::size_t home = static_cast<std::size_t>(entries_[index_[i]].key) & mask;
+      // move the entry into the hole if its home slot is not in the (hole, i] range
+      if (((i - home) & mask) >= ((i - hole) & mask)) {
+        index_[hole] = index_[i];
+        hole = i;
+      }
+    }
+    index_[hole] = kEmpty;
+  }
+
+  /**
+   * Removes an entry from the recency list
+   *
+   * @param[in] e Entry index
+   */
+  void unlink(uint32_t e) noexcept {
+    auto& entry = entries_[e];
+    if (kNone != entry.prev)
+      entries_[entry.prev].next = entry.next;
+    else
+      head_ = entry.next;
+    if (kNone != entry.next)
+      entries_[entry.next].prev = entry.prev;
+    else
+      tail_ = entry.prev;
+  }
+
+  /**
+   * Makes an entry the most recently seen one
+   *
+   * @param[in] e Entry index
+   */
+  void pushFront(uint32_t e) noexcept {
+    entries_[e].prev = kNone;
+    entries_[e].next = head_;
+    if (kNone != head_)
+      entries_[head_].prev = e;
+    head_ = e;
+    if (kNone == tail_)
+      tail_ = e;
+  }
+
+  /**
+   * Checks the bloom filters
+   *
+   * @param[in] key Fingerprint
+   *
+   * @return False if the key is definitely not tracked
+   */
+  bool mayContain(uint64_t key) const noexcept {
+    return testBloom(bloom_[0], key) || testBloom(bloom_[1], key);
+  }
+
+  /**
+   * Checks a single bloom filter
+   *
+   * @param[in] bits Filter bits
+   * @param[in] key Fingerprint
+   *
+   * @return False if the key was definitely not added to the filter
+   */
+  bool testBloom(const std::vector<uint64_t>& bits, uint64_t key) const noexcept {
+    const uint64_t step = (key >> 32) | 1;
+    for (unsigned i = 0; i < kProbes; ++i) {
+      const uint64_t bit = (key + i * step) % bloomBits_;
+      if (0 == (bits[bit / 64] & (uint64_t(1) << (bit % 64))))
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * Adds a key to the current bloom filter, rotating the filters once enough new keys were added to the current one
+   *
+   * Only new keys count towards the rotation: a refresh does not evict anything from the exact set, so counting it
+   * could clear the filter of a key that is still tracked. Refreshed keys are added to the current filter so they
+   * survive the rotations that follow.
+   *
+   * @param[in] key Fingerprint
+   * @param[in] added True if the key was not tracked before
+   */
+  void addToBloom(uint64_t key, bool added) noexcept {
+    if (added && inserted_ == capacity_) {
+      // the previous filter covers the last capacity_ new keys, keys older than that are evicted from the exact set
+      current_ ^= 1;
+      std::fill(bloom_[current_].begin(), bloom_[current_].end(), 0);
+      inserted_ = 0;
+    }
+    auto& bits = bloom_[current_];
+    const uint64_t step = (key >> 32) | 1;
+    for (unsigned i = 0; i < kProbes; ++i) {
+      const uint64_t bit = (key + i * step) % bloomBits_;
+      bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    if (added)
+      ++inserted_;
+  }
+
+  /**
+   * Time to live
+   */
+  Clock::duration ttl_;
+
+  /**
+   * Only redelivered envelopes are checked if set
+   */
+  bool redeliveredOnly_;
+
+  /**
+   * Maximum number of tracked fingerprints
+   */
+  std::size_t capacity_;
+
+  /**
+   * Entry storage
+   */
+  std::vector<Entry> entries_;
+
+  /**
+   * Open addressing index into entries_
+   */
+  std::vector<uint32_t> index_;
+
+  /**
+   * Number of bits per bloom filter
+   */
+  std::size_t bloomBits_;
+
+  /**
+   * Current and previous bloom filter
+   */
+  std::vector<uint64_t> bloom_[2];
+
+  /**
+   * Index of the filter new keys are added to
+   */
+  unsigned current_;
+
+  /**
+   * Number of keys added to the current filter
+   */
+  std::size_t inserted_;
+
+  /**
+   * Number of tracked fingerprints
+   */
+  std::size_t size_;
+
+  /**
+   * Most recently seen entry
+   */
+  uint32_t head_;
+
+  /**
+   * Least recently seen entry
+   */
+  uint32_t tail_;
+
+  /**
+   * First free entry
+   */
+  uint32_t free_;
+};
+
+/**
+ * Deduplicating envelope callback, skips and acknowledges known duplicates before the handler runs
+ *
+ * @tparam Handler Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+ *
+ * @note The delivery is remembered once the handler returns without throwing
+ */
+template <typename Handler>
+class Deduplicate final {
+public:
+  /**
+   * Constructor
+   *
+   * @param[in] channel Channel used to acknowledge skipped duplicates
+   * @param[in] deduplicator Cache of processed deliveries
+   * @param[in] handler Handler for deliveries that are not duplicates
+   */
+  Deduplicate(Channel& channel, Deduplicator& deduplicator, Handler handler) :
+    channel_(channel), deduplicator_(deduplicator), handler_(std::move(handler)) {}
+
+  /**
+   * Handles a delivery
+   *
+   * @param[in] envelope Delivery
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  void operator()(Envelope envelope) {
+    const auto& now = Deduplicator::Clock::now();
+    if (deduplicator_.duplicate(envelope, now)) {
+      channel_.ack(envelope->delivery_tag, false);
+      return;
+    }
+    const auto& key = Deduplicator::fingerprint(envelope);
+    handler_(std::move(envelope));
+    deduplicator_.insert(key, now);
+  }
+
+private:
+  /**
+   * Channel used to acknowledge skipped duplicates
+   */
+  Channel& channel_;
+
+  /**
+   * Cache of processed deliveries
+   */
+  Deduplicator& deduplicator_;
+
+  /**
+   * Handler for deliveries that are not duplicates
+   */
+  Handler handler_;
+};
+
+/**
+ * Wraps an envelope handler with a deduplication stage
+ *
+ * @tparam Handler Callable object that accepts an rmqcxx::Envelope (std::function<void(rmqcxx::Envelope)> compatible)
+ *
+ * @param[in] channel Channel used to acknowledge skipped duplicates
+ * @param[in] deduplicator Cache of processed deliveries
+ * @param[in] handler Handler for deliveries that are not duplicates
+ *
+ * @return Envelope callback that can be passed to Connection::consume
+ */
+template <typename Handler>
+Deduplicate<Handler> deduplicate(Channel& channel, Deduplicator& deduplicator, Handler handler) {
+  return Deduplicate<Handler>(channel, deduplicator, std::move(handler));
+}
+
+} // namespace rmqcxx
@@ -0,0 +1,253 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <amqp.h>
+
+#include "MemoryResource.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Keeps the frame buffers of rabbitmq-c alive for envelopes that reference them in place (zero-copy consuming)
+ *
+ * rabbitmq-c allocates received frames from a pool per channel and recycles it when the buffers are released. A
+ * borrowed envelope pins the pool of its channel, the pool is released once the last envelope of the channel is
+ * destroyed. Bodies that span several frames are reassembled into buffers that are reused.
+ *
+ * The leases and the reassembled bodies are allocated from a memory resource (std::pmr), with a resource other than
+ * the default one the buffers are not reused so a monotonic resource can be reset once the envelopes are destroyed.
+ *
+ * @note Not thread safe, envelopes have to be destroyed on the thread that consumes the connection
+ */
+class DeliveryBuffers final : public std::enable_shared_from_this<DeliveryBuffers> {
+public:
+
+  /**
+   * Reassembly buffer of a multi-frame body
+   */
+  using Body = std::vector<uint8_t, ResourceAllocator<uint8_t>>;
+
+  /**
+   * Maximum number of reassembly buffers kept for reuse
+   */
+  static constexpr std::size_t kSpareBodies = 16;
+
+  /**
+   * Constructor
+   *
+   * @param[in] state Connection state whose buffers are managed
+   * @param[in] resource Memory resource of the leases and the reassembled bodies
+   */
+  explicit DeliveryBuffers(::amqp_connection_state_t state, MemoryResource* resource = defaultResource()) : state_(state), resource_(resource) {
+    spare_.reserve(kSpareBodies);
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  DeliveryBuffers(const DeliveryBuffers&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  DeliveryBuffers(DeliveryBuffers&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  DeliveryBuffers& operator=(const DeliveryBuffers&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  DeliveryBuffers& operator=(DeliveryBuffers&&) = delete;
+
+  /**
+   * Pins the buffers of a channel
+   *
+   * @param[in] channel Channel identifier
+   * @param[in] body Reassembly buffer owned by the lease, returned for reuse when the lease is destroyed
+   *
+   * @return Lease that unpins the buffers when destroyed
+   *
+   * @note Must be called with shared ownership of this object (std::shared_ptr)
+   */
+  std::shared_ptr<void> pin(::amqp_channel_t channel, std::unique_ptr<Body> body = nullptr) {
+    std::shared_ptr<void> lease = std::allocate_shared<Lease>(resourceAllocator<Lease>(resource_), shared_from_this(), channel, std::move(body));
+    ++pins_[channel];
+    return lease;
+  }
+
+  /**
+   * Takes a reassembly buffer
+   *
+   * @param[in] size Body size
+   *
+   * @return Empty buffer with at least size bytes of capacity
+   */
+  std::unique_ptr<Body> body(std::size_t size) {
+    std::unique_ptr<Body> result;
+    if (spare_.empty()) {
+      result.reset(new Body(resourceAllocator<uint8_t>(resource_)));
+    } else {
+      result = std::move(spare_.back());
+      spare_.pop_back();
+    }
+    result->clear();
+    result->reserve(size);
+    return result;
+  }
+
+  /**
+   * Checks if the buffers of any channel are pinned
+   * @return True if an envelope borrows buffers
+   */
+  bool pinned() const noexcept {
+    return !pins_.empty();
+  }
+
+  /**
+   * Checks if the buffers of a channel are pinned
+   *
+   * @param[in] channel Channel identifier
+   *
+   * @return True if an envelope borrows buffers of the channel
+   */
+  bool pinned(::amqp_channel_t channel) const noexcept {
+    return 0 != pins_.count(channel);
+  }
+
+  /**
+   * Number of reassembly buffers kept for reuse
+   * @return Number of spare buffers
+   */
+  std::size_t spare() const noexcept {
+    return spare_.size();
+  }
+
+  /**
+   * Memory resource of the leases and the reassembled bodies
+   * @return Memory resource
+   */
+  MemoryResource* resource() const noexcept {
+    return resource_;
+  }
+
+  /**
+   * Forgets the connection state, called when the connection is closed
+   *
+   * @note The envelopes that still borrow buffers are dangling from this point on
+   */
+  void detach() noexcept {
+    state_ = nullptr;
+  }
+
+private:
+
+  /**
+   * Pin of a single envelope
+   */
+  struct Lease {
+    /**
+     * Constructor
+     *
+     * @param[in] owner Owner of the pinned buffers
+     * @param[in] channel Channel identifier
+     * @param[in] body Reassembly buffer, nullptr if the body is referenced in place
+     */
+    Lease(std::shared_ptr<DeliveryBuffers> owner, ::amqp_channel_t channel, std::unique_ptr<Body> body) noexcept :
+      owner(std::move(owner)), channel(channel), body(std::move(body)) {}
+
+    /**
+     * Destructor, unpins the buffers
+     */
+    ~Lease() noexcept {
+      owner->unpin(channel, std::move(body));
+    }
+
+    /**
+     * Owner of the pinned buffers
+     */
+    std::shared_ptr<DeliveryBuffers> owner;
+
+    /**
+     * Channel identifier
+     */
+    ::amqp_channel_t channel;
+
+    /**
+     * Reassembly buffer
+     */
+    std::unique_ptr<Body> body;
+  };
+
+  /**
+   * Unpins the buffers of a channel and releases them when nothing pins them anymore
+   *
+   * @param[in] channel Channel identifier
+   * @param[in] body Reassembly buffer to reuse, may be nullptr
+   */
+  void unpin(::amqp_channel_t channel, std::unique_ptr<Body> body) noexcept {
+    if (body && spare_.size() < kSpareBodies && defaultResource() == resource_)
+      spare_.push_back(std::move(body)); // capacity is reserved, does not throw
+    auto it = pins_.find(channel);
+    if (pins_.end() == it || 0 != --it->second)
+      return;
+    pins_.erase(it);
+    if (nullptr != state_)
+      ::amqp_maybe_release_buffers_on_channel(state_, channel);
+  }
+
+  /**
+   * Connection state, nullptr once the connection is closed
+   */
+  ::amqp_connection_state_t state_;
+
+  /**
+   * Memory resource of the leases and the reassembled bodies
+   */
+  MemoryResource* resource_;
+
+  /**
+   * Number of envelopes borrowing buffers per channel
+   */
+  std::unordered_map<::amqp_channel_t, std::size_t> pins_;
+
+  /**
+   * Reassembly buffers kept for reuse
+   */
+  std::vector<std::unique_ptr<Body>> spare_;
+};
+
+} // namespace rmqcxx
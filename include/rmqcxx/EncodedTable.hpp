@@ -0,0 +1,567 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <amqp.h>
+
+namespace rmqcxx {
+
+namespace impl {
+  /**
+   * Compile time sequence of indices
+   */
+  template <std::size_t... I>
+  struct Indices {};
+
+  /**
+   * Concatenates two index sequences, the second one is shifted by the size of the first one
+   */
+  template <typename First, typename Second>
+  struct JoinIndices;
+
+  /**
+   * Concatenates two index sequences, the second one is shifted by the size of the first one
+   */
+  template <std::size_t... I, std::size_t... J>
+  struct JoinIndices<Indices<I...>, Indices<J...>> {
+    using type = Indices<I..., (sizeof...(I) + J)...>;
+  };
+
+  /**
+   * Builds the index sequence 0 .. N-1 (logarithmic instantiation depth)
+   */
+  template <std::size_t N>
+  struct MakeIndices : JoinIndices<typename MakeIndices<N / 2>::type, typename MakeIndices<N - N / 2>::type> {};
+
+  /**
+   * Empty index sequence
+   */
+  template <>
+  struct MakeIndices<0> {
+    using type = Indices<>;
+  };
+
+  /**
+   * Index sequence with a single index
+   */
+  template <>
+  struct MakeIndices<1> {
+    using type = Indices<0>;
+  };
+
+  /**
+   * Fixed size byte storage that can be built at compile time
+   */
+  template <std::size_t N>
+  struct EncodedBytes {
+    /**
+     * Bytes
+     */
+    uint8_t data[N];
+  };
+
+  /**
+   * Sum of sizes
+   * @return 0
+   */
+  constexpr std::size_t sum() noexcept {
+    return 0;
+  }
+
+  /**
+   * Sum of sizes
+   *
+   * @param[in] first First size
+   * @param[in] rest Remaining sizes
+   *
+   * @return Sum of all sizes
+   */
+  template <typename... Rest>
+  constexpr std::size_t sum(std::size_t first, Rest... rest) noexcept {
+    return first + sum(rest...);
+  }
+
+  /**
+   * Computes a byte of an encoded field: short string key, kind and either a big endian number or a long string
+   *
+   * @param[in] i Index of the byte
+   * @param[in] key Key characters
+   * @param[in] keyLength Key length
+   * @param[in] kind Field kind (ie: AMQP_FIELD_KIND_I32)
+   * @param[in] number Numeric value, used when text is nullptr
+   * @param[in] width Size of the numeric value in bytes
+   * @param[in] text String value characters, nullptr for numeric values
+   * @param[in] textLength String value length
+   *
+   * @return Byte at the index
+   */
+  constexpr uint8_t fieldByte(
+    std::size_t i, const char* key, std::size_t keyLength, uint8_t kind, uint64_t number, std::size_t width, const char* text, std::size_t textLength) noexcept {
+    return 0 == i ? static_cast<uint8_t>(keyLength)
+      : i <= keyLength ? static_cast<uint8_t>(key[i - 1])
+      : keyLength + 1 == i ? kind
+      : nullptr == text ? static_cast<uint8_t>(number >> (8 * (width - 1 - (i - keyLength - 2))))
+      : i < keyLength + 6 ? static_cast<uint8_t>(textLength >> (8 * (3 - (i - keyLength - 2))))
+      : static_cast<uint8_t>(text[i - keyLength - 6]);
+  }
+
+  /**
+   * Encodes a field
+   *
+   * @param[in] key Key characters
+   * @param[in] keyLength Key length
+   * @param[in] kind Field kind
+   * @param[in] number Numeric value, used when text is nullptr
+   * @param[in] width Size of the numeric value in bytes
+   * @param[in] text String value characters, nullptr for numeric values
+   * @param[in] textLength String value length
+   *
+   * @return Encoded field
+   */
+  template <std::size_t... I>
+  constexpr EncodedBytes<sizeof...(I)> fieldBytes(
+    Indices<I...>, const char* key, std::size_t keyLength, uint8_t kind, uint64_t number, std::size_t width, const char* text, std::size_t textLength) noexcept {
+    return EncodedBytes<sizeof...(I)>{{fieldByte(I, key, keyLength, kind, number, width, text, textLength)...}};
+  }
+
+  /**
+   * Picks a byte out of consecutive encoded fields
+   *
+   * @param[in] i Index of the byte, relative to the first field
+   * @param[in] field Last field
+   *
+   * @return Byte at the index
+   */
+  template <std::size_t Size>
+  constexpr uint8_t pick(std::size_t i, const EncodedBytes<Size>& field) noexcept {
+    return field.data[i];
+  }
+
+  /**
+   * Picks a byte out of consecutive encoded fields
+   *
+   * @param[in] i Index of the byte, relative to the first field
+   * @param[in] first First field
+   * @param[in] rest Following fields
+   *
+   * @return Byte at the index
+   */
+  template <std::size_t Size, typename... Rest>
+  constexpr uint8_t pick(std::size_t i, const EncodedBytes<Size>& first, const Rest&... rest) noexcept {
+    return i < Size ? first.data[i] : pick(i - Size, rest...);
+  }
+
+  /**
+   * Computes a byte of an encoded table: big endian size of the entries followed by the entries
+   *
+   * @param[in] i Index of the byte
+   * @param[in] size Size of the entries
+   * @param[in] fields Encoded fields
+   *
+   * @return Byte at the index
+   */
+  template <typename... Fields>
+  constexpr uint8_t tableByte(std::size_t i, std::size_t size, const Fields&... fields) noexcept {
+    return i < 4 ? static_cast<uint8_t>(size >> (8 * (3 - i))) : pick(i - 4, fields...);
+  }
+
+  /**
+   * Computes a byte of an encoded table without entries
+   *
+   * @param[in] i Index of the byte
+   *
+   * @return Byte at the index
+   */
+  constexpr uint8_t tableByte(std::size_t, std::size_t) noexcept {
+    return 0;
+  }
+
+  /**
+   * Concatenates encoded fields into an encoded table
+   *
+   * @param[in] fields Encoded fields
+   *
+   * @return Encoded table
+   */
+  template <std::size_t... I, typename... Fields>
+  constexpr EncodedBytes<sizeof...(I)> tableBytes(Indices<I...>, const Fields&... fields) noexcept {
+    return EncodedBytes<sizeof...(I)>{{tableByte(I, sizeof...(I) - 4, fields...)...}};
+  }
+
+  /**
+   * Reads a big endian number
+   *
+   * @param[in] data Bytes
+   * @param[in] width Size of the number in bytes
+   *
+   * @return Number
+   */
+  inline uint64_t readNumber(const uint8_t* data, std::size_t width) noexcept {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < width; ++i)
+      value = (value << 8) | data[i];
+    return value;
+  }
+} // namespace impl
+
+/**
+ * Table entry encoded at compile time, created with encodeField
+ *
+ * @tparam Size Size of the encoding
+ */
+template <std::size_t Size>
+struct EncodedField : impl::EncodedBytes<Size> {
+  /**
+   * Constructor
+   *
+   * @param[in] bytes Encoding
+   */
+  constexpr explicit EncodedField(const impl::EncodedBytes<Size>& bytes) noexcept : impl::EncodedBytes<Size>(bytes) {}
+};
+
+/**
+ * Entries decoded from an EncodedTable, convertible to amqp_table_t
+ *
+ * The keys and the string values reference the encoding, decoding a table is a single pass over it without copies.
+ *
+ * @tparam Count Number of entries
+ */
+template <std::size_t Count>
+class EncodedEntries final {
+public:
+
+  /**
+   * Decodes the entries of a table encoded by encodeTable
+   *
+   * @param[in] encoded Encoding of the table, has to outlive this object
+   */
+  explicit EncodedEntries(const ::amqp_bytes_t& encoded) noexcept : encoded_(encoded) {
+    const uint8_t* data = static_cast<const uint8_t*>(encoded.bytes) + 4;
+    for (std::size_t i = 0; i < Count; ++i) {
+      auto& entry = entries_[i];
+      entry.key = ::amqp_bytes_t{data[0], const_cast<uint8_t*>(data + 1)};
+      data += 1 + data[0];
+      entry.value.kind = *data++;
+      switch (entry.value.kind) {
+        case AMQP_FIELD_KIND_BOOLEAN: entry.value.value.boolean = *data++; break;
+        case AMQP_FIELD_KIND_I8: entry.value.value.i8 = static_cast<int8_t>(*data++); break;
+        case AMQP_FIELD_KIND_U8: entry.value.value.u8 = *data++; break;
+        case AMQP_FIELD_KIND_I16: entry.value.value.i16 = static_cast<int16_t>(impl::readNumber(data, 2)); data += 2; break;
+        case AMQP_FIELD_KIND_U16: entry.value.value.u16 = static_cast<uint16_t>(impl::readNumber(data, 2)); data += 2; break;
+        case AMQP_FIELD_KIND_I32: entry.value.value.i32 = static_cast<int32_t>(impl::readNumber(data, 4)); data += 4; break;
+        case AMQP_FIELD_KIND_U32: entry.value.value.u32 = static_cast<uint32_t>(impl::readNumber(data, 4)); data += 4; break;
+        case AMQP_FIELD_KIND_I64: entry.value.value.i64 = static_cast<int64_t>(impl::readNumber(data, 8)); data += 8; break;
+        case AMQP_FIELD_KIND_U64: entry.value.value.u64 = impl::readNumber(data, 8); data += 8; break;
+        default: { // AMQP_FIELD_KIND_UTF8, the only other kind encodeField produces
+          const auto length = static_cast<std::size_t>(impl::readNumber(data, 4));
+          entry.value.value.bytes = ::amqp_bytes_t{length, const_cast<uint8_t*>(data + 4)};
+          data += 4 + length;
+        }
+      }
+    }
+  }
+
+  /**
+   * Conversion to amqp_table_t, references the entries of this object
+   */
+  operator ::amqp_table_t() const noexcept {
+    return ::amqp_table_t{static_cast<int>(Count), const_cast<::amqp_table_entry_t*>(entries_)};
+  }
+
+  /**
+   * Encoding of the table
+   * @return Bytes referencing the encoding of the table, to be spliced into natively encoded frames
+   */
+  const ::amqp_bytes_t& encoded() const noexcept {
+    return encoded_;
+  }
+
+private:
+
+  /**
+   * Encoding of the table
+   */
+  ::amqp_bytes_t encoded_;
+
+  /**
+   * Entry storage
+   */
+  ::amqp_table_entry_t entries_[Count > 0 ? Count : 1];
+};
+
+/**
+ * Field table in the AMQP wire encoding, built at compile time with encodeTable
+ *
+ * The encoding is spliced into the frames that are encoded natively (Connection::nativeEncoding), otherwise the
+ * entries are handed to rabbitmq-c as an amqp_table_t that references the encoding, without copying keys or strings.
+ *
+ * @tparam Size Size of the encoding, including the leading size of the entries
+ * @tparam Count Number of entries
+ */
+template <std::size_t Size, std::size_t Count>
+class EncodedTable final {
+public:
+
+  /**
+   * Constructor, used by encodeTable
+   *
+   * @param[in] bytes Encoding
+   */
+  constexpr explicit EncodedTable(const impl::EncodedBytes<Size>& bytes) noexcept : bytes_(bytes) {}
+
+  /**
+   * Encoding of the table, ready to be written as a method argument
+   * @return Bytes referencing the encoding
+   */
+  ::amqp_bytes_t bytes() const noexcept {
+    return ::amqp_bytes_t{Size, const_cast<uint8_t*>(bytes_.data)};
+  }
+
+  /**
+   * Entries of the table
+   * @return Entries referencing the encoding of this table
+   */
+  EncodedEntries<Count> entries() const noexcept {
+    return EncodedEntries<Count>(bytes());
+  }
+
+  /**
+   * Size of the encoding
+   * @return Size in bytes
+   */
+  static constexpr std::size_t size() noexcept {
+    return Size;
+  }
+
+  /**
+   * Number of entries
+   * @return Number of entries
+   */
+  static constexpr std::size_t count() noexcept {
+    return Count;
+  }
+
+  /**
+   * Byte of the encoding
+   *
+   * @param[in] i Index of the byte
+   *
+   * @return Byte at the index
+   */
+  constexpr uint8_t operator[](std::size_t i) const noexcept {
+    return bytes_.data[i];
+  }
+
+private:
+
+  /**
+   * Encoding storage
+   */
+  impl::EncodedBytes<Size> bytes_;
+};
+
+/**
+ * Encodes a boolean entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 2> encodeField(const char (&key)[K], bool value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 2>(impl::fieldBytes(typename impl::MakeIndices<K + 2>::type(), key, K - 1, AMQP_FIELD_KIND_BOOLEAN, value ? 1 : 0, 1, nullptr, 0));
+}
+
+/**
+ * Encodes an int8_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 2> encodeField(const char (&key)[K], int8_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 2>(impl::fieldBytes(typename impl::MakeIndices<K + 2>::type(), key, K - 1, AMQP_FIELD_KIND_I8, static_cast<uint8_t>(value), 1, nullptr, 0));
+}
+
+/**
+ * Encodes an uint8_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 2> encodeField(const char (&key)[K], uint8_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 2>(impl::fieldBytes(typename impl::MakeIndices<K + 2>::type(), key, K - 1, AMQP_FIELD_KIND_U8, value, 1, nullptr, 0));
+}
+
+/**
+ * Encodes an int16_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 3> encodeField(const char (&key)[K], int16_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 3>(impl::fieldBytes(typename impl::MakeIndices<K + 3>::type(), key, K - 1, AMQP_FIELD_KIND_I16, static_cast<uint16_t>(value), 2, nullptr, 0));
+}
+
+/**
+ * Encodes an uint16_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 3> encodeField(const char (&key)[K], uint16_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 3>(impl::fieldBytes(typename impl::MakeIndices<K + 3>::type(), key, K - 1, AMQP_FIELD_KIND_U16, value, 2, nullptr, 0));
+}
+
+/**
+ * Encodes an int32_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 5> encodeField(const char (&key)[K], int32_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 5>(impl::fieldBytes(typename impl::MakeIndices<K + 5>::type(), key, K - 1, AMQP_FIELD_KIND_I32, static_cast<uint32_t>(value), 4, nullptr, 0));
+}
+
+/**
+ * Encodes an uint32_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 5> encodeField(const char (&key)[K], uint32_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 5>(impl::fieldBytes(typename impl::MakeIndices<K + 5>::type(), key, K - 1, AMQP_FIELD_KIND_U32, value, 4, nullptr, 0));
+}
+
+/**
+ * Encodes an int64_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 9> encodeField(const char (&key)[K], int64_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 9>(impl::fieldBytes(typename impl::MakeIndices<K + 9>::type(), key, K - 1, AMQP_FIELD_KIND_I64, static_cast<uint64_t>(value), 8, nullptr, 0));
+}
+
+/**
+ * Encodes an uint64_t entry
+ *
+ * @tparam K Size of the key literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K>
+constexpr EncodedField<K + 9> encodeField(const char (&key)[K], uint64_t value) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + 9>(impl::fieldBytes(typename impl::MakeIndices<K + 9>::type(), key, K - 1, AMQP_FIELD_KIND_U64, value, 8, nullptr, 0));
+}
+
+/**
+ * Encodes an UTF-8 string entry (ie: encodeField("x-queue-type", "quorum"))
+ *
+ * @tparam K Size of the key literal
+ * @tparam V Size of the value literal
+ *
+ * @param[in] key Key literal
+ * @param[in] value Value literal
+ *
+ * @return Encoded entry
+ */
+template <std::size_t K, std::size_t V>
+constexpr EncodedField<K + V + 4> encodeField(const char (&key)[K], const char (&value)[V]) noexcept {
+  static_assert(K - 1 <= 255, "Keys are short strings");
+  return EncodedField<K + V + 4>(impl::fieldBytes(typename impl::MakeIndices<K + V + 4>::type(), key, K - 1, AMQP_FIELD_KIND_UTF8, 0, 0, value, V - 1));
+}
+
+/**
+ * Encodes a table
+ *
+ * @tparam Sizes Sizes of the encoded entries
+ *
+ * @param[in] fields Entries created with encodeField
+ *
+ * @return Encoded table (ie: static constexpr auto kArguments = encodeTable(encodeField("x-queue-type", "quorum"));)
+ */
+template <std::size_t... Sizes>
+constexpr EncodedTable<4 + impl::sum(Sizes...), sizeof...(Sizes)> encodeTable(const EncodedField<Sizes>&... fields) noexcept {
+  return EncodedTable<4 + impl::sum(Sizes...), sizeof...(Sizes)>(
+    impl::tableBytes(typename impl::MakeIndices<4 + impl::sum(Sizes...)>::type(), static_cast<const impl::EncodedBytes<Sizes>&>(fields)...));
+}
+
+} // namespace rmqcxx
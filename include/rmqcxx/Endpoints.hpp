@@ -0,0 +1,444 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Address of a broker
+ */
+struct Endpoint {
+  /**
+   * Address of the RMQ broker
+   */
+  std::string address;
+
+  /**
+   * Port of the RMQ broker
+   */
+  int port;
+};
+
+/**
+ * List of brokers (ie: nodes of a cluster) that are raced when connecting
+ *
+ * Attempts are started in order, a new one every stagger interval or as soon as all the started ones failed, the first
+ * one that succeeds wins. The outcome of every attempt is remembered: the endpoint that won last time is tried first
+ * and endpoints that failed recently are put in quarantine and tried last.
+ *
+ * Copies share the remembered state, so a copy captured by a RecoveringConnection factory keeps it across reconnects.
+ * It is safe to use from multiple threads.
+ *
+ * @note Destroying the last copy waits for the attempts that are still running (the ones that lost a race)
+ */
+class Endpoints final {
+public:
+
+  /**
+   * Clock used for the quarantine
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Constructor
+   *
+   * @tparam StaggerDuration std::chrono::duration compatible type
+   * @tparam QuarantineDuration std::chrono::duration compatible type
+   *
+   * @param[in] endpoints Endpoints in the order of preference
+   * @param[in] stagger Delay after which the next endpoint is tried while the previous attempts are still running
+   * @param[in] quarantine Duration for which a failed endpoint is tried after the healthy ones
+   *
+   * @throw Exception When the endpoint list is empty
+   */
+  template <typename StaggerDuration = std::chrono::milliseconds, typename QuarantineDuration = std::chrono::seconds>
+  explicit Endpoints(std::vector<Endpoint> endpoints, StaggerDuration stagger = std::chrono::milliseconds(250), QuarantineDuration quarantine = std::chrono::seconds(30)) :
+    state_(std::make_shared<State>(std::move(endpoints), std::chrono::duration_cast<Clock::duration>(stagger), std::chrono::duration_cast<Clock::duration>(quarantine))) {
+    if (state_->endpoints.empty())
+      throw Exception("No endpoints to connect to!");
+  }
+
+  /**
+   * Number of endpoints
+   * @return Number of endpoints
+   */
+  std::size_t size() const noexcept {
+    return state_->endpoints.size();
+  }
+
+  /**
+   * Endpoint access
+   *
+   * @param[in] index Index of the endpoint in the list given to the constructor
+   *
+   * @return Endpoint
+   */
+  const Endpoint& operator[](std::size_t index) const noexcept {
+    return state_->endpoints[index];
+  }
+
+  /**
+   * Order in which the endpoints are tried
+   *
+   * @return Indexes of the endpoints, the last winner first, then the healthy ones in the order of preference and
+   * then the quarantined ones, the ones that failed longest ago first
+   */
+  std::vector<std::size_t> order() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    const auto now = Clock::now();
+    std::vector<std::size_t> result(state_->endpoints.size());
+    for (std::size_t i = 0; i < result.size(); ++i)
+      result[i] = i;
+    const auto& health = state_->health;
+    auto quarantined = [&](std::size_t i) {
+      return health[i].failures > 0 && now - health[i].failedAt < state_->quarantine;
+    };
+    const std::size_t winner = state_->winner;
+    std::stable_sort(result.begin(), result.end(), [&](std::size_t a, std::size_t b) {
+      const bool qa = quarantined(a), qb = quarantined(b);
+      if (qa != qb)
+        return qb;
+      if (qa)
+        return health[a].failedAt < health[b].failedAt;
+      return a == winner && b != winner;
+    });
+    return result;
+  }
+
+  /**
+   * Checks if an endpoint is in quarantine
+   *
+   * @param[in] index Index of the endpoint
+   *
+   * @return True if the last attempt on the endpoint failed within the quarantine duration
+   */
+  bool quarantined(std::size_t index) const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    const auto& health = state_->health[index];
+    return health.failures > 0 && Clock::now() - health.failedAt < state_->quarantine;
+  }
+
+  /**
+   * Number of consecutive failed attempts on an endpoint
+   *
+   * @param[in] index Index of the endpoint
+   *
+   * @return Number of failed attempts since the last successful one
+   */
+  std::size_t failures(std::size_t index) const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->health[index].failures;
+  }
+
+  /**
+   * Records a successful attempt, the endpoint is tried first the next time
+   *
+   * @param[in] index Index of the endpoint
+   */
+  void succeeded(std::size_t index) {
+    state_->succeeded(index, true);
+  }
+
+  /**
+   * Records a failed attempt, the endpoint goes into quarantine
+   *
+   * @param[in] index Index of the endpoint
+   */
+  void failed(std::size_t index) {
+    state_->failed(index);
+  }
+
+  /**
+   * Races connection attempts on the endpoints
+   *
+   * Every attempt runs on its own thread. Once an attempt wins, the call returns without waiting for the others, they
+   * finish in the background and their results are destroyed on their threads. The threads are joined by the next
+   * connect call once they finished, and by the destructor of the last copy of the list.
+   *
+   * @tparam Result Movable type of the attempt result (ie: Connection)
+   *
+   * @param[in] attempt Makes a connection to an endpoint, has to own everything it uses as it may outlive the call
+   *
+   * @return Result of the first successful attempt
+   *
+   * @throw Whatever the attempt on the most preferred endpoint threw when all attempts fail
+   */
+  template <typename Result>
+  Result connect(std::function<Result(const Endpoint&)> attempt) const {
+    State* state = state_.get(); // the destructor of the state joins the attempts, they don't keep it alive
+    state->reap();
+    auto race = std::make_shared<Race<Result>>();
+    const auto& order = this->order();
+    race->errors.resize(order.size());
+    std::unique_lock<std::mutex> lock(race->mutex);
+    std::size_t started = 0;
+    for (auto index : order) {
+      const std::size_t position = started++;
+      auto finished = std::make_shared<std::atomic<bool>>(false);
+      state->spawn(std::thread([state, race, attempt, index, position, finished]() mutable {
+        std::unique_ptr<Result> result;
+        try {
+          result.reset(new Result(attempt(state->endpoints[index])));
+        } catch(...) {
+          state->failed(index);
+          std::lock_guard<std::mutex> lock(race->mutex);
+          race->errors[position] = std::current_exception();
+          ++race->failed;
+          race->done.notify_all();
+          *finished = true;
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> lock(race->mutex);
+          const bool won = !race->decided;
+          state->succeeded(index, won); // a loser that logged in is healthy, but it is not tried first next time
+          if (won) {
+            race->decided = true;
+            race->winner.swap(result);
+          }
+          race->done.notify_all();
+        }
+        result.reset(); // a losing result is destroyed here, outside of the lock
+        *finished = true;
+      }), finished);
+      race->done.wait_for(lock, state_->stagger, [&]() { return race->winner || race->failed == started; });
+      if (race->winner)
+        break;
+    }
+    race->done.wait(lock, [&]() { return race->winner || race->failed == started; });
+    if (!race->winner)
+      std::rethrow_exception(race->errors.front());
+    std::unique_ptr<Result> winner;
+    winner.swap(race->winner);
+    lock.unlock();
+    return std::move(*winner);
+  }
+
+private:
+
+  /**
+   * Remembered outcome of the attempts on an endpoint
+   */
+  struct Health {
+    /**
+     * Constructor
+     */
+    Health() noexcept : failures(0), failedAt() {}
+
+    /**
+     * Number of consecutive failed attempts
+     */
+    std::size_t failures;
+
+    /**
+     * Point in time of the last failed attempt
+     */
+    Clock::time_point failedAt;
+  };
+
+  /**
+   * State shared by the copies
+   */
+  struct State {
+    /**
+     * Constructor
+     *
+     * @param[in] endpoints Endpoints in the order of preference
+     * @param[in] stagger Delay between starting attempts
+     * @param[in] quarantine Duration of the quarantine
+     */
+    State(std::vector<Endpoint> endpoints, Clock::duration stagger, Clock::duration quarantine) :
+      endpoints(std::move(endpoints)), stagger(stagger), quarantine(quarantine), health(this->endpoints.size()), winner(this->endpoints.size()) {}
+
+    /**
+     * Destructor, waits for the attempts that are still running
+     */
+    ~State() noexcept {
+      for (auto& x : attempts)
+        x.first.join();
+    }
+
+    /**
+     * Records a successful attempt
+     *
+     * @param[in] index Index of the endpoint
+     * @param[in] won Set if the attempt won its race, the endpoint is then tried first the next time
+     */
+    void succeeded(std::size_t index, bool won) {
+      std::lock_guard<std::mutex> lock(mutex);
+      health[index].failures = 0;
+      if (won)
+        winner = index;
+    }
+
+    /**
+     * Records a failed attempt
+     *
+     * @param[in] index Index of the endpoint
+     */
+    void failed(std::size_t index) {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++health[index].failures;
+      health[index].failedAt = Clock::now();
+      if (winner == index)
+        winner = endpoints.size();
+    }
+
+    /**
+     * Keeps the thread of an attempt until it is joined
+     *
+     * @param[in] thread Attempt thread
+     * @param[in] finished Set by the thread once it does not touch the state anymore
+     */
+    void spawn(std::thread thread, std::shared_ptr<std::atomic<bool>> finished) {
+      std::lock_guard<std::mutex> lock(attemptsMutex);
+      attempts.emplace_back(std::move(thread), std::move(finished));
+    }
+
+    /**
+     * Joins the attempt threads that finished
+     */
+    void reap() {
+      std::lock_guard<std::mutex> lock(attemptsMutex);
+      for (auto it = attempts.begin(); it != attempts.end();) {
+        if (!*it->second) {
+          ++it;
+          continue;
+        }
+        it->first.join();
+        it = attempts.erase(it);
+      }
+    }
+
+    /**
+     * Endpoints, immutable
+     */
+    const std::vector<Endpoint> endpoints;
+
+    /**
+     * Delay between starting attempts
+     */
+    const Clock::duration stagger;
+
+    /**
+     * Duration of the quarantine
+     */
+    const Clock::duration quarantine;
+
+    /**
+     * Guards health and winner
+     */
+    std::mutex mutex;
+
+    /**
+     * Health of every endpoint
+     */
+    std::vector<Health> health;
+
+    /**
+     * Index of the last winner, endpoints.size() if none
+     */
+    std::size_t winner;
+
+    /**
+     * Guards attempts
+     */
+    std::mutex attemptsMutex;
+
+    /**
+     * Attempt threads that were not joined yet and their finished flags
+     */
+    std::vector<std::pair<std::thread, std::shared_ptr<std::atomic<bool>>>> attempts;
+  };
+
+  /**
+   * State of a single connect call shared with the attempts
+   *
+   * @tparam Result Type of the attempt result
+   */
+  template <typename Result>
+  struct Race {
+    /**
+     * Constructor
+     */
+    Race() : failed(0), decided(false) {}
+
+    /**
+     * Guards the race
+     */
+    std::mutex mutex;
+
+    /**
+     * Signalled when an attempt finishes
+     */
+    std::condition_variable done;
+
+    /**
+     * Result of the first successful attempt
+     */
+    std::unique_ptr<Result> winner;
+
+    /**
+     * Errors of the failed attempts in the order they were started
+     */
+    std::vector<std::exception_ptr> errors;
+
+    /**
+     * Number of failed attempts
+     */
+    std::size_t failed;
+
+    /**
+     * Set once an attempt won, the winner may already have been taken by the caller
+     */
+    bool decided;
+  };
+
+  /**
+   * Shared state
+   */
+  std::shared_ptr<State> state_;
+};
+
+} // namespace rmqcxx
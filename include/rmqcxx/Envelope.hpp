@@ -27,9 +27,13 @@ SOFTWARE.
 
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include <amqp.h>
 
 #include "AMQPStruct.hpp"
+#include "TableView.hpp"
 
 namespace rmqcxx {
 
@@ -45,11 +49,19 @@ public:
    */
   explicit Envelope(::amqp_envelope_t v = ::amqp_envelope_t()) noexcept : AMQPStruct<::amqp_envelope_t>(std::move(v)) {};
 
+  /**
+   * Constructs an envelope that references memory it does not own (zero-copy consuming)
+   *
+   * @param v AMQP envelope, not destroyed by this object
+   * @param lease Keeps the referenced memory alive as long as the envelope exists
+   */
+  Envelope(::amqp_envelope_t v, std::shared_ptr<void> lease) noexcept : AMQPStruct<::amqp_envelope_t>(std::move(v)), lease_(std::move(lease)) {}
+
   /**
    * Destructor
    */
   ~Envelope() noexcept {
-    if (!moved_)
+    if (!moved_ && !lease_)
       ::amqp_destroy_envelope(&memory_);
   }
 
@@ -81,6 +93,43 @@ public:
     const auto& b = static_cast<::amqp_envelope_t>(memory_).message.body;
     return std::string(static_cast<const char*>(b.bytes), b.len);
   }
+
+  /**
+   * Headers of the message
+   *
+   * The view is kept with the message, so the index of a large table is built by the first lookup only
+   *
+   * @return View of the headers, an empty view if the message has none
+   *
+   * @note Shares the lazily built index, the headers must not be looked up from several threads without synchronization
+   */
+  const TableView& headers() const noexcept {
+    const auto& properties = static_cast<const ::amqp_envelope_t&>(memory_).message.properties;
+    const ::amqp_table_t table = 0 != (properties._flags & AMQP_BASIC_HEADERS_FLAG) ? properties.headers : ::amqp_table_t{0, nullptr};
+    if (!headers_.references(table))
+      headers_ = TableView(table); // the content was set after construction
+    return headers_;
+  }
+
+  /**
+   * Checks if the envelope references buffers of the connection instead of owning its memory
+   * @return True if the envelope was consumed without copying
+   */
+  bool borrowed() const noexcept {
+    return static_cast<bool>(lease_);
+  }
+
+private:
+
+  /**
+   * Keeps borrowed memory alive, empty if the envelope owns its memory
+   */
+  std::shared_ptr<void> lease_;
+
+  /**
+   * View of the headers, rebound when it no longer references the headers of the message
+   */
+  mutable TableView headers_;
 };
 
 } // namespace rmqcxx
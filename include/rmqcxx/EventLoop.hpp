@@ -0,0 +1,644 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "Connection.hpp"
+#include "ConsumerCancel.hpp"
+#include "Envelope.hpp"
+#include "Exceptions.hpp"
+#include "ReturnedMessage.hpp"
+#include "TimingWheel.hpp"
+
+namespace rmqcxx {
+
+/**
+ * epoll based reactor that serves many connections from a single thread
+ *
+ * The socket of every registered connection is watched for readiness and the connection is consumed with a zero
+ * timeout only when there is something to read (or when data is still buffered by the library). Heartbeats of all
+ * connections and user timers are driven from the same timing wheel, so idle connections cost no CPU apart from a
+ * wakeup per heartbeat interval.
+ *
+ * The loop only uses the reactor hooks of Connection (fd, interest, onReadable, onWritable, nextTimeout and
+ * onTimeout), an application with its own event loop can drive connections the same way.
+ *
+ * @note Only stop() may be called from another thread, everything else has to be called from the thread running the loop
+ * @note Linux only
+ */
+class EventLoop final {
+public:
+
+  /**
+   * Clock used by the loop
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Timer callback
+   */
+  using Timer = std::function<void()>;
+
+  /**
+   * Callbacks of a registered connection, empty callbacks are ignored
+   */
+  struct Handlers {
+    /**
+     * Called for every received envelope
+     */
+    std::function<void(Envelope)> envelope;
+
+    /**
+     * Called for every returned message
+     */
+    std::function<void(ReturnedMessage)> returnedMessage;
+
+    /**
+     * Called for every publisher confirm
+     */
+    std::function<void(const ::amqp_basic_ack_t&)> acknowledge;
+
+    /**
+     * Called for every consumer cancellation, if empty a cancellation by the broker is reported as an error
+     */
+    std::function<void(ConsumerCancel)> cancel;
+
+    /**
+     * Called when consuming fails, if empty the exception propagates from the loop
+     *
+     * The connection is removed from the loop before this is called unless the error was a channel close or a
+     * consumer cancellation (which leave the connection usable)
+     */
+    std::function<void(Connection&, std::exception_ptr)> error;
+  };
+
+  /**
+   * Constructor
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] resolution Timer resolution
+   * @param[in] budget Maximum number of frames consumed from a single connection per wakeup (fairness between connections)
+   *
+   * @throw Exception When epoll or the wakeup descriptor can't be created
+   */
+  template <typename Duration = std::chrono::milliseconds>
+  explicit EventLoop(Duration resolution = Duration(1), std::size_t budget = 64) :
+    epoll_(::epoll_create1(EPOLL_CLOEXEC)),
+    wake_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+    budget_(budget == 0 ? 1 : budget),
+    timers_(resolution),
+    events_(64),
+    stopped_(false) {
+    if (epoll_ < 0 || wake_ < 0) {
+      const auto& error = std::string(std::strerror(errno));
+      closeDescriptors();
+      throw Exception("EventLoop: Failed to create descriptors: " + error);
+    }
+    ::epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_;
+    if (0 != ::epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &ev)) {
+      const auto& error = std::string(std::strerror(errno));
+      closeDescriptors();
+      throw Exception("EventLoop: Failed to register wakeup descriptor: " + error);
+    }
+  }
+
+  /**
+   * Destructor
+   */
+  ~EventLoop() noexcept {
+    closeDescriptors();
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  EventLoop(const EventLoop&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  EventLoop(EventLoop&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  EventLoop& operator=(EventLoop&&) = delete;
+
+  /**
+   * Registers a connection
+   *
+   * @param[in] connection Connection to serve, has to outlive its registration
+   * @param[in] handlers Callbacks for the connection
+   *
+   * @throw Exception When the connection has no socket or it can't be registered with epoll
+   */
+  void add(Connection& connection, Handlers handlers) {
+    const int fd = connection.fd();
+    if (fd < 0)
+      throw Exception("EventLoop: Connection has no socket!");
+    std::shared_ptr<Entry> entry(new Entry{fd, &connection, std::move(handlers), connection.interest()});
+    ::epoll_event ev{};
+    ev.events = events(entry->interest);
+    ev.data.fd = fd;
+    if (0 != ::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev))
+      throw Exception(std::string("EventLoop: Failed to register connection: ") + std::strerror(errno));
+    connections_[fd] = entry;
+    scheduleTimeout(entry);
+    if (connection.buffered())
+      ready_.push_back(fd);
+  }
+
+  /**
+   * Unregisters a connection
+   *
+   * @param[in] connection Connection to remove
+   *
+   * @return True if the connection was registered
+   *
+   * @note May be called from the connection callbacks
+   */
+  bool remove(const Connection& connection) noexcept {
+    for (const auto& x : connections_) {
+      if (x.second->connection == &connection) {
+        unregister(x.second);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Schedules a timer
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] delay Delay after which the timer is called, rounded up to the loop resolution
+   * @param[in] timer Timer callback
+   */
+  template <typename Duration>
+  void after(Duration delay, Timer timer) {
+    schedule(std::chrono::duration_cast<Clock::duration>(delay), std::move(timer));
+  }
+
+  /**
+   * Waits for events at most for the given duration and dispatches them
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] timeout Maximum duration to wait for events
+   *
+   * @return Number of consumed frames and expired timers, 0 if the timeout elapsed or stop was requested
+   *
+   * @throw Exception When waiting for events fails
+   * @throw Whatever the callbacks throw and consuming errors of connections without an error callback
+   */
+  template <typename Duration>
+  std::size_t runOnce(Duration timeout) {
+    const auto& deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout);
+    std::size_t dispatched;
+    do {
+      dispatched = poll(deadline); // internal wakeups (timer cascades) dispatch nothing
+    } while (0 == dispatched && !stopped_.exchange(false) && Clock::now() < deadline);
+    return dispatched;
+  }
+
+  /**
+   * Dispatches events until stop is called
+   *
+   * @throw Exception When waiting for events fails
+   * @throw Whatever the callbacks throw and consuming errors of connections without an error callback
+   *
+   * @note If stop was called before run, run returns immediately (the stop request is consumed)
+   */
+  void run() {
+    while (!stopped_.exchange(false))
+      poll(Clock::time_point::max());
+  }
+
+  /**
+   * Interrupts run or runOnce, can be called from any thread
+   */
+  void stop() noexcept {
+    stopped_ = true;
+    const uint64_t one = 1;
+    const auto r = ::write(wake_, &one, sizeof(one));
+    (void)r; // a full counter already wakes the loop
+  }
+
+  /**
+   * Number of registered connections
+   * @return Number of registered connections
+   */
+  std::size_t size() const noexcept {
+    return connections_.size();
+  }
+
+private:
+
+  /**
+   * Registered connection
+   */
+  struct Entry {
+    /**
+     * Socket descriptor of the connection
+     */
+    int fd;
+
+    /**
+     * Connection
+     */
+    Connection* connection;
+
+    /**
+     * Connection callbacks
+     */
+    Handlers handlers;
+
+    /**
+     * Interest the descriptor is registered with
+     */
+    Connection::Interest interest;
+  };
+
+  /**
+   * Closes the epoll and wakeup descriptors
+   */
+  void closeDescriptors() noexcept {
+    if (epoll_ >= 0)
+      ::close(epoll_);
+    if (wake_ >= 0)
+      ::close(wake_);
+    epoll_ = wake_ = -1;
+  }
+
+  /**
+   * Schedules a timer relative to the current time
+   *
+   * @param[in] delay Delay after which the timer is called
+   * @param[in] timer Timer callback
+   */
+  void schedule(Clock::duration delay, Timer timer) {
+    timers_.schedule(delay, std::move(timer), Clock::now());
+  }
+
+  /**
+   * Waits for events until a deadline and dispatches them
+   *
+   * @param[in] deadline Latest point in time to wait until
+   *
+   * @return Number of consumed frames and expired timers
+   */
+  std::size_t poll(Clock::time_point deadline) {
+    int timeout = 0;
+    if (ready_.empty()) {
+      const auto& now = Clock::now();
+      const auto& wake = std::min(deadline, timers_.nextExpiry());
+      if (Clock::time_point::max() == wake) {
+        timeout = -1;
+      } else if (wake > now) {
+        // round up, waking up early would spin until the deadline
+        const auto& left = std::chrono::duration_cast<std::chrono::milliseconds>(wake - now + std::chrono::milliseconds(1) - Clock::duration(1)).count();
+        timeout = left > INT_MAX ? INT_MAX : static_cast<int>(left);
+      }
+    }
+    const int n = ::epoll_wait(epoll_, events_.data(), static_cast<int>(events_.size()), timeout);
+    if (n < 0 && EINTR != errno)
+      throw Exception(std::string("EventLoop: Failed to wait for events: ") + std::strerror(errno));
+
+    std::size_t dispatched = 0;
+    pending_.swap(ready_);
+    try {
+      for (int i = 0; i < n; ++i) {
+        const int fd = events_[i].data.fd;
+        if (wake_ == fd) {
+          uint64_t counter;
+          const auto r = ::read(wake_, &counter, sizeof(counter));
+          (void)r;
+          continue;
+        }
+        auto it = connections_.find(fd);
+        if (connections_.end() == it)
+          continue;
+        auto entry = it->second;
+        if (events_[i].events & EPOLLOUT)
+          entry->connection->onWritable();
+        if (events_[i].events & ~uint32_t(EPOLLOUT))
+          dispatched += service(entry);
+        updateInterest(entry);
+      }
+      for (const int fd : pending_) {
+        auto it = connections_.find(fd);
+        if (connections_.end() != it && it->second->connection->buffered())
+          dispatched += service(it->second);
+      }
+    } catch(...) {
+      // keep the connections that still have buffered data for the next round
+      ready_.insert(ready_.end(), pending_.begin(), pending_.end());
+      pending_.clear();
+      throw;
+    }
+    pending_.clear();
+    dispatched += timers_.advance(Clock::now(), [] (Timer timer) { timer(); });
+    return dispatched;
+  }
+
+  /**
+   * Services a connection through its reactor hooks
+   *
+   * @param[in] entry Registered connection
+   * @param[in] timeout If set the heartbeat is serviced (onTimeout), otherwise the readable data is processed (onReadable)
+   *
+   * @return Number of consumed frames
+   */
+  std::size_t service(std::shared_ptr<Entry> entry, bool timeout = false) {
+    std::size_t consumed = 0;
+    try {
+      consumed = process(*entry, timeout);
+    } catch(const ChannelCloseException&) {
+      failed(entry, false);
+      return consumed;
+    } catch(const ConsumerCancelException&) {
+      failed(entry, false);
+      return consumed;
+    } catch(const ConnectionException&) {
+      failed(entry, true);
+      return consumed;
+    } catch(...) {
+      requeue(entry);
+      throw;
+    }
+    requeue(entry);
+    return consumed;
+  }
+
+  /**
+   * Forwards the consumed frames to the handlers of a connection, empty handlers are skipped
+   */
+  struct Dispatch {
+    /**
+     * Handlers of the connection
+     */
+    Handlers& handlers;
+
+    /**
+     * Forwards an envelope
+     * @param[in] envelope Envelope
+     */
+    void operator()(Envelope envelope) const {
+      if (handlers.envelope)
+        handlers.envelope(std::move(envelope));
+    }
+
+    /**
+     * Forwards a returned message
+     * @param[in] message Returned message
+     */
+    void operator()(ReturnedMessage message) const {
+      if (handlers.returnedMessage)
+        handlers.returnedMessage(std::move(message));
+    }
+
+    /**
+     * Forwards a publisher confirm
+     * @param[in] ack Publisher confirm
+     */
+    void operator()(const ::amqp_basic_ack_t& ack) const {
+      if (handlers.acknowledge)
+        handlers.acknowledge(ack);
+    }
+  };
+
+  /**
+   * Calls the reactor hook of a connection
+   *
+   * @param[in] entry Registered connection
+   * @param[in] timeout If set onTimeout is called, otherwise onReadable
+   *
+   * @return Number of consumed frames
+   */
+  std::size_t process(Entry& entry, bool timeout) {
+    const Dispatch dispatch{entry.handlers};
+    if (entry.handlers.cancel) {
+      const auto& cancel = std::ref(entry.handlers.cancel);
+      return timeout ?
+        (entry.connection->onTimeout(dispatch, dispatch, dispatch, cancel) ? 1 : 0) :
+        entry.connection->onReadable(budget_, dispatch, dispatch, dispatch, cancel);
+    }
+    return timeout ?
+      (entry.connection->onTimeout(dispatch, dispatch, dispatch, nullptr) ? 1 : 0) :
+      entry.connection->onReadable(budget_, dispatch, dispatch, dispatch, nullptr);
+  }
+
+  /**
+   * Reports a consuming error, must be called from a catch block
+   *
+   * @param[in] entry Registered connection
+   * @param[in] fatal If set the connection is removed from the loop
+   *
+   * @throw The exception being handled if there is no error callback
+   */
+  void failed(const std::shared_ptr<Entry>& entry, bool fatal) {
+    if (fatal)
+      unregister(entry);
+    else
+      requeue(entry);
+    if (!entry->handlers.error)
+      throw;
+    entry->handlers.error(*entry->connection, std::current_exception());
+  }
+
+  /**
+   * Marks a connection for servicing in the next round if it still has buffered data
+   *
+   * @param[in] entry Registered connection
+   */
+  void requeue(const std::shared_ptr<Entry>& entry) {
+    if (registered(entry) && entry->connection->buffered())
+      ready_.push_back(entry->fd);
+  }
+
+  /**
+   * Checks if an entry is still registered
+   *
+   * @param[in] entry Entry to check
+   *
+   * @return True if registered
+   */
+  bool registered(const std::shared_ptr<Entry>& entry) const noexcept {
+    auto it = connections_.find(entry->fd);
+    return connections_.end() != it && it->second == entry;
+  }
+
+  /**
+   * Removes an entry from epoll and from the registry
+   *
+   * @param[in] entry Entry to remove
+   */
+  void unregister(std::shared_ptr<Entry> entry) noexcept {
+    ::epoll_event ev{};
+    ::epoll_ctl(epoll_, EPOLL_CTL_DEL, entry->fd, &ev); // fails if the socket was already closed, nothing to do then
+    connections_.erase(entry->fd);
+  }
+
+  /**
+   * Converts a connection interest to epoll events
+   *
+   * @param[in] interest Connection interest
+   *
+   * @return epoll events
+   */
+  static uint32_t events(Connection::Interest interest) noexcept {
+    switch(interest) {
+      case Connection::Interest::Read:
+        return EPOLLIN;
+      case Connection::Interest::Write:
+        return EPOLLOUT;
+      case Connection::Interest::ReadWrite:
+        return EPOLLIN | EPOLLOUT;
+      default:
+        return 0;
+    }
+  }
+
+  /**
+   * Updates the epoll registration if the interest of a connection changed
+   *
+   * @param[in] entry Registered connection
+   */
+  void updateInterest(const std::shared_ptr<Entry>& entry) noexcept {
+    if (!registered(entry))
+      return;
+    const auto& interest = entry->connection->interest();
+    if (interest == entry->interest)
+      return;
+    ::epoll_event ev{};
+    ev.events = events(interest);
+    ev.data.fd = entry->fd;
+    if (0 == ::epoll_ctl(epoll_, EPOLL_CTL_MOD, entry->fd, &ev))
+      entry->interest = interest;
+  }
+
+  /**
+   * Schedules the heartbeat servicing of a connection when its nextTimeout elapses
+   *
+   * @param[in] entry Registered connection
+   */
+  void scheduleTimeout(const std::shared_ptr<Entry>& entry) {
+    const auto& delay = entry->connection->nextTimeout();
+    if (std::chrono::milliseconds::max() == delay)
+      return;
+    std::weak_ptr<Entry> weak(entry);
+    schedule(delay, [this, weak] () {
+      auto entry = weak.lock();
+      if (!entry || !registered(entry))
+        return;
+      if (std::chrono::milliseconds::zero() == entry->connection->nextTimeout()) {
+        try {
+          service(entry, true);
+        } catch(...) {
+          if (registered(entry))
+            scheduleTimeout(entry); // a throwing callback must not stop the heartbeats
+          throw;
+        }
+      }
+      if (registered(entry))
+        scheduleTimeout(entry);
+    });
+  }
+
+  /**
+   * epoll descriptor
+   */
+  int epoll_;
+
+  /**
+   * Descriptor used to wake up the loop from stop
+   */
+  int wake_;
+
+  /**
+   * Maximum number of frames consumed from a single connection per wakeup
+   */
+  std::size_t budget_;
+
+  /**
+   * User timers and heartbeat servicing
+   */
+  TimingWheel<Timer> timers_;
+
+  /**
+   * Registered connections by socket descriptor
+   */
+  std::unordered_map<int, std::shared_ptr<Entry>> connections_;
+
+  /**
+   * Connections with buffered data that have to be serviced without waiting for readiness
+   */
+  std::vector<int> ready_;
+
+  /**
+   * Connections with buffered data that are serviced in the current round
+   */
+  std::vector<int> pending_;
+
+  /**
+   * Storage for the events returned by epoll
+   */
+  std::vector<::epoll_event> events_;
+
+  /**
+   * Stop request flag
+   */
+  std::atomic<bool> stopped_;
+};
+
+} // namespace rmqcxx
@@ -27,7 +27,9 @@ SOFTWARE.
 
 #pragma once
 
+#include <cstddef>
 #include <stdexcept>
+#include <string>
 
 #include <amqp.h>
 
@@ -169,6 +171,33 @@ namespace rmqcxx {
       const ::amqp_frame_t frame;
   };
 
+  /**
+   * Consumer cancelled by the broker (basic.cancel) while no cancel callback was given to the consumer
+   */
+  struct ConsumerCancelException : public FrameException {
+    /**
+     * Constructor
+     *
+     * @param[in] connection Reference to the connection object
+     * @param[in] reply RPC reply object
+     * @param[in] frame Frame
+     * @param[in] consumerTag Tag of the cancelled consumer
+     * @param[in] reason Reason for throwing this exception
+     */
+    ConsumerCancelException(const Connection& connection, ::amqp_rpc_reply_t reply, ::amqp_frame_t frame, std::string consumerTag, std::string reason) noexcept :
+      FrameException(connection, reply, frame, std::move(reason) + " Consumer tag: " + consumerTag), channel(frame.channel), consumerTag(std::move(consumerTag)) {}
+
+    /**
+     * Channel id storage
+     */
+    ::amqp_channel_t channel;
+
+    /**
+     * Consumer tag storage
+     */
+    std::string consumerTag;
+  };
+
   /**
    * Channel closed received from the broker
    */
@@ -182,12 +211,65 @@ namespace rmqcxx {
      * @param[in] reason Reason for throwing this exception
      */
     ChannelCloseException(const Connection& connection, ::amqp_channel_t channel, const ::amqp_channel_close_t* decoded, std::string reason) noexcept :
-      ConnectionException(connection, std::move(reason) + ' ' + decodeAmqpMethod(decoded)), channel(channel) {}
+      ConnectionException(connection, std::move(reason) + ' ' + decodeAmqpMethod(decoded)),
+      channel(channel),
+      replyCode(nullptr == decoded ? 0 : decoded->reply_code),
+      method(nullptr == decoded ? 0 : (static_cast<::amqp_method_number_t>(decoded->class_id) << 16) | decoded->method_id),
+      replyText(nullptr == decoded ? std::string() : std::string(static_cast<const char*>(decoded->reply_text.bytes), decoded->reply_text.len)) {}
+
+    /**
+     * Constructs an exception for the same channel close with a different reason
+     *
+     * @param[in] cause Exception to take the channel close from
+     * @param[in] reason Reason for throwing this exception
+     */
+    ChannelCloseException(const ChannelCloseException& cause, std::string reason) noexcept :
+      ConnectionException(cause.connection, std::move(reason)), channel(cause.channel), replyCode(cause.replyCode), method(cause.method), replyText(cause.replyText) {}
 
     /**
       * Channel id storage
      */
     ::amqp_channel_t channel;
+
+    /**
+     * Reply code sent by the broker (ie: 404 for NOT_FOUND)
+     */
+    uint16_t replyCode;
+
+    /**
+     * Method that caused the channel to be closed (ie: AMQP_QUEUE_BIND_METHOD), 0 if unknown
+     */
+    ::amqp_method_number_t method;
+
+    /**
+     * Reply text sent by the broker
+     */
+    std::string replyText;
+  };
+
+  /**
+   * Channel closed by the broker because of a declaration that was sent without waiting for the reply
+   */
+  struct DeclarationException : public ChannelCloseException {
+    /**
+     * Constructor
+     *
+     * @param[in] cause Channel close received while waiting for the declarations to complete
+     * @param[in] index Position of the rejected declaration in the batch
+     * @param[in] declaration Description of the rejected declaration
+     */
+    DeclarationException(const ChannelCloseException& cause, std::size_t index, std::string declaration) noexcept :
+      ChannelCloseException(cause, "Declaration #" + std::to_string(index) + " rejected: " + declaration + ". " + cause.what()), index(index), declaration(std::move(declaration)) {}
+
+    /**
+     * Position of the rejected declaration, the ones before it were applied and the ones after it were dropped
+     */
+    std::size_t index;
+
+    /**
+     * Description of the rejected declaration
+     */
+    std::string declaration;
   };
 
   /**
@@ -205,6 +287,43 @@ namespace rmqcxx {
       ConnectionException(connection, std::move(reason) + ' ' + decodeAmqpMethod(decoded)) {}
   };
 
+  /**
+   * Failure to connect that happened before there was a connection object (AsyncConnector)
+   */
+  struct ConnectException : public Exception {
+    /**
+     * Constructor
+     *
+     * @param[in] address Address of the RMQ broker
+     * @param[in] port Port of the RMQ broker
+     * @param[in] status Status describing the failure (ie: AMQP_STATUS_TIMEOUT)
+     * @param[in] replyCode Reply code of the connection.close sent by the broker (ie: 403 for ACCESS_REFUSED), 0 if none
+     * @param[in] reason Reason for throwing this exception
+     */
+    ConnectException(std::string address, int port, ::amqp_status_enum status, uint16_t replyCode, std::string reason) :
+      Exception(address + ':' + std::to_string(port) + ": " + std::move(reason)), address(std::move(address)), port(port), status(status), replyCode(replyCode) {}
+
+    /**
+     * Address of the RMQ broker
+     */
+    std::string address;
+
+    /**
+     * Port of the RMQ broker
+     */
+    int port;
+
+    /**
+     * Status describing the failure
+     */
+    ::amqp_status_enum status;
+
+    /**
+     * Reply code of the connection.close sent by the broker, 0 if the broker did not close the connection
+     */
+    uint16_t replyCode;
+  };
+
   /**
    * AMQP Library exception
    */
@@ -28,6 +28,7 @@ SOFTWARE.
 #pragma once
 
 #include "Channel.hpp"
+#include "MethodEncoder.hpp"
 
 namespace rmqcxx {
 
@@ -93,7 +94,7 @@ public:
   /**
    * Declares an exchange on the broker
    *
-   * @tparam Args TableEntry types
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
    *
    * @param[in] type Type of the exchange
    * @param[in] passive Does not create an excange will check if an exchange with the same name exists
@@ -108,14 +109,50 @@ public:
    */
   template <typename... Args>
   void declare(const std::string& type, bool passive, bool durable, bool autoDelete, Args&&... args) {
-    Table arguments(std::forward<Args>(args)...);
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
     rpc(::amqp_exchange_declare, bytes(type), passive, durable, autoDelete, 0, static_cast<::amqp_table_t>(arguments));
+    if (!passive && nullptr != topology())
+      topology()->exchangeDeclared(name_, type, durable, autoDelete, arguments);
+  }
+
+  /**
+   * Declares an exchange on the broker without waiting for the broker to confirm it
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   *
+   * @param[in] type Type of the exchange
+   * @param[in] durable If set to true will persist after server reboots
+   * @param[in] autoDelete If set tells the server to delete the exchange after all queues are done using it
+   * @param[in] args Extra paramters associated with this exchange
+   *
+   * @throw ChannelException When the declaration can't be sent
+   * @throw SocketException When writing to the socket fails (native encoding)
+   *
+   * @note A rejected declaration closes the channel, the next RPC on the channel throws ChannelCloseException
+   * @note With native encoding (Connection::nativeEncoding) an EncodedTable is spliced into the frame as it is
+   */
+  template <typename... Args>
+  void declareNoWait(const std::string& type, bool durable, bool autoDelete, Args&&... args) {
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    const ::amqp_bytes_t encoded = impl::encoded(arguments);
+    if (nullptr != encoded.bytes && channel_.connection_.nativeEncoding()) {
+      const auto name = bytes(name_);
+      const auto kind = bytes(type);
+      channel_.sendEncoded(AMQP_EXCHANGE_DECLARE_METHOD, [&] (WireWriter& out, ::amqp_channel_t channel) {
+        MethodEncoder::exchangeDeclare(out, channel, name, kind, false, durable, autoDelete, false, true, encoded);
+      });
+    } else {
+      ::amqp_exchange_declare_t method{0, bytes(name_), bytes(type), false, durable, autoDelete, false, true, arguments};
+      channel_.send(AMQP_EXCHANGE_DECLARE_METHOD, &method);
+    }
+    if (nullptr != topology())
+      topology()->exchangeDeclared(name_, type, durable, autoDelete, arguments);
   }
 
   /**
    * Binds this exchange to another exchange
    *
-   * @tparam Args TableEntry types
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
    * @param[in] src Source exchange name
    * @param[in] routingKey Routing key to bind with
    * @param[in] args Any extra parameters for this binding
@@ -127,14 +164,37 @@ public:
    */
   template <typename... Args>
   void bind(const std::string& src, const std::string& routingKey, Args&&... args) {
-    Table arguments(std::forward<Args>(args)...);
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
     rpc(::amqp_exchange_bind, bytes(src), bytes(routingKey), static_cast<::amqp_table_t>(arguments));
+    if (nullptr != topology())
+      topology()->bound(true, name_, src, routingKey, arguments);
+  }
+
+  /**
+   * Binds this exchange to another exchange without waiting for the broker to confirm it
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   * @param[in] src Source exchange name
+   * @param[in] routingKey Routing key to bind with
+   * @param[in] args Any extra parameters for this binding
+   *
+   * @throw ChannelException When the binding can't be sent
+   *
+   * @note A rejected binding closes the channel, the next RPC on the channel throws ChannelCloseException
+   */
+  template <typename... Args>
+  void bindNoWait(const std::string& src, const std::string& routingKey, Args&&... args) {
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    ::amqp_exchange_bind_t method{0, bytes(name_), bytes(src), bytes(routingKey), true, arguments};
+    channel_.send(AMQP_EXCHANGE_BIND_METHOD, &method);
+    if (nullptr != topology())
+      topology()->bound(true, name_, src, routingKey, arguments);
   }
 
   /**
    * Unbinds this exchange from another exchange
    *
-   * @tparam Args TableEntry types
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
    *
    * @param[in] src Source exchange name
    * @param[in] routingKey Routing key to unbind from
@@ -147,8 +207,10 @@ public:
    */
   template <typename... Args>
   void unbind(const std::string& src, const std::string& routingKey, Args&&... args) {
-    Table arguments(std::forward<Args>(args)...);
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
     rpc(::amqp_exchange_unbind, bytes(src), bytes(routingKey), static_cast<::amqp_table_t>(arguments));
+    if (nullptr != topology())
+      topology()->unbound(true, name_, src, routingKey);
   }
 
   /**
@@ -163,6 +225,8 @@ public:
    */
   void remove(bool ifUnused) {
     rpc(::amqp_exchange_delete, ifUnused);
+    if (nullptr != topology())
+      topology()->exchangeDeleted(name_);
   }
 
   /**
@@ -175,6 +239,14 @@ public:
 
 private:
 
+  /**
+   * Topology recorder of the connection
+   * @return Recorder, nullptr if the connection is not recorded
+   */
+  Topology* topology() const noexcept {
+    return channel_.connection_.topology();
+  }
+
   /**
    * Reference to the channel that will be used for RPC
    */
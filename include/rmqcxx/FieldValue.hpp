@@ -27,6 +27,7 @@ SOFTWARE.
 
 #pragma once
 
+#include <cstring>
 #include <string>
 
 #include <amqp.h>
@@ -121,11 +122,11 @@ public:
   FieldValue(const std::string& v, uint8_t kind = AMQP_FIELD_KIND_UTF8) noexcept : cache_{ .kind = kind, .value  = { .bytes = bytes(v) }} {}
 
   /**
-   * Constructs field value from a const char*
+   * Constructs field value from a const char*, the characters are referenced
    * @param[in] v Value
    * @param[in] kind Defaults to UTF-8, can be overriden if needed to AMQP_FIELD_KIND_BYTES
    */
-  FieldValue(const char* v, uint8_t kind = AMQP_FIELD_KIND_UTF8) : FieldValue(std::string(v), kind) {}
+  FieldValue(const char* v, uint8_t kind = AMQP_FIELD_KIND_UTF8) noexcept : cache_{ .kind = kind, .value  = { .bytes = ::amqp_bytes_t{ std::strlen(v), const_cast<char*>(v) } }} {}
 
   /**
    * Constructs field value from 8 bit signed STL container with sequential memory
@@ -144,9 +145,11 @@ public:
 
   /**
    * Constructs field value from a table
+   * @tparam Allocator Allocator of the table
    * @param[in] v Value
    */
-  FieldValue(const Table& v) : FieldValue(static_cast<::amqp_table_t>(v)) {}
+  template <typename Allocator>
+  FieldValue(const BasicTable<Allocator>& v) : FieldValue(static_cast<::amqp_table_t>(v)) {}
 
   /**
    * Constructs field value from 8 bit signed integer
@@ -0,0 +1,284 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "Connection.hpp"
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Services the heartbeats of a connection from a helper thread
+ *
+ * The underlying library only sends heartbeats and notices a missing peer while the application calls into it, a
+ * connection that is only published on or that is left alone during a long computation gets dropped by the broker.
+ * The engine wakes up whenever Connection::nextTimeout elapses (half of the negotiated interval) and calls
+ * Connection::onTimeout, which sends a heartbeat when one is due and fails once nothing was received from the broker
+ * for two intervals.
+ *
+ * The connection is not thread safe, every use of it has to happen while holding lock() (or through use()) for as long
+ * as the engine runs. Frames that arrive while the engine services the connection are passed to the callbacks on the
+ * engine thread, with the lock held: on a connection that consumes, deliveries, returned messages and publisher
+ * confirms can surface there instead of in the application's own consume calls. A frame that has no callback fails the
+ * engine (see check()) instead of being dropped silently.
+ */
+class HeartbeatEngine final {
+public:
+
+  /**
+   * Constructor, starts the engine thread
+   *
+   * @param[in] connection Connection to service, has to outlive the engine
+   * @param[in] envelopeCallback Callback to call (on the engine thread) if an envelope was obtained, nullptr to fail
+   * the engine on a delivery
+   * @param[in] returnedMessageCallback Callback to call (on the engine thread) if a returned message was received,
+   * nullptr to fail the engine on basic.return
+   * @param[in] acknowledgeCallback Callback to call (on the engine thread) if an acknowledgment was received, nullptr to
+   * fail the engine on basic.ack
+   * @param[in] cancelCallback Callback to call if a consumer was cancelled, nullptr to fail on basic.cancel
+   */
+  explicit HeartbeatEngine(
+    Connection& connection,
+    std::function<void(Envelope)> envelopeCallback = nullptr,
+    std::function<void(ReturnedMessage)> returnedMessageCallback = nullptr,
+    std::function<void(::amqp_basic_ack_t)> acknowledgeCallback = nullptr,
+    std::function<void(ConsumerCancel)> cancelCallback = nullptr) :
+      connection_(connection),
+      envelopeCallback_(std::move(envelopeCallback)),
+      returnedMessageCallback_(std::move(returnedMessageCallback)),
+      acknowledgeCallback_(std::move(acknowledgeCallback)),
+      cancelCallback_(std::move(cancelCallback)),
+      stop_(false),
+      beats_(0),
+      thread_(&HeartbeatEngine::run, this) {}
+
+  /**
+   * Destructor, stops the engine thread
+   */
+  ~HeartbeatEngine() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wakeup_.notify_all();
+    thread_.join();
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  HeartbeatEngine(const HeartbeatEngine&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  HeartbeatEngine(HeartbeatEngine&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  HeartbeatEngine& operator=(const HeartbeatEngine&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  HeartbeatEngine& operator=(HeartbeatEngine&&) = delete;
+
+  /**
+   * Locks the connection against the engine thread
+   * @return Lock that has to be held while using the connection
+   */
+  std::unique_lock<std::mutex> lock() {
+    return std::unique_lock<std::mutex>(mutex_);
+  }
+
+  /**
+   * Calls a function with the connection locked against the engine thread
+   *
+   * @tparam Function Callable object that accepts Connection&
+   *
+   * @param[in] f Function to call
+   *
+   * @return Whatever the function returns
+   */
+  template <typename Function>
+  auto use(Function f) -> decltype(f(std::declval<Connection&>())) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return f(connection_);
+  }
+
+  /**
+   * Checks if the engine still services the connection
+   * @return False once servicing failed (dead peer, socket error, ...)
+   */
+  bool alive() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !error_;
+  }
+
+  /**
+   * Rethrows the exception that stopped the engine, if any
+   *
+   * @throw ConnectionException (or a derived exception) that was thrown by Connection::onTimeout
+   */
+  void check() const {
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error = error_;
+    }
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  /**
+   * Number of times the engine serviced the connection
+   * @return Number of Connection::onTimeout calls made by the engine
+   */
+  uint64_t beats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return beats_;
+  }
+
+private:
+
+  /**
+   * Engine thread
+   */
+  void run() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      const auto& timeout = error_ ? std::chrono::milliseconds::max() : connection_.nextTimeout();
+      if (std::chrono::milliseconds::max() == timeout) {
+        wakeup_.wait(lock); // heartbeats are disabled or servicing failed, nothing to do until stopped
+        continue;
+      }
+      if (timeout > std::chrono::milliseconds::zero()) {
+        wakeup_.wait_for(lock, timeout);
+        continue; // the deadline moves when the application services the connection itself
+      }
+      service();
+    }
+  }
+
+  /**
+   * Services the connection once, the lock has to be held
+   */
+  void service() noexcept {
+    ++beats_;
+    try {
+      const auto& envelope = [this] (Envelope e) {
+        if (!envelopeCallback_)
+          throw ConnectionException(connection_, "HeartbeatEngine: Received a delivery without an envelope callback!");
+        envelopeCallback_(std::move(e));
+      };
+      const auto& returned = [this] (ReturnedMessage m) {
+        if (!returnedMessageCallback_)
+          throw ConnectionException(connection_, "HeartbeatEngine: Received a returned message without a returned message callback!");
+        returnedMessageCallback_(std::move(m));
+      };
+      const auto& acknowledge = [this] (::amqp_basic_ack_t ack) {
+        if (!acknowledgeCallback_)
+          throw ConnectionException(connection_, "HeartbeatEngine: Received an acknowledgment without an acknowledge callback!");
+        acknowledgeCallback_(ack);
+      };
+      if (cancelCallback_)
+        connection_.onTimeout(envelope, returned, acknowledge, cancelCallback_);
+      else
+        connection_.onTimeout(envelope, returned, acknowledge, nullptr);
+    } catch(...) {
+      error_ = std::current_exception();
+    }
+  }
+
+  /**
+   * Serviced connection
+   */
+  Connection& connection_;
+
+  /**
+   * Envelope callback
+   */
+  const std::function<void(Envelope)> envelopeCallback_;
+
+  /**
+   * Returned message callback
+   */
+  const std::function<void(ReturnedMessage)> returnedMessageCallback_;
+
+  /**
+   * Acknowledge callback
+   */
+  const std::function<void(::amqp_basic_ack_t)> acknowledgeCallback_;
+
+  /**
+   * Consumer cancel callback
+   */
+  const std::function<void(ConsumerCancel)> cancelCallback_;
+
+  /**
+   * Guards the connection and the engine state
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Wakes the engine thread up when it has to stop
+   */
+  std::condition_variable wakeup_;
+
+  /**
+   * Set when the engine has to stop
+   */
+  bool stop_;
+
+  /**
+   * Number of times the connection was serviced
+   */
+  uint64_t beats_;
+
+  /**
+   * Exception that stopped servicing
+   */
+  std::exception_ptr error_;
+
+  /**
+   * Engine thread, started last
+   */
+  std::thread thread_;
+};
+
+} // namespace rmqcxx
@@ -0,0 +1,118 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+
+#if defined(__has_include)
+#if __cplusplus >= 201703L && __has_include(<memory_resource>)
+#include <memory_resource>
+/**
+ * Defined when std::pmr is available, the memory resource based APIs are only provided then
+ */
+#define RMQCXX_HAS_PMR 1
+#endif
+#endif
+
+namespace rmqcxx {
+
+#ifdef RMQCXX_HAS_PMR
+
+/**
+ * Source of memory for the consume-side buffers (std::pmr::memory_resource)
+ */
+using MemoryResource = std::pmr::memory_resource;
+
+/**
+ * Allocator that takes its memory from a MemoryResource
+ *
+ * @tparam T Allocated type
+ */
+template <typename T>
+using ResourceAllocator = std::pmr::polymorphic_allocator<T>;
+
+/**
+ * Resource used when none is given
+ * @return std::pmr::get_default_resource()
+ */
+inline MemoryResource* defaultResource() noexcept {
+  return std::pmr::get_default_resource();
+}
+
+/**
+ * Creates an allocator for a resource
+ *
+ * @tparam T Allocated type
+ *
+ * @param[in] resource Memory resource
+ *
+ * @return Allocator taking its memory from the resource
+ */
+template <typename T>
+ResourceAllocator<T> resourceAllocator(MemoryResource* resource) noexcept {
+  return ResourceAllocator<T>(resource);
+}
+
+#else
+
+/**
+ * Placeholder when std::pmr is not available, the memory always comes from the global heap
+ */
+class MemoryResource;
+
+/**
+ * Allocator used when std::pmr is not available
+ *
+ * @tparam T Allocated type
+ */
+template <typename T>
+using ResourceAllocator = std::allocator<T>;
+
+/**
+ * Resource used when none is given
+ * @return nullptr, the global heap
+ */
+inline MemoryResource* defaultResource() noexcept {
+  return nullptr;
+}
+
+/**
+ * Creates an allocator, std::allocator ignores the resource
+ *
+ * @tparam T Allocated type
+ *
+ * @return Allocator
+ */
+template <typename T>
+ResourceAllocator<T> resourceAllocator(MemoryResource*) noexcept {
+  return ResourceAllocator<T>();
+}
+
+#endif
+
+} // namespace rmqcxx
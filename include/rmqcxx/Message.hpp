@@ -30,6 +30,7 @@ SOFTWARE.
 #include <amqp.h>
 
 #include "AMQPStruct.hpp"
+#include "TableView.hpp"
 
 namespace rmqcxx {
 
@@ -71,6 +72,29 @@ public:
    */
   Message& operator=(Message&&) noexcept = default;
 
+  /**
+   * Headers of the message
+   *
+   * The view is kept with the message, so the index of a large table is built by the first lookup only
+   *
+   * @return View of the headers, an empty view if the message has none
+   *
+   * @note Shares the lazily built index, the headers must not be looked up from several threads without synchronization
+   */
+  const TableView& headers() const noexcept {
+    const auto& properties = static_cast<const ::amqp_message_t&>(memory_).properties;
+    const ::amqp_table_t table = 0 != (properties._flags & AMQP_BASIC_HEADERS_FLAG) ? properties.headers : ::amqp_table_t{0, nullptr};
+    if (!headers_.references(table))
+      headers_ = TableView(table); // the content was set after construction
+    return headers_;
+  }
+
+private:
+
+  /**
+   * View of the headers, rebound when it no longer references the headers of the message
+   */
+  mutable TableView headers_;
 };
 
 } // namespace rmqcxx
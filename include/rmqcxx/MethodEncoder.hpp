@@ -0,0 +1,246 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <amqp.h>
+#include <amqp_framing.h>
+
+#include "Wire.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Encodes the methods that are sent for every message (basic.publish, basic.ack and basic.nack) without going through
+ * the table driven encoder and the frame pool of rabbitmq-c, as well as declarations with pre-encoded arguments
+ *
+ * The frames are appended to a WireWriter, they are byte for byte the ones rabbitmq-c sends.
+ */
+class MethodEncoder final {
+public:
+
+  /**
+   * Only static members
+   */
+  MethodEncoder() = delete;
+
+  /**
+   * Encodes basic.ack
+   *
+   * @param[out] out Writer to append the frame to
+   * @param[in] channel Channel identifier
+   * @param[in] tag Delivery tag
+   * @param[in] multiple If set acknowledges all messages up to the tag
+   */
+  static void ack(WireWriter& out, ::amqp_channel_t channel, uint64_t tag, bool multiple) {
+    acknowledgement(out, channel, AMQP_BASIC_ACK_METHOD, tag, multiple ? 1 : 0);
+  }
+
+  /**
+   * Encodes basic.nack
+   *
+   * @param[out] out Writer to append the frame to
+   * @param[in] channel Channel identifier
+   * @param[in] tag Delivery tag
+   * @param[in] multiple If set rejects all messages up to the tag
+   * @param[in] requeue If set the messages are requeued, otherwise they are dead-lettered
+   */
+  static void nack(WireWriter& out, ::amqp_channel_t channel, uint64_t tag, bool multiple, bool requeue) {
+    acknowledgement(out, channel, AMQP_BASIC_NACK_METHOD, tag, (multiple ? 1 : 0) | (requeue ? 2 : 0));
+  }
+
+  /**
+   * Encodes basic.publish followed by the content header and the body frames
+   *
+   * @param[out] out Writer to append the frames to
+   * @param[in] channel Channel identifier
+   * @param[in] exchange Exchange name
+   * @param[in] routingKey Routing key
+   * @param[in] mandatory Mandatory flag
+   * @param[in] immediate Immediate flag
+   * @param[in] properties Message properties, only the ones flagged in _flags are encoded
+   * @param[in] body Message body
+   * @param[in] frameMax Negotiated maximum frame size, the body is split into frames of at most this size
+   *
+   * @throw Exception When a short string is longer than 255 bytes or a header value is of an unknown kind
+   */
+  static void publish(
+    WireWriter& out, ::amqp_channel_t channel, const ::amqp_bytes_t& exchange, const ::amqp_bytes_t& routingKey,
+    bool mandatory, bool immediate, const ::amqp_basic_properties_t& properties, const ::amqp_bytes_t& body, std::size_t frameMax) {
+    const std::size_t chunk = frameMax > kFrameOverhead ? frameMax - kFrameOverhead : body.len;
+    const std::size_t frames = 0 == body.len ? 0 : (body.len + chunk - 1) / chunk;
+    out.reserve(kFrameOverhead * (2 + frames) + 16 + exchange.len + routingKey.len + kHeaderSize + body.len);
+
+    auto frame = out.beginMethod(channel, AMQP_BASIC_PUBLISH_METHOD);
+    out.u16(0); // ticket
+    out.shortString(exchange);
+    out.shortString(routingKey);
+    out.u8((mandatory ? 1 : 0) | (immediate ? 2 : 0));
+    out.endFrame(frame);
+
+    frame = out.beginFrame(AMQP_FRAME_HEADER, channel);
+    out.u16(AMQP_BASIC_CLASS);
+    out.u16(0); // weight
+    out.u64(body.len);
+    MethodEncoder::properties(out, properties);
+    out.endFrame(frame);
+
+    const auto* bytes = static_cast<const uint8_t*>(body.bytes);
+    for (std::size_t offset = 0; offset < body.len; offset += chunk) {
+      frame = out.beginFrame(AMQP_FRAME_BODY, channel);
+      out.bytes(bytes + offset, offset + chunk < body.len ? chunk : body.len - offset);
+      out.endFrame(frame);
+    }
+  }
+
+  /**
+   * Encodes queue.declare
+   *
+   * @param[out] out Writer to append the frame to
+   * @param[in] channel Channel identifier
+   * @param[in] queue Queue name
+   * @param[in] passive Passive flag
+   * @param[in] durable Durable flag
+   * @param[in] exclusive Exclusive flag
+   * @param[in] autoDelete Auto delete flag
+   * @param[in] noWait Nowait flag
+   * @param[in] arguments Arguments in the wire encoding (ie: EncodedTable::bytes()), spliced in as they are
+   *
+   * @throw Exception When the queue name is longer than 255 bytes
+   */
+  static void queueDeclare(
+    WireWriter& out, ::amqp_channel_t channel, const ::amqp_bytes_t& queue,
+    bool passive, bool durable, bool exclusive, bool autoDelete, bool noWait, const ::amqp_bytes_t& arguments) {
+    out.reserve(kFrameOverhead + 8 + queue.len + arguments.len);
+    const auto frame = out.beginMethod(channel, AMQP_QUEUE_DECLARE_METHOD);
+    out.u16(0); // ticket
+    out.shortString(queue);
+    out.u8((passive ? 1 : 0) | (durable ? 2 : 0) | (exclusive ? 4 : 0) | (autoDelete ? 8 : 0) | (noWait ? 16 : 0));
+    out.bytes(arguments.bytes, arguments.len);
+    out.endFrame(frame);
+  }
+
+  /**
+   * Encodes exchange.declare
+   *
+   * @param[out] out Writer to append the frame to
+   * @param[in] channel Channel identifier
+   * @param[in] exchange Exchange name
+   * @param[in] type Exchange type
+   * @param[in] passive Passive flag
+   * @param[in] durable Durable flag
+   * @param[in] autoDelete Auto delete flag
+   * @param[in] internal Internal flag
+   * @param[in] noWait Nowait flag
+   * @param[in] arguments Arguments in the wire encoding (ie: EncodedTable::bytes()), spliced in as they are
+   *
+   * @throw Exception When the exchange name or type is longer than 255 bytes
+   */
+  static void exchangeDeclare(
+    WireWriter& out, ::amqp_channel_t channel, const ::amqp_bytes_t& exchange, const ::amqp_bytes_t& type,
+    bool passive, bool durable, bool autoDelete, bool internal, bool noWait, const ::amqp_bytes_t& arguments) {
+    out.reserve(kFrameOverhead + 9 + exchange.len + type.len + arguments.len);
+    const auto frame = out.beginMethod(channel, AMQP_EXCHANGE_DECLARE_METHOD);
+    out.u16(0); // ticket
+    out.shortString(exchange);
+    out.shortString(type);
+    out.u8((passive ? 1 : 0) | (durable ? 2 : 0) | (autoDelete ? 4 : 0) | (internal ? 8 : 0) | (noWait ? 16 : 0));
+    out.bytes(arguments.bytes, arguments.len);
+    out.endFrame(frame);
+  }
+
+  /**
+   * Encodes the property list of a content header
+   *
+   * @param[out] out Writer to append the properties to
+   * @param[in] properties Message properties, only the ones flagged in _flags are encoded
+   *
+   * @throw Exception When a short string is longer than 255 bytes or a header value is of an unknown kind
+   */
+  static void properties(WireWriter& out, const ::amqp_basic_properties_t& properties) {
+    const auto flags = properties._flags;
+    out.u16(static_cast<uint16_t>(flags));
+    if (flags & AMQP_BASIC_CONTENT_TYPE_FLAG) out.shortString(properties.content_type);
+    if (flags & AMQP_BASIC_CONTENT_ENCODING_FLAG) out.shortString(properties.content_encoding);
+    if (flags & AMQP_BASIC_HEADERS_FLAG) out.table(properties.headers);
+    if (flags & AMQP_BASIC_DELIVERY_MODE_FLAG) out.u8(properties.delivery_mode);
+    if (flags & AMQP_BASIC_PRIORITY_FLAG) out.u8(properties.priority);
+    if (flags & AMQP_BASIC_CORRELATION_ID_FLAG) out.shortString(properties.correlation_id);
+    if (flags & AMQP_BASIC_REPLY_TO_FLAG) out.shortString(properties.reply_to);
+    if (flags & AMQP_BASIC_EXPIRATION_FLAG) out.shortString(properties.expiration);
+    if (flags & AMQP_BASIC_MESSAGE_ID_FLAG) out.shortString(properties.message_id);
+    if (flags & AMQP_BASIC_TIMESTAMP_FLAG) out.u64(properties.timestamp);
+    if (flags & AMQP_BASIC_TYPE_FLAG) out.shortString(properties.type);
+    if (flags & AMQP_BASIC_USER_ID_FLAG) out.shortString(properties.user_id);
+    if (flags & AMQP_BASIC_APP_ID_FLAG) out.shortString(properties.app_id);
+    if (flags & AMQP_BASIC_CLUSTER_ID_FLAG) out.shortString(properties.cluster_id);
+  }
+
+  /**
+   * Size of basic.ack and basic.nack frames
+   */
+  static constexpr std::size_t kAcknowledgementSize = 21;
+
+private:
+
+  /**
+   * Frame header and frame end
+   */
+  static constexpr std::size_t kFrameOverhead = 8;
+
+  /**
+   * Content header without properties (class, weight, body size and property flags)
+   */
+  static constexpr std::size_t kHeaderSize = 14;
+
+  /**
+   * Encodes basic.ack or basic.nack, both have a fixed size
+   *
+   * @param[out] out Writer to append the frame to
+   * @param[in] channel Channel identifier
+   * @param[in] method AMQP_BASIC_ACK_METHOD or AMQP_BASIC_NACK_METHOD
+   * @param[in] tag Delivery tag
+   * @param[in] bits Packed bit arguments of the method
+   */
+  static void acknowledgement(WireWriter& out, ::amqp_channel_t channel, ::amqp_method_number_t method, uint64_t tag, uint8_t bits) {
+    const uint8_t frame[kAcknowledgementSize] = {
+      AMQP_FRAME_METHOD,
+      static_cast<uint8_t>(channel >> 8), static_cast<uint8_t>(channel),
+      0, 0, 0, 13, // payload size
+      static_cast<uint8_t>(method >> 24), static_cast<uint8_t>(method >> 16), static_cast<uint8_t>(method >> 8), static_cast<uint8_t>(method),
+      static_cast<uint8_t>(tag >> 56), static_cast<uint8_t>(tag >> 48), static_cast<uint8_t>(tag >> 40), static_cast<uint8_t>(tag >> 32),
+      static_cast<uint8_t>(tag >> 24), static_cast<uint8_t>(tag >> 16), static_cast<uint8_t>(tag >> 8), static_cast<uint8_t>(tag),
+      bits,
+      AMQP_FRAME_END
+    };
+    out.bytes(frame, sizeof(frame));
+  }
+};
+
+} // namespace rmqcxx
@@ -30,6 +30,7 @@ SOFTWARE.
 #include <vector>
 
 #include "Channel.hpp"
+#include "MethodEncoder.hpp"
 #include "Table.hpp"
 #include "util.hpp"
 
@@ -93,7 +94,7 @@ public:
   /**
    * Declares the queue on the broker
    *
-   * @tparam Args TableEntry types
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
    *
    * @param[in] passive If set only checks the queue with the same name exists (no queue is created)
    * @param[in] durable If set the queue will persist after broker restart
@@ -110,14 +111,53 @@ public:
    */
   template <typename... Args>
   const amqp_queue_declare_ok_t* declare(bool passive, bool durable, bool exclusive, bool autoDelete, Args&&... args) {
-    Table arguments(std::forward<Args>(args)...);
-    return rpc(::amqp_queue_declare, passive, durable, exclusive, autoDelete, static_cast<::amqp_table_t>(arguments));
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    const auto ok = rpc(::amqp_queue_declare, passive, durable, exclusive, autoDelete, static_cast<::amqp_table_t>(arguments));
+    if (!passive && nullptr != topology())
+      topology()->queueDeclared(channel_.id(), container<std::string>(ok->queue), name_.empty(), durable, exclusive, autoDelete, arguments);
+    return ok;
+  }
+
+  /**
+   * Declares the queue on the broker without waiting for the broker to confirm it
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   *
+   * @param[in] durable If set the queue will persist after broker restart
+   * @param[in] exclusive If set the declared queue will be exclusive for the connection it was created on
+   * @param[in] autoDelete If set queue will be deleted when there are no more consumers
+   * @param[in] args Any extra parameters associated with this queue
+   *
+   * @throw ChannelException When the queue has no name (the name assigned by the broker is only in the reply) or
+   * when the declaration can't be sent
+   * @throw SocketException When writing to the socket fails (native encoding)
+   *
+   * @note A rejected declaration closes the channel, the next RPC on the channel throws ChannelCloseException
+   * @note With native encoding (Connection::nativeEncoding) an EncodedTable is spliced into the frame as it is
+   */
+  template <typename... Args>
+  void declareNoWait(bool durable, bool exclusive, bool autoDelete, Args&&... args) {
+    if (name_.empty())
+      throw ChannelException(channel_.connection_, channel_, context_ + "Server named queue can't be declared without waiting for the reply!");
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    const ::amqp_bytes_t encoded = impl::encoded(arguments);
+    if (nullptr != encoded.bytes && channel_.connection_.nativeEncoding()) {
+      const auto name = bytes(name_);
+      channel_.sendEncoded(AMQP_QUEUE_DECLARE_METHOD, [&] (WireWriter& out, ::amqp_channel_t channel) {
+        MethodEncoder::queueDeclare(out, channel, name, false, durable, exclusive, autoDelete, true, encoded);
+      });
+    } else {
+      ::amqp_queue_declare_t method{0, bytes(name_), false, durable, exclusive, autoDelete, true, arguments};
+      channel_.send(AMQP_QUEUE_DECLARE_METHOD, &method);
+    }
+    if (nullptr != topology())
+      topology()->queueDeclared(channel_.id(), name_, false, durable, exclusive, autoDelete, arguments);
   }
 
   /**
    * Binds this queue
    *
-   * @tparam Args TableEntry types
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
    *
    * @param[in] exchange Name of the exchange to bind this queue to
    * @param[in] routingKey Routing key to bind this queue with
@@ -130,14 +170,38 @@ public:
    */
   template <typename... Args>
   void bind(const std::string& exchange, const std::string& routingKey, Args&&... args) {
-    Table arguments(std::forward<Args>(args)...);
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
     rpc(::amqp_queue_bind, bytes(exchange), bytes(routingKey), arguments);
+    if (nullptr != topology())
+      topology()->bound(false, topology()->resolve(channel_.id(), name_), exchange, routingKey, arguments);
+  }
+
+  /**
+   * Binds this queue without waiting for the broker to confirm it
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   *
+   * @param[in] exchange Name of the exchange to bind this queue to
+   * @param[in] routingKey Routing key to bind this queue with
+   * @param[in] args Any extra parameters associated with this queue binding
+   *
+   * @throw ChannelException When the binding can't be sent
+   *
+   * @note A rejected binding closes the channel, the next RPC on the channel throws ChannelCloseException
+   */
+  template <typename... Args>
+  void bindNoWait(const std::string& exchange, const std::string& routingKey, Args&&... args) {
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    ::amqp_queue_bind_t method{0, bytes(name_), bytes(exchange), bytes(routingKey), true, arguments};
+    channel_.send(AMQP_QUEUE_BIND_METHOD, &method);
+    if (nullptr != topology())
+      topology()->bound(false, topology()->resolve(channel_.id(), name_), exchange, routingKey, arguments);
   }
 
   /**
    * Unbinds this queue
    *
-   * @tparam Args TableEntry types
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
    *
    * @param[in] exchange Name of the exchange to bind this queue to
    * @param[in] routingKey Routing key to bind this queue with
@@ -150,15 +214,17 @@ public:
    */
   template <typename... Args>
   void unbind(const std::string& exchange, const std::string& routingKey, Args&&... args) {
-    Table arguments(std::forward<Args>(args)...);
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
     rpc(::amqp_queue_unbind, bytes(exchange), bytes(routingKey), arguments);
+    if (nullptr != topology())
+      topology()->unbound(false, topology()->resolve(channel_.id(), name_), exchange, routingKey);
   }
 
 
   /**
    * Registers to start consuming from this queue
    *
-   * @tparam Args TableEntry types
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
    *
    * @param[in] consumerTag Consumer specific tag (one will be assigned if empty, must be unique for a channel)
    * @param[in] noLocal If this is set then the server will not send messages to the connection that published them
@@ -175,8 +241,11 @@ public:
    */
   template <typename... Args>
   std::string consume(const std::string& consumerTag, bool noLocal, bool noAck, bool exclusive, Args&&... args) {
-    Table arguments(std::forward<Args>(args)...);
-    return container<std::string>(rpc(::amqp_basic_consume, bytes(consumerTag), noLocal, noAck, exclusive, arguments)->consumer_tag);
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    auto tag = container<std::string>(rpc(::amqp_basic_consume, bytes(consumerTag), noLocal, noAck, exclusive, arguments)->consumer_tag);
+    if (nullptr != topology())
+      topology()->consumed(channel_.id(), topology()->resolve(channel_.id(), name_), tag, noLocal, noAck, exclusive, arguments);
+    return tag;
   }
 
   /**
@@ -193,7 +262,10 @@ public:
    * @throw RPCException For general RPC exception
    */
   uint32_t remove(bool ifUnused, bool ifEmpty) {
-    return rpc(::amqp_queue_delete, ifUnused, ifEmpty)->message_count;
+    const auto count = rpc(::amqp_queue_delete, ifUnused, ifEmpty)->message_count;
+    if (nullptr != topology())
+      topology()->queueDeleted(topology()->resolve(channel_.id(), name_));
+    return count;
   }
 
   /**
@@ -220,6 +292,14 @@ public:
 
 private:
 
+  /**
+   * Topology recorder of the connection
+   * @return Recorder, nullptr if the connection is not recorded
+   */
+  Topology* topology() const noexcept {
+    return channel_.connection_.topology();
+  }
+
   /**
    * Reference to a channel to perform RPCs on
    */
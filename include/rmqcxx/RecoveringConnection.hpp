@@ -0,0 +1,312 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <thread>
+#include <utility>
+
+#include "Connection.hpp"
+#include "Exceptions.hpp"
+#include "Topology.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Connection that reconnects after a failure and replays the topology that was declared on it
+ *
+ * The wrapped Connection object stays the same, Channel, Exchange and Queue objects created on connection() stay
+ * valid across a recovery, their channels, declarations, bindings, QoS and consumers are replayed (see Topology).
+ *
+ * @note Delivery tags of the previous connection are invalid after a recovery, generation() tells them apart
+ * @note Not thread safe, like Connection
+ */
+class RecoveringConnection final {
+public:
+
+  /**
+   * Creates a new connection (std::function<Connection()> compatible)
+   */
+  using Factory = std::function<Connection()>;
+
+  /**
+   * Clock used for the reconnect delays
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Reconnect backoff
+   */
+  struct Backoff {
+    /**
+     * Maximum number of connection attempts in a row, 0 for no limit
+     */
+    std::size_t maxAttempts;
+
+    /**
+     * Delay before the second attempt
+     */
+    Clock::duration initialDelay;
+
+    /**
+     * Upper bound of the delay
+     */
+    Clock::duration maxDelay;
+
+    /**
+     * Multiplier applied to the delay after every failed attempt
+     */
+    double multiplier;
+
+    /**
+     * Fraction of the delay that is randomized ([0, 1]), spreads out clients that lost the broker at the same time
+     */
+    double jitter;
+  };
+
+  /**
+   * Constructor, connects with the backoff
+   *
+   * @param[in] factory Creates connections
+   * @param[in] backoff Reconnect backoff
+   *
+   * @throw Same as the factory when all attempts failed
+   */
+  RecoveringConnection(Factory factory, Backoff backoff) :
+    factory_(std::move(factory)), backoff_(backoff), random_(std::random_device()()), connection_(connect()), generation_(0) {
+    connection_.record(&topology_);
+  }
+
+  /**
+   * Destructor
+   */
+  ~RecoveringConnection() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  RecoveringConnection(const RecoveringConnection&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  RecoveringConnection(RecoveringConnection&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  RecoveringConnection& operator=(const RecoveringConnection&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  RecoveringConnection& operator=(RecoveringConnection&&) = delete;
+
+  /**
+   * The connection, stays the same object across recoveries
+   * @return Reference to the connection
+   */
+  Connection& connection() noexcept {
+    return connection_;
+  }
+
+  /**
+   * Recorded topology
+   * @return Reference to the recorded topology
+   */
+  Topology& topology() noexcept {
+    return topology_;
+  }
+
+  /**
+   * Number of completed recoveries
+   * @return Number of completed recoveries
+   */
+  uint64_t generation() const noexcept {
+    return generation_;
+  }
+
+  /**
+   * Reconnects with the backoff and replays the recorded topology
+   *
+   * @throw Same as the factory when all attempts failed
+   * @throw ChannelCloseException When the broker rejects the recorded topology
+   */
+  void recover() {
+    for (std::size_t attempt = 1;; ++attempt) {
+      try {
+        // the peer may be gone without a trace, don't wait for it to acknowledge closing the failed connection
+        try {
+          connection_.setRpcTimeout(std::chrono::milliseconds(1));
+        } catch(const Exception&) {
+        }
+        connection_ = factory_();
+        connection_.record(&topology_);
+        topology_.replay(connection_);
+        ++generation_;
+        return;
+      } catch(const ConnectionException& e) {
+        if (!recoverable(e) || exhausted(attempt))
+          throw;
+      }
+      std::this_thread::sleep_for(delay(attempt));
+    }
+  }
+
+  /**
+   * Runs an operation on the connection, recovers and runs it again when the connection fails
+   *
+   * @tparam Function Callable object that accepts Connection&
+   *
+   * @param[in] f Operation
+   *
+   * @return Whatever the operation returns
+   *
+   * @throw Whatever the operation throws except for connection failures, and the same as recover
+   */
+  template <typename Function>
+  auto run(Function f) -> decltype(f(std::declval<Connection&>())) {
+    for (;;) {
+      try {
+        return f(connection_);
+      } catch(const ConnectionException& e) {
+        if (!recoverable(e))
+          throw;
+      }
+      recover();
+    }
+  }
+
+  /**
+   * Checks if an exception means the connection failed (as opposed to a failed operation on a working connection)
+   *
+   * @param[in] e Exception
+   *
+   * @return True for socket, library and frame errors and a connection close sent by the broker
+   */
+  static bool recoverable(const ConnectionException& e) noexcept {
+    return nullptr != dynamic_cast<const SocketException*>(&e)
+      || nullptr != dynamic_cast<const LibraryException*>(&e)
+      || nullptr != dynamic_cast<const FrameStatusException*>(&e)
+      || nullptr != dynamic_cast<const ConnectionCloseException*>(&e);
+  }
+
+  /**
+   * Delay before the next attempt, without the jitter
+   *
+   * @param[in] attempt Number of failed attempts
+   *
+   * @return Delay
+   */
+  Clock::duration backoff(std::size_t attempt) const noexcept {
+    double d = static_cast<double>(backoff_.initialDelay.count());
+    for (std::size_t i = 1; i < attempt && d < backoff_.maxDelay.count(); ++i)
+      d *= backoff_.multiplier;
+    return std::min(Clock::duration(static_cast<Clock::duration::rep>(d)), backoff_.maxDelay);
+  }
+
+private:
+
+  /**
+   * Checks if the attempts are exhausted
+   *
+   * @param[in] attempt Number of failed attempts
+   *
+   * @return True if no more attempts should be made
+   */
+  bool exhausted(std::size_t attempt) const noexcept {
+    return 0 != backoff_.maxAttempts && attempt >= backoff_.maxAttempts;
+  }
+
+  /**
+   * Jittered delay before the next attempt
+   *
+   * @param[in] attempt Number of failed attempts
+   *
+   * @return Delay
+   */
+  Clock::duration delay(std::size_t attempt) {
+    const auto& d = backoff(attempt);
+    const double jitter = std::min(std::max(backoff_.jitter, 0.0), 1.0);
+    std::uniform_real_distribution<double> distribution(1.0 - jitter, 1.0);
+    return Clock::duration(static_cast<Clock::duration::rep>(static_cast<double>(d.count()) * distribution(random_)));
+  }
+
+  /**
+   * Creates a connection with the backoff
+   *
+   * @return Connection
+   */
+  Connection connect() {
+    for (std::size_t attempt = 1;; ++attempt) {
+      try {
+        return factory_();
+      } catch(const ConnectionException& e) {
+        if (!recoverable(e) || exhausted(attempt))
+          throw;
+      }
+      std::this_thread::sleep_for(delay(attempt));
+    }
+  }
+
+  /**
+   * Connection factory
+   */
+  Factory factory_;
+
+  /**
+   * Reconnect backoff
+   */
+  const Backoff backoff_;
+
+  /**
+   * Jitter source
+   */
+  std::minstd_rand random_;
+
+  /**
+   * Recorded topology, declared before the connection which refers to it
+   */
+  Topology topology_;
+
+  /**
+   * The connection
+   */
+  Connection connection_;
+
+  /**
+   * Number of completed recoveries
+   */
+  uint64_t generation_;
+};
+
+} // namespace rmqcxx
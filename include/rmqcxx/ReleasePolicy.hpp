@@ -0,0 +1,300 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace rmqcxx {
+
+/**
+ * Counters of a ReleasePolicy
+ */
+struct ReleaseStats {
+  /**
+   * Operations (RPCs and consume calls, including the ones that timed out) seen by the policy
+   */
+  uint64_t operations;
+
+  /**
+   * Times the frame buffers were released
+   */
+  uint64_t releases;
+
+  /**
+   * Releases that were due but skipped because zero-copy envelopes still borrow the buffers
+   */
+  uint64_t skipped;
+
+  /**
+   * Estimated bytes decoded into the frame pools since the last release
+   */
+  std::size_t pooled;
+
+  /**
+   * Highest estimate of the pooled bytes seen so far
+   */
+  std::size_t peak;
+};
+
+/**
+ * Decides when a connection releases the frame buffers of rabbitmq-c
+ *
+ * rabbitmq-c decodes incoming frames into per channel pools, releasing them lets it recycle the pool pages and free
+ * the large blocks, which then have to be allocated again for the next frames. By default the buffers are released
+ * after every operation, which keeps the resident memory low at the cost of malloc churn. The buffers can instead be
+ * released every N operations, when the pooled bytes cross a high-water mark or once the connection is idle, a
+ * release is done as soon as any of the enabled conditions is met.
+ *
+ * @note rabbitmq-c does not expose the size of its pools, the pooled bytes are estimated from the content (headers
+ * and bodies) consumed since the last release plus kOperationOverhead for every operation that did something, which
+ * stands for the decoded method frames and makes RPCs and confirms without content reach the high-water mark too
+ */
+class ReleasePolicy final {
+public:
+
+  /**
+   * Clock used for the idle condition
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Estimated pool bytes taken by the frames decoded during an operation besides the content (method frame, decoded
+   * properties, strings of the reply)
+   */
+  static constexpr std::size_t kOperationOverhead = 256;
+
+  /**
+   * Constructor, releases after every operation
+   */
+  ReleasePolicy() noexcept : every_(1), highWaterMark_(0), idle_(Clock::duration::zero()), operations_(0), last_(), dirty_(false), stats_{0, 0, 0, 0, 0} {}
+
+  /**
+   * Policy that releases after every operation (default)
+   * @return Policy
+   */
+  static ReleasePolicy always() noexcept {
+    return ReleasePolicy();
+  }
+
+  /**
+   * Policy that keeps the pools warm and releases only when they grow or the connection is idle
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] highWaterMark Estimated pooled bytes after which the buffers are released
+   * @param[in] idle Idle time after which the buffers are released
+   *
+   * @return Policy
+   */
+  template <typename Duration>
+  static ReleasePolicy warm(std::size_t highWaterMark, Duration idle) noexcept {
+    return ReleasePolicy().every(0).highWaterMark(highWaterMark).idle(idle);
+  }
+
+  /**
+   * Releases after a number of operations
+   *
+   * @param[in] operations Number of operations, 0 disables the condition
+   *
+   * @return Reference to this object
+   */
+  ReleasePolicy& every(std::size_t operations) noexcept {
+    every_ = operations;
+    return *this;
+  }
+
+  /**
+   * Releases once the estimated pooled bytes reach a limit
+   *
+   * @param[in] bytes Limit in bytes, 0 disables the condition
+   *
+   * @return Reference to this object
+   */
+  ReleasePolicy& highWaterMark(std::size_t bytes) noexcept {
+    highWaterMark_ = bytes;
+    return *this;
+  }
+
+  /**
+   * Releases once nothing was done for a while, checked when a consume call times out
+   *
+   * The idle time starts with the last operation that did something, the buffers are released once per idle period
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] duration Idle time, zero disables the condition
+   *
+   * @return Reference to this object
+   */
+  template <typename Duration>
+  ReleasePolicy& idle(Duration duration) noexcept {
+    idle_ = std::chrono::duration_cast<Clock::duration>(duration);
+    return *this;
+  }
+
+  /**
+   * Number of operations after which the buffers are released
+   * @return Number of operations, 0 if disabled
+   */
+  std::size_t every() const noexcept {
+    return every_;
+  }
+
+  /**
+   * Estimated pooled bytes after which the buffers are released
+   * @return Limit in bytes, 0 if disabled
+   */
+  std::size_t highWaterMark() const noexcept {
+    return highWaterMark_;
+  }
+
+  /**
+   * Idle time after which the buffers are released
+   * @return Idle time, zero if disabled
+   */
+  Clock::duration idle() const noexcept {
+    return idle_;
+  }
+
+  /**
+   * Checks if the idle condition is enabled, only then the operations need a time stamp
+   * @return True if the idle condition is enabled
+   */
+  bool timed() const noexcept {
+    return idle_ > Clock::duration::zero();
+  }
+
+  /**
+   * Records content decoded into the frame pools
+   *
+   * @param[in] bytes Number of bytes
+   */
+  void used(std::size_t bytes) noexcept {
+    stats_.pooled += bytes;
+    stats_.peak = std::max(stats_.peak, stats_.pooled);
+  }
+
+  /**
+   * Records an operation
+   *
+   * @param[in] now Time of the operation, only used if the idle condition is enabled
+   * @param[in] active False if the operation did nothing (ie: consume timed out), only then the idle condition is checked
+   *
+   * @return True if the buffers should be released
+   */
+  bool due(Clock::time_point now, bool active = true) noexcept {
+    ++stats_.operations;
+    ++operations_;
+    if (active) {
+      last_ = now;
+      dirty_ = true;
+      used(kOperationOverhead);
+    }
+    return (0 != every_ && operations_ >= every_)
+      || (0 != highWaterMark_ && stats_.pooled >= highWaterMark_)
+      || (!active && dirty_ && timed() && now - last_ >= idle_);
+  }
+
+  /**
+   * Records a release of all frame buffers, the counters of the conditions start over
+   */
+  void released() noexcept {
+    ++stats_.releases;
+    operations_ = 0;
+    dirty_ = false;
+    stats_.pooled = 0;
+  }
+
+  /**
+   * Records a release of the frame buffers of a single channel
+   *
+   * Only the operation count starts over, the pools of the other channels are not released so the pooled bytes and
+   * the idle condition are kept until the next release of all buffers.
+   */
+  void releasedChannel() noexcept {
+    ++stats_.releases;
+    operations_ = 0;
+  }
+
+  /**
+   * Records a release that was due but could not be done, the conditions stay met
+   */
+  void skipped() noexcept {
+    ++stats_.skipped;
+  }
+
+  /**
+   * Counters
+   * @return Counters of this policy
+   */
+  const ReleaseStats& stats() const noexcept {
+    return stats_;
+  }
+
+private:
+
+  /**
+   * Number of operations after which the buffers are released, 0 if disabled
+   */
+  std::size_t every_;
+
+  /**
+   * Estimated pooled bytes after which the buffers are released, 0 if disabled
+   */
+  std::size_t highWaterMark_;
+
+  /**
+   * Idle time after which the buffers are released, zero if disabled
+   */
+  Clock::duration idle_;
+
+  /**
+   * Operations since the last release
+   */
+  std::size_t operations_;
+
+  /**
+   * Time of the last operation that did something
+   */
+  Clock::time_point last_;
+
+  /**
+   * Set if something was done since the last release
+   */
+  bool dirty_;
+
+  /**
+   * Counters
+   */
+  ReleaseStats stats_;
+};
+
+} // namespace rmqcxx
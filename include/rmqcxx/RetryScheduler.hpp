@@ -0,0 +1,267 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <functional>
+
+#include "Channel.hpp"
+#include "Envelope.hpp"
+#include "TimingWheel.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Client side retry scheduler for deliveries whose processing failed
+ *
+ * Failed deliveries are kept unacknowledged in a timing wheel and dispatched again locally after an exponential
+ * backoff instead of being nacked with requeue (which makes the broker redeliver them immediately). Once the
+ * attempts are exhausted the delivery is nacked without requeue so the broker dead letters it (if the queue has
+ * a dead letter exchange configured) or drops it.
+ *
+ * Held deliveries stay unacknowledged, so they keep counting against the channel prefetch (basic.qos) exactly
+ * like deliveries that are being processed. A handler that throws counts as a failed attempt, the delivery is
+ * rescheduled (or nacked) before the exception is passed on, so no delivery is left unsettled.
+ *
+ * @note All deliveries passed to the scheduler have to be received on the channel the scheduler was constructed with
+ * @note Delivery tags become invalid when the channel or the connection closes, call clear() in that case
+ */
+class RetryScheduler final {
+public:
+
+  /**
+   * Handler type, returns true if the delivery was processed and should be acknowledged
+   */
+  using Handler = std::function<bool(const Envelope&)>;
+
+  /**
+   * Clock used by the scheduler
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Retry policy
+   */
+  struct Policy {
+    /**
+     * Maximum number of times a delivery is passed to the handler (including the first dispatch)
+     */
+    std::size_t maxAttempts;
+
+    /**
+     * Delay before the first retry
+     */
+    Clock::duration initialDelay;
+
+    /**
+     * Upper bound for the delay between two attempts
+     */
+    Clock::duration maxDelay;
+
+    /**
+     * Factor by which the delay grows after every failed attempt
+     */
+    double multiplier;
+  };
+
+  /**
+   * Constructor
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] channel Channel on which the deliveries were received
+   * @param[in] handler Delivery handler
+   * @param[in] policy Retry policy
+   * @param[in] resolution Resolution of the underlying timing wheel
+   */
+  template <typename Duration = std::chrono::milliseconds>
+  RetryScheduler(Channel& channel, Handler handler, Policy policy, Duration resolution = std::chrono::milliseconds(10)) :
+    channel_(channel), handler_(std::move(handler)), policy_(policy), wheel_(resolution) {}
+
+  /**
+   * Destructor
+   *
+   * @note Deliveries still waiting for a retry are left unacknowledged, the broker requeues them once the channel closes
+   */
+  ~RetryScheduler() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  RetryScheduler(const RetryScheduler&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  RetryScheduler(RetryScheduler&&) noexcept = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  RetryScheduler& operator=(const RetryScheduler&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  RetryScheduler& operator=(RetryScheduler&&) noexcept = delete;
+
+  /**
+   * Dispatches a new delivery, can be used directly as the envelope callback of Connection::consume
+   *
+   * @param[in] envelope Delivery to dispatch
+   * @param[in] now Current point in time, the backoff of a failed attempt is counted from it
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   * @throw Whatever the handler threw, after the delivery was rescheduled or nacked
+   */
+  void operator()(Envelope envelope, Clock::time_point now = Clock::now()) {
+    dispatch(Retry{std::move(envelope), 0}, now);
+  }
+
+  /**
+   * Dispatches all deliveries whose backoff has expired
+   *
+   * @param[in] now Current point in time
+   *
+   * @return Number of deliveries that were dispatched
+   *
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   * @throw Whatever the handler threw, after the delivery was rescheduled or nacked (the remaining deliveries are
+   * dispatched by the next poll)
+   */
+  std::size_t poll(Clock::time_point now = Clock::now()) {
+    return wheel_.advance(now, [this, now] (Retry retry) { dispatch(std::move(retry), now); });
+  }
+
+  /**
+   * Drops all deliveries waiting for a retry without acknowledging them (ie: after the channel was closed)
+   */
+  void clear() noexcept {
+    wheel_.clear();
+  }
+
+  /**
+   * Number of deliveries waiting for a retry
+   * @return Number of deliveries held by the scheduler
+   */
+  std::size_t pending() const noexcept {
+    return wheel_.size();
+  }
+
+  /**
+   * Delay before a retry
+   *
+   * @param[in] attempt Number of attempts done so far (1 for the first retry)
+   *
+   * @return Delay to wait before the next attempt
+   */
+  Clock::duration delay(std::size_t attempt) const noexcept {
+    double d = static_cast<double>(policy_.initialDelay.count());
+    for (std::size_t i = 1; i < attempt && d < policy_.maxDelay.count(); ++i)
+      d *= policy_.multiplier;
+    return std::min(Clock::duration(static_cast<Clock::duration::rep>(d)), policy_.maxDelay);
+  }
+
+private:
+
+  /**
+   * Delivery waiting for a retry
+   */
+  struct Retry {
+    /**
+     * Held delivery
+     */
+    Envelope envelope;
+
+    /**
+     * Number of attempts done so far
+     */
+    std::size_t attempts;
+  };
+
+  /**
+   * Passes a delivery to the handler and settles or reschedules it
+   *
+   * @param[in] retry Delivery to dispatch
+   * @param[in] now Current point in time, the backoff of a failed attempt is counted from it
+   *
+   * @throw Whatever the handler threw, once the delivery was handled like a failed attempt
+   */
+  void dispatch(Retry retry, Clock::time_point now) {
+    ++retry.attempts;
+    bool processed = false;
+    std::exception_ptr error;
+    try {
+      processed = handler_(retry.envelope);
+    } catch(...) {
+      error = std::current_exception();
+    }
+    if (processed) {
+      channel_.ack(retry.envelope->delivery_tag, false);
+      return;
+    }
+    if (retry.attempts >= policy_.maxAttempts) {
+      channel_.nack(retry.envelope->delivery_tag, false, false);
+    } else {
+      const auto& d = delay(retry.attempts);
+      wheel_.schedule(d, std::move(retry), now);
+    }
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  /**
+   * Channel used to settle deliveries
+   */
+  Channel& channel_;
+
+  /**
+   * Delivery handler
+   */
+  Handler handler_;
+
+  /**
+   * Retry policy
+   */
+  const Policy policy_;
+
+  /**
+   * Deliveries waiting for a retry
+   */
+  TimingWheel<Retry> wheel_;
+};
+
+} // namespace rmqcxx
@@ -0,0 +1,513 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "EventLoop.hpp"
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Single I/O thread of a ShardedRuntime with its own EventLoop
+ *
+ * Connections, channels and everything else used by a shard are created and used only on its thread (through tasks),
+ * so nothing is shared between cores. The thread is pinned before the loop is created, memory the thread allocates
+ * (ie: the frame and envelope buffers of rabbitmq-c) therefore comes from the NUMA node of its core under the default
+ * (local) allocation policy.
+ */
+class Shard final {
+public:
+
+  /**
+   * Task run on the shard thread
+   */
+  using Task = std::function<void(Shard&)>;
+
+  /**
+   * Constructor, does not start the thread
+   *
+   * @param[in] index Index of the shard in the runtime
+   * @param[in] cpu Core to pin the thread to, -1 to leave it unpinned
+   */
+  Shard(std::size_t index, int cpu) : index_(index), cpu_(cpu), node_(nodeOf(cpu)), stopping_(false) {}
+
+  /**
+   * Destructor, stops and joins the thread
+   */
+  ~Shard() noexcept {
+    stop();
+    join();
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  Shard(const Shard&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  Shard(Shard&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  Shard& operator=(const Shard&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  Shard& operator=(Shard&&) = delete;
+
+  /**
+   * Index of the shard
+   * @return Index of the shard in the runtime
+   */
+  std::size_t index() const noexcept {
+    return index_;
+  }
+
+  /**
+   * Core the thread is pinned to
+   * @return Core, -1 if unpinned
+   */
+  int cpu() const noexcept {
+    return cpu_;
+  }
+
+  /**
+   * NUMA node of the core
+   * @return NUMA node, -1 if unknown or unpinned
+   */
+  int node() const noexcept {
+    return node_;
+  }
+
+  /**
+   * Event loop of the shard
+   *
+   * @return Event loop
+   *
+   * @note Only to be used from the shard thread
+   */
+  EventLoop& loop() noexcept {
+    return *loop_;
+  }
+
+  /**
+   * Keeps an object alive until the shard stops, objects are destroyed on the shard thread in reverse order
+   *
+   * @tparam T Type of the object
+   *
+   * @param[in] object Object to keep (ie: Connection or Channel)
+   *
+   * @return Reference to the object
+   *
+   * @note Only to be used from the shard thread
+   */
+  template <typename T>
+  T& keep(std::unique_ptr<T> object) {
+    T& result = *object;
+    objects_.emplace_back(std::shared_ptr<T>(std::move(object)));
+    return result;
+  }
+
+  /**
+   * Runs a task on the shard thread, can be called from any thread
+   *
+   * @param[in] task Task to run
+   *
+   * @note Tasks posted after stop are dropped
+   */
+  void post(Task task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    if (loop_)
+      loop_->stop(); // wakes the loop up to run the task
+  }
+
+  /**
+   * Requests the thread to stop, can be called from any thread
+   */
+  void stop() noexcept {
+    stopping_ = true;
+    if (loop_)
+      loop_->stop();
+  }
+
+  /**
+   * Waits for the thread to finish
+   */
+  void join() noexcept {
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  /**
+   * Rethrows the error that stopped the shard
+   *
+   * @throw Whatever a task or a loop callback threw
+   */
+  void check() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_)
+      std::rethrow_exception(error_);
+  }
+
+  /**
+   * Starts the thread and waits until it is pinned and its loop is created
+   *
+   * @throw Exception When pinning the thread or creating the loop fails
+   */
+  void start() {
+    std::promise<void> started;
+    auto future = started.get_future();
+    thread_ = std::thread([this, &started]() { main(started); });
+    try {
+      future.get();
+    } catch(...) {
+      join();
+      throw;
+    }
+  }
+
+  /**
+   * Looks up the NUMA node of a core (Linux sysfs)
+   *
+   * @param[in] cpu Core
+   *
+   * @return NUMA node, -1 if unknown
+   */
+  static int nodeOf(int cpu) noexcept {
+    if (cpu < 0)
+      return -1;
+    const auto& path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    ::DIR* dir = ::opendir(path.c_str());
+    if (nullptr == dir)
+      return -1;
+    int node = -1;
+    while (::dirent* entry = ::readdir(dir)) {
+      if (0 == std::strncmp(entry->d_name, "node", 4) && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+        node = std::atoi(entry->d_name + 4);
+        break;
+      }
+    }
+    ::closedir(dir);
+    return node;
+  }
+
+private:
+
+  /**
+   * Thread function
+   *
+   * @param[in] started Fulfilled once the thread is pinned and the loop is created
+   */
+  void main(std::promise<void>& started) {
+    try {
+      if (cpu_ >= CPU_SETSIZE)
+        throw Exception("Shard " + std::to_string(index_) + ": Invalid core " + std::to_string(cpu_));
+      if (cpu_ >= 0) {
+        ::cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_, &set);
+        const int status = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+        if (0 != status)
+          throw Exception("Shard " + std::to_string(index_) + ": Failed to pin to core " + std::to_string(cpu_) + ": " + std::strerror(status));
+      }
+      loop_.reset(new EventLoop());
+    } catch(...) {
+      started.set_exception(std::current_exception());
+      return;
+    }
+    started.set_value();
+
+    try {
+      while (!stopping_) {
+        drain();
+        if (!stopping_)
+          loop_->run();
+      }
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+    }
+    while (!objects_.empty())
+      objects_.pop_back();
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.clear();
+  }
+
+  /**
+   * Runs the posted tasks
+   *
+   * @throw Whatever a task throws
+   */
+  void drain() {
+    std::deque<Task> tasks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks.swap(tasks_);
+    }
+    while (!tasks.empty()) {
+      auto task = std::move(tasks.front());
+      tasks.pop_front();
+      task(*this);
+    }
+  }
+
+  /**
+   * Index of the shard
+   */
+  const std::size_t index_;
+
+  /**
+   * Core the thread is pinned to, -1 if unpinned
+   */
+  const int cpu_;
+
+  /**
+   * NUMA node of the core, -1 if unknown
+   */
+  const int node_;
+
+  /**
+   * Set when the shard has to stop
+   */
+  std::atomic<bool> stopping_;
+
+  /**
+   * Guards tasks_ and error_
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Posted tasks
+   */
+  std::deque<Task> tasks_;
+
+  /**
+   * Error that stopped the shard
+   */
+  std::exception_ptr error_;
+
+  /**
+   * Event loop, created on the shard thread
+   */
+  std::unique_ptr<EventLoop> loop_;
+
+  /**
+   * Objects kept alive until the shard stops
+   */
+  std::vector<std::shared_ptr<void>> objects_;
+
+  /**
+   * Shard thread
+   */
+  std::thread thread_;
+};
+
+/**
+ * Thread per core runtime, every shard is an I/O thread pinned to a core with its own EventLoop
+ *
+ * Work is assigned to shards by index or by key (shardFor) and posted to them as tasks. A shard owns the connections
+ * created by its tasks, so a consumer or publisher never touches memory of another core.
+ *
+ * @note Linux only
+ */
+class ShardedRuntime final {
+public:
+
+  /**
+   * Starts one shard per core
+   *
+   * @param[in] cpus Cores to pin the shards to, -1 leaves a shard unpinned
+   *
+   * @throw Exception When there are no cores or a shard can't be started
+   */
+  explicit ShardedRuntime(const std::vector<int>& cpus) {
+    if (cpus.empty())
+      throw Exception("ShardedRuntime: No cores given!");
+    shards_.reserve(cpus.size());
+    for (std::size_t i = 0; i < cpus.size(); ++i)
+      shards_.emplace_back(new Shard(i, cpus[i]));
+    for (auto& shard : shards_)
+      shard->start(); // shards that were started are stopped by their destructors if this throws
+  }
+
+  /**
+   * Destructor, stops all shards and waits for them
+   */
+  ~ShardedRuntime() noexcept {
+    stop();
+    join();
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  ShardedRuntime(const ShardedRuntime&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  ShardedRuntime(ShardedRuntime&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  ShardedRuntime& operator=(const ShardedRuntime&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  ShardedRuntime& operator=(ShardedRuntime&&) = delete;
+
+  /**
+   * Cores the process is allowed to run on
+   *
+   * @return Cores from the affinity mask of the process
+   *
+   * @throw Exception When the affinity mask can't be read
+   */
+  static std::vector<int> cores() {
+    ::cpu_set_t set;
+    CPU_ZERO(&set);
+    if (0 != ::sched_getaffinity(0, sizeof(set), &set))
+      throw Exception(std::string("ShardedRuntime: Failed to read the affinity mask: ") + std::strerror(errno));
+    std::vector<int> result;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+      if (CPU_ISSET(cpu, &set))
+        result.push_back(cpu);
+    return result;
+  }
+
+  /**
+   * Number of shards
+   * @return Number of shards
+   */
+  std::size_t size() const noexcept {
+    return shards_.size();
+  }
+
+  /**
+   * Shard access
+   *
+   * @param[in] index Index of the shard
+   *
+   * @return Shard
+   */
+  Shard& operator[](std::size_t index) noexcept {
+    return *shards_[index];
+  }
+
+  /**
+   * Shard a key (ie: queue name) is assigned to, the same key always maps to the same shard
+   *
+   * @param[in] key Key
+   *
+   * @return Index of the shard
+   */
+  std::size_t shardFor(const std::string& key) const noexcept {
+    return std::hash<std::string>()(key) % shards_.size();
+  }
+
+  /**
+   * Runs a task on a shard, can be called from any thread
+   *
+   * @param[in] index Index of the shard
+   * @param[in] task Task to run
+   */
+  void post(std::size_t index, Shard::Task task) {
+    shards_[index]->post(std::move(task));
+  }
+
+  /**
+   * Runs a task on every shard, can be called from any thread
+   *
+   * @param[in] task Task to run
+   */
+  void broadcast(const Shard::Task& task) {
+    for (auto& shard : shards_)
+      shard->post(task);
+  }
+
+  /**
+   * Requests all shards to stop, can be called from any thread
+   */
+  void stop() noexcept {
+    for (auto& shard : shards_)
+      shard->stop();
+  }
+
+  /**
+   * Waits for all shards to finish
+   */
+  void join() noexcept {
+    for (auto& shard : shards_)
+      shard->join();
+  }
+
+  /**
+   * Rethrows the first error that stopped a shard
+   *
+   * @throw Whatever a task or a loop callback threw
+   */
+  void check() const {
+    for (const auto& shard : shards_)
+      shard->check();
+  }
+
+private:
+
+  /**
+   * Shards
+   */
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace rmqcxx
@@ -0,0 +1,299 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Socket level tuning of a connection
+ *
+ * Every option is left at the system (or rabbitmq-c) default unless it is set, rabbitmq-c enables TCP_NODELAY on
+ * its own TCP sockets.
+ */
+class SocketOptions final {
+public:
+
+  /**
+   * Constructor, nothing is changed by default
+   */
+  SocketOptions() noexcept : noDelay_(kUnset), quickAck_(kUnset), sendBuffer_(kUnset), receiveBuffer_(kUnset), busyPoll_(kUnset) {}
+
+  /**
+   * Options for latency sensitive traffic: Nagle disabled, delayed ACKs disabled
+   * @return Options
+   */
+  static SocketOptions lowLatency() noexcept {
+    return SocketOptions().noDelay(true).quickAck(true);
+  }
+
+  /**
+   * Options for bulk traffic: Nagle enabled so small frames are coalesced, large socket buffers
+   *
+   * @param[in] buffer Send and receive buffer size in bytes
+   *
+   * @return Options
+   */
+  static SocketOptions bulk(int buffer = 4 * 1024 * 1024) noexcept {
+    return SocketOptions().noDelay(false).sendBuffer(buffer).receiveBuffer(buffer);
+  }
+
+  /**
+   * Sets TCP_NODELAY
+   *
+   * @param[in] value True to disable Nagle's algorithm
+   *
+   * @return Reference to this object
+   */
+  SocketOptions& noDelay(bool value) noexcept {
+    noDelay_ = value ? 1 : 0;
+    return *this;
+  }
+
+  /**
+   * Sets TCP_QUICKACK (Linux)
+   *
+   * @param[in] value True to acknowledge received data immediately
+   *
+   * @return Reference to this object
+   *
+   * @note The kernel can leave the quick ACK mode on its own, apply the options again to re-enable it
+   */
+  SocketOptions& quickAck(bool value) noexcept {
+    quickAck_ = value ? 1 : 0;
+    return *this;
+  }
+
+  /**
+   * Sets SO_SNDBUF
+   *
+   * @param[in] bytes Send buffer size in bytes (the kernel doubles it for bookkeeping)
+   *
+   * @return Reference to this object
+   */
+  SocketOptions& sendBuffer(int bytes) noexcept {
+    sendBuffer_ = bytes;
+    return *this;
+  }
+
+  /**
+   * Sets SO_RCVBUF
+   *
+   * @param[in] bytes Receive buffer size in bytes (the kernel doubles it for bookkeeping)
+   *
+   * @return Reference to this object
+   */
+  SocketOptions& receiveBuffer(int bytes) noexcept {
+    receiveBuffer_ = bytes;
+    return *this;
+  }
+
+  /**
+   * Sets SO_BUSY_POLL (Linux)
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] duration How long a blocking read busy polls the device queue before sleeping
+   *
+   * @return Reference to this object
+   *
+   * @note Raising the value above the system default requires CAP_NET_ADMIN
+   */
+  template <typename Duration>
+  SocketOptions& busyPoll(Duration duration) noexcept {
+    busyPoll_ = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    return *this;
+  }
+
+  /**
+   * Checks if any option is set
+   * @return True if applying the options would not change anything
+   */
+  bool empty() const noexcept {
+    return int(kUnset) == noDelay_ && int(kUnset) == quickAck_ && int(kUnset) == sendBuffer_ && int(kUnset) == receiveBuffer_ && int(kUnset) == busyPoll_;
+  }
+
+  /**
+   * Applies the options that are set to a socket
+   *
+   * @param[in] fd Socket file descriptor
+   *
+   * @throw Exception When an option can't be set
+   */
+  void apply(int fd) const {
+    set(fd, IPPROTO_TCP, TCP_NODELAY, noDelay_, "TCP_NODELAY");
+    set(fd, SOL_SOCKET, SO_SNDBUF, sendBuffer_, "SO_SNDBUF");
+    set(fd, SOL_SOCKET, SO_RCVBUF, receiveBuffer_, "SO_RCVBUF");
+#ifdef TCP_QUICKACK
+    set(fd, IPPROTO_TCP, TCP_QUICKACK, quickAck_, "TCP_QUICKACK");
+#else
+    if (kUnset != quickAck_)
+      throw Exception("SocketOptions: TCP_QUICKACK is not supported on this platform!");
+#endif
+#ifdef SO_BUSY_POLL
+    set(fd, SOL_SOCKET, SO_BUSY_POLL, busyPoll_, "SO_BUSY_POLL");
+#else
+    if (kUnset != busyPoll_)
+      throw Exception("SocketOptions: SO_BUSY_POLL is not supported on this platform!");
+#endif
+  }
+
+private:
+
+  /**
+   * Marks an option that is not set
+   */
+  static constexpr int kUnset = -1;
+
+  /**
+   * Sets a single integer socket option
+   *
+   * @param[in] fd Socket file descriptor
+   * @param[in] level Option level
+   * @param[in] name Option name
+   * @param[in] value Option value, nothing is done for kUnset
+   * @param[in] what Option name for the error message
+   *
+   * @throw Exception When setsockopt fails
+   */
+  static void set(int fd, int level, int name, int value, const char* what) {
+    if (int(kUnset) == value)
+      return;
+    if (0 != ::setsockopt(fd, level, name, &value, sizeof(value)))
+      throw Exception(std::string("SocketOptions: Failed to set ") + what + ": " + std::strerror(errno));
+  }
+
+  /**
+   * TCP_NODELAY value
+   */
+  int noDelay_;
+
+  /**
+   * TCP_QUICKACK value
+   */
+  int quickAck_;
+
+  /**
+   * SO_SNDBUF value
+   */
+  int sendBuffer_;
+
+  /**
+   * SO_RCVBUF value
+   */
+  int receiveBuffer_;
+
+  /**
+   * SO_BUSY_POLL value in microseconds
+   */
+  int busyPoll_;
+};
+
+/**
+ * Corks a TCP socket for the lifetime of the object, writes are coalesced into full segments and sent when the
+ * object is destroyed
+ *
+ * Meant to wrap a burst of publishes so they leave the host in as few packets as possible, uses TCP_CORK on Linux
+ * and TCP_NOPUSH elsewhere.
+ */
+class Cork final {
+public:
+
+  /**
+   * Constructor, corks the socket
+   *
+   * @param[in] fd Socket file descriptor (Connection::fd())
+   *
+   * @throw Exception When the socket can't be corked
+   */
+  explicit Cork(int fd) : fd_(fd) {
+    if (!set(1))
+      throw Exception(std::string("Cork: Failed to cork the socket: ") + std::strerror(errno));
+  }
+
+  /**
+   * Destructor, uncorks the socket which flushes the pending partial segment
+   */
+  ~Cork() noexcept {
+    set(0);
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  Cork(const Cork&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  Cork(Cork&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  Cork& operator=(const Cork&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  Cork& operator=(Cork&&) = delete;
+
+private:
+
+  /**
+   * Sets the cork option
+   *
+   * @param[in] value Option value
+   *
+   * @return True on success
+   */
+  bool set(int value) noexcept {
+#ifdef TCP_CORK
+    return 0 == ::setsockopt(fd_, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#else
+    return 0 == ::setsockopt(fd_, IPPROTO_TCP, TCP_NOPUSH, &value, sizeof(value));
+#endif
+  }
+
+  /**
+   * Socket file descriptor
+   */
+  int fd_;
+};
+
+} // namespace rmqcxx
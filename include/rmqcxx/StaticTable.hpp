@@ -0,0 +1,264 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <amqp.h>
+
+#include "Exceptions.hpp"
+#include "FieldValue.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Table with a fixed capacity that owns its keys and string values in an inline buffer
+ *
+ * Unlike Table it does not reference the memory of its arguments and does not allocate, the conversion to
+ * amqp_table_t references the inline storage. Copies and moves rebase the references to their own storage.
+ *
+ * @tparam N Maximum number of entries
+ * @tparam Bytes Size of the buffer holding the keys and the string values
+ *
+ * @note Nested tables and arrays are not supported since their storage can't be owned
+ */
+template <std::size_t N, std::size_t Bytes = 256>
+class StaticTable final {
+public:
+
+  static_assert(N > 0, "A table needs room for at least one entry");
+
+  /**
+   * Constructs an empty table
+   */
+  StaticTable() noexcept : size_(0), used_(0) {}
+
+  /**
+   * Destructor
+   */
+  ~StaticTable() noexcept = default;
+
+  /**
+   * Copy constructor
+   */
+  StaticTable(const StaticTable& other) noexcept {
+    assign(other);
+  }
+
+  /**
+   * Move constructor, same as copying since the storage is inline
+   */
+  StaticTable(StaticTable&& other) noexcept {
+    assign(other);
+  }
+
+  /**
+   * Copy assignment operator
+   */
+  StaticTable& operator=(const StaticTable& other) noexcept {
+    if (this != &other)
+      assign(other);
+    return *this;
+  }
+
+  /**
+   * Move assignment operator, same as copying since the storage is inline
+   */
+  StaticTable& operator=(StaticTable&& other) noexcept {
+    if (this != &other)
+      assign(other);
+    return *this;
+  }
+
+  /**
+   * Adds an entry, the key and a string value are copied into the table
+   *
+   * @param[in] key Name of the entry
+   * @param[in] value Value of the entry
+   *
+   * @return Reference to this object
+   *
+   * @throw Exception When the table is full, the buffer is too small or the value is a table or an array
+   */
+  StaticTable& add(::amqp_bytes_t key, const FieldValue& value) {
+    ::amqp_table_entry_t entry;
+    entry.value = value;
+    if (AMQP_FIELD_KIND_TABLE == entry.value.kind || AMQP_FIELD_KIND_ARRAY == entry.value.kind)
+      throw Exception("StaticTable: Nested tables and arrays are not supported!");
+    if (N == size_)
+      throw Exception("StaticTable: Too many entries!");
+    const bool copied = AMQP_FIELD_KIND_UTF8 == entry.value.kind || AMQP_FIELD_KIND_BYTES == entry.value.kind;
+    if (Bytes - used_ < key.len + (copied ? entry.value.value.bytes.len : 0))
+      throw Exception("StaticTable: Not enough room for the keys and values!");
+    entry.key = store(key);
+    if (copied)
+      entry.value.value.bytes = store(entry.value.value.bytes);
+    entries_[size_++] = entry;
+    return *this;
+  }
+
+  /**
+   * Adds an entry, the key and a string value are copied into the table
+   *
+   * @param[in] key Name of the entry
+   * @param[in] value Value of the entry
+   *
+   * @return Reference to this object
+   *
+   * @throw Exception When the table is full, the buffer is too small or the value is a table or an array
+   */
+  StaticTable& add(const char* key, const FieldValue& value) {
+    return add(::amqp_bytes_t{std::strlen(key), const_cast<char*>(key)}, value);
+  }
+
+  /**
+   * Adds an entry, the key and a string value are copied into the table
+   *
+   * @param[in] key Name of the entry
+   * @param[in] value Value of the entry
+   *
+   * @return Reference to this object
+   *
+   * @throw Exception When the table is full, the buffer is too small or the value is a table or an array
+   */
+  StaticTable& add(const std::string& key, const FieldValue& value) {
+    return add(bytes(key), value);
+  }
+
+  /**
+   * Removes all entries
+   */
+  void clear() noexcept {
+    size_ = 0;
+    used_ = 0;
+  }
+
+  /**
+   * Number of entries
+   * @return Number of entries
+   */
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * Checks if there are no entries
+   * @return True if the table is empty
+   */
+  bool empty() const noexcept {
+    return 0 == size_;
+  }
+
+  /**
+   * Number of buffer bytes used by the keys and the string values
+   * @return Used bytes, at most Bytes
+   */
+  std::size_t used() const noexcept {
+    return used_;
+  }
+
+  /**
+   * Conversion to amqp_table_t, references the storage of this table
+   */
+  operator ::amqp_table_t() const noexcept {
+    return ::amqp_table_t{static_cast<int>(size_), const_cast<::amqp_table_entry_t*>(entries_)};
+  }
+
+private:
+
+  /**
+   * Copies bytes into the buffer, the room has to be checked before
+   *
+   * @param[in] value Bytes to copy
+   *
+   * @return Bytes referencing the copy
+   */
+  ::amqp_bytes_t store(::amqp_bytes_t value) noexcept {
+    if (0 == value.len)
+      return ::amqp_bytes_t{0, nullptr};
+    char* copy = buffer_ + used_;
+    std::memcpy(copy, value.bytes, value.len);
+    used_ += value.len;
+    return ::amqp_bytes_t{value.len, copy};
+  }
+
+  /**
+   * Points bytes of another table to the same offset in this one
+   *
+   * @param[in] other Table the bytes belong to
+   * @param[in] value Bytes referencing the buffer of the other table
+   *
+   * @return Bytes referencing the buffer of this table
+   */
+  ::amqp_bytes_t rebase(const StaticTable& other, ::amqp_bytes_t value) noexcept {
+    if (0 != value.len)
+      value.bytes = buffer_ + (static_cast<const char*>(value.bytes) - other.buffer_);
+    return value;
+  }
+
+  /**
+   * Takes over the entries of another table
+   *
+   * @param[in] other Table to copy
+   */
+  void assign(const StaticTable& other) noexcept {
+    size_ = other.size_;
+    used_ = other.used_;
+    std::memcpy(buffer_, other.buffer_, used_);
+    for (std::size_t i = 0; i < size_; ++i) {
+      entries_[i] = other.entries_[i];
+      entries_[i].key = rebase(other, entries_[i].key);
+      if (AMQP_FIELD_KIND_UTF8 == entries_[i].value.kind || AMQP_FIELD_KIND_BYTES == entries_[i].value.kind)
+        entries_[i].value.value.bytes = rebase(other, entries_[i].value.value.bytes);
+    }
+  }
+
+  /**
+   * Number of entries
+   */
+  std::size_t size_;
+
+  /**
+   * Used bytes of the buffer
+   */
+  std::size_t used_;
+
+  /**
+   * Entry storage
+   */
+  ::amqp_table_entry_t entries_[N];
+
+  /**
+   * Storage of the keys and the string values
+   */
+  char buffer_[Bytes];
+};
+
+} // namespace rmqcxx
@@ -0,0 +1,165 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "Channel.hpp"
+#include "ConsumerCancel.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Re-subscribe policy for consumers cancelled by the broker
+ *
+ * Keeps the subscribe action of every registered consumer and runs it again when the broker cancels that consumer
+ * (basic.cancel), so only the affected consumer is restarted instead of the whole connection.
+ *
+ * Usage:
+ * @code
+ * Subscriptions subscriptions;
+ * subscriptions.add(channel, [&queue] () { return queue.consume("", false, false, false); });
+ * connection.consume(onEnvelope, onReturn, onAck, std::ref(subscriptions));
+ * @endcode
+ *
+ * @note If the queue was deleted the subscribe action fails (the broker closes the channel with 404), the consumer is
+ * then dropped from the registry and the exception propagates to the caller
+ */
+class Subscriptions final {
+public:
+
+  /**
+   * Subscribe action, has to start consuming and return the consumer tag
+   */
+  using Subscribe = std::function<std::string()>;
+
+  /**
+   * Constructor
+   */
+  Subscriptions() = default;
+
+  /**
+   * Destructor
+   */
+  ~Subscriptions() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  Subscriptions(const Subscriptions&) = delete;
+
+  /**
+   * Move constructable
+   */
+  Subscriptions(Subscriptions&&) = default;
+
+  /**
+   * Can't be copy assigned
+   */
+  Subscriptions& operator=(const Subscriptions&) = delete;
+
+  /**
+   * Move assignable
+   */
+  Subscriptions& operator=(Subscriptions&&) = default;
+
+  /**
+   * Subscribes a consumer and registers it for re-subscription
+   *
+   * @param[in] channel Channel the subscribe action consumes on
+   * @param[in] subscribe Subscribe action
+   *
+   * @return Consumer tag
+   *
+   * @throw Whatever the subscribe action throws
+   */
+  std::string add(const Channel& channel, Subscribe subscribe) {
+    auto tag = subscribe();
+    subscriptions_[Key(channel.id(), tag)] = std::move(subscribe);
+    return tag;
+  }
+
+  /**
+   * Removes a consumer from the registry (does not cancel it)
+   *
+   * @param[in] channel Channel the consumer consumes on
+   * @param[in] consumerTag Consumer tag
+   *
+   * @return True if the consumer was registered
+   */
+  bool remove(const Channel& channel, const std::string& consumerTag) {
+    return subscriptions_.erase(Key(channel.id(), consumerTag)) > 0;
+  }
+
+  /**
+   * Handles a consumer cancellation, can be passed as the cancel callback to Connection::consume
+   *
+   * @param[in] cancel Cancellation
+   *
+   * @return True if the consumer was subscribed again
+   *
+   * @throw Whatever the subscribe action throws
+   */
+  bool operator()(const ConsumerCancel& cancel) {
+    auto it = subscriptions_.find(Key(cancel.channel(), cancel.consumerTag()));
+    if (subscriptions_.end() == it)
+      return false;
+    auto subscribe = std::move(it->second);
+    subscriptions_.erase(it);
+    if (!cancel.fromBroker())
+      return false; // cancelled by the client, nothing to restore
+    auto tag = subscribe();
+    subscriptions_[Key(cancel.channel(), std::move(tag))] = std::move(subscribe);
+    return true;
+  }
+
+  /**
+   * Number of registered consumers
+   * @return Number of registered consumers
+   */
+  std::size_t size() const noexcept {
+    return subscriptions_.size();
+  }
+
+private:
+
+  /**
+   * Channel identifier and consumer tag (consumer tags are unique per channel)
+   */
+  using Key = std::pair<::amqp_channel_t, std::string>;
+
+  /**
+   * Subscribe actions of the registered consumers
+   */
+  std::map<Key, Subscribe> subscriptions_;
+};
+
+} // namespace rmqcxx
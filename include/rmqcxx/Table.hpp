@@ -27,53 +27,95 @@ SOFTWARE.
 
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include <amqp.h>
 
+#include "EncodedTable.hpp"
+#include "MemoryResource.hpp"
+
 namespace rmqcxx {
 
+namespace impl {
+  /**
+   * Checks if the first of the arguments is std::allocator_arg_t
+   */
+  template <typename... Args>
+  struct LeadingAllocatorArg : std::false_type {};
+
+  /**
+   * Checks if the first of the arguments is std::allocator_arg_t
+   */
+  template <typename First, typename... Args>
+  struct LeadingAllocatorArg<First, Args...> : std::is_same<typename std::decay<First>::type, std::allocator_arg_t> {};
+} // namespace impl
+
 /**
  * Wrapper around amqp_table_t
+ *
+ * @tparam Allocator Allocator of the entry storage (::amqp_table_entry_t)
  */
-class Table final {
+template <typename Allocator = std::allocator<::amqp_table_entry_t>>
+class BasicTable final {
 public:
 
+  /**
+   * Allocator type
+   */
+  using allocator_type = Allocator;
+
   /**
    * Constructs a table from table entries
    *
    * @tparam Args TableEntry convertible types
    * @param[in] args Table entries
    */
-  template <typename... Args>
-  Table(Args&&... args) noexcept :
+  template <typename... Args, typename std::enable_if<!impl::LeadingAllocatorArg<Args...>::value, int>::type = 0>
+  BasicTable(Args&&... args) noexcept :
     cache_{ static_cast<::amqp_table_entry_t>(args)... },
     value_{ .num_entries = sizeof...(args), .entries = const_cast<::amqp_table_entry_t*>(cache_.data()) } {
   }
 
+  /**
+   * Constructs a table from table entries with the entries allocated by an allocator
+   *
+   * @tparam Args TableEntry convertible types
+   * @param[in] allocator Allocator of the entry storage
+   * @param[in] args Table entries
+   */
+  template <typename... Args>
+  BasicTable(std::allocator_arg_t, const Allocator& allocator, Args&&... args) :
+    cache_({ static_cast<::amqp_table_entry_t>(args)... }, allocator),
+    value_{ .num_entries = sizeof...(args), .entries = cache_.data() } {
+  }
+
   /**
    * Destructor
    */
-  ~Table() noexcept = default;
+  ~BasicTable() noexcept = default;
 
   /**
    * Copy constructor
    */
-  Table(const Table& other) :
+  BasicTable(const BasicTable& other) :
     cache_(other.cache_),
     value_ {.num_entries = static_cast<int>(cache_.size()), .entries = cache_.data()} {}
 
   /**
    * Move constructor
    */
-  Table(Table&& other) noexcept :
+  BasicTable(BasicTable&& other) noexcept :
     cache_(std::move(other.cache_)),
     value_ {.num_entries = static_cast<int>(cache_.size()), .entries = cache_.data()} {}
 
   /**
    * Copy assignment operator
    */
-  Table& operator=(const Table& other) {
+  BasicTable& operator=(const BasicTable& other) {
     cache_ = other.cache_;
     value_.num_entries = cache_.size();
     value_.entries = cache_.data();
@@ -83,13 +125,21 @@ public:
   /**
    * Move assignment operator
    */
-  Table& operator=(Table&& other) noexcept {
+  BasicTable& operator=(BasicTable&& other) noexcept {
     cache_ = std::move(other.cache_);
     value_.num_entries = cache_.size();
     value_.entries = cache_.data();
     return *this;
   }
 
+  /**
+   * Allocator of the entry storage
+   * @return Copy of the allocator
+   */
+  allocator_type get_allocator() const noexcept {
+    return cache_.get_allocator();
+  }
+
   /**
    * Conversion to amqp_table_t const reference
    */
@@ -102,7 +152,7 @@ private:
   /**
    * Storage for entries
    */
-  std::vector<::amqp_table_entry_t> cache_;
+  std::vector<::amqp_table_entry_t, Allocator> cache_;
 
   /**
    * Table cache
@@ -110,4 +160,269 @@ private:
   ::amqp_table_t value_;
 };
 
+/**
+ * Table with the entries on the global heap
+ */
+using Table = BasicTable<>;
+
+#ifdef RMQCXX_HAS_PMR
+namespace pmr {
+  /**
+   * Table with the entries allocated from a std::pmr::memory_resource
+   */
+  using Table = BasicTable<std::pmr::polymorphic_allocator<::amqp_table_entry_t>>;
+} // namespace pmr
+#endif
+
+namespace impl {
+  /**
+   * Checks if the arguments are a single amqp_table_t convertible object (ie: StaticTable)
+   */
+  template <typename... Args>
+  struct SingleTable : std::false_type {};
+
+  /**
+   * Checks if the arguments are a single amqp_table_t convertible object (ie: StaticTable)
+   */
+  template <typename T>
+  struct SingleTable<T> : std::is_convertible<const typename std::decay<T>::type&, ::amqp_table_t> {};
+
+  /**
+   * Checks if a type is an EncodedTable
+   */
+  template <typename T>
+  struct IsEncodedTable : std::false_type {};
+
+  /**
+   * Checks if a type is an EncodedTable
+   */
+  template <std::size_t Size, std::size_t Count>
+  struct IsEncodedTable<EncodedTable<Size, Count>> : std::true_type {};
+
+  /**
+   * Checks if the arguments are a single EncodedTable
+   */
+  template <typename... Args>
+  struct SingleEncodedTable : std::false_type {};
+
+  /**
+   * Checks if the arguments are a single EncodedTable
+   */
+  template <typename T>
+  struct SingleEncodedTable<T> : IsEncodedTable<typename std::decay<T>::type> {};
+
+  /**
+   * Builds the arguments of a method from table entries
+   *
+   * @tparam Args TableEntry convertible types
+   *
+   * @param[in] args Table entries
+   *
+   * @return Table referencing the entries
+   */
+  template <typename... Args, typename std::enable_if<!SingleTable<Args...>::value && !SingleEncodedTable<Args...>::value, int>::type = 0>
+  Table arguments(Args&&... args) {
+    return Table(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Passes a table that was built by the caller as the arguments of a method
+   *
+   * @tparam T amqp_table_t convertible type
+   *
+   * @param[in] table Table
+   *
+   * @return Reference to the table, or the moved table if it is a temporary
+   */
+  template <typename T, typename std::enable_if<SingleTable<T>::value, int>::type = 0>
+  T arguments(T&& table) {
+    return std::forward<T>(table);
+  }
+
+  /**
+   * Passes a table that was encoded at compile time as the arguments of a method
+   *
+   * @tparam Size Size of the encoding
+   * @tparam Count Number of entries
+   *
+   * @param[in] table Encoded table
+   *
+   * @return Entries referencing the encoding
+   */
+  template <std::size_t Size, std::size_t Count>
+  EncodedEntries<Count> arguments(const EncodedTable<Size, Count>& table) noexcept {
+    return table.entries();
+  }
+
+  /**
+   * Encoding of the arguments of a method
+   *
+   * @param[in] arguments Arguments that were not encoded at compile time
+   *
+   * @return Empty bytes, the arguments have to be encoded
+   */
+  template <typename T>
+  ::amqp_bytes_t encoded(const T&) noexcept {
+    return ::amqp_bytes_t{0, nullptr};
+  }
+
+  /**
+   * Encoding of the arguments of a method
+   *
+   * @tparam Count Number of entries
+   *
+   * @param[in] arguments Entries of a table that was encoded at compile time
+   *
+   * @return Encoding of the table
+   */
+  template <std::size_t Count>
+  ::amqp_bytes_t encoded(const EncodedEntries<Count>& arguments) noexcept {
+    return arguments.encoded();
+  }
+} // namespace impl
+
+/**
+ * Deep copy of an amqp_table_t that owns all of its storage
+ *
+ * Table and FieldValue only reference the memory of their arguments, this is used where a table has to outlive them
+ * (for example recorded topology that is replayed after a reconnect).
+ */
+class OwnedTable final {
+public:
+
+  /**
+   * Constructs an empty table
+   */
+  OwnedTable() noexcept : value_{0, nullptr} {}
+
+  /**
+   * Constructs a deep copy of a table
+   *
+   * @param[in] table Table to copy
+   */
+  explicit OwnedTable(const ::amqp_table_t& table) : value_(copy(table)) {}
+
+  /**
+   * Destructor
+   */
+  ~OwnedTable() noexcept = default;
+
+  /**
+   * Copy constructor (deep copy)
+   */
+  OwnedTable(const OwnedTable& other) : value_(copy(other.value_)) {}
+
+  /**
+   * Move constructor, the copied data stays where it is so the table remains valid
+   */
+  OwnedTable(OwnedTable&&) = default;
+
+  /**
+   * Copy assignment operator (deep copy)
+   */
+  OwnedTable& operator=(const OwnedTable& other) {
+    if (this != &other)
+      *this = OwnedTable(other);
+    return *this;
+  }
+
+  /**
+   * Move assignment operator
+   */
+  OwnedTable& operator=(OwnedTable&&) = default;
+
+  /**
+   * Conversion to amqp_table_t
+   */
+  operator ::amqp_table_t() const noexcept {
+    return value_;
+  }
+
+private:
+
+  /**
+   * Copies bytes into owned storage
+   *
+   * @param[in] value Bytes to copy
+   *
+   * @return Bytes referencing the owned copy
+   */
+  ::amqp_bytes_t copy(::amqp_bytes_t value) {
+    if (0 == value.len)
+      return ::amqp_bytes_t{0, nullptr};
+    bytes_.emplace_back(static_cast<const char*>(value.bytes), value.len);
+    return ::amqp_bytes_t{value.len, &bytes_.back()[0]};
+  }
+
+  /**
+   * Deep copies a field value
+   *
+   * @param[in] value Field value to copy
+   *
+   * @return Field value referencing owned copies
+   */
+  ::amqp_field_value_t copy(const ::amqp_field_value_t& value) {
+    ::amqp_field_value_t r = value;
+    switch (value.kind) {
+      case AMQP_FIELD_KIND_UTF8:
+      case AMQP_FIELD_KIND_BYTES:
+        r.value.bytes = copy(value.value.bytes);
+        break;
+      case AMQP_FIELD_KIND_TABLE:
+        r.value.table = copy(value.value.table);
+        break;
+      case AMQP_FIELD_KIND_ARRAY: {
+        values_.emplace_back(value.value.array.entries, value.value.array.entries + value.value.array.num_entries);
+        auto& values = values_.back(); // deque elements don't move when more are added
+        for (auto& x : values)
+          x = copy(x);
+        r.value.array.entries = values.data();
+        break;
+      }
+      default:
+        break;
+    }
+    return r;
+  }
+
+  /**
+   * Deep copies a table
+   *
+   * @param[in] table Table to copy
+   *
+   * @return Table referencing owned copies
+   */
+  ::amqp_table_t copy(const ::amqp_table_t& table) {
+    if (0 == table.num_entries)
+      return ::amqp_table_t{0, nullptr};
+    entries_.emplace_back(table.entries, table.entries + table.num_entries);
+    auto& entries = entries_.back();
+    for (auto& x : entries) {
+      x.key = copy(x.key);
+      x.value = copy(x.value);
+    }
+    return ::amqp_table_t{table.num_entries, entries.data()};
+  }
+
+  /**
+   * Storage of copied bytes
+   */
+  std::deque<std::string> bytes_;
+
+  /**
+   * Storage of copied table entries
+   */
+  std::deque<std::vector<::amqp_table_entry_t>> entries_;
+
+  /**
+   * Storage of copied array values
+   */
+  std::deque<std::vector<::amqp_field_value_t>> values_;
+
+  /**
+   * Copied table
+   */
+  ::amqp_table_t value_;
+};
+
 } // namespace rmqxx
@@ -27,11 +27,13 @@ SOFTWARE.
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include <amqp.h>
 
 #include "FieldValue.hpp"
+#include "MemoryResource.hpp"
 #include "Table.hpp"
 #include "util.hpp"
 
@@ -39,48 +41,82 @@ namespace rmqcxx {
 
 /**
  * Represents a single table entry
- * @tparam T Any ::amqp_field_value_t convertible type
+ * @tparam Allocator Allocator of the key (char)
  */
-class TableEntry final {
+template <typename Allocator = std::allocator<char>>
+class BasicTableEntry final {
 public:
+
+  /**
+   * Allocator type
+   */
+  using allocator_type = Allocator;
+
+  /**
+   * Key type
+   */
+  using Key = std::basic_string<char, std::char_traits<char>, Allocator>;
+
   /**
    * Constructor
    *
    * @param[in] key Name of the table entry
    * @param[in] value Value of the table entry
    */
-  TableEntry(std::string key, FieldValue value) noexcept : key_(std::move(key)), value_(std::move(value)) {}
+  BasicTableEntry(Key key, FieldValue value) noexcept : key_(std::move(key)), value_(std::move(value)) {}
+
+  /**
+   * Constructor with the key allocated by an allocator
+   *
+   * @tparam K Type the key can be constructed from together with the allocator (ie: const char*)
+   *
+   * @param[in] allocator Allocator of the key
+   * @param[in] key Name of the table entry
+   * @param[in] value Value of the table entry
+   */
+  template <typename K>
+  BasicTableEntry(std::allocator_arg_t, const Allocator& allocator, const K& key, FieldValue value) : key_(key, allocator), value_(std::move(value)) {}
 
   /**
    * Constructor
    * @param[in] entry AMQP Table entry
+   * @param[in] allocator Allocator of the key
    */
-  TableEntry(::amqp_table_entry_t entry) noexcept : key_(container<std::string>(entry.key)), value_(FieldValue(entry.value)) {}
+  BasicTableEntry(::amqp_table_entry_t entry, const Allocator& allocator = Allocator()) :
+    key_(static_cast<const char*>(entry.key.bytes), entry.key.len, allocator), value_(FieldValue(entry.value)) {}
 
   /**
    * Destructor
    */
-  ~TableEntry() noexcept = default;
+  ~BasicTableEntry() noexcept = default;
 
   /**
    * Can't be copy constructed
    */
-  TableEntry(const TableEntry&) = delete;
+  BasicTableEntry(const BasicTableEntry&) = delete;
 
   /**
    * Move constructable
    */
-  TableEntry(TableEntry&&) noexcept = default;
+  BasicTableEntry(BasicTableEntry&&) noexcept = default;
 
   /**
    * Can't be copy assigned
    */
-  TableEntry& operator=(const TableEntry&) = delete;
+  BasicTableEntry& operator=(const BasicTableEntry&) = delete;
 
   /**
    * Can't be move assigned
    */
-  TableEntry& operator=(TableEntry&&) noexcept = delete;
+  BasicTableEntry& operator=(BasicTableEntry&&) noexcept = delete;
+
+  /**
+   * Allocator of the key
+   * @return Copy of the allocator
+   */
+  allocator_type get_allocator() const noexcept {
+    return key_.get_allocator();
+  }
 
   /**
    * Conversion to amqp_table_entry_t
@@ -96,11 +132,25 @@ private:
   /**
    * Reference to the table entry name
    */
-  std::string key_;
+  Key key_;
 
   /**
    * Reference to the table entry value
    */
   FieldValue value_;
 };
+
+/**
+ * Table entry with the key on the global heap
+ */
+using TableEntry = BasicTableEntry<>;
+
+#ifdef RMQCXX_HAS_PMR
+namespace pmr {
+  /**
+   * Table entry with the key allocated from a std::pmr::memory_resource
+   */
+  using TableEntry = BasicTableEntry<std::pmr::polymorphic_allocator<char>>;
+} // namespace pmr
+#endif
 } // namespace rmqcxx
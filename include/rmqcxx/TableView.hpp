@@ -0,0 +1,530 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <amqp.h>
+
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+class ArrayView;
+class TableView;
+
+/**
+ * Read-only view of a received field value (ie: a message header), it references the value and never copies it
+ */
+class FieldValueView final {
+public:
+
+  /**
+   * Constructs a view of nothing, as returned for missing keys
+   */
+  FieldValueView() noexcept : value_(nullptr) {}
+
+  /**
+   * Constructor
+   *
+   * @param[in] value Value to reference, has to outlive this view
+   */
+  explicit FieldValueView(const ::amqp_field_value_t& value) noexcept : value_(&value) {}
+
+  /**
+   * Checks if the view references a value
+   * @return False for missing keys
+   */
+  explicit operator bool() const noexcept {
+    return nullptr != value_;
+  }
+
+  /**
+   * Kind of the value
+   * @return Field kind (ie: AMQP_FIELD_KIND_UTF8), 0 if there is no value
+   */
+  uint8_t kind() const noexcept {
+    return nullptr == value_ ? 0 : value_->kind;
+  }
+
+  /**
+   * Reads the value if it is of the matching kind
+   *
+   * @tparam T bool, int8_t, uint8_t, int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t (also timestamps), float,
+   * double, ::amqp_decimal_t, ::amqp_bytes_t (strings and byte arrays, not copied), std::string (copied), TableView or
+   * ArrayView
+   *
+   * @param[out] out Value, untouched if the kind doesn't match
+   *
+   * @return True if the value was read
+   */
+  template <typename T>
+  bool get(T& out) const noexcept(!std::is_same<T, std::string>::value) {
+    return nullptr != value_ && read(*value_, out);
+  }
+
+  /**
+   * Reads the value
+   *
+   * @tparam T Any type accepted by get
+   *
+   * @return Value
+   *
+   * @throw Exception When there is no value or it is of another kind
+   */
+  template <typename T>
+  T as() const {
+    T out{};
+    if (!get(out))
+      throw Exception("FieldValueView: Value of kind '" + std::string(1, nullptr == value_ ? '-' : static_cast<char>(value_->kind)) + "' can't be read as the requested type!");
+    return out;
+  }
+
+  /**
+   * Referenced value
+   * @return Pointer to the value, nullptr if there is none
+   */
+  const ::amqp_field_value_t* value() const noexcept {
+    return value_;
+  }
+
+private:
+
+  /**
+   * Reads a boolean
+   */
+  static bool read(const ::amqp_field_value_t& v, bool& out) noexcept {
+    if (AMQP_FIELD_KIND_BOOLEAN != v.kind)
+      return false;
+    out = 0 != v.value.boolean;
+    return true;
+  }
+
+  /**
+   * Reads an int8_t
+   */
+  static bool read(const ::amqp_field_value_t& v, int8_t& out) noexcept {
+    return AMQP_FIELD_KIND_I8 == v.kind && (out = v.value.i8, true);
+  }
+
+  /**
+   * Reads an uint8_t
+   */
+  static bool read(const ::amqp_field_value_t& v, uint8_t& out) noexcept {
+    return AMQP_FIELD_KIND_U8 == v.kind && (out = v.value.u8, true);
+  }
+
+  /**
+   * Reads an int16_t
+   */
+  static bool read(const ::amqp_field_value_t& v, int16_t& out) noexcept {
+    return AMQP_FIELD_KIND_I16 == v.kind && (out = v.value.i16, true);
+  }
+
+  /**
+   * Reads an uint16_t
+   */
+  static bool read(const ::amqp_field_value_t& v, uint16_t& out) noexcept {
+    return AMQP_FIELD_KIND_U16 == v.kind && (out = v.value.u16, true);
+  }
+
+  /**
+   * Reads an int32_t
+   */
+  static bool read(const ::amqp_field_value_t& v, int32_t& out) noexcept {
+    return AMQP_FIELD_KIND_I32 == v.kind && (out = v.value.i32, true);
+  }
+
+  /**
+   * Reads an uint32_t
+   */
+  static bool read(const ::amqp_field_value_t& v, uint32_t& out) noexcept {
+    return AMQP_FIELD_KIND_U32 == v.kind && (out = v.value.u32, true);
+  }
+
+  /**
+   * Reads an int64_t
+   */
+  static bool read(const ::amqp_field_value_t& v, int64_t& out) noexcept {
+    return AMQP_FIELD_KIND_I64 == v.kind && (out = v.value.i64, true);
+  }
+
+  /**
+   * Reads an uint64_t or a timestamp
+   */
+  static bool read(const ::amqp_field_value_t& v, uint64_t& out) noexcept {
+    return (AMQP_FIELD_KIND_U64 == v.kind || AMQP_FIELD_KIND_TIMESTAMP == v.kind) && (out = v.value.u64, true);
+  }
+
+  /**
+   * Reads a float
+   */
+  static bool read(const ::amqp_field_value_t& v, float& out) noexcept {
+    return AMQP_FIELD_KIND_F32 == v.kind && (out = v.value.f32, true);
+  }
+
+  /**
+   * Reads a double
+   */
+  static bool read(const ::amqp_field_value_t& v, double& out) noexcept {
+    return AMQP_FIELD_KIND_F64 == v.kind && (out = v.value.f64, true);
+  }
+
+  /**
+   * Reads a decimal
+   */
+  static bool read(const ::amqp_field_value_t& v, ::amqp_decimal_t& out) noexcept {
+    return AMQP_FIELD_KIND_DECIMAL == v.kind && (out = v.value.decimal, true);
+  }
+
+  /**
+   * Reads a string or a byte array without copying it
+   */
+  static bool read(const ::amqp_field_value_t& v, ::amqp_bytes_t& out) noexcept {
+    return (AMQP_FIELD_KIND_UTF8 == v.kind || AMQP_FIELD_KIND_BYTES == v.kind) && (out = v.value.bytes, true);
+  }
+
+  /**
+   * Copies a string or a byte array
+   */
+  static bool read(const ::amqp_field_value_t& v, std::string& out) {
+    if (AMQP_FIELD_KIND_UTF8 != v.kind && AMQP_FIELD_KIND_BYTES != v.kind)
+      return false;
+    out.assign(static_cast<const char*>(v.value.bytes.bytes), v.value.bytes.len);
+    return true;
+  }
+
+  /**
+   * Reads a nested table
+   */
+  static bool read(const ::amqp_field_value_t& v, TableView& out) noexcept;
+
+  /**
+   * Reads an array
+   */
+  static bool read(const ::amqp_field_value_t& v, ArrayView& out) noexcept;
+
+  /**
+   * Referenced value
+   */
+  const ::amqp_field_value_t* value_;
+};
+
+/**
+ * Read-only view of a received field array, it references the values and never copies them
+ */
+class ArrayView final {
+public:
+
+  /**
+   * Constructs a view of an empty array
+   */
+  ArrayView() noexcept : array_{0, nullptr} {}
+
+  /**
+   * Constructor
+   *
+   * @param[in] array Array to reference, its values have to outlive this view
+   */
+  explicit ArrayView(const ::amqp_array_t& array) noexcept : array_(array) {}
+
+  /**
+   * Number of values
+   * @return Number of values
+   */
+  std::size_t size() const noexcept {
+    return array_.num_entries > 0 ? static_cast<std::size_t>(array_.num_entries) : 0;
+  }
+
+  /**
+   * Checks if there are no values
+   * @return True if the array is empty
+   */
+  bool empty() const noexcept {
+    return 0 == size();
+  }
+
+  /**
+   * Value at a position
+   *
+   * @param[in] i Position
+   *
+   * @return View of the value, a view of nothing if the position is out of range
+   */
+  FieldValueView operator[](std::size_t i) const noexcept {
+    return i < size() ? FieldValueView(array_.entries[i]) : FieldValueView();
+  }
+
+private:
+
+  /**
+   * Referenced array
+   */
+  ::amqp_array_t array_;
+};
+
+/**
+ * Read-only view of a received field table (ie: the headers of a message)
+ *
+ * Lookups compare the keys in place. Tables of at least kIndexThreshold entries get a hash index on their first lookup,
+ * smaller ones are searched linearly. Keys that appear more than once resolve to their first occurrence either way.
+ *
+ * @note The index is built lazily by a const lookup, a view must not be shared between threads without synchronization
+ */
+class TableView final {
+public:
+
+  /**
+   * Number of entries from which lookups use a hash index
+   */
+  static constexpr std::size_t kIndexThreshold = 16;
+
+  /**
+   * Constructs a view of an empty table
+   */
+  TableView() noexcept : table_{0, nullptr} {}
+
+  /**
+   * Constructor
+   *
+   * @param[in] table Table to reference, its entries have to outlive this view
+   */
+  explicit TableView(const ::amqp_table_t& table) noexcept : table_(table) {}
+
+  /**
+   * Number of entries
+   * @return Number of entries
+   */
+  std::size_t size() const noexcept {
+    return table_.num_entries > 0 ? static_cast<std::size_t>(table_.num_entries) : 0;
+  }
+
+  /**
+   * Checks if there are no entries
+   * @return True if the table is empty
+   */
+  bool empty() const noexcept {
+    return 0 == size();
+  }
+
+  /**
+   * First entry, entries are kept in the order they were received
+   * @return Pointer to the first entry
+   */
+  const ::amqp_table_entry_t* begin() const noexcept {
+    return table_.entries;
+  }
+
+  /**
+   * Past the last entry
+   * @return Pointer past the last entry
+   */
+  const ::amqp_table_entry_t* end() const noexcept {
+    return table_.entries + size();
+  }
+
+  /**
+   * Looks up a value
+   *
+   * @param[in] key Key
+   * @param[in] length Length of the key
+   *
+   * @return View of the value, a view of nothing if the key is missing
+   *
+   * @throw std::bad_alloc When building the index fails
+   */
+  FieldValueView find(const char* key, std::size_t length) const {
+    const ::amqp_table_entry_t* entry = nullptr;
+    if (size() < kIndexThreshold) {
+      for (const auto& x : *this) {
+        if (equal(x.key, key, length)) {
+          entry = &x;
+          break;
+        }
+      }
+    } else {
+      if (index_.empty())
+        buildIndex();
+      const std::size_t mask = index_.size() - 1;
+      for (std::size_t slot = hash(key, length) & mask; 0 != index_[slot]; slot = (slot + 1) & mask) {
+        const auto& x = table_.entries[index_[slot] - 1];
+        if (equal(x.key, key, length)) {
+          entry = &x;
+          break;
+        }
+      }
+    }
+    return nullptr == entry ? FieldValueView() : FieldValueView(entry->value);
+  }
+
+  /**
+   * Looks up a value
+   *
+   * @param[in] key Key
+   *
+   * @return View of the value, a view of nothing if the key is missing
+   *
+   * @throw std::bad_alloc When building the index fails
+   */
+  FieldValueView find(const char* key) const {
+    return find(key, std::strlen(key));
+  }
+
+  /**
+   * Looks up a value
+   *
+   * @param[in] key Key
+   *
+   * @return View of the value, a view of nothing if the key is missing
+   *
+   * @throw std::bad_alloc When building the index fails
+   */
+  FieldValueView find(const std::string& key) const {
+    return find(key.data(), key.size());
+  }
+
+  /**
+   * Looks up a value
+   *
+   * @param[in] key Key
+   *
+   * @return View of the value, a view of nothing if the key is missing
+   *
+   * @throw std::bad_alloc When building the index fails
+   */
+  FieldValueView operator[](const std::string& key) const {
+    return find(key.data(), key.size());
+  }
+
+  /**
+   * Checks if there is a value for a key
+   *
+   * @param[in] key Key
+   *
+   * @return True if the table has the key
+   *
+   * @throw std::bad_alloc When building the index fails
+   */
+  bool contains(const std::string& key) const {
+    return static_cast<bool>(find(key.data(), key.size()));
+  }
+
+  /**
+   * Checks if lookups go through the hash index
+   * @return True once the index was built
+   */
+  bool indexed() const noexcept {
+    return !index_.empty();
+  }
+
+  /**
+   * Checks if the view references a table
+   *
+   * @param[in] table Table
+   *
+   * @return True if the view references the entries of the table
+   */
+  bool references(const ::amqp_table_t& table) const noexcept {
+    return table_.entries == table.entries && table_.num_entries == table.num_entries;
+  }
+
+private:
+
+  /**
+   * Compares a key in place
+   *
+   * @param[in] key Key of an entry
+   * @param[in] data Characters of the other key
+   * @param[in] length Length of the other key
+   *
+   * @return True if the keys are equal
+   */
+  static bool equal(const ::amqp_bytes_t& key, const char* data, std::size_t length) noexcept {
+    return key.len == length && (0 == length || 0 == std::memcmp(key.bytes, data, length));
+  }
+
+  /**
+   * FNV-1a hash of a key
+   *
+   * @param[in] data Characters of the key
+   * @param[in] length Length of the key
+   *
+   * @return Hash
+   */
+  static std::size_t hash(const char* data, std::size_t length) noexcept {
+    uint32_t h = 2166136261U;
+    for (std::size_t i = 0; i < length; ++i)
+      h = (h ^ static_cast<uint8_t>(data[i])) * 16777619U;
+    return h;
+  }
+
+  /**
+   * Builds the open addressing index, slots hold the entry position + 1 (0 is an empty slot)
+   */
+  void buildIndex() const {
+    std::size_t capacity = 1;
+    while (capacity < 2 * size())
+      capacity <<= 1;
+    std::vector<uint32_t> index(capacity, 0);
+    const std::size_t mask = capacity - 1;
+    for (std::size_t i = 0; i < size(); ++i) {
+      const auto& key = table_.entries[i].key;
+      std::size_t slot = hash(static_cast<const char*>(key.bytes), key.len) & mask;
+      while (0 != index[slot] && !equal(table_.entries[index[slot] - 1].key, static_cast<const char*>(key.bytes), key.len))
+        slot = (slot + 1) & mask;
+      if (0 == index[slot])
+        index[slot] = static_cast<uint32_t>(i + 1); // the first occurrence of a duplicate key wins
+    }
+    index_.swap(index);
+  }
+
+  /**
+   * Referenced table
+   */
+  ::amqp_table_t table_;
+
+  /**
+   * Hash index, empty until the first lookup of a large table
+   */
+  mutable std::vector<uint32_t> index_;
+};
+
+inline bool FieldValueView::read(const ::amqp_field_value_t& v, TableView& out) noexcept {
+  return AMQP_FIELD_KIND_TABLE == v.kind && (out = TableView(v.value.table), true);
+}
+
+inline bool FieldValueView::read(const ::amqp_field_value_t& v, ArrayView& out) noexcept {
+  return AMQP_FIELD_KIND_ARRAY == v.kind && (out = ArrayView(v.value.array), true);
+}
+
+} // namespace rmqcxx
@@ -0,0 +1,355 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace rmqcxx {
+
+/**
+ * Hierarchical timing wheel
+ *
+ * Every level has kSlots slots, a slot on level N spans kSlots^N ticks. Scheduling and expiring an item is O(1),
+ * items scheduled far in the future are cascaded to lower levels once per kSlots ticks of the level above.
+ *
+ * @tparam T Movable type of the scheduled items
+ * @tparam Levels Number of wheel levels, the wheel spans kSlots^Levels ticks, longer delays are clamped to that span
+ */
+template <typename T, std::size_t Levels = 4>
+class TimingWheel final {
+public:
+
+  /**
+   * Clock used by the wheel
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Number of slots per level
+   */
+  static constexpr std::size_t kSlots = 64;
+
+  /**
+   * Constructor
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] resolution Duration of a single tick
+   * @param[in] start Point in time that is considered as tick 0
+   */
+  template <typename Duration>
+  explicit TimingWheel(Duration resolution, Clock::time_point start = Clock::now()) :
+    resolution_(std::chrono::duration_cast<Clock::duration>(resolution)), start_(start), tick_(0), size_(0) {
+    if (resolution_ <= Clock::duration::zero())
+      resolution_ = Clock::duration(1);
+  }
+
+  /**
+   * Destructor
+   */
+  ~TimingWheel() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  TimingWheel(const TimingWheel&) = delete;
+
+  /**
+   * Move constructable
+   */
+  TimingWheel(TimingWheel&&) = default;
+
+  /**
+   * Can't be copy assigned
+   */
+  TimingWheel& operator=(const TimingWheel&) = delete;
+
+  /**
+   * Move assignable
+   */
+  TimingWheel& operator=(TimingWheel&&) = default;
+
+  /**
+   * Schedules an item to expire after a delay
+   *
+   * @tparam Duration std::chrono::duration compatible type
+   *
+   * @param[in] delay Delay after which the item expires, rounded up to the wheel resolution
+   * @param[in] value Item to schedule
+   * @param[in] now Point in time the delay is counted from
+   *
+   * @note The delay is counted from now, not from the last advance, the item expires on the next tick at the earliest
+   */
+  template <typename Duration>
+  void schedule(Duration delay, T value, Clock::time_point now = Clock::now()) {
+    const auto& d = std::chrono::duration_cast<Clock::duration>(delay);
+    const auto& at = (now - start_) + (d > Clock::duration::zero() ? d : Clock::duration::zero());
+    uint64_t deadline = at <= Clock::duration::zero() ? 0 : static_cast<uint64_t>((at.count() + resolution_.count() - 1) / resolution_.count());
+    if (deadline <= tick_)
+      deadline = tick_ + 1;
+    insert(Entry{deadline, std::move(value)});
+    ++size_;
+  }
+
+  /**
+   * Advances the wheel up to a point in time and expires due items
+   *
+   * @tparam Callback Callable object that accepts T (std::function<void(T)> compatible)
+   *
+   * @param[in] now Point in time to advance the wheel to
+   * @param[in] callback Callback called for every expired item
+   *
+   * @return Number of expired items
+   *
+   * @note The callback may schedule new items, they expire on the next tick at the earliest
+   * @note If the callback throws, the items that expired on the same tick after the failing one are kept and expire on
+   * the next advance
+   */
+  template <typename Callback>
+  std::size_t advance(Clock::time_point now, Callback callback) {
+    if (now <= start_)
+      return 0;
+    const uint64_t target = static_cast<uint64_t>((now - start_) / resolution_);
+    std::size_t expired = 0;
+    while (tick_ < target) {
+      if (0 == size_) {
+        tick_ = target; // nothing to expire, jump ahead
+        break;
+      }
+      ++tick_;
+      cascade(1);
+      auto& slot = wheels_[0][tick_ % kSlots];
+      if (slot.empty())
+        continue;
+      spare_.swap(slot);
+      size_ -= spare_.size();
+      std::size_t i = 0;
+      try {
+        for (; i < spare_.size(); ++i) {
+          ++expired;
+          callback(std::move(spare_[i].value));
+        }
+      } catch(...) {
+        for (++i; i < spare_.size(); ++i) {
+          spare_[i].deadline = tick_ + 1;
+          insert(std::move(spare_[i]));
+          ++size_;
+        }
+        spare_.clear();
+        throw;
+      }
+      spare_.clear();
+    }
+    return expired;
+  }
+
+  /**
+   * Advances the wheel to the current time
+   *
+   * @tparam Callback Callable object that accepts T (std::function<void(T)> compatible)
+   *
+   * @param[in] callback Callback called for every expired item
+   *
+   * @return Number of expired items
+   */
+  template <typename Callback>
+  std::size_t advance(Callback callback) {
+    return advance(Clock::now(), callback);
+  }
+
+  /**
+   * Removes all items from the wheel
+   */
+  void clear() noexcept {
+    for (auto& level : wheels_)
+      for (auto& slot : level)
+        slot.clear();
+    size_ = 0;
+  }
+
+  /**
+   * Number of scheduled items
+   * @return Number of scheduled items
+   */
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * Checks if there are any scheduled items
+   * @return True if nothing is scheduled
+   */
+  bool empty() const noexcept {
+    return 0 == size_;
+  }
+
+  /**
+   * Earliest point in time at which advance has work to do
+   *
+   * @return Expiry of the nearest item on the lowest level, or the point in time at which the nearest item of a
+   * higher level is cascaded down, Clock::time_point::max() if nothing is scheduled
+   *
+   * @note Suitable as a poll deadline, the wheel has to be advanced again at the returned point in time
+   */
+  Clock::time_point nextExpiry() const noexcept {
+    if (0 == size_)
+      return Clock::time_point::max();
+    uint64_t next = UINT64_MAX;
+    for (std::size_t level = 0; level < Levels; ++level) {
+      const uint64_t block = tick_ >> (kBits * level);
+      for (uint64_t i = 1; i <= kSlots; ++i) {
+        if (!wheels_[level][(block + i) % kSlots].empty()) {
+          next = std::min(next, (block + i) << (kBits * level));
+          break;
+        }
+      }
+    }
+    return start_ + resolution_ * static_cast<Clock::rep>(next);
+  }
+
+  /**
+   * Point in time the wheel was advanced to, delays passed to schedule are relative to it
+   * @return Point in time of the current tick
+   */
+  Clock::time_point position() const noexcept {
+    return start_ + resolution_ * static_cast<Clock::rep>(tick_);
+  }
+
+  /**
+   * Tick resolution
+   * @return Duration of a single tick
+   */
+  Clock::duration resolution() const noexcept {
+    return resolution_;
+  }
+
+private:
+
+  /**
+   * Scheduled item
+   */
+  struct Entry {
+    /**
+     * Tick on which this item expires
+     */
+    uint64_t deadline;
+
+    /**
+     * Item storage
+     */
+    T value;
+  };
+
+  /**
+   * Slot storage, vectors are reused so a steady state does not allocate
+   */
+  using Slot = std::vector<Entry>;
+
+  /**
+   * Number of bits used to index a slot
+   */
+  static constexpr unsigned kBits = 6;
+
+  static_assert((std::size_t(1) << kBits) == kSlots, "Slot count must match the index width");
+  static_assert(Levels > 0 && Levels * kBits < 64, "Unsupported number of levels");
+
+  /**
+   * Puts an entry into the slot that matches its deadline
+   *
+   * @param[in] entry Entry to insert
+   */
+  void insert(Entry entry) {
+    const uint64_t delta = entry.deadline - tick_;
+    std::size_t level = 0;
+    while (level + 1 < Levels && delta >= (uint64_t(1) << (kBits * (level + 1))))
+      ++level;
+    if (delta >= (uint64_t(1) << (kBits * Levels)))
+      entry.deadline = tick_ + (uint64_t(1) << (kBits * Levels)) - 1; // clamp to the span of the wheel
+    wheels_[level][(entry.deadline >> (kBits * level)) % kSlots].emplace_back(std::move(entry));
+  }
+
+  /**
+   * Moves entries from a higher level down when the lower level wraps around
+   *
+   * @param[in] level Level to cascade from
+   */
+  void cascade(std::size_t level) {
+    if (level >= Levels || 0 != (tick_ & ((uint64_t(1) << (kBits * level)) - 1)))
+      return;
+    cascade(level + 1);
+    auto& slot = wheels_[level][(tick_ >> (kBits * level)) % kSlots];
+    if (slot.empty())
+      return;
+    Slot entries;
+    entries.swap(slot);
+    for (auto& x : entries)
+      insert(std::move(x));
+  }
+
+  /**
+   * Tick duration
+   */
+  Clock::duration resolution_;
+
+  /**
+   * Point in time of tick 0
+   */
+  Clock::time_point start_;
+
+  /**
+   * Current tick
+   */
+  uint64_t tick_;
+
+  /**
+   * Number of scheduled items
+   */
+  std::size_t size_;
+
+  /**
+   * Wheel levels
+   */
+  std::array<std::array<Slot, kSlots>, Levels> wheels_;
+
+  /**
+   * Storage for the slot that is currently expiring
+   */
+  Slot spare_;
+};
+
+template <typename T, std::size_t Levels>
+constexpr std::size_t TimingWheel<T, Levels>::kSlots;
+
+template <typename T, std::size_t Levels>
+constexpr unsigned TimingWheel<T, Levels>::kBits;
+
+} // namespace rmqcxx
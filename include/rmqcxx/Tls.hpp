@@ -0,0 +1,353 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <amqp.h>
+#include <amqp_ssl_socket.h>
+
+#include <openssl/ssl.h>
+
+#include "Connection.hpp"
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Cache of TLS sessions shared by connections, lets a reconnect resume the previous session instead of doing a
+ * full handshake
+ *
+ * Sessions are keyed by peer (address:port), only the most recent session of a peer is kept.
+ *
+ * @note Thread safe, can be shared by connections living on different threads
+ */
+class TlsSessionCache final {
+public:
+
+  /**
+   * Constructor
+   */
+  TlsSessionCache() = default;
+
+  /**
+   * Destructor
+   */
+  ~TlsSessionCache() noexcept {
+    for (auto& x : sessions_)
+      ::SSL_SESSION_free(x.second);
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  TlsSessionCache(const TlsSessionCache&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  TlsSessionCache(TlsSessionCache&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  TlsSessionCache& operator=(TlsSessionCache&&) = delete;
+
+  /**
+   * Stores the session of a peer, replacing the previous one
+   *
+   * @param[in] peer Peer identifier
+   * @param[in] session Session, the cache takes over the passed reference
+   */
+  void put(const std::string& peer, ::SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = sessions_[peer];
+    if (nullptr != slot)
+      ::SSL_SESSION_free(slot);
+    slot = session;
+  }
+
+  /**
+   * Gets the session of a peer
+   *
+   * @param[in] peer Peer identifier
+   *
+   * @return New reference to the session (has to be released with SSL_SESSION_free), nullptr if there is none
+   */
+  ::SSL_SESSION* get(const std::string& peer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(peer);
+    if (sessions_.end() == it)
+      return nullptr;
+    ::SSL_SESSION_up_ref(it->second);
+    return it->second;
+  }
+
+  /**
+   * Forgets the session of a peer
+   *
+   * @param[in] peer Peer identifier
+   */
+  void erase(const std::string& peer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(peer);
+    if (sessions_.end() == it)
+      return;
+    ::SSL_SESSION_free(it->second);
+    sessions_.erase(it);
+  }
+
+  /**
+   * Number of cached sessions
+   * @return Number of cached sessions
+   */
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.size();
+  }
+
+private:
+
+  /**
+   * Protects sessions_
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Sessions by peer
+   */
+  std::unordered_map<std::string, ::SSL_SESSION*> sessions_;
+};
+
+/**
+ * TLS transport options
+ */
+struct TlsOptions {
+  /**
+   * Creates options that verify the broker against the default CA bundle and allow TLS 1.2 or newer
+   */
+  TlsOptions() : verifyPeer(true), verifyHostname(true), minVersion(AMQP_TLSv1_2), maxVersion(AMQP_TLSvLATEST) {}
+
+  /**
+   * Creates options with every setting given explicitly
+   *
+   * @param[in] caCertificate Path to the CA certificate bundle, empty to use the library defaults
+   * @param[in] certificate Path to the client certificate, empty for no client certificate
+   * @param[in] key Path to the private key of the client certificate
+   * @param[in] verifyPeer Verify the certificate chain of the broker
+   * @param[in] verifyHostname Verify that the broker certificate matches the address that is connected to
+   * @param[in] minVersion Minimum TLS version
+   * @param[in] maxVersion Maximum TLS version
+   * @param[in] sessionCache Session cache used for resumption, nullptr to always do a full handshake
+   */
+  TlsOptions(std::string caCertificate, std::string certificate, std::string key, bool verifyPeer, bool verifyHostname,
+    ::amqp_tls_version_t minVersion, ::amqp_tls_version_t maxVersion, std::shared_ptr<TlsSessionCache> sessionCache = nullptr) :
+    caCertificate(std::move(caCertificate)), certificate(std::move(certificate)), key(std::move(key)), verifyPeer(verifyPeer),
+    verifyHostname(verifyHostname), minVersion(minVersion), maxVersion(maxVersion), sessionCache(std::move(sessionCache)) {}
+
+  /**
+   * Path to the CA certificate bundle used to verify the broker, empty to use the library defaults
+   */
+  std::string caCertificate;
+
+  /**
+   * Path to the client certificate (required for the EXTERNAL SASL method), empty for no client certificate
+   */
+  std::string certificate;
+
+  /**
+   * Path to the private key of the client certificate
+   */
+  std::string key;
+
+  /**
+   * Verify the certificate chain of the broker (default: true)
+   */
+  bool verifyPeer;
+
+  /**
+   * Verify that the broker certificate matches the address that is connected to (default: true)
+   */
+  bool verifyHostname;
+
+  /**
+   * Minimum TLS version (default: TLS 1.2)
+   */
+  ::amqp_tls_version_t minVersion;
+
+  /**
+   * Maximum TLS version (default: the newest supported)
+   */
+  ::amqp_tls_version_t maxVersion;
+
+  /**
+   * Session cache used for resumption, nullptr to always do a full handshake
+   */
+  std::shared_ptr<TlsSessionCache> sessionCache;
+};
+
+namespace impl {
+
+  /**
+   * Session cache binding stored on the SSL_CTX of a TLS socket
+   */
+  struct TlsResumption {
+    /**
+     * Cache the sessions are stored in
+     */
+    std::shared_ptr<TlsSessionCache> cache;
+
+    /**
+     * Peer identifier
+     */
+    std::string peer;
+  };
+
+  /**
+   * Releases the binding when the SSL_CTX is freed
+   */
+  inline void freeTlsResumption(void*, void* ptr, ::CRYPTO_EX_DATA*, int, long, void*) {
+    delete static_cast<TlsResumption*>(ptr);
+  }
+
+  /**
+   * SSL_CTX ex data index of the session cache binding
+   * @return Index
+   */
+  inline int tlsResumptionIndex() {
+    static const int index = ::SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, freeTlsResumption);
+    return index;
+  }
+
+  /**
+   * Gets the session cache binding of a connection
+   *
+   * @param[in] ssl Connection
+   *
+   * @return Binding, nullptr if there is none
+   */
+  inline TlsResumption* tlsResumption(const ::SSL* ssl) {
+    return static_cast<TlsResumption*>(::SSL_CTX_get_ex_data(::SSL_get_SSL_CTX(ssl), tlsResumptionIndex()));
+  }
+
+  /**
+   * Info callback, offers the cached session before the first ClientHello is written
+   */
+  inline void tlsInfo(const ::SSL* ssl, int where, int) {
+    if (0 == (where & SSL_CB_HANDSHAKE_START) || !::SSL_in_before(ssl))
+      return;
+    auto resumption = tlsResumption(ssl);
+    if (nullptr == resumption)
+      return;
+    auto session = resumption->cache->get(resumption->peer);
+    if (nullptr == session)
+      return;
+    ::SSL_set_session(const_cast<::SSL*>(ssl), session); // takes its own reference
+    ::SSL_SESSION_free(session);
+  }
+
+  /**
+   * New session callback, stores resumable sessions (including TLS 1.3 tickets received after the handshake)
+   *
+   * @return 1 if the reference to the session was taken over
+   */
+  inline int tlsNewSession(::SSL* ssl, ::SSL_SESSION* session) {
+    auto resumption = tlsResumption(ssl);
+    if (nullptr == resumption || !::SSL_SESSION_is_resumable(session))
+      return 0;
+    resumption->cache->put(resumption->peer, session);
+    return 1;
+  }
+
+  /**
+   * Throws if a TLS socket configuration call failed
+   *
+   * @param[in] status Status returned by the configuration call
+   * @param[in] what Description of the call
+   *
+   * @throw Exception When status is not AMQP_STATUS_OK
+   */
+  inline void checkTls(int status, const char* what) {
+    if (AMQP_STATUS_OK != status)
+      throw Exception(std::string("TLS: Failed to ") + what + ": " + ::amqp_error_string2(status));
+  }
+
+} // namespace impl
+
+/**
+ * Creates a socket factory for TLS connections
+ *
+ * @param[in] options TLS options
+ * @param[in] address Address of the broker (the session cache key together with the port)
+ * @param[in] port Port of the broker
+ *
+ * @return Socket factory to pass to the Connection constructor
+ *
+ * @note The returned factory throws Exception when a certificate or key can't be loaded
+ */
+inline SocketFactory tlsSocketFactory(const TlsOptions& options, const std::string& address, int port) {
+  const auto& peer = address + ':' + std::to_string(port);
+  return [options, peer] (::amqp_connection_state_t state) -> ::amqp_socket_t* {
+    auto socket = ::amqp_ssl_socket_new(state);
+    if (nullptr == socket)
+      return nullptr;
+    if (!options.caCertificate.empty())
+      impl::checkTls(::amqp_ssl_socket_set_cacert(socket, options.caCertificate.c_str()), "load the CA certificate");
+    if (!options.certificate.empty())
+      impl::checkTls(::amqp_ssl_socket_set_key(socket, options.certificate.c_str(), options.key.c_str()), "load the client certificate");
+    ::amqp_ssl_socket_set_verify_peer(socket, options.verifyPeer);
+    ::amqp_ssl_socket_set_verify_hostname(socket, options.verifyHostname);
+    impl::checkTls(::amqp_ssl_socket_set_ssl_versions(socket, options.minVersion, options.maxVersion), "set the TLS versions");
+    if (options.sessionCache) {
+      auto ctx = static_cast<::SSL_CTX*>(::amqp_ssl_socket_get_context(socket));
+      if (nullptr == ctx)
+        throw Exception("TLS: Socket has no context!");
+      auto resumption = new impl::TlsResumption{options.sessionCache, peer};
+      if (1 != ::SSL_CTX_set_ex_data(ctx, impl::tlsResumptionIndex(), resumption)) {
+        delete resumption;
+        throw Exception("TLS: Failed to attach the session cache!");
+      }
+      // rabbitmq-c creates the SSL object while opening the socket, the callbacks hook resumption into that handshake
+      ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+      ::SSL_CTX_sess_set_new_cb(ctx, impl::tlsNewSession);
+      ::SSL_CTX_set_info_callback(ctx, impl::tlsInfo);
+    }
+    return socket;
+  };
+}
+
+} // namespace rmqcxx
@@ -0,0 +1,678 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <amqp.h>
+#include <amqp_framing.h>
+
+#include "Connection.hpp"
+#include "Exceptions.hpp"
+#include "Table.hpp"
+#include "util.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Records the topology (channels, qos, exchanges, queues, bindings and consumers) declared through Channel, Exchange
+ * and Queue on a connection and replays it on a new connection
+ *
+ * Recording is enabled with Connection::record. The replay pipelines the recorded methods with nowait set, instead
+ * of waiting for a round trip per method, and then waits for a single synchronous method per channel which fails if
+ * any of the pipelined methods failed.
+ *
+ * @note Declarations done with Channel::rpc or the raw library calls are not recorded
+ */
+class Topology final {
+public:
+
+  /**
+   * Constructor
+   */
+  Topology() = default;
+
+  /**
+   * Destructor
+   */
+  ~Topology() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  Topology(const Topology&) = delete;
+
+  /**
+   * Can't be move constructed
+   */
+  Topology(Topology&&) = delete;
+
+  /**
+   * Can't be copy assigned
+   */
+  Topology& operator=(const Topology&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  Topology& operator=(Topology&&) = delete;
+
+  /**
+   * Records an opened channel
+   *
+   * @param[in] channel Channel identifier
+   */
+  void channelOpened(::amqp_channel_t channel) {
+    channels_[channel] = ChannelRecord{false, 0, 0, false};
+  }
+
+  /**
+   * Records a closed channel, its consumers are forgotten
+   *
+   * @param[in] channel Channel identifier
+   */
+  void channelClosed(::amqp_channel_t channel) {
+    channels_.erase(channel);
+    declared_.erase(channel);
+    for (auto it = consumers_.begin(); it != consumers_.end();) {
+      if (it->second.channel == channel)
+        it = cancelled(it);
+      else
+        ++it;
+    }
+  }
+
+  /**
+   * Records the QoS of a channel
+   *
+   * @param[in] channel Channel identifier
+   * @param[in] prefetchSize Prefetch size
+   * @param[in] prefetchCount Prefetch count
+   * @param[in] global Global flag
+   */
+  void qos(::amqp_channel_t channel, uint32_t prefetchSize, uint16_t prefetchCount, bool global) {
+    channels_[channel] = ChannelRecord{true, prefetchSize, prefetchCount, global};
+  }
+
+  /**
+   * Records a declared exchange
+   *
+   * @param[in] name Exchange name
+   * @param[in] type Exchange type
+   * @param[in] durable Durable flag
+   * @param[in] autoDelete Auto delete flag
+   * @param[in] arguments Declare arguments
+   */
+  void exchangeDeclared(const std::string& name, const std::string& type, bool durable, bool autoDelete, const ::amqp_table_t& arguments) {
+    exchanges_[name] = ExchangeRecord{type, durable, autoDelete, OwnedTable(arguments)};
+  }
+
+  /**
+   * Records a deleted exchange, bindings from and to it are forgotten
+   *
+   * @param[in] name Exchange name
+   */
+  void exchangeDeleted(const std::string& name) {
+    exchanges_.erase(name);
+    for (auto it = bindings_.begin(); it != bindings_.end();) {
+      if (it->second.source == name || (it->second.exchange && it->second.destination == name))
+        it = bindings_.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  /**
+   * Records a declared queue
+   *
+   * @param[in] channel Channel the queue was declared on
+   * @param[in] name Queue name (the generated one for server named queues)
+   * @param[in] serverNamed Set if the queue was declared without a name
+   * @param[in] durable Durable flag
+   * @param[in] exclusive Exclusive flag
+   * @param[in] autoDelete Auto delete flag
+   * @param[in] arguments Declare arguments
+   */
+  void queueDeclared(::amqp_channel_t channel, const std::string& name, bool serverNamed, bool durable, bool exclusive, bool autoDelete, const ::amqp_table_t& arguments) {
+    queues_[name] = QueueRecord{serverNamed, durable, exclusive, autoDelete, OwnedTable(arguments)};
+    declared_[channel] = name;
+  }
+
+  /**
+   * Resolves the name of a queue the way the broker does, an empty name refers to the queue last declared on the channel
+   *
+   * @param[in] channel Channel identifier
+   * @param[in] name Queue name
+   *
+   * @return Queue name
+   */
+  const std::string& resolve(::amqp_channel_t channel, const std::string& name) const {
+    if (!name.empty())
+      return name;
+    auto it = declared_.find(channel);
+    return declared_.end() == it ? name : it->second;
+  }
+
+  /**
+   * Records a deleted queue, its bindings and consumers are forgotten
+   *
+   * @param[in] name Queue name
+   */
+  void queueDeleted(const std::string& name) {
+    queues_.erase(name);
+    for (auto it = bindings_.begin(); it != bindings_.end();) {
+      if (!it->second.exchange && it->second.destination == name)
+        it = bindings_.erase(it);
+      else
+        ++it;
+    }
+    for (auto it = consumers_.begin(); it != consumers_.end();) {
+      if (it->second.queue == name)
+        it = consumers_.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  /**
+   * Records a binding
+   *
+   * @param[in] exchange Set for an exchange to exchange binding, otherwise the destination is a queue
+   * @param[in] destination Destination queue or exchange
+   * @param[in] source Source exchange
+   * @param[in] routingKey Routing key
+   * @param[in] arguments Binding arguments
+   */
+  void bound(bool exchange, const std::string& destination, const std::string& source, const std::string& routingKey, const ::amqp_table_t& arguments) {
+    bindings_[key(exchange, destination, source, routingKey)] = BindingRecord{exchange, destination, source, routingKey, OwnedTable(arguments)};
+  }
+
+  /**
+   * Records a removed binding
+   *
+   * @param[in] exchange Set for an exchange to exchange binding, otherwise the destination is a queue
+   * @param[in] destination Destination queue or exchange
+   * @param[in] source Source exchange
+   * @param[in] routingKey Routing key
+   */
+  void unbound(bool exchange, const std::string& destination, const std::string& source, const std::string& routingKey) {
+    bindings_.erase(key(exchange, destination, source, routingKey));
+  }
+
+  /**
+   * Records a consumer
+   *
+   * @param[in] channel Channel identifier
+   * @param[in] queue Queue name
+   * @param[in] consumerTag Consumer tag (as returned by the broker)
+   * @param[in] noLocal No local flag
+   * @param[in] noAck No ack flag
+   * @param[in] exclusive Exclusive flag
+   * @param[in] arguments Consume arguments
+   */
+  void consumed(::amqp_channel_t channel, const std::string& queue, const std::string& consumerTag, bool noLocal, bool noAck, bool exclusive, const ::amqp_table_t& arguments) {
+    consumers_[key(channel, consumerTag)] = ConsumerRecord{channel, queue, consumerTag, noLocal, noAck, exclusive, OwnedTable(arguments)};
+  }
+
+  /**
+   * Records a cancelled consumer, an auto delete queue is forgotten with its last consumer
+   *
+   * @param[in] channel Channel identifier
+   * @param[in] consumerTag Consumer tag
+   */
+  void cancelled(::amqp_channel_t channel, const std::string& consumerTag) {
+    auto it = consumers_.find(key(channel, consumerTag));
+    if (consumers_.end() != it)
+      cancelled(it);
+  }
+
+  /**
+   * Current name of a queue, server named queues get a new name when they are replayed
+   *
+   * @param[in] name Name the queue was declared (or last replayed) with
+   *
+   * @return Current name of the queue
+   */
+  const std::string& name(const std::string& name) const {
+    auto it = renamed_.find(name);
+    return renamed_.end() == it ? name : it->second;
+  }
+
+  /**
+   * Number of recorded bindings
+   * @return Number of recorded bindings
+   */
+  std::size_t bindings() const noexcept {
+    return bindings_.size();
+  }
+
+  /**
+   * Number of recorded consumers
+   * @return Number of recorded consumers
+   */
+  std::size_t consumers() const noexcept {
+    return consumers_.size();
+  }
+
+  /**
+   * Checks if nothing is recorded
+   * @return True if nothing is recorded
+   */
+  bool empty() const noexcept {
+    return channels_.empty() && exchanges_.empty() && queues_.empty() && bindings_.empty() && consumers_.empty();
+  }
+
+  /**
+   * Forgets everything that was recorded
+   */
+  void clear() noexcept {
+    channels_.clear();
+    exchanges_.clear();
+    queues_.clear();
+    bindings_.clear();
+    consumers_.clear();
+    declared_.clear();
+    renamed_.clear();
+  }
+
+  /**
+   * Replays the recorded topology on a connection
+   *
+   * Channels are opened (and their QoS set) first, then exchanges, queues and bindings are declared on the lowest
+   * recorded channel (or a temporary one with the highest channel identifier if there is none), then consumers are
+   * started on their channels. Server named queues are declared synchronously to learn their new name.
+   *
+   * @param[in] connection Connection to replay on
+   *
+   * @throw ChannelCloseException When a recorded declaration is rejected by the broker
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw OperationException When a method can't be sent
+   * @throw RPCException For general RPC exception
+   */
+  void replay(Connection& connection) {
+    for (const auto& x : channels_) {
+      connection.rpc(::amqp_channel_open, x.first);
+      if (x.second.qos)
+        connection.rpc(::amqp_basic_qos, x.first, x.second.prefetchSize, x.second.prefetchCount, x.second.global);
+    }
+    const bool temporary = channels_.empty();
+    if (temporary && exchanges_.empty() && queues_.empty())
+      return;
+    const auto channel = temporary ? static_cast<::amqp_channel_t>(connection.channelMax()) : channels_.begin()->first;
+    if (temporary)
+      connection.rpc(::amqp_channel_open, channel);
+
+    rename(connection, channel);
+    {
+      auto cork = connection.corked();
+      for (const auto& x : exchanges_) {
+        ::amqp_exchange_declare_t method{0, bytes(x.first), bytes(x.second.type), false, x.second.durable, x.second.autoDelete, false, true, x.second.arguments};
+        send(connection, channel, AMQP_EXCHANGE_DECLARE_METHOD, method);
+      }
+      for (const auto& x : queues_) {
+        if (x.second.serverNamed)
+          continue; // already declared by rename, names starting with amq. can't be declared by clients
+        ::amqp_queue_declare_t method{0, bytes(x.first), false, x.second.durable, x.second.exclusive, x.second.autoDelete, true, x.second.arguments};
+        send(connection, channel, AMQP_QUEUE_DECLARE_METHOD, method);
+      }
+      for (const auto& x : bindings_) {
+        const auto& binding = x.second;
+        if (binding.exchange) {
+          ::amqp_exchange_bind_t method{0, bytes(binding.destination), bytes(binding.source), bytes(binding.routingKey), true, binding.arguments};
+          send(connection, channel, AMQP_EXCHANGE_BIND_METHOD, method);
+        } else {
+          ::amqp_queue_bind_t method{0, bytes(binding.destination), bytes(binding.source), bytes(binding.routingKey), true, binding.arguments};
+          send(connection, channel, AMQP_QUEUE_BIND_METHOD, method);
+        }
+      }
+    }
+    // declarations have to be done before consumers on other channels refer to them
+    barrier(connection, channel);
+    if (temporary) {
+      connection.rpc(::amqp_channel_close, channel, AMQP_REPLY_SUCCESS);
+      return;
+    }
+
+    {
+      auto cork = connection.corked();
+      for (const auto& x : consumers_) {
+        const auto& consumer = x.second;
+        ::amqp_basic_consume_t method{0, bytes(consumer.queue), bytes(consumer.tag), consumer.noLocal, consumer.noAck, consumer.exclusive, true, consumer.arguments};
+        send(connection, consumer.channel, AMQP_BASIC_CONSUME_METHOD, method);
+      }
+    }
+    for (const auto& x : channels_)
+      if (x.first != channel)
+        barrier(connection, x.first);
+  }
+
+private:
+
+  /**
+   * Recorded channel
+   */
+  struct ChannelRecord {
+    /**
+     * Set if QoS was set on the channel
+     */
+    bool qos;
+
+    /**
+     * Prefetch size
+     */
+    uint32_t prefetchSize;
+
+    /**
+     * Prefetch count
+     */
+    uint16_t prefetchCount;
+
+    /**
+     * Global flag
+     */
+    bool global;
+  };
+
+  /**
+   * Recorded exchange
+   */
+  struct ExchangeRecord {
+    /**
+     * Exchange type
+     */
+    std::string type;
+
+    /**
+     * Durable flag
+     */
+    bool durable;
+
+    /**
+     * Auto delete flag
+     */
+    bool autoDelete;
+
+    /**
+     * Declare arguments
+     */
+    OwnedTable arguments;
+  };
+
+  /**
+   * Recorded queue
+   */
+  struct QueueRecord {
+    /**
+     * Set if the queue was declared without a name
+     */
+    bool serverNamed;
+
+    /**
+     * Durable flag
+     */
+    bool durable;
+
+    /**
+     * Exclusive flag
+     */
+    bool exclusive;
+
+    /**
+     * Auto delete flag
+     */
+    bool autoDelete;
+
+    /**
+     * Declare arguments
+     */
+    OwnedTable arguments;
+  };
+
+  /**
+   * Recorded binding
+   */
+  struct BindingRecord {
+    /**
+     * Set for an exchange to exchange binding
+     */
+    bool exchange;
+
+    /**
+     * Destination queue or exchange
+     */
+    std::string destination;
+
+    /**
+     * Source exchange
+     */
+    std::string source;
+
+    /**
+     * Routing key
+     */
+    std::string routingKey;
+
+    /**
+     * Binding arguments
+     */
+    OwnedTable arguments;
+  };
+
+  /**
+   * Recorded consumer
+   */
+  struct ConsumerRecord {
+    /**
+     * Channel identifier
+     */
+    ::amqp_channel_t channel;
+
+    /**
+     * Queue name
+     */
+    std::string queue;
+
+    /**
+     * Consumer tag
+     */
+    std::string tag;
+
+    /**
+     * No local flag
+     */
+    bool noLocal;
+
+    /**
+     * No ack flag
+     */
+    bool noAck;
+
+    /**
+     * Exclusive flag
+     */
+    bool exclusive;
+
+    /**
+     * Consume arguments
+     */
+    OwnedTable arguments;
+  };
+
+  /**
+   * Consumers by channel and tag
+   */
+  using Consumers = std::map<std::string, ConsumerRecord>;
+
+  /**
+   * Binding key
+   */
+  static std::string key(bool exchange, const std::string& destination, const std::string& source, const std::string& routingKey) {
+    std::string r(exchange ? "e" : "q");
+    r.reserve(destination.size() + source.size() + routingKey.size() + 3);
+    r.append(destination).push_back('\0');
+    r.append(source).push_back('\0');
+    r.append(routingKey);
+    return r;
+  }
+
+  /**
+   * Consumer key
+   */
+  static std::string key(::amqp_channel_t channel, const std::string& consumerTag) {
+    return std::to_string(channel) + ':' + consumerTag;
+  }
+
+  /**
+   * Forgets a consumer and its auto delete queue if this was the last consumer of it
+   *
+   * @param[in] it Consumer
+   *
+   * @return Iterator following the removed consumer
+   */
+  Consumers::iterator cancelled(Consumers::iterator it) {
+    const auto queue = it->second.queue;
+    it = consumers_.erase(it);
+    auto q = queues_.find(queue);
+    if (queues_.end() == q || !q->second.autoDelete)
+      return it;
+    for (const auto& x : consumers_)
+      if (x.second.queue == queue)
+        return it;
+    queueDeleted(queue); // no consumer refers to the queue anymore, it stays valid
+    return it;
+  }
+
+  /**
+   * Declares server named queues synchronously and renames their references
+   *
+   * @param[in] connection Connection to declare on
+   * @param[in] channel Channel to declare on
+   */
+  void rename(Connection& connection, ::amqp_channel_t channel) {
+    std::map<std::string, QueueRecord> renamed;
+    for (auto it = queues_.begin(); it != queues_.end();) {
+      if (!it->second.serverNamed) {
+        ++it;
+        continue;
+      }
+      const auto& ok = connection.rpc(::amqp_queue_declare, channel, ::amqp_bytes_t{0, nullptr}, false, it->second.durable, it->second.exclusive, it->second.autoDelete, static_cast<::amqp_table_t>(it->second.arguments));
+      const auto& previous = it->first;
+      const auto& current = container<std::string>(ok->queue);
+      for (auto& x : bindings_)
+        if (!x.second.exchange && x.second.destination == previous)
+          x.second.destination = current;
+      for (auto& x : consumers_)
+        if (x.second.queue == previous)
+          x.second.queue = current;
+      for (auto& x : declared_)
+        if (x.second == previous)
+          x.second = current;
+      for (auto& x : renamed_)
+        if (x.second == previous)
+          x.second = current;
+      renamed_[previous] = current;
+      renamed.emplace(current, std::move(it->second));
+      it = queues_.erase(it);
+    }
+    for (auto& x : renamed)
+      queues_.insert(std::move(x));
+  }
+
+  /**
+   * Sends a method without waiting for a reply
+   *
+   * @tparam Method Method structure type
+   *
+   * @param[in] connection Connection to send on
+   * @param[in] channel Channel to send on
+   * @param[in] id Method identifier
+   * @param[in] method Method
+   *
+   * @throw OperationException When the method can't be sent
+   */
+  template <typename Method>
+  static void send(Connection& connection, ::amqp_channel_t channel, ::amqp_method_number_t id, Method& method) {
+    const auto status = ::amqp_send_method(connection, channel, id, &method);
+    if (AMQP_STATUS_OK != status)
+      throw OperationException(connection, status, "Topology: Failed to send method on channel " + std::to_string(channel) + "!");
+  }
+
+  /**
+   * Synchronous QoS that only completes after all methods sent before it on the channel were processed
+   *
+   * @param[in] connection Connection
+   * @param[in] channel Channel
+   */
+  void barrier(Connection& connection, ::amqp_channel_t channel) {
+    auto it = channels_.find(channel);
+    if (channels_.end() != it && it->second.qos)
+      connection.rpc(::amqp_basic_qos, channel, it->second.prefetchSize, it->second.prefetchCount, it->second.global);
+    else
+      connection.rpc(::amqp_basic_qos, channel, 0, 0, false); // the broker default
+  }
+
+  /**
+   * Channels by identifier
+   */
+  std::map<::amqp_channel_t, ChannelRecord> channels_;
+
+  /**
+   * Exchanges by name
+   */
+  std::map<std::string, ExchangeRecord> exchanges_;
+
+  /**
+   * Queues by name
+   */
+  std::map<std::string, QueueRecord> queues_;
+
+  /**
+   * Bindings by destination, source and routing key
+   */
+  std::map<std::string, BindingRecord> bindings_;
+
+  /**
+   * Consumers by channel and tag
+   */
+  Consumers consumers_;
+
+  /**
+   * Name of the queue last declared on a channel
+   */
+  std::map<::amqp_channel_t, std::string> declared_;
+
+  /**
+   * Current names of server named queues by the names they had before
+   */
+  std::map<std::string, std::string> renamed_;
+};
+
+} // namespace rmqcxx
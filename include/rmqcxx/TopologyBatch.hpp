@@ -0,0 +1,410 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <amqp.h>
+#include <amqp_framing.h>
+
+#include "Channel.hpp"
+#include "Exceptions.hpp"
+#include "Table.hpp"
+#include "util.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Collects exchange, queue and binding declarations and sends them to the broker in one go
+ *
+ * The declarations are sent back to back with the nowait flag set (the socket is corked while sending them), then a
+ * single RPC waits for the broker to process all of them. The broker handles the methods of a channel in order and
+ * closes the channel on the first one it rejects, so a rejection is reported as DeclarationException that names the
+ * rejected declaration.
+ */
+class TopologyBatch final {
+public:
+
+  /**
+   * Constructor
+   *
+   * @param[in] channel Channel to declare on
+   */
+  explicit TopologyBatch(Channel& channel) noexcept : channel_(channel) {}
+
+  /**
+   * Destructor, declarations that were not flushed are dropped
+   */
+  ~TopologyBatch() noexcept = default;
+
+  /**
+   * Can't be copy constructed
+   */
+  TopologyBatch(const TopologyBatch&) = delete;
+
+  /**
+   * Move constructable
+   */
+  TopologyBatch(TopologyBatch&&) = default;
+
+  /**
+   * Can't be copy assigned
+   */
+  TopologyBatch& operator=(const TopologyBatch&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  TopologyBatch& operator=(TopologyBatch&&) = delete;
+
+  /**
+   * Adds an exchange declaration
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   *
+   * @param[in] name Name of the exchange
+   * @param[in] type Type of the exchange
+   * @param[in] durable If set to true will persist after server reboots
+   * @param[in] autoDelete If set tells the server to delete the exchange after all queues are done using it
+   * @param[in] args Extra paramters associated with this exchange
+   *
+   * @return Reference to this batch
+   */
+  template <typename... Args>
+  TopologyBatch& exchange(std::string name, std::string type, bool durable, bool autoDelete, Args&&... args) {
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    declarations_.push_back(Declaration{AMQP_EXCHANGE_DECLARE_METHOD, std::move(name), std::move(type), std::string(), std::string(), durable, false, autoDelete, OwnedTable(arguments)});
+    return *this;
+  }
+
+  /**
+   * Adds a queue declaration
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   *
+   * @param[in] name Name of the queue
+   * @param[in] durable If set the queue will persist after broker restart
+   * @param[in] exclusive If set the declared queue will be exclusive for the connection it was created on
+   * @param[in] autoDelete If set queue will be deleted when there are no more consumers
+   * @param[in] args Any extra parameters associated with this queue
+   *
+   * @return Reference to this batch
+   *
+   * @throw ChannelException When the name is empty (the name assigned by the broker is only in the reply)
+   */
+  template <typename... Args>
+  TopologyBatch& queue(std::string name, bool durable, bool exclusive, bool autoDelete, Args&&... args) {
+    if (name.empty())
+      throw ChannelException(channel_.connection_, channel_, "TopologyBatch: Server named queue can't be declared without waiting for the reply!");
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    declarations_.push_back(Declaration{AMQP_QUEUE_DECLARE_METHOD, std::move(name), std::string(), std::string(), std::string(), durable, exclusive, autoDelete, OwnedTable(arguments)});
+    return *this;
+  }
+
+  /**
+   * Adds a queue binding
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   *
+   * @param[in] queue Name of the queue
+   * @param[in] exchange Name of the exchange to bind the queue to
+   * @param[in] routingKey Routing key to bind the queue with
+   * @param[in] args Any extra parameters associated with this queue binding
+   *
+   * @return Reference to this batch
+   */
+  template <typename... Args>
+  TopologyBatch& bind(std::string queue, std::string exchange, std::string routingKey, Args&&... args) {
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    declarations_.push_back(Declaration{AMQP_QUEUE_BIND_METHOD, std::move(queue), std::string(), std::move(exchange), std::move(routingKey), false, false, false, OwnedTable(arguments)});
+    return *this;
+  }
+
+  /**
+   * Adds an exchange to exchange binding
+   *
+   * @tparam Args TableEntry types, a single amqp_table_t convertible type (ie: StaticTable) or a single EncodedTable
+   *
+   * @param[in] destination Name of the destination exchange
+   * @param[in] source Name of the source exchange
+   * @param[in] routingKey Routing key to bind with
+   * @param[in] args Any extra parameters for this binding
+   *
+   * @return Reference to this batch
+   */
+  template <typename... Args>
+  TopologyBatch& bindExchange(std::string destination, std::string source, std::string routingKey, Args&&... args) {
+    auto&& arguments = impl::arguments(std::forward<Args>(args)...);
+    declarations_.push_back(Declaration{AMQP_EXCHANGE_BIND_METHOD, std::move(destination), std::string(), std::move(source), std::move(routingKey), false, false, false, OwnedTable(arguments)});
+    return *this;
+  }
+
+  /**
+   * Sends all declarations and waits until the broker processed them, the batch is empty afterwards
+   *
+   * Declarations are recorded by the topology recorder of the connection once the broker processed them.
+   *
+   * @throw ChannelException When a declaration can't be sent, the batch is left untouched
+   * @throw DeclarationException When the broker rejected a declaration, the declarations before it were applied
+   * @throw ChannelCloseException When channel for the executed RPC should be closed
+   * @throw ConnectionCloseException When connection for the executed RPC should be closed
+   * @throw LibraryException When there is a library exception
+   * @throw RPCException For general RPC exception
+   */
+  void flush() {
+    if (declarations_.empty())
+      return;
+    {
+      auto cork = channel_.connection_.corked();
+      for (auto& x : declarations_)
+        send(x);
+    }
+    try {
+      // every broker pre-declares amq.direct, passively declaring it is a round trip without side effects
+      const std::string barrier("amq.direct");
+      channel_.rpc(::amqp_exchange_declare, bytes(barrier), bytes(barrier), true, false, false, false, ::amqp_table_t{0, nullptr});
+    } catch(const ChannelCloseException& e) {
+      const auto index = rejected(e);
+      if (declarations_.size() == index) {
+        declarations_.clear();
+        throw;
+      }
+      record(index);
+      const auto declaration = describe(declarations_[index]);
+      declarations_.clear();
+      throw DeclarationException(e, index, declaration);
+    }
+    record(declarations_.size());
+    declarations_.clear();
+  }
+
+  /**
+   * Drops all declarations that were not flushed
+   */
+  void clear() noexcept {
+    declarations_.clear();
+  }
+
+  /**
+   * Number of declarations waiting to be flushed
+   * @return Number of declarations
+   */
+  std::size_t size() const noexcept {
+    return declarations_.size();
+  }
+
+  /**
+   * Checks if there is anything to flush
+   * @return True if there are no declarations
+   */
+  bool empty() const noexcept {
+    return declarations_.empty();
+  }
+
+private:
+
+  /**
+   * Declaration waiting to be flushed
+   */
+  struct Declaration {
+    /**
+     * Method identifier
+     */
+    ::amqp_method_number_t id;
+
+    /**
+     * Exchange or queue name, destination of a binding
+     */
+    std::string name;
+
+    /**
+     * Exchange type
+     */
+    std::string type;
+
+    /**
+     * Source exchange of a binding
+     */
+    std::string source;
+
+    /**
+     * Routing key of a binding
+     */
+    std::string routingKey;
+
+    /**
+     * Durable flag
+     */
+    bool durable;
+
+    /**
+     * Exclusive flag
+     */
+    bool exclusive;
+
+    /**
+     * Auto delete flag
+     */
+    bool autoDelete;
+
+    /**
+     * Arguments
+     */
+    OwnedTable arguments;
+  };
+
+  /**
+   * Sends a declaration with the nowait flag set
+   *
+   * @param[in] x Declaration
+   *
+   * @throw ChannelException When the declaration can't be sent
+   */
+  void send(const Declaration& x) {
+    switch (x.id) {
+      case AMQP_EXCHANGE_DECLARE_METHOD: {
+        ::amqp_exchange_declare_t method{0, bytes(x.name), bytes(x.type), false, x.durable, x.autoDelete, false, true, x.arguments};
+        channel_.send(x.id, &method);
+        break;
+      }
+      case AMQP_QUEUE_DECLARE_METHOD: {
+        ::amqp_queue_declare_t method{0, bytes(x.name), false, x.durable, x.exclusive, x.autoDelete, true, x.arguments};
+        channel_.send(x.id, &method);
+        break;
+      }
+      case AMQP_QUEUE_BIND_METHOD: {
+        ::amqp_queue_bind_t method{0, bytes(x.name), bytes(x.source), bytes(x.routingKey), true, x.arguments};
+        channel_.send(x.id, &method);
+        break;
+      }
+      case AMQP_EXCHANGE_BIND_METHOD: {
+        ::amqp_exchange_bind_t method{0, bytes(x.name), bytes(x.source), bytes(x.routingKey), true, x.arguments};
+        channel_.send(x.id, &method);
+        break;
+      }
+    }
+  }
+
+  /**
+   * Finds the declaration that made the broker close the channel
+   *
+   * The channel close names the method that caused it, among the declarations of that method the first one whose name
+   * is quoted in the reply text is picked (ie: "NOT_FOUND - no exchange 'x' in vhost '/'"), otherwise the first one.
+   *
+   * @param[in] e Channel close
+   *
+   * @return Index of the declaration, size() if no declaration matches the method
+   */
+  std::size_t rejected(const ChannelCloseException& e) const {
+    std::size_t first = declarations_.size();
+    for (std::size_t i = 0; i < declarations_.size(); ++i) {
+      const auto& x = declarations_[i];
+      if (x.id != e.method)
+        continue;
+      if (declarations_.size() == first)
+        first = i;
+      if (quoted(e.replyText, x.name) || quoted(e.replyText, x.source))
+        return i;
+    }
+    return first;
+  }
+
+  /**
+   * Checks if a name is quoted in a text
+   *
+   * @param[in] text Text
+   * @param[in] name Name
+   *
+   * @return True if the text contains the name in single quotes
+   */
+  static bool quoted(const std::string& text, const std::string& name) {
+    return !name.empty() && std::string::npos != text.find('\'' + name + '\'');
+  }
+
+  /**
+   * Describes a declaration
+   *
+   * @param[in] x Declaration
+   *
+   * @return Description
+   */
+  static std::string describe(const Declaration& x) {
+    switch (x.id) {
+      case AMQP_EXCHANGE_DECLARE_METHOD:
+        return "exchange.declare(" + x.name + ", " + x.type + ")";
+      case AMQP_QUEUE_DECLARE_METHOD:
+        return "queue.declare(" + x.name + ")";
+      case AMQP_QUEUE_BIND_METHOD:
+        return "queue.bind(" + x.name + ", " + x.source + ", " + x.routingKey + ")";
+      default:
+        return "exchange.bind(" + x.name + ", " + x.source + ", " + x.routingKey + ")";
+    }
+  }
+
+  /**
+   * Records processed declarations with the topology recorder of the connection
+   *
+   * @param[in] count Number of declarations, from the first one, that the broker processed
+   */
+  void record(std::size_t count) {
+    auto topology = channel_.connection_.topology();
+    if (nullptr == topology)
+      return;
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto& x = declarations_[i];
+      switch (x.id) {
+        case AMQP_EXCHANGE_DECLARE_METHOD:
+          topology->exchangeDeclared(x.name, x.type, x.durable, x.autoDelete, x.arguments);
+          break;
+        case AMQP_QUEUE_DECLARE_METHOD:
+          topology->queueDeclared(channel_.id(), x.name, false, x.durable, x.exclusive, x.autoDelete, x.arguments);
+          break;
+        case AMQP_QUEUE_BIND_METHOD:
+          topology->bound(false, topology->resolve(channel_.id(), x.name), x.source, x.routingKey, x.arguments);
+          break;
+        case AMQP_EXCHANGE_BIND_METHOD:
+          topology->bound(true, x.name, x.source, x.routingKey, x.arguments);
+          break;
+      }
+    }
+  }
+
+  /**
+   * Channel to declare on
+   */
+  Channel& channel_;
+
+  /**
+   * Declarations in the order they were added
+   */
+  std::vector<Declaration> declarations_;
+};
+
+} // namespace rmqcxx
@@ -0,0 +1,545 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <amqp.h>
+#include <amqp_framing.h>
+
+#include "Exceptions.hpp"
+
+namespace rmqcxx {
+
+/**
+ * Encodes AMQP 0-9-1 frames into a byte buffer
+ *
+ * Integers are written in network byte order. The buffer keeps its capacity when cleared, so a writer that is reused
+ * does not allocate in a steady state.
+ */
+class WireWriter final {
+public:
+
+  /**
+   * Constructs an empty writer
+   */
+  WireWriter() = default;
+
+  /**
+   * Destructor
+   */
+  ~WireWriter() noexcept = default;
+
+  /**
+   * Copy constructable
+   */
+  WireWriter(const WireWriter&) = default;
+
+  /**
+   * Move constructable
+   */
+  WireWriter(WireWriter&&) = default;
+
+  /**
+   * Copy assignable
+   */
+  WireWriter& operator=(const WireWriter&) = default;
+
+  /**
+   * Move assignable
+   */
+  WireWriter& operator=(WireWriter&&) = default;
+
+  /**
+   * Removes the written bytes, keeps the capacity
+   */
+  void clear() noexcept {
+    buffer_.clear();
+  }
+
+  /**
+   * Makes room for more bytes so the following writes don't allocate
+   * @param[in] size Number of bytes that are about to be written
+   */
+  void reserve(std::size_t size) {
+    buffer_.reserve(buffer_.size() + size);
+  }
+
+  /**
+   * Written bytes
+   * @return Pointer to the written bytes
+   */
+  const uint8_t* data() const noexcept {
+    return buffer_.data();
+  }
+
+  /**
+   * Number of written bytes
+   * @return Number of written bytes
+   */
+  std::size_t size() const noexcept {
+    return buffer_.size();
+  }
+
+  /**
+   * Checks if anything was written
+   * @return True if nothing was written
+   */
+  bool empty() const noexcept {
+    return buffer_.empty();
+  }
+
+  /**
+   * Writes the AMQP 0-9-1 protocol header
+   */
+  void protocolHeader() {
+    static const uint8_t header[] = {'A', 'M', 'Q', 'P', 0, AMQP_PROTOCOL_VERSION_MAJOR, AMQP_PROTOCOL_VERSION_MINOR, AMQP_PROTOCOL_VERSION_REVISION};
+    bytes(header, sizeof(header));
+  }
+
+  /**
+   * Starts a frame, the payload is written after this call
+   *
+   * @param[in] type Frame type (ie: AMQP_FRAME_METHOD)
+   * @param[in] channel Channel identifier
+   *
+   * @return Position of the frame that has to be passed to endFrame
+   */
+  std::size_t beginFrame(uint8_t type, ::amqp_channel_t channel) {
+    const std::size_t start = buffer_.size();
+    u8(type);
+    u16(channel);
+    u32(0); // patched by endFrame
+    return start;
+  }
+
+  /**
+   * Starts a method frame, the method arguments are written after this call
+   *
+   * @param[in] channel Channel identifier
+   * @param[in] method Method identifier (ie: AMQP_CONNECTION_TUNE_OK_METHOD)
+   *
+   * @return Position of the frame that has to be passed to endFrame
+   */
+  std::size_t beginMethod(::amqp_channel_t channel, ::amqp_method_number_t method) {
+    const std::size_t start = beginFrame(AMQP_FRAME_METHOD, channel);
+    u32(method);
+    return start;
+  }
+
+  /**
+   * Finishes a frame
+   *
+   * @param[in] start Position returned by beginFrame or beginMethod
+   */
+  void endFrame(std::size_t start) {
+    patch32(start + 3, static_cast<uint32_t>(buffer_.size() - start - kFrameHeaderSize));
+    u8(AMQP_FRAME_END);
+  }
+
+  /**
+   * Writes an octet
+   * @param[in] value Value to write
+   */
+  void u8(uint8_t value) {
+    buffer_.push_back(value);
+  }
+
+  /**
+   * Writes a short integer
+   * @param[in] value Value to write
+   */
+  void u16(uint16_t value) {
+    const uint8_t b[] = {static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+    bytes(b, sizeof(b));
+  }
+
+  /**
+   * Writes a long integer
+   * @param[in] value Value to write
+   */
+  void u32(uint32_t value) {
+    const uint8_t b[] = {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+    bytes(b, sizeof(b));
+  }
+
+  /**
+   * Writes a long long integer
+   * @param[in] value Value to write
+   */
+  void u64(uint64_t value) {
+    u32(static_cast<uint32_t>(value >> 32));
+    u32(static_cast<uint32_t>(value));
+  }
+
+  /**
+   * Writes raw bytes
+   *
+   * @param[in] data Bytes to write
+   * @param[in] size Number of bytes
+   */
+  void bytes(const void* data, std::size_t size) {
+    const auto* begin = static_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), begin, begin + size);
+  }
+
+  /**
+   * Writes a short string (at most 255 bytes)
+   *
+   * @param[in] data Bytes of the string
+   * @param[in] size Length of the string
+   *
+   * @throw Exception When the string is longer than 255 bytes
+   */
+  void shortString(const void* data, std::size_t size) {
+    if (size > UINT8_MAX)
+      throw Exception("Short string too long: " + std::to_string(size));
+    u8(static_cast<uint8_t>(size));
+    bytes(data, size);
+  }
+
+  /**
+   * Writes a short string (at most 255 bytes)
+   *
+   * @param[in] value String to write
+   *
+   * @throw Exception When the string is longer than 255 bytes
+   */
+  void shortString(const ::amqp_bytes_t& value) {
+    shortString(value.bytes, value.len);
+  }
+
+  /**
+   * Writes a long string
+   *
+   * @param[in] data Bytes of the string
+   * @param[in] size Length of the string
+   */
+  void longString(const void* data, std::size_t size) {
+    u32(static_cast<uint32_t>(size));
+    bytes(data, size);
+  }
+
+  /**
+   * Writes a long string
+   * @param[in] value String to write
+   */
+  void longString(const ::amqp_bytes_t& value) {
+    longString(value.bytes, value.len);
+  }
+
+  /**
+   * Writes a field table
+   *
+   * @param[in] value Table to write
+   *
+   * @throw Exception When a key is longer than 255 bytes or a value is of an unknown kind
+   */
+  void table(const ::amqp_table_t& value) {
+    const std::size_t start = buffer_.size();
+    u32(0); // patched once the entries are written
+    for (int i = 0; i < value.num_entries; ++i) {
+      shortString(value.entries[i].key);
+      field(value.entries[i].value);
+    }
+    patch32(start, static_cast<uint32_t>(buffer_.size() - start - 4));
+  }
+
+  /**
+   * Writes a field array
+   *
+   * @param[in] value Array to write
+   *
+   * @throw Exception When a value is of an unknown kind
+   */
+  void array(const ::amqp_array_t& value) {
+    const std::size_t start = buffer_.size();
+    u32(0); // patched once the entries are written
+    for (int i = 0; i < value.num_entries; ++i)
+      field(value.entries[i]);
+    patch32(start, static_cast<uint32_t>(buffer_.size() - start - 4));
+  }
+
+  /**
+   * Writes a field value with its kind
+   *
+   * @param[in] value Value to write
+   *
+   * @throw Exception When the value is of an unknown kind
+   */
+  void field(const ::amqp_field_value_t& value) {
+    u8(value.kind);
+    switch (value.kind) {
+      case AMQP_FIELD_KIND_BOOLEAN: u8(value.value.boolean ? 1 : 0); break;
+      case AMQP_FIELD_KIND_I8: u8(static_cast<uint8_t>(value.value.i8)); break;
+      case AMQP_FIELD_KIND_U8: u8(value.value.u8); break;
+      case AMQP_FIELD_KIND_I16: u16(static_cast<uint16_t>(value.value.i16)); break;
+      case AMQP_FIELD_KIND_U16: u16(value.value.u16); break;
+      case AMQP_FIELD_KIND_I32: u32(static_cast<uint32_t>(value.value.i32)); break;
+      case AMQP_FIELD_KIND_U32: u32(value.value.u32); break;
+      case AMQP_FIELD_KIND_I64: u64(static_cast<uint64_t>(value.value.i64)); break;
+      case AMQP_FIELD_KIND_U64: case AMQP_FIELD_KIND_TIMESTAMP: u64(value.value.u64); break;
+      case AMQP_FIELD_KIND_F32: {
+        uint32_t bits;
+        std::memcpy(&bits, &value.value.f32, sizeof(bits));
+        u32(bits);
+        break;
+      }
+      case AMQP_FIELD_KIND_F64: {
+        uint64_t bits;
+        std::memcpy(&bits, &value.value.f64, sizeof(bits));
+        u64(bits);
+        break;
+      }
+      case AMQP_FIELD_KIND_DECIMAL: u8(value.value.decimal.decimals); u32(value.value.decimal.value); break;
+      case AMQP_FIELD_KIND_UTF8: case AMQP_FIELD_KIND_BYTES: longString(value.value.bytes); break;
+      case AMQP_FIELD_KIND_ARRAY: array(value.value.array); break;
+      case AMQP_FIELD_KIND_TABLE: table(value.value.table); break;
+      case AMQP_FIELD_KIND_VOID: break;
+      default: throw Exception("Unknown field kind: " + std::to_string(value.kind));
+    }
+  }
+
+  /**
+   * Size of the frame header (type, channel and payload size)
+   */
+  static constexpr std::size_t kFrameHeaderSize = 7;
+
+private:
+
+  /**
+   * Overwrites a long integer
+   *
+   * @param[in] position Position of the integer
+   * @param[in] value Value to write
+   */
+  void patch32(std::size_t position, uint32_t value) noexcept {
+    buffer_[position] = static_cast<uint8_t>(value >> 24);
+    buffer_[position + 1] = static_cast<uint8_t>(value >> 16);
+    buffer_[position + 2] = static_cast<uint8_t>(value >> 8);
+    buffer_[position + 3] = static_cast<uint8_t>(value);
+  }
+
+  /**
+   * Written bytes
+   */
+  std::vector<uint8_t> buffer_;
+};
+
+/**
+ * Frame found in a byte buffer by WireReader::frame, the payload points into the buffer
+ */
+struct WireFrame {
+  /**
+   * Frame type (ie: AMQP_FRAME_METHOD)
+   */
+  uint8_t type;
+
+  /**
+   * Channel identifier
+   */
+  ::amqp_channel_t channel;
+
+  /**
+   * Payload of the frame
+   */
+  const uint8_t* payload;
+
+  /**
+   * Size of the payload
+   */
+  std::size_t size;
+};
+
+/**
+ * Decodes AMQP 0-9-1 data from a byte buffer (non owning)
+ */
+class WireReader final {
+public:
+
+  /**
+   * Constructor
+   *
+   * @param[in] data Bytes to read
+   * @param[in] size Number of bytes
+   */
+  WireReader(const uint8_t* data, std::size_t size) noexcept : data_(data), size_(size), position_(0) {}
+
+  /**
+   * Constructs a reader of a frame payload
+   *
+   * @param[in] frame Frame to read
+   */
+  explicit WireReader(const WireFrame& frame) noexcept : WireReader(frame.payload, frame.size) {}
+
+  /**
+   * Finds the first complete frame in a buffer
+   *
+   * @param[in] data Bytes received so far
+   * @param[in] size Number of bytes
+   * @param[in] maxSize Maximum payload size that is accepted
+   * @param[out] frame Frame that was found
+   *
+   * @return Number of bytes the frame takes up in the buffer, 0 if the buffer does not contain a complete frame yet
+   *
+   * @throw Exception When the frame is larger than maxSize or not terminated by the frame end octet
+   */
+  static std::size_t frame(const uint8_t* data, std::size_t size, std::size_t maxSize, WireFrame& frame) {
+    if (size < WireWriter::kFrameHeaderSize)
+      return 0;
+    WireReader header(data, size);
+    frame.type = header.u8();
+    frame.channel = header.u16();
+    frame.size = header.u32();
+    if (frame.size > maxSize)
+      throw Exception("Frame too large: " + std::to_string(frame.size));
+    const std::size_t total = WireWriter::kFrameHeaderSize + frame.size + 1;
+    if (size < total)
+      return 0;
+    if (AMQP_FRAME_END != data[total - 1])
+      throw Exception("Missing frame end");
+    frame.payload = data + WireWriter::kFrameHeaderSize;
+    return total;
+  }
+
+  /**
+   * Number of bytes left to read
+   * @return Number of bytes left
+   */
+  std::size_t remaining() const noexcept {
+    return size_ - position_;
+  }
+
+  /**
+   * Reads an octet
+   * @return Value
+   * @throw Exception When there is not enough data
+   */
+  uint8_t u8() {
+    return *advance(1);
+  }
+
+  /**
+   * Reads a short integer
+   * @return Value
+   * @throw Exception When there is not enough data
+   */
+  uint16_t u16() {
+    const uint8_t* b = advance(2);
+    return static_cast<uint16_t>((b[0] << 8) | b[1]);
+  }
+
+  /**
+   * Reads a long integer
+   * @return Value
+   * @throw Exception When there is not enough data
+   */
+  uint32_t u32() {
+    const uint8_t* b = advance(4);
+    return (static_cast<uint32_t>(b[0]) << 24) | (static_cast<uint32_t>(b[1]) << 16) | (static_cast<uint32_t>(b[2]) << 8) | b[3];
+  }
+
+  /**
+   * Reads a long long integer
+   * @return Value
+   * @throw Exception When there is not enough data
+   */
+  uint64_t u64() {
+    const uint64_t high = u32();
+    return (high << 32) | u32();
+  }
+
+  /**
+   * Reads a short string
+   * @return Value
+   * @throw Exception When there is not enough data
+   */
+  std::string shortString() {
+    const std::size_t length = u8();
+    const auto* b = advance(length);
+    return std::string(reinterpret_cast<const char*>(b), length);
+  }
+
+  /**
+   * Reads a long string
+   * @return Value
+   * @throw Exception When there is not enough data
+   */
+  std::string longString() {
+    const std::size_t length = u32();
+    const auto* b = advance(length);
+    return std::string(reinterpret_cast<const char*>(b), length);
+  }
+
+  /**
+   * Skips a field table
+   * @throw Exception When there is not enough data
+   */
+  void skipTable() {
+    advance(u32());
+  }
+
+private:
+
+  /**
+   * Moves the read position
+   *
+   * @param[in] count Number of bytes to move by
+   *
+   * @return Pointer to the bytes that were skipped
+   *
+   * @throw Exception When there is not enough data
+   */
+  const uint8_t* advance(std::size_t count) {
+    if (count > remaining())
+      throw Exception("Truncated AMQP data");
+    const uint8_t* b = data_ + position_;
+    position_ += count;
+    return b;
+  }
+
+  /**
+   * Data to read
+   */
+  const uint8_t* data_;
+
+  /**
+   * Size of the data
+   */
+  std::size_t size_;
+
+  /**
+   * Read position
+   */
+  std::size_t position_;
+};
+
+} // namespace rmqcxx
@@ -30,6 +30,8 @@ SOFTWARE.
 #include <cstring>
 #include <chrono>
 #include <functional>
+#include <string>
+#include <type_traits>
 
 #include <amqp.h>
 
@@ -90,6 +92,21 @@ namespace impl {
   std::string decodeCloseMethod(const T* decoded) {
     return std::string("Code: ") + std::to_string(decoded->reply_code) + " Message: " + container<std::string>(decoded->reply_text);
   }
+
+  /**
+   * Checks if a type is a std::chrono::duration
+   * @tparam T Type to check
+   */
+  template <typename T>
+  struct isDuration : std::false_type {};
+
+  /**
+   * Checks if a type is a std::chrono::duration
+   * @tparam Rep Duration representation
+   * @tparam Period Duration period
+   */
+  template <typename Rep, typename Period>
+  struct isDuration<std::chrono::duration<Rep, Period>> : std::true_type {};
 } // namespace impl
 
 /**
@@ -159,4 +176,87 @@ private:
   std::function<void()> function;
 };
 
+/**
+ * Calls a callable object when it goes out of scope, unlike defer the callable is stored as it is (no std::function,
+ * no allocation)
+ *
+ * @tparam Function Callable object without arguments (ie: a lambda)
+ */
+template <typename Function>
+class ScopeGuard final {
+public:
+  /**
+   * Constructor
+   *
+   * @param[in] f Function to call upon destruction
+   */
+  explicit ScopeGuard(Function f) noexcept : function_(std::move(f)), active_(true) {}
+
+  /**
+   * Calls the function that was passed in the constructor unless it was moved away
+   */
+  ~ScopeGuard() noexcept(false) { // the function may throw, ie: Connection::rpc reports the reply from the guard
+    if (active_)
+      function_();
+  }
+
+  /**
+   * Can't be copy constructed
+   */
+  ScopeGuard(const ScopeGuard&) = delete;
+
+  /**
+   * Move constructable, the other guard won't call the function
+   */
+  ScopeGuard(ScopeGuard&& other) noexcept : function_(std::move(other.function_)), active_(other.active_) {
+    other.active_ = false;
+  }
+
+  /**
+   * Can't be copy assigned
+   */
+  ScopeGuard& operator=(const ScopeGuard&) = delete;
+
+  /**
+   * Can't be move assigned
+   */
+  ScopeGuard& operator=(ScopeGuard&&) = delete;
+
+private:
+  /**
+   * Function storage
+   */
+  Function function_;
+
+  /**
+   * Set while the function has to be called
+   */
+  bool active_;
+};
+
+/**
+ * Creates a ScopeGuard
+ *
+ * @tparam Function Callable object without arguments
+ *
+ * @param[in] f Function to call when the guard goes out of scope
+ *
+ * @return Guard to keep in a local variable (auto g = makeScopeGuard(...);)
+ */
+template <typename Function>
+ScopeGuard<Function> makeScopeGuard(Function f) noexcept {
+  return ScopeGuard<Function>(std::move(f));
+}
+
+namespace impl {
+  /**
+   * Empty string that can be passed as a context without constructing one
+   * @return Reference to an empty string
+   */
+  inline const std::string& noContext() noexcept {
+    static const std::string empty;
+    return empty;
+  }
+} // namespace impl
+
 } // namespace rmqcxx
@@ -0,0 +1,96 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rmqcxx.hpp>
+
+using namespace benchmark;
+using namespace rmqcxx;
+using namespace std;
+using namespace std::chrono;
+
+static void deduplicatorHash(State& state) {
+  const string id("5f1c9e0a-8a3b-4d7e-9a51-1b0f6c2d4e8f");
+  for (auto _ : state)
+    DoNotOptimize(impl::hash(id.data(), id.size()));
+}
+BENCHMARK(deduplicatorHash);
+
+static void deduplicatorUnknown(State& state) {
+  const size_t capacity = static_cast<size_t>(state.range(0));
+  Deduplicator dedup(capacity, minutes(10));
+  const auto now = Deduplicator::Clock::now();
+  for (size_t i = 0; i < capacity; ++i)
+    dedup.insert(impl::hash(&i, sizeof(i)), now);
+
+  uint64_t i = capacity;
+  for (auto _ : state) {
+    ++i;
+    DoNotOptimize(dedup.contains(impl::hash(&i, sizeof(i)), now));
+  }
+}
+BENCHMARK(deduplicatorUnknown)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void deduplicatorKnown(State& state) {
+  const size_t capacity = static_cast<size_t>(state.range(0));
+  Deduplicator dedup(capacity, minutes(10));
+  const auto now = Deduplicator::Clock::now();
+  vector<uint64_t> keys(capacity);
+  for (size_t i = 0; i < capacity; ++i) {
+    keys[i] = impl::hash(&i, sizeof(i));
+    dedup.insert(keys[i], now);
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    DoNotOptimize(dedup.contains(keys[i], now));
+    if (++i == capacity)
+      i = 0;
+  }
+}
+BENCHMARK(deduplicatorKnown)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void deduplicatorInsert(State& state) {
+  const size_t capacity = static_cast<size_t>(state.range(0));
+  Deduplicator dedup(capacity, minutes(10));
+  const auto now = Deduplicator::Clock::now();
+
+  uint64_t i = 0;
+  for (auto _ : state) {
+    ++i;
+    dedup.insert(impl::hash(&i, sizeof(i)), now);
+  }
+}
+BENCHMARK(deduplicatorInsert)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,118 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rmqcxx.hpp>
+
+using namespace benchmark;
+using namespace rmqcxx;
+using namespace std;
+
+static amqp_basic_properties_t properties() {
+  amqp_basic_properties_t p{};
+  p._flags = AMQP_BASIC_CONTENT_TYPE_FLAG | AMQP_BASIC_DELIVERY_MODE_FLAG;
+  p.content_type = amqp_cstring_bytes("application/json");
+  p.delivery_mode = 2;
+  return p;
+}
+
+// Payload of the method frame and the property list written by MethodEncoder, compared to rabbitmq-c's encoders
+static bool sameAsLibrary(const string& body) {
+  auto p = properties();
+  amqp_basic_publish_t publish{0, amqp_cstring_bytes("exchange"), amqp_cstring_bytes("routing.key"), 0, 0};
+  vector<uint8_t> buffer(4096);
+  const int methodSize = amqp_encode_method(AMQP_BASIC_PUBLISH_METHOD, &publish, amqp_bytes_t{buffer.size(), buffer.data()});
+  WireWriter out;
+  MethodEncoder::publish(out, 1, publish.exchange, publish.routing_key, false, false, p, amqp_bytes_t{body.size(), const_cast<char*>(body.data())}, 131072);
+  if (methodSize < 0 || 0 != memcmp(out.data() + WireWriter::kFrameHeaderSize + 4, buffer.data(), static_cast<size_t>(methodSize)))
+    return false;
+  const size_t header = WireWriter::kFrameHeaderSize + 4 + static_cast<size_t>(methodSize) + 1;
+  const int propertiesSize = amqp_encode_properties(AMQP_BASIC_CLASS, &p, amqp_bytes_t{buffer.size(), buffer.data()});
+  return propertiesSize >= 0 && 0 == memcmp(out.data() + header + WireWriter::kFrameHeaderSize + 12, buffer.data(), static_cast<size_t>(propertiesSize));
+}
+
+static void encodeAckLibrary(State& state) {
+  vector<uint8_t> buffer(64);
+  amqp_basic_ack_t ack{0, 0};
+  for (auto _ : state) {
+    ++ack.delivery_tag;
+    DoNotOptimize(amqp_encode_method(AMQP_BASIC_ACK_METHOD, &ack, amqp_bytes_t{buffer.size(), buffer.data()}));
+  }
+}
+BENCHMARK(encodeAckLibrary);
+
+static void encodeAckNative(State& state) {
+  WireWriter out;
+  uint64_t tag = 0;
+  for (auto _ : state) {
+    out.clear();
+    MethodEncoder::ack(out, 1, ++tag, false);
+    DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(encodeAckNative);
+
+static void encodePublishLibrary(State& state) {
+  const string body(static_cast<size_t>(state.range(0)), 'x');
+  const auto p = properties();
+  amqp_basic_publish_t publish{0, amqp_cstring_bytes("exchange"), amqp_cstring_bytes("routing.key"), 0, 0};
+  vector<uint8_t> buffer(body.size() + 4096);
+  for (auto _ : state) {
+    // the method and properties are encoded by rabbitmq-c, the body is copied into the frame
+    const int methodSize = amqp_encode_method(AMQP_BASIC_PUBLISH_METHOD, &publish, amqp_bytes_t{buffer.size(), buffer.data()});
+    const int propertiesSize = amqp_encode_properties(AMQP_BASIC_CLASS, const_cast<amqp_basic_properties_t*>(&p), amqp_bytes_t{buffer.size() - methodSize, buffer.data() + methodSize});
+    memcpy(buffer.data() + methodSize + propertiesSize, body.data(), body.size());
+    DoNotOptimize(buffer.data());
+  }
+}
+BENCHMARK(encodePublishLibrary)->Range(16, 64 << 10);
+
+static void encodePublishNative(State& state) {
+  const string body(static_cast<size_t>(state.range(0)), 'x');
+  if (!sameAsLibrary(body)) {
+    state.SkipWithError("MethodEncoder output differs from rabbitmq-c");
+    return;
+  }
+  const auto p = properties();
+  const auto exchange = amqp_cstring_bytes("exchange");
+  const auto routingKey = amqp_cstring_bytes("routing.key");
+  WireWriter out;
+  for (auto _ : state) {
+    out.clear();
+    MethodEncoder::publish(out, 1, exchange, routingKey, false, false, p, amqp_bytes_t{body.size(), const_cast<char*>(body.data())}, 131072);
+    DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(encodePublishNative)->Range(16, 64 << 10);
+
+BENCHMARK_MAIN();
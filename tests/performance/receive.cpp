@@ -0,0 +1,79 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <rmqcxx.hpp>
+
+using namespace benchmark;
+using namespace rmqcxx;
+using namespace std;
+using namespace std::chrono;
+
+// Consumes with consumeBatch, range(0) is the kernel receive buffer (SO_RCVBUF) and range(1) the message size
+static void batchConsumer(State& state) {
+  const auto receiveBuffer = static_cast<int>(state.range(0));
+  const string body(static_cast<size_t>(state.range(1)), 'x');
+  Connection connection(SocketFactory(::amqp_tcp_socket_new), SocketOptions().receiveBuffer(receiveBuffer),
+    "172.17.0.2", 5672, "/", 0, 131072, 1, seconds(1), static_cast<const seconds*>(nullptr), nullptr, AMQP_SASL_METHOD_PLAIN, "guest", "guest");
+  Channel channel(connection, 1);
+  Queue queue(channel, "queue0");
+
+  queue.declare(false, false, true, true);
+  queue.consume("", false, true, true); // no acks, only the receive path is measured
+
+  const size_t kEnvelopes(10000);
+  size_t batches = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (size_t i = 0; i < kEnvelopes; ++i)
+      channel.publish("", "queue0", false, false, body);
+    state.ResumeTiming();
+    size_t consumed = 0;
+    while (consumed < kEnvelopes) {
+      consumed += connection.consumeBatch(seconds(1), kEnvelopes - consumed, [] (Envelope envelope) { DoNotOptimize(envelope->delivery_tag); },
+        [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, nullptr);
+      ++batches;
+    }
+  }
+  state.counters["envelopes/batch"] = Counter(static_cast<double>(kEnvelopes * state.iterations()) / static_cast<double>(batches));
+  state.SetItemsProcessed(static_cast<int64_t>(kEnvelopes * state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(kEnvelopes * body.size() * state.iterations()));
+}
+
+static void receiveSweep(internal::Benchmark* b) {
+  for (int receiveBuffer : {64 << 10, 256 << 10, 1 << 20, 4 << 20})
+    for (int messageSize : {64, 1 << 10, 16 << 10})
+      b->Args({receiveBuffer, messageSize});
+}
+BENCHMARK(batchConsumer)->Apply(receiveSweep);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <rmqcxx.hpp>
+
+using namespace benchmark;
+using namespace rmqcxx;
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * Every shard publishes to and consumes from its own queue on its own connection, the benchmark argument is the
+ * number of shards (cores)
+ */
+static void shardedConsumer(State& state) {
+  const auto& cores = ShardedRuntime::cores();
+  const size_t shards = min(static_cast<size_t>(state.range(0)), cores.size());
+  ShardedRuntime runtime(vector<int>(cores.begin(), cores.begin() + shards));
+
+  const size_t kEnvelopes(10000);
+  vector<Channel*> channels(shards);
+  atomic<size_t> consumed(0);
+  unique_ptr<promise<void>> done;
+
+  promise<void> ready;
+  atomic<size_t> started(0);
+  runtime.broadcast([&] (Shard& shard) {
+    auto& connection = shard.keep(unique_ptr<Connection>(new Connection("172.17.0.2", 5672, "guest", "guest", "/", 0, 131072, 1, seconds(1))));
+    auto& channel = shard.keep(unique_ptr<Channel>(new Channel(connection, 1)));
+    auto& queue = shard.keep(unique_ptr<Queue>(new Queue(channel, "shard" + to_string(shard.index()))));
+    queue.declare(false, false, true, true);
+    queue.consume("", false, false, true);
+    channels[shard.index()] = &channel;
+
+    EventLoop::Handlers handlers;
+    handlers.envelope = [&channel, &consumed, &done, shards, kEnvelopes] (Envelope envelope) {
+      channel.ack(envelope->delivery_tag, false);
+      if (shards * kEnvelopes == ++consumed)
+        done->set_value();
+    };
+    shard.loop().add(connection, std::move(handlers));
+    if (shards == ++started)
+      ready.set_value();
+  });
+  ready.get_future().wait();
+
+  for (auto _ : state) {
+    consumed = 0;
+    done.reset(new promise<void>());
+    auto finished = done->get_future();
+    runtime.broadcast([&channels, kEnvelopes] (Shard& shard) {
+      auto& channel = *channels[shard.index()];
+      const auto& queue = "shard" + to_string(shard.index());
+      for (size_t i = 0; i < kEnvelopes; ++i)
+        channel.publish("", queue, false, false, "{}");
+    });
+    finished.wait();
+  }
+  state.SetItemsProcessed(state.iterations() * shards * kEnvelopes);
+  runtime.stop();
+  runtime.join();
+  runtime.check();
+}
+BENCHMARK(shardedConsumer)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_MAIN();
@@ -0,0 +1,96 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+#include <rmqcxx.hpp>
+
+using namespace benchmark;
+using namespace rmqcxx;
+using namespace std;
+using namespace std::chrono;
+
+enum Tuning { Default, LowLatency, Bulk };
+
+static SocketOptions socketOptions(int64_t tuning) {
+  switch (tuning) {
+    case LowLatency: return SocketOptions::lowLatency();
+    case Bulk: return SocketOptions::bulk();
+    default: return SocketOptions();
+  }
+}
+
+static Connection connect(int64_t tuning) {
+  return Connection(SocketFactory(::amqp_tcp_socket_new), socketOptions(tuning),
+    "172.17.0.2", 5672, "/", 0, 131072, 1, seconds(1), static_cast<const seconds*>(nullptr), nullptr, AMQP_SASL_METHOD_PLAIN, "guest", "guest");
+}
+
+// round trip of a single message, arg: tuning
+static void socketRoundTrip(State& state) {
+  auto connection = connect(state.range(0));
+  Channel channel(connection, 1);
+  Queue queue(channel, "socket0");
+  queue.declare(false, false, true, true);
+  queue.consume("", false, true, true);
+
+  for (auto _ : state) {
+    channel.publish("", "socket0", false, false, "{}");
+    connection.consumeEnvelope([] (const Envelope&) {});
+  }
+}
+BENCHMARK(socketRoundTrip)->Arg(Default)->Arg(LowLatency)->Arg(Bulk)->UseRealTime();
+
+// burst of publishes delivered back to the consumer, args: tuning, corked
+static void socketBurst(State& state) {
+  auto connection = connect(state.range(0));
+  const bool corked = 0 != state.range(1);
+  Channel channel(connection, 1);
+  Queue queue(channel, "socket1");
+  queue.declare(false, false, true, true);
+  queue.consume("", false, true, true);
+
+  const size_t kEnvelopes(1000);
+
+  for (auto _ : state) {
+    if (corked) {
+      Cork cork(connection.fd());
+      for (size_t i = 0; i < kEnvelopes; ++i)
+        channel.publish("", "socket1", false, false, "{}");
+    } else {
+      for (size_t i = 0; i < kEnvelopes; ++i)
+        channel.publish("", "socket1", false, false, "{}");
+    }
+    for (size_t i = 0; i < kEnvelopes; ++i)
+      connection.consumeEnvelope([] (const Envelope&) {});
+  }
+  state.SetItemsProcessed(state.iterations() * kEnvelopes);
+}
+BENCHMARK(socketBurst)->Args({Default, 0})->Args({Default, 1})->Args({LowLatency, 0})->Args({LowLatency, 1})->Args({Bulk, 0})->Args({Bulk, 1})->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,185 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/Channel.hpp>
+#include <rmqcxx/Queue.hpp>
+#include <rmqcxx/StaticTable.hpp>
+
+#include "ChannelTest.hpp"
+#include "MockAMQP.hpp"
+
+namespace {
+  /**
+   * Number of allocations made while counting
+   */
+  std::size_t allocations = 0;
+
+  /**
+   * Allocations are only counted while this is set, the ones made by the mocks are never counted
+   */
+  bool counting = false;
+
+  /**
+   * Counts the allocations made during its lifetime
+   */
+  struct CountAllocations {
+    CountAllocations() {
+      allocations = 0;
+      counting = true;
+    }
+
+    ~CountAllocations() {
+      counting = false;
+    }
+  };
+} // namespace
+
+void* operator new(std::size_t size) {
+  if (counting && !rmqcxx::unit_tests::MockAMQP::mocking())
+    ++allocations;
+  if (void* p = std::malloc(size == 0 ? 1 : size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SaveArg;
+using ::testing::SetArgPointee;
+
+using std::string;
+
+TEST_F(ChannelTest, HotPathDoesNotAllocate) {
+  auto ch = createSimpleChannel();
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId))
+    .Times(3);
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .RetiresOnSaturation();
+  EXPECT_CALL(amqp, basic_ack(connPtr, channelId, 10UL, false))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, basic_nack(connPtr, channelId, 11UL, false, true))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, basic_publish(connPtr, channelId, _, _, 0, 0, _, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  for (const char* method : {"basic_ack", "basic_nack", "basic_publish"}) {
+    EXPECT_CALL(amqp, get_rpc_reply(connPtr, method))
+      .WillOnce(Return(normalReply));
+  }
+  EXPECT_CALL(amqp, consume_message(connPtr, _, _, 0))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_envelope_t{.channel = channelId}), Return(normalReply)));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+
+  string exchange("exchange"), routingKey("routingKey"), body("body");
+  amqp_basic_properties_t props{};
+  bool consumed = false;
+  {
+    CountAllocations count;
+    ch.ack(10UL, false);
+    ch.nack(11UL, false, true);
+    ch.publish(exchange, routingKey, false, false, body, props);
+    pConn->consumeEnvelope([&consumed] (Envelope) { consumed = true; });
+  }
+  EXPECT_TRUE(consumed);
+  EXPECT_EQ(allocations, 0U);
+}
+
+TEST_F(ChannelTest, NativeEncodingDoesNotAllocate) {
+  auto ch = createSimpleChannel();
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillRepeatedly(Return(fds[0]));
+  EXPECT_CALL(amqp, get_frame_max(connPtr))
+    .WillRepeatedly(Return(131072));
+  pConn->nativeEncoding(true);
+
+  string exchange("exchange"), routingKey("routingKey"), body("body");
+  amqp_basic_properties_t props{};
+  props._flags = AMQP_BASIC_DELIVERY_MODE_FLAG;
+  props.delivery_mode = 2;
+  ch.publish(exchange, routingKey, false, false, body, props); // sizes the output buffer
+  char sink[4096];
+  {
+    CountAllocations count;
+    for (uint64_t tag = 1; tag <= 100; ++tag) {
+      ch.publish(exchange, routingKey, false, false, body, props);
+      ch.ack(tag, false);
+      ch.nack(tag, false, true);
+      while (::recv(fds[1], sink, sizeof(sink), MSG_DONTWAIT) > 0) {}
+    }
+  }
+  EXPECT_EQ(allocations, 0U);
+
+  pConn->nativeEncoding(false);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_F(ChannelTest, StaticTableDeclareDoesNotAllocate) {
+  auto ch = createSimpleChannel();
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "queue_declare"))
+    .WillOnce(Return(normalReply));
+  amqp_queue_declare_ok_t result{};
+  amqp_table_t arguments{};
+  EXPECT_CALL(amqp, queue_declare(connPtr, channelId, _, 0, 1, 0, 0, _))
+    .WillOnce(DoAll(SaveArg<7>(&arguments), Return(&result)));
+
+  Queue q(ch, "orders");
+  const amqp_queue_declare_ok_t* ok = nullptr;
+  {
+    CountAllocations count;
+    StaticTable<2> args;
+    args.add("x-queue-type", "quorum").add("x-message-ttl", int32_t(60000));
+    ok = q.declare(false, true, false, false, args);
+  }
+  EXPECT_EQ(ok, &result);
+  EXPECT_EQ(arguments.num_entries, 2);
+  EXPECT_EQ(allocations, 0U);
+}
+
+}} // namespace rmqcxx.unit_tests
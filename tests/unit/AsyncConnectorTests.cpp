@@ -0,0 +1,292 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "ConnectionTest.hpp"
+#include <rmqcxx/AsyncConnector.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+/**
+ * Minimal broker side of the AMQP handshake over a loopback socket
+ */
+class FakeBroker final {
+public:
+  FakeBroker() : fd_(::socket(AF_INET, SOCK_STREAM, 0)) {
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::listen(fd_, 64);
+    socklen_t length = sizeof(address);
+    ::getsockname(fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+  }
+
+  ~FakeBroker() {
+    join();
+    for (auto fd : clients_)
+      ::close(fd);
+    ::close(fd_);
+  }
+
+  void join() {
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  int port() const noexcept {
+    return port_;
+  }
+
+  void serve(std::size_t connections, uint16_t refuseWith = 0) {
+    thread_ = std::thread([this, connections, refuseWith] () {
+      for (std::size_t i = 0; i < connections; ++i) {
+        const int client = ::accept(fd_, nullptr, nullptr);
+        clients_.push_back(client);
+        handshake(client, refuseWith);
+      }
+    });
+  }
+
+  std::vector<std::string> responses;
+  std::vector<std::string> vhosts;
+
+private:
+  static bool readAll(int fd, uint8_t* data, std::size_t size) {
+    while (size > 0) {
+      const auto received = ::recv(fd, data, size, 0);
+      if (received <= 0)
+        return false;
+      data += received;
+      size -= static_cast<std::size_t>(received);
+    }
+    return true;
+  }
+
+  static std::vector<uint8_t> readFrame(int fd) {
+    std::vector<uint8_t> frame(7);
+    if (!readAll(fd, frame.data(), frame.size()))
+      return {};
+    WireReader header(frame.data(), frame.size());
+    header.u8();
+    header.u16();
+    frame.resize(7 + header.u32() + 1);
+    if (!readAll(fd, frame.data() + 7, frame.size() - 7))
+      return {};
+    return frame;
+  }
+
+  static void send(int fd, const WireWriter& writer) {
+    ::send(fd, writer.data(), writer.size(), MSG_NOSIGNAL);
+  }
+
+  void handshake(int fd, uint16_t refuseWith) {
+    uint8_t header[8];
+    if (!readAll(fd, header, sizeof(header)))
+      return;
+
+    WireWriter out;
+    auto start = out.beginMethod(0, AMQP_CONNECTION_START_METHOD);
+    out.u8(0);
+    out.u8(9);
+    out.table(amqp_table_t{0, nullptr});
+    out.longString("AMQPLAIN PLAIN", 14);
+    out.longString("en_US", 5);
+    out.endFrame(start);
+    send(fd, out);
+
+    auto frame = readFrame(fd);
+    WireReader startOk(frame.data() + 7, frame.size() - 8);
+    startOk.u32();
+    startOk.skipTable();
+    startOk.shortString();
+    responses.push_back(startOk.longString());
+
+    out.clear();
+    if (0 != refuseWith) {
+      start = out.beginMethod(0, AMQP_CONNECTION_CLOSE_METHOD);
+      out.u16(refuseWith);
+      out.shortString("ACCESS_REFUSED", 14);
+      out.u16(0);
+      out.u16(0);
+      out.endFrame(start);
+      send(fd, out);
+      return;
+    }
+    start = out.beginMethod(0, AMQP_CONNECTION_TUNE_METHOD);
+    out.u16(100);
+    out.u32(65536);
+    out.u16(30);
+    out.endFrame(start);
+    send(fd, out);
+
+    readFrame(fd); // tune-ok
+    frame = readFrame(fd);
+    WireReader open(frame.data() + 7, frame.size() - 8);
+    open.u32();
+    vhosts.push_back(open.shortString());
+
+    out.clear();
+    start = out.beginMethod(0, AMQP_CONNECTION_OPEN_OK_METHOD);
+    out.shortString("", 0);
+    out.endFrame(start);
+    send(fd, out);
+  }
+
+  int fd_;
+  int port_;
+  std::thread thread_;
+  std::vector<int> clients_;
+};
+
+struct AsyncConnectorTest : public ConnectionTest {
+
+};
+
+TEST_F(AsyncConnectorTest, OpensConnectionsInParallel) {
+  constexpr std::size_t count = 8;
+  FakeBroker broker;
+  broker.serve(count);
+
+  AsyncConnector connector(vhost, "user", "password", 2047, 131072, 60);
+  for (std::size_t i = 0; i < count; ++i)
+    EXPECT_EQ(connector.add("127.0.0.1", broker.port()), i);
+  EXPECT_EQ(connector.size(), count);
+  EXPECT_THROW(connector.take(0), Exception);
+
+  EXPECT_EQ(connector.run(seconds(5)), count);
+
+  std::vector<int> fds;
+  EXPECT_CALL(amqp, new_connection())
+    .WillRepeatedly(Return(connPtr));
+  EXPECT_CALL(amqp, tcp_socket_new(connPtr))
+    .WillRepeatedly(Return(socketPtr));
+  EXPECT_CALL(amqp, tcp_socket_set_sockfd(socketPtr, _))
+    .Times(count)
+    .WillRepeatedly(Invoke([&fds] (amqp_socket_t*, int fd) { fds.push_back(fd); }));
+  EXPECT_CALL(amqp, tune_connection(connPtr, 100, 65536, 30))
+    .Times(count)
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, connection_close(connPtr, AMQP_REPLY_SUCCESS))
+    .Times(count)
+    .WillRepeatedly(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "connection_close"))
+    .Times(count)
+    .WillRepeatedly(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_connection(connPtr))
+    .Times(count)
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+
+  {
+    std::vector<Connection> connections;
+    for (std::size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(connector.ready(i));
+      connections.push_back(connector.take(i));
+      EXPECT_FALSE(connector.ready(i));
+    }
+    EXPECT_THROW(connector.take(0), Exception);
+  }
+  for (auto fd : fds)
+    ::close(fd);
+
+  broker.join();
+  EXPECT_EQ(broker.responses, std::vector<std::string>(count, std::string("\0user\0password", 14)));
+  EXPECT_EQ(broker.vhosts, std::vector<std::string>(count, vhost));
+}
+
+TEST_F(AsyncConnectorTest, Refused) {
+  FakeBroker broker;
+  broker.serve(1, 403);
+
+  AsyncConnector connector(vhost, "user", "wrong", 0, 131072, 0);
+  connector.add("127.0.0.1", broker.port());
+  EXPECT_EQ(connector.run(seconds(5)), 0);
+  EXPECT_FALSE(connector.ready(0));
+  try {
+    connector.take(0);
+    FAIL() << "Expected ConnectException";
+  } catch(const ConnectException& e) {
+    EXPECT_EQ(e.replyCode, 403);
+    EXPECT_EQ(e.status, AMQP_STATUS_CONNECTION_CLOSED);
+    EXPECT_EQ(e.port, broker.port());
+  }
+}
+
+TEST_F(AsyncConnectorTest, NothingListening) {
+  int port = 0;
+  {
+    FakeBroker closed;
+    port = closed.port();
+  }
+  AsyncConnector connector(vhost, "user", "password", 0, 131072, 0);
+  connector.add("127.0.0.1", port);
+  EXPECT_EQ(connector.run(seconds(5)), 0);
+  try {
+    connector.take(0);
+    FAIL() << "Expected ConnectException";
+  } catch(const ConnectException& e) {
+    EXPECT_EQ(e.status, AMQP_STATUS_SOCKET_ERROR);
+    EXPECT_EQ(e.replyCode, 0);
+  }
+}
+
+TEST_F(AsyncConnectorTest, Timeout) {
+  FakeBroker silent; // accepts on the TCP level but never answers
+  AsyncConnector connector(vhost, "user", "password", 0, 131072, 0);
+  connector.add("127.0.0.1", silent.port());
+  const auto& start = std::chrono::steady_clock::now();
+  EXPECT_EQ(connector.run(milliseconds(50)), 0);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, seconds(2));
+  try {
+    connector.take(0);
+    FAIL() << "Expected ConnectException";
+  } catch(const ConnectException& e) {
+    EXPECT_EQ(e.status, AMQP_STATUS_TIMEOUT);
+  }
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,180 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/ChannelPool.hpp>
+
+#include "ConnectionTest.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::Return;
+
+struct ChannelPoolTest : public ConnectionTest {
+  ChannelPoolTest() : ConnectionTest(), openOk{} {
+    EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+      .Times(AnyNumber());
+    EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_open"))
+      .WillRepeatedly(Return(normalReply));
+    EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_close"))
+      .WillRepeatedly(Return(normalReply));
+  }
+
+  void expectOpen(amqp_channel_t id, int times = 1) {
+    EXPECT_CALL(amqp, channel_open(connPtr, id))
+      .Times(times)
+      .WillRepeatedly(Return(&openOk));
+  }
+
+  void expectClose(amqp_channel_t id) {
+    EXPECT_CALL(amqp, channel_close(connPtr, id, AMQP_REPLY_SUCCESS))
+      .WillOnce(Return(normalReply));
+  }
+
+  void expectCloseOk(amqp_channel_t id) {
+    EXPECT_CALL(amqp, send_method(connPtr, id, AMQP_CHANNEL_CLOSE_OK_METHOD, _))
+      .WillOnce(Return(AMQP_STATUS_OK));
+    EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, id));
+  }
+
+  amqp_channel_open_ok_t openOk;
+};
+
+TEST_F(ChannelPoolTest, AllocatesAndReuses) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_channel_max(connPtr))
+    .WillOnce(Return(3));
+  expectOpen(1);
+  expectOpen(2);
+  expectOpen(3);
+  expectClose(1);
+  expectClose(2);
+  expectClose(3);
+
+  ChannelPool pool(conn);
+  EXPECT_EQ(pool.capacity(), 3);
+  {
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    EXPECT_EQ(a->id(), 1);
+    EXPECT_EQ((*b).id(), 2);
+    EXPECT_EQ(pool.size(), 2);
+    EXPECT_EQ(pool.idle(), 0);
+  }
+  EXPECT_EQ(pool.idle(), 2);
+  {
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    auto c = pool.acquire();
+    EXPECT_EQ(a->id() + b->id(), 3);
+    EXPECT_EQ(c->id(), 3);
+    EXPECT_THROW(pool.acquire(), Exception);
+  }
+  EXPECT_EQ(pool.idle(), 3);
+  EXPECT_EQ(pool.size(), 3);
+}
+
+TEST_F(ChannelPoolTest, Warm) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_channel_max(connPtr))
+    .WillOnce(Return(0));
+  expectOpen(1);
+  expectOpen(2);
+  expectClose(1);
+  expectClose(2);
+
+  ChannelPool pool(conn, 2);
+  EXPECT_EQ(pool.capacity(), 65535);
+  EXPECT_EQ(pool.idle(), 2);
+  auto lease = pool.acquire();
+  EXPECT_EQ(pool.idle(), 1);
+}
+
+TEST_F(ChannelPoolTest, KeepsReturnedChannelsBeyondWarm) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_channel_max(connPtr))
+    .WillOnce(Return(0));
+  expectOpen(1);
+  expectOpen(2);
+  expectOpen(3);
+  expectClose(1);
+  expectClose(2);
+  expectClose(3);
+
+  ChannelPool pool(conn, 1);
+  {
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    auto c = pool.acquire();
+    EXPECT_EQ(pool.idle(), 0);
+  }
+  EXPECT_EQ(pool.idle(), 3); // the peak number of leases stays open
+  EXPECT_EQ(pool.size(), 3);
+}
+
+TEST_F(ChannelPoolTest, ReplacesBrokenChannels) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_channel_max(connPtr))
+    .WillOnce(Return(8));
+  expectOpen(1, 2);
+  expectOpen(2, 2);
+  expectCloseOk(1);
+  expectCloseOk(2);
+  ChannelPool pool(conn, 1);
+
+  {
+    // invalidated by the lease holder, replaced right away to keep the pool warm
+    auto lease = pool.acquire();
+    lease.invalidate();
+  }
+  EXPECT_EQ(pool.idle(), 1);
+  EXPECT_EQ(pool.size(), 1);
+
+  {
+    // leased channel closed by the broker, replaced when returned
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+    EXPECT_EQ(second->id(), 2);
+    pool.closed(2);
+    pool.closed(7); // not in use
+    EXPECT_EQ(pool.size(), 2);
+  }
+  EXPECT_EQ(pool.size(), 2);
+  EXPECT_EQ(pool.idle(), 2);
+
+  // idle channel closed by the broker, the remaining idle channel keeps the pool warm
+  expectCloseOk(1);
+  expectClose(2);
+  pool.closed(1);
+  EXPECT_EQ(pool.idle(), 1);
+  EXPECT_EQ(pool.size(), 1);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -25,6 +25,11 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 #include <rmqcxx/Channel.hpp>
@@ -34,8 +39,11 @@ SOFTWARE.
 namespace rmqcxx { namespace unit_tests {
 
 using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::DoAll;
 using ::testing::Pointee;
 using ::testing::Return;
+using ::testing::SetArgPointee;
 
 using std::move;
 using std::string;
@@ -190,6 +198,21 @@ TEST_F(ChannelTest, Flow) {
   EXPECT_TRUE(ch.flow(false));
 }
 
+TEST_F(ChannelTest, Cancel) {
+  auto ch = createSimpleChannel();
+  EXPECT_EQ(ch.id(), channelId);
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_cancel"))
+    .WillOnce(Return(normalReply));
+
+  amqp_bytes_t ctag { .len = ::strlen("ctag"), .bytes = const_cast<char*>("ctag") };
+  amqp_basic_cancel_ok_t result { .consumer_tag = ctag };
+  EXPECT_CALL(amqp, basic_cancel(connPtr, channelId, ctag))
+    .WillOnce(Return(&result));
+  ch.cancel("ctag");
+}
+
 TEST_F(ChannelTest, Recover) {
   auto ch = createSimpleChannel();
 
@@ -240,4 +263,175 @@ TEST_F(ChannelTest, Publish) {
   EXPECT_THROW(ch.publish(exchange, routingKey, false, false, body, props), ChannelException);
 }
 
+TEST_F(ChannelTest, NativeEncoding) {
+  auto ch = createSimpleChannel();
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillRepeatedly(Return(fds[0]));
+  EXPECT_CALL(amqp, get_frame_max(connPtr))
+    .WillOnce(Return(131072));
+  EXPECT_CALL(amqp, basic_publish(_, _, _, _, _, _, _, _)).Times(0);
+  EXPECT_CALL(amqp, basic_ack(_, _, _, _)).Times(0);
+  EXPECT_CALL(amqp, basic_nack(_, _, _, _, _)).Times(0);
+
+  pConn->nativeEncoding(true);
+  EXPECT_TRUE(pConn->nativeEncoding());
+  amqp_basic_properties_t props{};
+  props._flags = AMQP_BASIC_PRIORITY_FLAG;
+  props.priority = 3;
+  string exchange("exchange"), routingKey("routingKey"), body("body");
+  ch.publish(exchange, routingKey, true, false, body, props);
+  EXPECT_EQ(ch.ack(10, false), AMQP_STATUS_OK);
+  EXPECT_EQ(ch.nack(11, true, true), AMQP_STATUS_OK);
+
+  WireWriter expected;
+  MethodEncoder::publish(expected, channelId, bytes(exchange), bytes(routingKey), true, false, props, bytes(body), 131072);
+  MethodEncoder::ack(expected, channelId, 10, false);
+  MethodEncoder::nack(expected, channelId, 11, true, true);
+  std::vector<uint8_t> received(expected.size() + 1);
+  ASSERT_EQ(::recv(fds[1], received.data(), received.size(), MSG_DONTWAIT), static_cast<ssize_t>(expected.size()));
+  EXPECT_EQ(::memcmp(received.data(), expected.data(), expected.size()), 0);
+
+  ::close(fds[1]);
+  EXPECT_CALL(amqp, get_socket(connPtr))
+    .WillOnce(Return(socketPtr));
+  EXPECT_THROW(ch.ack(12, false), SocketException);
+  ::close(fds[0]);
+  pConn->nativeEncoding(false);
+}
+
+TEST_F(ChannelTest, ReleasePolicy) {
+  auto ch = createSimpleChannel();
+  pConn->releasePolicy(rmqcxx::ReleasePolicy().every(3));
+
+  EXPECT_CALL(amqp, basic_ack(connPtr, channelId, _, false))
+    .Times(4)
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_ack"))
+    .Times(4)
+    .WillRepeatedly(Return(normalReply));
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  for (uint64_t tag = 1; tag <= 4; ++tag)
+    ch.ack(tag, false);
+  EXPECT_EQ(pConn->releasePolicy().stats().operations, 4U);
+  EXPECT_EQ(pConn->releasePolicy().stats().releases, 1U);
+  pConn->releasePolicy(rmqcxx::ReleasePolicy()); // the fixture expects the release after channel.close
+}
+
+TEST_F(ChannelTest, LazyOpenAndDeferredClose) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(AnyNumber());
+
+  EXPECT_CALL(amqp, send_method(connPtr, 9, AMQP_CHANNEL_OPEN_METHOD, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  {
+    Channel ch(conn, 9, true);
+    EXPECT_EQ(conn.pending(), 1);
+  }
+  EXPECT_TRUE(conn.closing(9));
+
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillOnce(Return(-1));
+  EXPECT_CALL(amqp, send_method(connPtr, 9, AMQP_CHANNEL_CLOSE_METHOD, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_EQ(conn.flushCloses(), 1);
+  EXPECT_EQ(conn.flushCloses(), 0);
+  EXPECT_TRUE(conn.closing(9));
+  EXPECT_THROW((Channel{conn, 9}), ConnectionException);
+
+  // the replies are consumed by the poll path, channel.open-ok of a closed channel is dropped
+  amqp_channel_open_ok_t openOk{};
+  amqp_channel_close_ok_t closeOk{};
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2);
+  EXPECT_CALL(amqp, consume_message(connPtr, _, _, 0))
+    .Times(2)
+    .WillRepeatedly(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_UNEXPECTED_STATE}));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, _))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t{.frame_type = AMQP_FRAME_METHOD, .channel = 9, .payload = { amqp_method_t{.id = AMQP_CHANNEL_OPEN_OK_METHOD, .decoded = &openOk}}}), Return(AMQP_STATUS_OK)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t{.frame_type = AMQP_FRAME_METHOD, .channel = 9, .payload = { amqp_method_t{.id = AMQP_CHANNEL_CLOSE_OK_METHOD, .decoded = &closeOk}}}), Return(AMQP_STATUS_OK)));
+  EXPECT_TRUE(conn.consume(std::chrono::seconds(1), [] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}));
+  EXPECT_TRUE(conn.consume(std::chrono::seconds(1), [] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}));
+  EXPECT_EQ(conn.pending(), 0);
+  EXPECT_FALSE(conn.closing(9));
+}
+
+TEST_F(ChannelTest, ReopenQueuedClose) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(AnyNumber());
+
+  EXPECT_CALL(amqp, send_method(connPtr, 9, AMQP_CHANNEL_OPEN_METHOD, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  Channel(conn, 9, true);
+  EXPECT_TRUE(conn.closing(9));
+
+  // a queued close is done synchronously before the identifier is used again
+  amqp_channel_open_ok_t openOk{};
+  EXPECT_CALL(amqp, channel_close(connPtr, 9, AMQP_REPLY_SUCCESS))
+    .Times(2)
+    .WillRepeatedly(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_close"))
+    .Times(2)
+    .WillRepeatedly(Return(normalReply));
+  EXPECT_CALL(amqp, channel_open(connPtr, 9))
+    .WillOnce(Return(&openOk));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_open"))
+    .WillOnce(Return(normalReply));
+  Channel ch(conn, 9);
+  EXPECT_FALSE(conn.closing(9));
+}
+
+TEST_F(ChannelTest, LazyReopenQueuedClose) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(AnyNumber());
+
+  EXPECT_CALL(amqp, send_method(connPtr, 9, AMQP_CHANNEL_OPEN_METHOD, _))
+    .Times(2)
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  Channel(conn, 9, true);
+  EXPECT_TRUE(conn.closing(9));
+
+  // both channel.open-ok replies are awaited, the first one arrives after the synchronous close
+  EXPECT_CALL(amqp, channel_close(connPtr, 9, AMQP_REPLY_SUCCESS))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_close"))
+    .WillOnce(Return(normalReply));
+  Channel ch(conn, 9, true);
+  EXPECT_FALSE(conn.closing(9));
+  EXPECT_EQ(conn.pending(), 2);
+
+  amqp_channel_open_ok_t openOk{};
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2);
+  EXPECT_CALL(amqp, consume_message(connPtr, _, _, 0))
+    .Times(2)
+    .WillRepeatedly(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_UNEXPECTED_STATE}));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, _))
+    .Times(2)
+    .WillRepeatedly(DoAll(SetArgPointee<1>(amqp_frame_t{.frame_type = AMQP_FRAME_METHOD, .channel = 9, .payload = { amqp_method_t{.id = AMQP_CHANNEL_OPEN_OK_METHOD, .decoded = &openOk}}}), Return(AMQP_STATUS_OK)));
+  EXPECT_TRUE(conn.consume(std::chrono::seconds(1), [] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}));
+  EXPECT_EQ(conn.pending(), 1);
+  EXPECT_TRUE(conn.consume(std::chrono::seconds(1), [] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}));
+  EXPECT_EQ(conn.pending(), 0);
+}
+
+TEST_F(ChannelTest, DeferredClosesAreBatched) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, send_method(connPtr, _, AMQP_CHANNEL_OPEN_METHOD, _))
+    .Times(Connection::kCloseBatch)
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillOnce(Return(-1));
+  EXPECT_CALL(amqp, send_method(connPtr, _, AMQP_CHANNEL_CLOSE_METHOD, _))
+    .Times(Connection::kCloseBatch)
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  for (amqp_channel_t id = 1; id <= Connection::kCloseBatch; ++id)
+    Channel(conn, id, true);
+  EXPECT_EQ(conn.pending(), 2 * Connection::kCloseBatch); // channel.open-ok and channel.close-ok of every channel
+}
+
 }} // namespace rmqcxx.unit_tests
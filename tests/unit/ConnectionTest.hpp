@@ -41,6 +41,24 @@ SOFTWARE.
 #include "MockAMQP.hpp"
 
 namespace rmqcxx { namespace unit_tests {
+
+MATCHER(AnnouncesCancelNotify, "client properties announcing the consumer_cancel_notify capability") {
+  auto is = [](const amqp_bytes_t& key, const std::string& name) {
+    return std::string(static_cast<const char*>(key.bytes), key.len) == name;
+  };
+  for (int i = 0; nullptr != arg && i < arg->num_entries; ++i) {
+    const auto& entry = arg->entries[i];
+    if (!is(entry.key, "capabilities") || AMQP_FIELD_KIND_TABLE != entry.value.kind)
+      continue;
+    for (int j = 0; j < entry.value.value.table.num_entries; ++j) {
+      const auto& capability = entry.value.value.table.entries[j];
+      if (is(capability.key, "consumer_cancel_notify"))
+        return AMQP_FIELD_KIND_BOOLEAN == capability.value.kind && capability.value.value.boolean;
+    }
+  }
+  return false;
+}
+
 struct ConnectionTest : public ::testing::Test {
   ConnectionTest() : address("address"), port(1), vhost("vhost"), maxChannels(2), maxFrameSize(3), heartbeat(4), connectTimeout(5), handshakeTimeout(6), properties(), saslMethod(AMQP_SASL_METHOD_UNDEFINED), connPtr(reinterpret_cast<amqp_connection_state_t>(7)), socketPtr(reinterpret_cast<amqp_socket_t*>(8)), connectTv{.tv_sec = connectTimeout.count(), .tv_usec = 0}, handshakeTv{.tv_sec = handshakeTimeout.count(), .tv_usec = 0}, normalReply{.reply_type = AMQP_RESPONSE_NORMAL } {
 
@@ -65,13 +83,8 @@ struct ConnectionTest : public ::testing::Test {
         .WillOnce(::testing::Return(AMQP_STATUS_OK));
     }
 
-    if (withProperties) {
-      EXPECT_CALL(amqp, login_with_properties(connPtr, vhost.c_str(), maxChannels, maxFrameSize, heartbeat, &properties, saslMethod, loginArguments))
-        .WillOnce(::testing::Return(reply));
-    } else {
-      EXPECT_CALL(amqp, login(connPtr, vhost.c_str(), maxChannels, maxFrameSize, heartbeat, saslMethod, loginArguments))
-        .WillOnce(::testing::Return(reply));
-    }
+    EXPECT_CALL(amqp, login_with_properties(connPtr, vhost.c_str(), maxChannels, maxFrameSize, heartbeat, AnnouncesCancelNotify(), saslMethod, loginArguments))
+      .WillOnce(::testing::Return(reply));
 
     EXPECT_CALL(amqp, connection_close(connPtr, AMQP_REPLY_SUCCESS));
 
@@ -25,18 +25,28 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <cstring>
+#include <memory_resource>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include "ConnectionTest.hpp"
 
 namespace rmqcxx { namespace unit_tests {
 
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::Invoke;
 using ::testing::Pointee;
 using ::testing::Return;
 using ::testing::SaveArg;
 using ::testing::SetArgPointee;
 using ::testing::Test;
 
+using std::chrono::milliseconds;
 using std::chrono::seconds;
 using std::forward;
 using std::string;
@@ -55,13 +65,8 @@ struct ConnectionLoginTest : public ConnectionTest {
     EXPECT_CALL(amqp, socket_open_noblock(socketPtr, address.c_str(), port, Pointee(connectTv)))
       .WillOnce(Return(0));
 
-    if (withProperties) {
-      EXPECT_CALL(amqp, login_with_properties(connPtr, vhost.c_str(), maxChannels, maxFrameSize, heartbeat, &properties, saslMethod, loginArguments))
-        .WillOnce(::testing::Return(loginReply));
-    } else {
-      EXPECT_CALL(amqp, login(connPtr, vhost.c_str(), maxChannels, maxFrameSize, heartbeat, saslMethod, loginArguments))
-        .WillOnce(::testing::Return(loginReply));
-    }
+    EXPECT_CALL(amqp, login_with_properties(connPtr, vhost.c_str(), maxChannels, maxFrameSize, heartbeat, AnnouncesCancelNotify(), saslMethod, loginArguments))
+      .WillOnce(::testing::Return(loginReply));
 
     EXPECT_CALL(amqp, connection_close(connPtr, AMQP_REPLY_SUCCESS));
 
@@ -207,6 +212,129 @@ TEST_F(ConnectionLoginTest, FailureToLogin) {
   loginFailureTest<LibraryException>(false, amqp_rpc_reply_t { .reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = 43 }, "external");
 }
 
+TEST_F(ConnectionTest, AnnouncesConsumerCancelNotify) {
+  saslMethod = AMQP_SASL_METHOD_EXTERNAL;
+  auto text = [](const char* v) { return amqp_bytes_t{std::strlen(v), const_cast<char*>(v)}; };
+  amqp_table_entry_t capabilities[1];
+  capabilities[0].key = text("publisher_confirms");
+  capabilities[0].value.kind = AMQP_FIELD_KIND_BOOLEAN;
+  capabilities[0].value.value.boolean = 1;
+  amqp_table_entry_t entries[2];
+  entries[0].key = text("product");
+  entries[0].value.kind = AMQP_FIELD_KIND_UTF8;
+  entries[0].value.value.bytes = text("unit test");
+  entries[1].key = text("capabilities");
+  entries[1].value.kind = AMQP_FIELD_KIND_TABLE;
+  entries[1].value.value.table = amqp_table_t{1, capabilities};
+  properties = amqp_table_t{2, entries};
+
+  vector<string> keys, announced;
+  auto record = [&](amqp_connection_state_t, char const*, int, int, int, const amqp_table_t* clientProperties, amqp_sasl_method_enum, const vector<const char*>&) {
+    for (int i = 0; i < clientProperties->num_entries; ++i)
+      keys.emplace_back(static_cast<const char*>(clientProperties->entries[i].key.bytes), clientProperties->entries[i].key.len);
+    const auto& table = clientProperties->entries[1].value.value.table;
+    for (int i = 0; i < table.num_entries; ++i)
+      announced.emplace_back(static_cast<const char*>(table.entries[i].key.bytes), table.entries[i].key.len);
+    return normalReply;
+  };
+  EXPECT_CALL(amqp, new_connection())
+    .WillOnce(Return(connPtr));
+  EXPECT_CALL(amqp, tcp_socket_new(connPtr))
+    .WillOnce(Return(socketPtr));
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, address.c_str(), port, Pointee(connectTv)))
+    .WillOnce(Return(0));
+  EXPECT_CALL(amqp, login_with_properties(connPtr, vhost.c_str(), maxChannels, maxFrameSize, heartbeat, AnnouncesCancelNotify(), saslMethod, vector<const char*>{"external"}))
+    .WillOnce(Invoke(record));
+  EXPECT_CALL(amqp, connection_close(connPtr, AMQP_REPLY_SUCCESS));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "connection_close"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_connection(connPtr));
+
+  {
+    Connection connection(address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, static_cast<const seconds*>(nullptr), &properties, saslMethod, "external");
+  }
+  EXPECT_EQ(keys, (vector<string>{"product", "capabilities"}));
+  EXPECT_EQ(announced, (vector<string>{"publisher_confirms", "consumer_cancel_notify"}));
+  EXPECT_EQ(capabilities[0].value.value.boolean, 1); // the user table is left as it is
+  EXPECT_EQ(entries[1].value.value.table.num_entries, 1);
+}
+
+TEST_F(ConnectionTest, SocketFactory) {
+  saslMethod = AMQP_SASL_METHOD_EXTERNAL;
+  prepareConnectionCreation(false, false, "external");
+  std::size_t calls = 0;
+  Connection conn([&calls] (amqp_connection_state_t state) { ++calls; return ::amqp_tcp_socket_new(state); },
+    address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, static_cast<const seconds*>(nullptr), nullptr, saslMethod, "external");
+  EXPECT_EQ(calls, 1);
+}
+
+TEST_F(ConnectionTest, NativeEncodingNeedsPlainTcp) {
+  saslMethod = AMQP_SASL_METHOD_EXTERNAL;
+  prepareConnectionCreation(false, false, "external");
+  Connection custom([] (amqp_connection_state_t state) { return ::amqp_tcp_socket_new(state); },
+    address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, static_cast<const seconds*>(nullptr), nullptr, saslMethod, "external");
+  EXPECT_THROW(custom.nativeEncoding(true), ConnectionException);
+  EXPECT_FALSE(custom.nativeEncoding());
+}
+
+TEST_F(ConnectionTest, SocketFactoryFailure) {
+  EXPECT_CALL(amqp, new_connection())
+    .WillOnce(Return(connPtr));
+  EXPECT_CALL(amqp, destroy_connection(connPtr));
+
+  EXPECT_THROW(Connection([] (amqp_connection_state_t) -> amqp_socket_t* { return nullptr; },
+    address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, static_cast<const seconds*>(nullptr), nullptr, saslMethod), SocketException);
+}
+
+TEST_F(ConnectionTest, SocketOptions) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  int value = -1;
+  socklen_t len = sizeof(value);
+  saslMethod = AMQP_SASL_METHOD_EXTERNAL;
+  prepareConnectionCreation(false, false, "external");
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillRepeatedly(Return(fd));
+  {
+    Connection conn(SocketFactory(::amqp_tcp_socket_new), SocketOptions::lowLatency(),
+      address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, static_cast<const seconds*>(nullptr), nullptr, saslMethod, "external");
+    EXPECT_EQ(::getsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, &len), 0);
+    EXPECT_NE(value, 0);
+
+    conn.configure(SocketOptions::bulk(1 << 16));
+    EXPECT_EQ(::getsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, &len), 0);
+    EXPECT_EQ(value, 0);
+    EXPECT_EQ(::getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &value, &len), 0);
+    EXPECT_GE(value, 1 << 16);
+  }
+  ::close(fd);
+}
+
+TEST_F(ConnectionTest, SocketOptionsFailure) {
+  EXPECT_CALL(amqp, new_connection())
+    .WillOnce(Return(connPtr));
+  EXPECT_CALL(amqp, tcp_socket_new(connPtr))
+    .WillOnce(Return(socketPtr));
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, address.c_str(), port, Pointee(connectTv)))
+    .WillOnce(Return(0));
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillOnce(Return(-1));
+  EXPECT_CALL(amqp, connection_close(connPtr, AMQP_REPLY_SUCCESS));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "connection_close"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_connection(connPtr));
+
+  EXPECT_THROW(Connection(SocketFactory(::amqp_tcp_socket_new), SocketOptions().noDelay(true),
+    address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, static_cast<const seconds*>(nullptr), nullptr, saslMethod), SocketException);
+
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillOnce(Return(-1));
+  EXPECT_CALL(amqp, get_socket(connPtr))
+    .WillOnce(Return(socketPtr));
+  EXPECT_THROW(conn.configure(SocketOptions().sendBuffer(4096)), SocketException);
+}
+
 TEST_F(ConnectionTest, ConnectionCreation) {
   std::string username("username"), password("password"), external("external");
 
@@ -279,6 +407,37 @@ TEST_F(ConnectionTest, ConsumeEmptyEnvelopeTimeout) {
   EXPECT_FALSE(conn.consumeEnvelope(consumeTimeout, [] (Envelope) {}));
 }
 
+TEST_F(ConnectionTest, ConsumeReleasePolicy) {
+  auto conn = createSimpleConnection();
+  const std::size_t overhead = ReleasePolicy::kOperationOverhead;
+  conn.releasePolicy(ReleasePolicy::warm(150 + 2 * overhead, std::chrono::nanoseconds(1)));
+
+  string body(100, 'x');
+  EXPECT_CALL(amqp, consume_message(connPtr, _, _, 0))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_envelope_t{.channel = 1, .message = {.body = bytes(body)}}), Return(normalReply)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_envelope_t{.channel = 1, .message = {.body = bytes(body)}}), Return(normalReply)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_envelope_t{.channel = 1, .message = {.body = bytes(body)}}), Return(normalReply)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_envelope_t{.channel = 0}), Return(normalReply)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_envelope_t{.channel = 0}), Return(normalReply)));
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(5);
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(2);
+  auto consume = [&conn] () {
+    return conn.consumeEnvelope(std::chrono::seconds(0), [] (Envelope) {});
+  };
+  EXPECT_TRUE(consume());
+  EXPECT_EQ(conn.releasePolicy().stats().pooled, 100U + overhead);
+  EXPECT_TRUE(consume()); // crosses the high-water mark
+  EXPECT_EQ(conn.releasePolicy().stats().releases, 1U);
+  EXPECT_EQ(conn.releasePolicy().stats().peak, 200U + 2 * overhead);
+  EXPECT_TRUE(consume());
+  EXPECT_FALSE(consume()); // idle
+  EXPECT_FALSE(consume()); // already released
+  EXPECT_EQ(conn.releasePolicy().stats().releases, 2U);
+  EXPECT_EQ(conn.releasePolicy().stats().operations, 5U);
+}
+
 TEST_F(ConnectionTest, ConsumeUnhandledRPCReply) {
   auto conn = createSimpleConnection();
 
@@ -545,6 +704,323 @@ TEST_F(ConnectionTest, ConsumeConnectionCloseReceived) {
   EXPECT_THROW(conn.consumeEnvelope(consumeTimeout, [] (Envelope) {}), ConnectionCloseException);
 }
 
+TEST_F(ConnectionTest, ConsumeCancelReceived) {
+  auto conn = createSimpleConnection();
+
+  seconds consumeTimeout(55);
+  struct timeval consumeTv{.tv_sec = consumeTimeout.count(), .tv_usec = 0};
+
+  amqp_rpc_reply_t reply {.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_UNEXPECTED_STATE };
+
+  amqp_basic_cancel_t basicCancel { .consumer_tag = amqp_bytes_t {.len = ::strlen("ctag"), .bytes = const_cast<char*>("ctag")}, .nowait = true };
+
+  EXPECT_CALL(amqp, destroy_envelope(_)); // destroys the empty envelope
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(consumeTv), 0))
+    .WillOnce(Return(reply));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(consumeTv)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .channel = 11, .payload = { amqp_method_t{.id = AMQP_BASIC_CANCEL_METHOD, .decoded = &basicCancel}}}),Return(AMQP_STATUS_OK)));
+
+  bool called = false;
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_TRUE(conn.consume(consumeTimeout, [] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, [&called] (ConsumerCancel cancel) {
+    EXPECT_EQ(cancel.channel(), 11);
+    EXPECT_EQ(cancel.consumerTag(), "ctag");
+    EXPECT_TRUE(cancel.fromBroker());
+    called = true;
+  }));
+  EXPECT_TRUE(called);
+}
+
+TEST_F(ConnectionTest, ConsumeCancelOkReceived) {
+  auto conn = createSimpleConnection();
+
+  seconds consumeTimeout(55);
+  struct timeval consumeTv{.tv_sec = consumeTimeout.count(), .tv_usec = 0};
+
+  amqp_rpc_reply_t reply {.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_UNEXPECTED_STATE };
+
+  amqp_basic_cancel_ok_t basicCancelOk { .consumer_tag = amqp_bytes_t {.len = ::strlen("ctag"), .bytes = const_cast<char*>("ctag")} };
+
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2); // destroys the empty envelopes
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(consumeTv), 0))
+    .Times(2)
+    .WillRepeatedly(Return(reply));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(consumeTv)))
+    .Times(2)
+    .WillRepeatedly(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .channel = 11, .payload = { amqp_method_t{.id = AMQP_BASIC_CANCEL_OK_METHOD, .decoded = &basicCancelOk}}}),Return(AMQP_STATUS_OK)));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(2);
+
+  bool called = false;
+  EXPECT_TRUE(conn.consume(consumeTimeout, [] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, [&called] (ConsumerCancel cancel) {
+    EXPECT_EQ(cancel.consumerTag(), "ctag");
+    EXPECT_FALSE(cancel.fromBroker());
+    called = true;
+  }));
+  EXPECT_TRUE(called);
+
+  // ignored when no cancel callback is given
+  EXPECT_TRUE(conn.consume(consumeTimeout, [] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}));
+}
+
+TEST_F(ConnectionTest, ConsumeCancelWithoutCallback) {
+  auto conn = createSimpleConnection();
+
+  seconds consumeTimeout(55);
+  struct timeval consumeTv{.tv_sec = consumeTimeout.count(), .tv_usec = 0};
+
+  amqp_rpc_reply_t reply {.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_UNEXPECTED_STATE };
+
+  amqp_basic_cancel_t basicCancel { .consumer_tag = amqp_bytes_t {.len = ::strlen("ctag"), .bytes = const_cast<char*>("ctag")}, .nowait = true };
+
+  EXPECT_CALL(amqp, destroy_envelope(_)); // destroys the empty envelope
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(consumeTv), 0))
+    .WillOnce(Return(reply));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(consumeTv)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .channel = 11, .payload = { amqp_method_t{.id = AMQP_BASIC_CANCEL_METHOD, .decoded = &basicCancel}}}),Return(AMQP_STATUS_OK)));
+
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  try {
+    conn.consumeEnvelope(consumeTimeout, [] (Envelope) {});
+    ASSERT_TRUE(false);
+  } catch(const ConsumerCancelException& ex) {
+    EXPECT_EQ(ex.channel, 11);
+    EXPECT_EQ(ex.consumerTag, "ctag");
+  } catch(...) {
+    ASSERT_TRUE(false);
+  }
+}
+
+TEST_F(ConnectionTest, ZeroCopyConsumeInPlace) {
+  auto conn = createSimpleConnection();
+  conn.zeroCopy(true);
+  EXPECT_TRUE(conn.zeroCopy());
+
+  seconds consumeTimeout(55);
+  struct timeval consumeTv{.tv_sec = consumeTimeout.count(), .tv_usec = 0};
+
+  char body[] = "hello";
+  amqp_basic_deliver_t deliver{.consumer_tag = amqp_bytes_t{.len = 4, .bytes = const_cast<char*>("ctag")}, .delivery_tag = 42};
+  amqp_basic_properties_t properties{};
+
+  EXPECT_CALL(amqp, destroy_envelope(_)).Times(0);
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(consumeTv)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .channel = 3, .payload = { amqp_method_t{.id = AMQP_BASIC_DELIVER_METHOD, .decoded = &deliver}}}), Return(AMQP_STATUS_OK)));
+  amqp_frame_t header{.frame_type = AMQP_FRAME_HEADER, .channel = 3};
+  header.payload.properties.body_size = 5;
+  header.payload.properties.decoded = &properties;
+  amqp_frame_t content{.frame_type = AMQP_FRAME_BODY, .channel = 3};
+  content.payload.body_fragment = amqp_bytes_t{.len = 5, .bytes = body};
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, nullptr))
+    .WillOnce(DoAll(SetArgPointee<1>(header), Return(AMQP_STATUS_OK)))
+    .WillOnce(DoAll(SetArgPointee<1>(content), Return(AMQP_STATUS_OK)));
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 3)); // last envelope of the channel destroyed
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+
+  bool called = false;
+  EXPECT_TRUE(conn.consumeEnvelope(consumeTimeout, [&] (Envelope envelope) {
+    EXPECT_TRUE(envelope.borrowed());
+    EXPECT_EQ(envelope->message.body.bytes, static_cast<void*>(body));
+    EXPECT_EQ(envelope->delivery_tag, 42u);
+    EXPECT_EQ(envelope->channel, 3);
+    EXPECT_EQ(envelope.body(), "hello");
+    called = true;
+  }));
+  EXPECT_TRUE(called);
+}
+
+TEST_F(ConnectionTest, ZeroCopyConsumeReassembles) {
+  auto conn = createSimpleConnection();
+  conn.zeroCopy(true);
+
+  seconds consumeTimeout(55);
+  struct timeval consumeTv{.tv_sec = consumeTimeout.count(), .tv_usec = 0};
+
+  char first[] = "hello";
+  char second[] = "world";
+  amqp_basic_deliver_t deliver{.delivery_tag = 1};
+  amqp_basic_properties_t properties{};
+
+  EXPECT_CALL(amqp, destroy_envelope(_)).Times(0);
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(consumeTv)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .channel = 3, .payload = { amqp_method_t{.id = AMQP_BASIC_DELIVER_METHOD, .decoded = &deliver}}}), Return(AMQP_STATUS_OK)));
+  amqp_frame_t header{.frame_type = AMQP_FRAME_HEADER, .channel = 3};
+  header.payload.properties.body_size = 10;
+  header.payload.properties.decoded = &properties;
+  amqp_frame_t content{.frame_type = AMQP_FRAME_BODY, .channel = 3};
+  content.payload.body_fragment = amqp_bytes_t{.len = 5, .bytes = first};
+  amqp_frame_t rest = content;
+  rest.payload.body_fragment.bytes = second;
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, nullptr))
+    .WillOnce(DoAll(SetArgPointee<1>(header), Return(AMQP_STATUS_OK)))
+    .WillOnce(DoAll(SetArgPointee<1>(content), Return(AMQP_STATUS_OK)))
+    .WillOnce(DoAll(SetArgPointee<1>(rest), Return(AMQP_STATUS_OK)));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr)).Times(0); // the envelope is still alive
+
+  Envelope kept;
+  EXPECT_TRUE(conn.consumeEnvelope(consumeTimeout, [&kept] (Envelope envelope) {
+    kept = std::move(envelope);
+  }));
+  EXPECT_TRUE(kept.borrowed());
+  EXPECT_EQ(kept.body(), "helloworld");
+  EXPECT_NE(kept->message.body.bytes, static_cast<void*>(first));
+
+  conn.releaseBuffers(3); // pinned, not released
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 3));
+  kept = Envelope();
+  EXPECT_CALL(amqp, destroy_envelope(static_cast<amqp_envelope_t*>(kept)));
+}
+
+TEST_F(ConnectionTest, ZeroCopyMemoryResource) {
+  auto conn = createSimpleConnection();
+  alignas(std::max_align_t) char arena[1024];
+  std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+  conn.zeroCopy(true);
+  conn.memoryResource(&resource);
+  EXPECT_EQ(conn.memoryResource(), &resource);
+
+  char first[] = "hello";
+  char second[] = "world";
+  amqp_basic_deliver_t deliver{.delivery_tag = 1};
+  amqp_basic_properties_t properties{};
+  amqp_frame_t header{.frame_type = AMQP_FRAME_HEADER, .channel = 3};
+  header.payload.properties.body_size = 10;
+  header.payload.properties.decoded = &properties;
+  amqp_frame_t content{.frame_type = AMQP_FRAME_BODY, .channel = 3};
+  content.payload.body_fragment = amqp_bytes_t{.len = 5, .bytes = first};
+  amqp_frame_t rest = content;
+  rest.payload.body_fragment.bytes = second;
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, _))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .channel = 3, .payload = { amqp_method_t{.id = AMQP_BASIC_DELIVER_METHOD, .decoded = &deliver}}}), Return(AMQP_STATUS_OK)))
+    .WillOnce(DoAll(SetArgPointee<1>(header), Return(AMQP_STATUS_OK)))
+    .WillOnce(DoAll(SetArgPointee<1>(content), Return(AMQP_STATUS_OK)))
+    .WillOnce(DoAll(SetArgPointee<1>(rest), Return(AMQP_STATUS_OK)));
+
+  Envelope kept;
+  EXPECT_TRUE(conn.consumeEnvelope(seconds(1), [&kept] (Envelope envelope) {
+    kept = std::move(envelope);
+  }));
+  EXPECT_EQ(kept.body(), "helloworld");
+  const auto* body = static_cast<const char*>(kept->message.body.bytes);
+  EXPECT_TRUE(body >= arena && body < arena + sizeof(arena));
+  EXPECT_THROW(conn.memoryResource(std::pmr::get_default_resource()), ConnectionException);
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 3));
+  kept = Envelope();
+  EXPECT_CALL(amqp, destroy_envelope(static_cast<amqp_envelope_t*>(kept)));
+  resource.release(); // frees the batch
+}
+
+TEST_F(ConnectionTest, ZeroCopyConsumeInterleavedFrame) {
+  auto conn = createSimpleConnection();
+  conn.zeroCopy(true);
+
+  seconds consumeTimeout(55);
+  struct timeval consumeTv{.tv_sec = consumeTimeout.count(), .tv_usec = 0};
+
+  amqp_basic_deliver_t deliver{.delivery_tag = 1};
+
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(consumeTv)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .channel = 3, .payload = { amqp_method_t{.id = AMQP_BASIC_DELIVER_METHOD, .decoded = &deliver}}}), Return(AMQP_STATUS_OK)));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, nullptr))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t{.frame_type = AMQP_FRAME_HEADER, .channel = 4}), Return(AMQP_STATUS_OK)));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_THROW(conn.consumeEnvelope(consumeTimeout, [] (Envelope) {}), FrameException);
+}
+
+TEST_F(ConnectionTest, ReactorInterest) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillOnce(Return(12))
+    .WillOnce(Return(-1));
+  EXPECT_EQ(conn.interest(), Connection::Interest::Read);
+  EXPECT_EQ(conn.interest(), Connection::Interest::None);
+}
+
+TEST_F(ConnectionTest, OnReadable) {
+  auto conn = createSimpleConnection();
+  struct timeval zeroTv{.tv_sec = 0, .tv_usec = 0};
+
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillRepeatedly(DoAll(Invoke([] (amqp_connection_state_t, amqp_envelope_t* envelope, struct timeval*, int) { envelope->channel = 1; }), Return(normalReply)));
+  EXPECT_CALL(amqp, frames_enqueued(connPtr))
+    .WillRepeatedly(Return(false));
+  EXPECT_CALL(amqp, data_in_buffer(connPtr))
+    .WillOnce(Return(true))
+    .WillOnce(Return(false))
+    .WillRepeatedly(Return(true));
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(5);
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(5);
+
+  std::size_t envelopes = 0;
+  auto envelope = [&envelopes] (Envelope) { ++envelopes; };
+  // drains until nothing is buffered
+  EXPECT_EQ(conn.onReadable(10, envelope, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, nullptr), 2);
+  // stops when the budget is used up
+  EXPECT_EQ(conn.onReadable(3, envelope, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, nullptr), 3);
+  EXPECT_EQ(envelopes, 5);
+}
+
+TEST_F(ConnectionTest, ConsumeBatch) {
+  auto conn = createSimpleConnection();
+  seconds consumeTimeout(55);
+  struct timeval consumeTv{.tv_sec = consumeTimeout.count(), .tv_usec = 0};
+  struct timeval zeroTv{.tv_sec = 0, .tv_usec = 0};
+
+  auto deliver = [] (amqp_connection_state_t, amqp_envelope_t* envelope, struct timeval*, int) { envelope->channel = 1; };
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(consumeTv), 0))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_TIMEOUT}))
+    .WillRepeatedly(DoAll(Invoke(deliver), Return(normalReply)));
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillRepeatedly(DoAll(Invoke(deliver), Return(normalReply)));
+  EXPECT_CALL(amqp, frames_enqueued(connPtr))
+    .WillRepeatedly(Return(false));
+  EXPECT_CALL(amqp, data_in_buffer(connPtr))
+    .WillOnce(Return(true))
+    .WillOnce(Return(true))
+    .WillOnce(Return(false))
+    .WillRepeatedly(Return(true));
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(8);
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(8);
+
+  std::size_t envelopes = 0;
+  auto envelope = [&envelopes] (Envelope) { ++envelopes; };
+  // times out waiting for the first frame
+  EXPECT_EQ(conn.consumeBatch(consumeTimeout, 10, envelope, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, nullptr), 0);
+  // drains until nothing is buffered
+  EXPECT_EQ(conn.consumeBatch(consumeTimeout, 10, envelope, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, nullptr), 3);
+  // stops when the budget is used up
+  EXPECT_EQ(conn.consumeBatch(consumeTimeout, 4, envelope, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, nullptr), 4);
+  EXPECT_EQ(envelopes, 7);
+}
+
+TEST_F(ConnectionTest, NextTimeout) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_heartbeat(connPtr))
+    .WillOnce(Return(0))
+    .WillRepeatedly(Return(4));
+  EXPECT_EQ(conn.nextTimeout(), milliseconds::max());
+  const auto& timeout = conn.nextTimeout();
+  EXPECT_GT(timeout, milliseconds::zero());
+  EXPECT_LE(timeout, milliseconds(2000));
+}
+
+TEST_F(ConnectionTest, OnTimeout) {
+  auto conn = createSimpleConnection();
+  struct timeval zeroTv{.tv_sec = 0, .tv_usec = 0};
+
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_TIMEOUT}));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_FALSE(conn.onTimeout([] (Envelope) {}, [] (ReturnedMessage) {}, [] (amqp_basic_ack_t) {}, nullptr));
+}
+
 TEST_F(ConnectionTest, SetRPCTimeout) {
   auto conn = createSimpleConnection();
   seconds rpcTimeout(1);
@@ -0,0 +1,169 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/Deduplicator.hpp>
+
+#include "ChannelTest.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::Return;
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+struct DeduplicatorTest : public ChannelTest {
+  Envelope delivery(uint64_t tag, const char* messageId, bool redelivered = true) {
+    Envelope envelope;
+    envelope->channel = channelId;
+    envelope->delivery_tag = tag;
+    envelope->redelivered = redelivered;
+    envelope->message.properties._flags = AMQP_BASIC_MESSAGE_ID_FLAG;
+    envelope->message.properties.message_id.bytes = const_cast<char*>(messageId);
+    envelope->message.properties.message_id.len = std::strlen(messageId);
+    return envelope;
+  }
+};
+
+TEST_F(DeduplicatorTest, Fingerprint) {
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(3);
+  auto a = delivery(1, "a");
+  auto b = delivery(2, "a");
+  auto c = delivery(3, "b");
+  EXPECT_EQ(Deduplicator::fingerprint(a), Deduplicator::fingerprint(b));
+  EXPECT_NE(Deduplicator::fingerprint(a), Deduplicator::fingerprint(c));
+}
+
+TEST_F(DeduplicatorTest, Expires) {
+  Deduplicator dedup(16, seconds(10));
+  const auto start = Deduplicator::Clock::now();
+  dedup.insert(42, start);
+  EXPECT_TRUE(dedup.contains(42, start + seconds(9)));
+  EXPECT_FALSE(dedup.contains(43, start));
+  EXPECT_FALSE(dedup.contains(42, start + seconds(10)));
+  EXPECT_EQ(dedup.size(), 0);
+}
+
+TEST_F(DeduplicatorTest, EvictsLeastRecentlySeen) {
+  Deduplicator dedup(100, seconds(10));
+  const auto start = Deduplicator::Clock::now();
+  for (uint64_t i = 0; i < 100; ++i)
+    dedup.insert(i * 64, start); // same home slot to exercise probing
+  dedup.insert(0, start);
+  for (uint64_t i = 100; i < 150; ++i)
+    dedup.insert(i * 64, start);
+  EXPECT_EQ(dedup.size(), 100);
+  EXPECT_TRUE(dedup.contains(0, start));
+  for (uint64_t i = 1; i <= 50; ++i)
+    EXPECT_FALSE(dedup.contains(i * 64, start)) << i;
+  for (uint64_t i = 51; i < 150; ++i)
+    EXPECT_TRUE(dedup.contains(i * 64, start)) << i;
+}
+
+TEST_F(DeduplicatorTest, RefreshesKeepTrackedKeys) {
+  Deduplicator dedup(16, seconds(10));
+  const auto start = Deduplicator::Clock::now();
+  dedup.insert(42, start);
+  for (uint64_t i = 0; i < 15; ++i)
+    dedup.insert(i + 100, start);
+  for (int round = 0; round < 3; ++round) {
+    for (uint64_t i = 0; i < 15; ++i)
+      dedup.insert(i + 100, start);
+  }
+  EXPECT_EQ(dedup.size(), 16);
+  EXPECT_TRUE(dedup.contains(42, start));
+
+  // a key refreshed between new keys survives the rotations they cause
+  for (uint64_t round = 1; round <= 4; ++round) {
+    dedup.insert(42, start);
+    for (uint64_t i = 0; i < 15; ++i)
+      dedup.insert(round * 100 + 100 + i, start);
+  }
+  EXPECT_TRUE(dedup.contains(42, start));
+  for (uint64_t i = 0; i < 15; ++i) {
+    EXPECT_TRUE(dedup.contains(500 + i, start)) << i;
+    EXPECT_FALSE(dedup.contains(400 + i, start)) << i;
+  }
+}
+
+TEST_F(DeduplicatorTest, SkipsDuplicates) {
+  auto ch = createSimpleChannel();
+  Deduplicator dedup(16, seconds(60));
+  std::size_t calls = 0;
+  auto handler = deduplicate(ch, dedup, [&calls] (Envelope) { ++calls; });
+
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(3);
+  handler(delivery(1, "m1", false));
+  handler(delivery(2, "m2", false));
+  EXPECT_EQ(calls, 2);
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, basic_ack(connPtr, channelId, 3UL, false))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_ack"))
+    .WillOnce(Return(normalReply));
+  handler(delivery(3, "m1", true));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST_F(DeduplicatorTest, ChecksOnlyRedelivered) {
+  auto ch = createSimpleChannel();
+  Deduplicator dedup(16, seconds(60));
+  std::size_t calls = 0;
+  auto handler = deduplicate(ch, dedup, [&calls] (Envelope) { ++calls; });
+
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2);
+  handler(delivery(1, "m1", false));
+  handler(delivery(2, "m1", false));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST_F(DeduplicatorTest, ForgetsFailedDeliveries) {
+  auto ch = createSimpleChannel();
+  Deduplicator dedup(16, seconds(60), false);
+  std::size_t calls = 0;
+  auto handler = deduplicate(ch, dedup, [&calls] (Envelope) {
+    if (++calls == 1)
+      throw std::runtime_error("failed");
+  });
+
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2);
+  EXPECT_THROW(handler(delivery(1, "m1")), std::runtime_error);
+  handler(delivery(2, "m1"));
+  EXPECT_EQ(calls, 2);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,120 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <memory_resource>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/DeliveryBuffers.hpp>
+
+#include "MockAMQP.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::Test;
+
+struct DeliveryBuffersTest : public Test {
+  DeliveryBuffersTest() : connPtr(reinterpret_cast<amqp_connection_state_t>(7)), buffers(std::make_shared<DeliveryBuffers>(connPtr)) {}
+
+  amqp_connection_state_t connPtr;
+  std::shared_ptr<DeliveryBuffers> buffers;
+  MockAMQP amqp;
+};
+
+TEST_F(DeliveryBuffersTest, ReleasesOnLastLease) {
+  auto first = buffers->pin(3);
+  auto second = buffers->pin(3);
+  auto other = buffers->pin(4);
+  EXPECT_TRUE(buffers->pinned());
+  EXPECT_TRUE(buffers->pinned(3));
+  EXPECT_FALSE(buffers->pinned(5));
+
+  first.reset();
+  EXPECT_TRUE(buffers->pinned(3));
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 3));
+  second.reset();
+  EXPECT_FALSE(buffers->pinned(3));
+  EXPECT_TRUE(buffers->pinned());
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 4));
+  other.reset();
+  EXPECT_FALSE(buffers->pinned());
+}
+
+TEST_F(DeliveryBuffersTest, ReusesBodies) {
+  auto body = buffers->body(100);
+  EXPECT_TRUE(body->empty());
+  EXPECT_GE(body->capacity(), 100u);
+  body->assign(50, 'x');
+  const auto* data = body->data();
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 1));
+  buffers->pin(1, std::move(body)).reset();
+  EXPECT_EQ(buffers->spare(), 1u);
+
+  auto reused = buffers->body(10);
+  EXPECT_TRUE(reused->empty());
+  EXPECT_EQ(reused->data(), data);
+  EXPECT_EQ(buffers->spare(), 0u);
+}
+
+TEST_F(DeliveryBuffersTest, KeepsLimitedSpares) {
+  std::vector<std::shared_ptr<void>> leases;
+  for (std::size_t i = 0; i < DeliveryBuffers::kSpareBodies + 4; ++i)
+    leases.push_back(buffers->pin(1, buffers->body(8)));
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 1));
+  leases.clear();
+  EXPECT_EQ(buffers->spare(), DeliveryBuffers::kSpareBodies);
+}
+
+TEST_F(DeliveryBuffersTest, MemoryResource) {
+  alignas(std::max_align_t) char arena[4096];
+  std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+  auto pooled = std::make_shared<DeliveryBuffers>(connPtr, &resource);
+  EXPECT_EQ(pooled->resource(), &resource);
+
+  auto body = pooled->body(100);
+  const auto* data = reinterpret_cast<const char*>(body->data());
+  EXPECT_TRUE(data >= arena && data + 100 <= arena + sizeof(arena));
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, 1));
+  pooled->pin(1, std::move(body)).reset();
+  EXPECT_EQ(pooled->spare(), 0u); // not reused, the resource may be reset
+
+  resource.release();
+  auto next = pooled->body(100);
+  EXPECT_EQ(reinterpret_cast<const char*>(next->data()), data); // the whole batch was freed at once
+}
+
+TEST_F(DeliveryBuffersTest, OutlivesOwner) {
+  auto lease = buffers->pin(2);
+  buffers->detach();
+  buffers.reset();
+  lease.reset(); // the connection is gone, nothing to release
+}
+
+}} // namespace rmqcxx.unit_tests
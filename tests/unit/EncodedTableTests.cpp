@@ -0,0 +1,105 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "comparison.hpp"
+
+#include <rmqcxx/EncodedTable.hpp>
+#include <rmqcxx/Table.hpp>
+#include <rmqcxx/TableEntry.hpp>
+#include <rmqcxx/Wire.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+constexpr auto kQuorum = encodeTable(encodeField("x-queue-type", "quorum"), encodeField("x-max-length", int32_t(1000)));
+
+// built at compile time
+static_assert(kQuorum.size() == 4 + 13 + 1 + 4 + 6 + 13 + 1 + 4, "Size of the encoding");
+static_assert(kQuorum.count() == 2, "Number of entries");
+static_assert(kQuorum[3] == kQuorum.size() - 4 && kQuorum[4] == 12 && kQuorum[17] == AMQP_FIELD_KIND_UTF8, "Encoding");
+
+vector<uint8_t> encoding(const ::amqp_bytes_t& bytes) {
+  const auto data = static_cast<const uint8_t*>(bytes.bytes);
+  return vector<uint8_t>(data, data + bytes.len);
+}
+
+vector<uint8_t> encoding(const ::amqp_table_t& table) {
+  WireWriter out;
+  out.table(table);
+  return vector<uint8_t>(out.data(), out.data() + out.size());
+}
+
+} // namespace
+
+// The encoding has to be the one rabbitmq-c produces for the same table
+
+TEST(EncodedTableTest, MatchesRuntimeEncoding) {
+  EXPECT_EQ(encoding(kQuorum.bytes()), encoding(Table(TableEntry("x-queue-type", "quorum"), TableEntry("x-max-length", int32_t(1000)))));
+
+  constexpr auto all = encodeTable(
+    encodeField("t", true), encodeField("b", int8_t(-2)), encodeField("B", uint8_t(200)), encodeField("s", int16_t(-300)),
+    encodeField("u", uint16_t(60000)), encodeField("I", int32_t(-70000)), encodeField("i", uint32_t(4000000000U)),
+    encodeField("l", int64_t(-5000000000LL)), encodeField("L", uint64_t(0x0102030405060708ULL)), encodeField("S", ""));
+  EXPECT_EQ(encoding(all.bytes()), encoding(Table(
+    TableEntry("t", true), TableEntry("b", int8_t(-2)), TableEntry("B", uint8_t(200)), TableEntry("s", int16_t(-300)),
+    TableEntry("u", uint16_t(60000)), TableEntry("I", int32_t(-70000)), TableEntry("i", uint32_t(4000000000U)),
+    TableEntry("l", int64_t(-5000000000LL)), TableEntry("L", uint64_t(0x0102030405060708ULL)), TableEntry("S", ""))));
+
+  constexpr auto empty = encodeTable();
+  EXPECT_EQ(encoding(empty.bytes()), (vector<uint8_t>{0, 0, 0, 0}));
+  EXPECT_EQ(static_cast<amqp_table_t>(empty.entries()).num_entries, 0);
+}
+
+TEST(EncodedTableTest, Entries) {
+  const auto entries = kQuorum.entries();
+  const amqp_table_t table = entries;
+  EXPECT_EQ(table, static_cast<amqp_table_t>(Table(TableEntry("x-queue-type", "quorum"), TableEntry("x-max-length", int32_t(1000)))));
+  // references the encoding instead of copying
+  EXPECT_EQ(table.entries[0].key.bytes, static_cast<const void*>(&static_cast<const uint8_t*>(kQuorum.bytes().bytes)[5]));
+  EXPECT_EQ(entries.encoded().bytes, kQuorum.bytes().bytes);
+  EXPECT_EQ(entries.encoded().len, kQuorum.size());
+
+  constexpr auto all = encodeTable(
+    encodeField("t", false), encodeField("b", int8_t(-2)), encodeField("B", uint8_t(200)), encodeField("s", int16_t(-300)),
+    encodeField("u", uint16_t(60000)), encodeField("I", int32_t(-70000)), encodeField("i", uint32_t(4000000000U)),
+    encodeField("l", int64_t(-5000000000LL)), encodeField("L", uint64_t(0x0102030405060708ULL)), encodeField("S", ""));
+  EXPECT_EQ(static_cast<amqp_table_t>(all.entries()), static_cast<amqp_table_t>(Table(
+    TableEntry("t", false), TableEntry("b", int8_t(-2)), TableEntry("B", uint8_t(200)), TableEntry("s", int16_t(-300)),
+    TableEntry("u", uint16_t(60000)), TableEntry("I", int32_t(-70000)), TableEntry("i", uint32_t(4000000000U)),
+    TableEntry("l", int64_t(-5000000000LL)), TableEntry("L", uint64_t(0x0102030405060708ULL)), TableEntry("S", ""))));
+}
+
+}} // namespace rmqcxx.unit_tests
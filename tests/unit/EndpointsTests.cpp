@@ -0,0 +1,199 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ConnectionTest.hpp"
+#include <rmqcxx/Endpoints.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::InvokeWithoutArgs;
+using ::testing::Return;
+using ::testing::StrEq;
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+struct EndpointsTest : public ConnectionTest {
+
+  void prepareAttempts() {
+    EXPECT_CALL(amqp, new_connection())
+      .WillRepeatedly(Return(connPtr));
+    EXPECT_CALL(amqp, tcp_socket_new(connPtr))
+      .WillRepeatedly(Return(socketPtr));
+    EXPECT_CALL(amqp, login_with_properties(connPtr, StrEq(vhost), maxChannels, maxFrameSize, heartbeat, AnnouncesCancelNotify(), AMQP_SASL_METHOD_PLAIN, _))
+      .WillRepeatedly(Return(normalReply));
+    EXPECT_CALL(amqp, connection_close(connPtr, AMQP_REPLY_SUCCESS))
+      .WillRepeatedly(Return(normalReply));
+    EXPECT_CALL(amqp, get_rpc_reply(connPtr, "connection_close"))
+      .WillRepeatedly(Return(normalReply));
+    EXPECT_CALL(amqp, destroy_connection(connPtr))
+      .WillRepeatedly(Return(AMQP_STATUS_OK));
+  }
+
+  Connection connect(const Endpoints& endpoints) {
+    return Connection(endpoints, "user", "password", vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout);
+  }
+
+  void waitForFailures(const Endpoints& endpoints, std::size_t index, std::size_t failures) {
+    const auto& deadline = steady_clock::now() + seconds(5);
+    while (endpoints.failures(index) < failures && steady_clock::now() < deadline)
+      std::this_thread::sleep_for(milliseconds(1));
+  }
+};
+
+TEST_F(EndpointsTest, Order) {
+  EXPECT_THROW(Endpoints(std::vector<Endpoint>()), Exception);
+
+  Endpoints endpoints({{"a", 1}, {"b", 2}, {"c", 3}});
+  ASSERT_EQ(endpoints.size(), 3);
+  EXPECT_EQ(endpoints[1].address, "b");
+  EXPECT_EQ(endpoints[2].port, 3);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{0, 1, 2}));
+
+  endpoints.failed(0);
+  EXPECT_TRUE(endpoints.quarantined(0));
+  EXPECT_EQ(endpoints.failures(0), 1);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{1, 2, 0}));
+
+  endpoints.succeeded(2);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{2, 1, 0}));
+
+  std::this_thread::sleep_for(milliseconds(1));
+  endpoints.failed(1);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{2, 0, 1}));
+
+  endpoints.succeeded(0);
+  EXPECT_FALSE(endpoints.quarantined(0));
+  EXPECT_EQ(endpoints.failures(0), 0);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{0, 2, 1}));
+
+  Endpoints copy = endpoints;
+  copy.failed(2);
+  EXPECT_TRUE(endpoints.quarantined(2));
+}
+
+TEST_F(EndpointsTest, QuarantineExpires) {
+  Endpoints endpoints({{"a", 1}, {"b", 2}}, milliseconds(10), milliseconds(1));
+  endpoints.failed(0);
+  std::this_thread::sleep_for(milliseconds(5));
+  EXPECT_FALSE(endpoints.quarantined(0));
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{0, 1}));
+}
+
+TEST_F(EndpointsTest, FailsOverWithoutWaitingForTheStagger) {
+  prepareAttempts();
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("down"), 1, _))
+    .WillOnce(Return(AMQP_STATUS_SOCKET_ERROR));
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("up"), 2, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+
+  Endpoints endpoints({{"down", 1}, {"up", 2}}, seconds(10));
+  const auto& start = steady_clock::now();
+  {
+    auto conn = connect(endpoints);
+  }
+  EXPECT_LT(steady_clock::now() - start, seconds(5));
+  EXPECT_EQ(endpoints.failures(0), 1);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{1, 0}));
+}
+
+TEST_F(EndpointsTest, RacesSlowEndpoint) {
+  prepareAttempts();
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("slow"), 1, _))
+    .WillOnce(InvokeWithoutArgs([] () { std::this_thread::sleep_for(milliseconds(300)); return AMQP_STATUS_SOCKET_ERROR; }));
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("up"), 2, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+
+  Endpoints endpoints({{"slow", 1}, {"up", 2}}, milliseconds(20));
+  const auto& start = steady_clock::now();
+  {
+    auto conn = connect(endpoints);
+    EXPECT_LT(steady_clock::now() - start, milliseconds(250));
+  }
+  waitForFailures(endpoints, 0, 1);
+  EXPECT_EQ(endpoints.failures(0), 1);
+  EXPECT_EQ(endpoints.failures(1), 0);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{1, 0}));
+}
+
+TEST_F(EndpointsTest, JoinsLosingAttempts) {
+  prepareAttempts();
+  std::atomic<bool> finished(false);
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("slow"), 1, _))
+    .WillOnce(InvokeWithoutArgs([&finished] () { std::this_thread::sleep_for(milliseconds(200)); finished = true; return AMQP_STATUS_SOCKET_ERROR; }));
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("up"), 2, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+
+  {
+    Endpoints endpoints({{"slow", 1}, {"up", 2}}, milliseconds(20));
+    auto conn = connect(endpoints);
+    EXPECT_FALSE(finished);
+  }
+  // the list does not outlive the attempt that lost the race
+  EXPECT_TRUE(finished);
+}
+
+TEST_F(EndpointsTest, RemembersTheWinnerNotTheLastLogin) {
+  prepareAttempts();
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("slow"), 1, _))
+    .WillOnce(InvokeWithoutArgs([] () { std::this_thread::sleep_for(milliseconds(100)); return AMQP_STATUS_OK; }));
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, StrEq("fast"), 2, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+
+  Endpoints endpoints({{"slow", 1}, {"fast", 2}}, milliseconds(20));
+  endpoints.failed(1);
+  {
+    auto conn = connect(endpoints);
+  }
+  std::this_thread::sleep_for(milliseconds(300)); // the slow attempt logs in after the race was decided
+  EXPECT_EQ(endpoints.failures(0), 0);
+  EXPECT_EQ(endpoints.failures(1), 0);
+  EXPECT_EQ(endpoints.order(), (std::vector<std::size_t>{1, 0}));
+}
+
+TEST_F(EndpointsTest, AllFail) {
+  prepareAttempts();
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, _, _, _))
+    .WillRepeatedly(Return(AMQP_STATUS_SOCKET_ERROR));
+
+  Endpoints endpoints({{"a", 1}, {"b", 2}}, milliseconds(10));
+  EXPECT_THROW(connect(endpoints), SocketException);
+  EXPECT_EQ(endpoints.failures(0), 1);
+  EXPECT_EQ(endpoints.failures(1), 1);
+}
+
+}} // namespace rmqcxx.unit_tests
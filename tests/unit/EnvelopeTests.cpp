@@ -74,6 +74,16 @@ TEST_F(EnvelopeTest, MoveAssignmentTest) {
   EXPECT_CALL(amqp, destroy_envelope(static_cast<::amqp_envelope_t*>(y)));
 }
 
+TEST_F(EnvelopeTest, BorrowedTest) {
+  auto released = std::make_shared<bool>(false);
+  {
+    Envelope x(::amqp_envelope_t(), std::shared_ptr<void>(released.get(), [released] (void*) { *released = true; }));
+    EXPECT_TRUE(x.borrowed());
+    EXPECT_CALL(amqp, destroy_envelope(::testing::_)).Times(0);
+  }
+  EXPECT_TRUE(*released);
+}
+
 TEST_F(EnvelopeTest, CastTest) {
   Envelope x;
   x->channel = 10;
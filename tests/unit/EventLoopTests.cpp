@@ -0,0 +1,214 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/EventLoop.hpp>
+
+#include "ConnectionTest.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::Pointee;
+using ::testing::Return;
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+struct EventLoopTest : public ConnectionTest {
+  EventLoopTest() : zeroTv{.tv_sec = 0, .tv_usec = 0} {
+    EXPECT_EQ(::pipe(fds), 0);
+  }
+
+  ~EventLoopTest() {
+    ::close(fds[0]);
+    ::close(fds[1]);
+  }
+
+  void prepareLoop(int heartbeatSeconds = 0) {
+    EXPECT_CALL(amqp, get_sockfd(connPtr))
+      .WillRepeatedly(Return(fds[0]));
+    EXPECT_CALL(amqp, get_heartbeat(connPtr))
+      .WillRepeatedly(Return(heartbeatSeconds));
+    EXPECT_CALL(amqp, data_in_buffer(connPtr))
+      .WillRepeatedly(Return(false));
+    EXPECT_CALL(amqp, frames_enqueued(connPtr))
+      .WillRepeatedly(Return(false));
+  }
+
+  void makeReadable() {
+    const char c = 0;
+    EXPECT_EQ(::write(fds[1], &c, 1), 1);
+  }
+
+  int fds[2];
+  struct timeval zeroTv;
+};
+
+static void deliver(amqp_connection_state_t, amqp_envelope_t* envelope, struct timeval*, int) {
+  envelope->channel = 1;
+  envelope->delivery_tag = 5;
+}
+
+TEST_F(EventLoopTest, DispatchesReadableConnection) {
+  auto conn = createSimpleConnection();
+  prepareLoop();
+  EventLoop loop;
+  std::size_t envelopes = 0;
+  EventLoop::Handlers handlers;
+  handlers.envelope = [&envelopes] (Envelope e) { EXPECT_EQ(e->delivery_tag, 5UL); ++envelopes; };
+  loop.add(conn, handlers);
+  EXPECT_EQ(loop.size(), 1);
+
+  makeReadable();
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillOnce(DoAll(Invoke(deliver), Return(normalReply)));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_EQ(loop.runOnce(milliseconds(0)), 1);
+  EXPECT_EQ(envelopes, 1);
+
+  EXPECT_TRUE(loop.remove(conn));
+  EXPECT_FALSE(loop.remove(conn));
+  EXPECT_EQ(loop.size(), 0);
+}
+
+TEST_F(EventLoopTest, DrainsBufferedData) {
+  auto conn = createSimpleConnection();
+  prepareLoop();
+  EventLoop loop;
+  std::size_t envelopes = 0;
+  EventLoop::Handlers handlers;
+  handlers.envelope = [&envelopes] (Envelope) { ++envelopes; };
+  loop.add(conn, handlers);
+
+  makeReadable();
+  EXPECT_CALL(amqp, data_in_buffer(connPtr))
+    .WillOnce(Return(true))
+    .WillOnce(Return(true))
+    .WillRepeatedly(Return(false));
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .Times(3)
+    .WillRepeatedly(DoAll(Invoke(deliver), Return(normalReply)));
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(3);
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(3);
+  EXPECT_EQ(loop.runOnce(milliseconds(0)), 3);
+  EXPECT_EQ(envelopes, 3);
+}
+
+TEST_F(EventLoopTest, IdleConnectionWaits) {
+  auto conn = createSimpleConnection();
+  prepareLoop();
+  EventLoop loop;
+  loop.add(conn, EventLoop::Handlers());
+
+  const auto start = EventLoop::Clock::now();
+  EXPECT_EQ(loop.runOnce(milliseconds(20)), 0);
+  EXPECT_GE(EventLoop::Clock::now() - start, milliseconds(20));
+}
+
+TEST_F(EventLoopTest, Timers) {
+  EventLoop loop;
+  std::size_t calls = 0;
+  loop.after(milliseconds(5), [&calls] () { ++calls; });
+  const auto start = EventLoop::Clock::now();
+  EXPECT_EQ(loop.runOnce(seconds(10)), 1);
+  EXPECT_LT(EventLoop::Clock::now() - start, seconds(1));
+  EXPECT_EQ(calls, 1);
+}
+
+TEST_F(EventLoopTest, ServicesHeartbeats) {
+  auto conn = createSimpleConnection();
+  prepareLoop(1);
+  EventLoop loop;
+  const auto start = EventLoop::Clock::now(); // the heartbeat timer is armed by add
+  loop.add(conn, EventLoop::Handlers());
+
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_TIMEOUT}));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_EQ(loop.runOnce(seconds(10)), 1); // the heartbeat timer
+  EXPECT_GE(EventLoop::Clock::now() - start, milliseconds(500));
+}
+
+TEST_F(EventLoopTest, FatalErrorRemovesConnection) {
+  auto conn = createSimpleConnection();
+  prepareLoop();
+  EventLoop loop;
+  std::size_t errors = 0;
+  EventLoop::Handlers handlers;
+  handlers.error = [&errors, &conn] (Connection& c, std::exception_ptr ex) {
+    EXPECT_EQ(&c, &conn);
+    EXPECT_THROW(std::rethrow_exception(ex), SocketException);
+    ++errors;
+  };
+  loop.add(conn, handlers);
+
+  makeReadable();
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_SOCKET_ERROR}));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_EQ(loop.runOnce(milliseconds(0)), 0);
+  EXPECT_EQ(errors, 1);
+  EXPECT_EQ(loop.size(), 0);
+}
+
+TEST_F(EventLoopTest, ErrorWithoutHandlerPropagates) {
+  auto conn = createSimpleConnection();
+  prepareLoop();
+  EventLoop loop;
+  loop.add(conn, EventLoop::Handlers());
+
+  makeReadable();
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_SOCKET_ERROR}));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_THROW(loop.runOnce(milliseconds(0)), SocketException);
+  EXPECT_EQ(loop.size(), 0);
+}
+
+TEST_F(EventLoopTest, Stop) {
+  EventLoop loop;
+  loop.after(milliseconds(1), [&loop] () { loop.stop(); });
+  loop.run();
+  loop.stop();
+  loop.run(); // consumes the pending stop request
+}
+
+}} // namespace rmqcxx.unit_tests
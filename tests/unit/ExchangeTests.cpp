@@ -25,17 +25,27 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <cstring>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 #include "ChannelTest.hpp"
+#include <rmqcxx/EncodedTable.hpp>
 #include <rmqcxx/Exchange.hpp>
 #include <rmqcxx/TableEntry.hpp>
 
 namespace rmqcxx { namespace unit_tests {
 
+using ::testing::_;
+using ::testing::Invoke;
 using ::testing::Return;
 
 using std::string;
+using std::vector;
 
 struct ExchangeTest : ChannelTest {
 
@@ -141,6 +151,72 @@ TEST_F(ExchangeTest, Bind) {
   ex.bind("otherEx", "rkey", TableEntry("entry", 1));
 }
 
+TEST_F(ExchangeTest, DeclareNoWait) {
+  auto ch = createSimpleChannel();
+  Exchange ex(ch, "exchange1");
+
+  EXPECT_CALL(amqp, send_method(connPtr, channelId, AMQP_EXCHANGE_DECLARE_METHOD, _))
+    .WillOnce(Invoke([&] (amqp_connection_state_t, amqp_channel_t, amqp_method_number_t, void* decoded) {
+      auto method = static_cast<amqp_exchange_declare_t*>(decoded);
+      EXPECT_EQ(container<string>(method->exchange), "exchange1");
+      EXPECT_EQ(container<string>(method->type), "type");
+      EXPECT_FALSE(method->passive);
+      EXPECT_TRUE(method->durable);
+      EXPECT_FALSE(method->auto_delete);
+      EXPECT_TRUE(method->nowait);
+      EXPECT_EQ(method->arguments.num_entries, 1);
+      return AMQP_STATUS_OK;
+    }))
+    .WillOnce(Return(AMQP_STATUS_SOCKET_ERROR));
+  ex.declareNoWait("type", true, false, TableEntry("entry", 1));
+
+  EXPECT_CALL(amqp, method_name(AMQP_EXCHANGE_DECLARE_METHOD))
+    .WillOnce(Return("AMQP_EXCHANGE_DECLARE_METHOD"));
+  EXPECT_CALL(amqp, error_string2(AMQP_STATUS_SOCKET_ERROR))
+    .WillOnce(Return("socket error"));
+  EXPECT_THROW(ex.declareNoWait("type", true, false), ChannelException);
+}
+
+TEST_F(ExchangeTest, DeclareNoWaitEncoded) {
+  auto ch = createSimpleChannel();
+  Exchange ex(ch, "exchange1");
+  constexpr auto arguments = encodeTable(encodeField("alternate-exchange", "unrouted"));
+
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillRepeatedly(Return(fds[0]));
+  EXPECT_CALL(amqp, send_method(_, _, _, _)).Times(0);
+  pConn->nativeEncoding(true);
+  ex.declareNoWait("topic", true, false, arguments);
+
+  WireWriter frame;
+  MethodEncoder::exchangeDeclare(frame, channelId, bytes(ex.name()), bytes(string("topic")), false, true, false, false, true, arguments.bytes());
+  vector<uint8_t> received(frame.size() + 1);
+  ASSERT_EQ(::recv(fds[1], received.data(), received.size(), MSG_DONTWAIT), static_cast<ssize_t>(frame.size()));
+  EXPECT_EQ(::memcmp(received.data(), frame.data(), frame.size()), 0);
+
+  pConn->nativeEncoding(false);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_F(ExchangeTest, BindNoWait) {
+  auto ch = createSimpleChannel();
+  Exchange ex(ch, "exchange1");
+
+  EXPECT_CALL(amqp, send_method(connPtr, channelId, AMQP_EXCHANGE_BIND_METHOD, _))
+    .WillOnce(Invoke([&] (amqp_connection_state_t, amqp_channel_t, amqp_method_number_t, void* decoded) {
+      auto method = static_cast<amqp_exchange_bind_t*>(decoded);
+      EXPECT_EQ(container<string>(method->destination), "exchange1");
+      EXPECT_EQ(container<string>(method->source), "otherEx");
+      EXPECT_EQ(container<string>(method->routing_key), "rkey");
+      EXPECT_TRUE(method->nowait);
+      return AMQP_STATUS_OK;
+    }));
+  ex.bindNoWait("otherEx", "rkey");
+}
+
 TEST_F(ExchangeTest, Unbind) {
   auto ch = createSimpleChannel();
   EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId))
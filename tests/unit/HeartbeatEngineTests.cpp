@@ -0,0 +1,125 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "ConnectionTest.hpp"
+#include <rmqcxx/HeartbeatEngine.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::DoAll;
+using ::testing::Pointee;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+struct HeartbeatEngineTest : public ConnectionTest {
+
+};
+
+TEST_F(HeartbeatEngineTest, Disabled) {
+  auto conn = createSimpleConnection();
+  EXPECT_CALL(amqp, get_heartbeat(connPtr))
+    .WillRepeatedly(Return(0));
+
+  HeartbeatEngine engine(conn);
+  EXPECT_EQ(engine.use([] (Connection& c) { return c.heartbeat().count(); }), 0);
+  {
+    auto lock = engine.lock();
+    EXPECT_TRUE(lock.owns_lock());
+  }
+  EXPECT_TRUE(engine.alive());
+  EXPECT_NO_THROW(engine.check());
+  EXPECT_EQ(engine.beats(), 0);
+}
+
+TEST_F(HeartbeatEngineTest, DetectsDeadPeer) {
+  auto conn = createSimpleConnection();
+  struct timeval zeroTv{.tv_sec = 0, .tv_usec = 0};
+  amqp_basic_ack_t basicAck { .delivery_tag = 7UL, .multiple = false };
+
+  EXPECT_CALL(amqp, get_heartbeat(connPtr))
+    .WillRepeatedly(Return(1));
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2);
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(2);
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_UNEXPECTED_STATE}))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_HEARTBEAT_TIMEOUT}));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(zeroTv)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .payload = { amqp_method_t{.id = AMQP_BASIC_ACK_METHOD, .decoded = &basicAck}}}), Return(AMQP_STATUS_OK)));
+
+  std::atomic<uint64_t> acknowledged(0);
+  HeartbeatEngine engine(conn, nullptr, nullptr, [&acknowledged] (amqp_basic_ack_t ack) { acknowledged = ack.delivery_tag; });
+
+  const auto& deadline = steady_clock::now() + std::chrono::seconds(5);
+  while (engine.alive() && steady_clock::now() < deadline)
+    std::this_thread::sleep_for(milliseconds(10));
+
+  EXPECT_FALSE(engine.alive());
+  EXPECT_THROW(engine.check(), RPCException);
+  EXPECT_EQ(engine.beats(), 2);
+  EXPECT_EQ(acknowledged, 7);
+}
+
+TEST_F(HeartbeatEngineTest, FailsWithoutCallback) {
+  auto conn = createSimpleConnection();
+  struct timeval zeroTv{.tv_sec = 0, .tv_usec = 0};
+  amqp_basic_ack_t basicAck { .delivery_tag = 7UL, .multiple = false };
+
+  EXPECT_CALL(amqp, get_heartbeat(connPtr))
+    .WillRepeatedly(Return(1));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr));
+  EXPECT_CALL(amqp, consume_message(connPtr, _, Pointee(zeroTv), 0))
+    .WillOnce(Return(amqp_rpc_reply_t{.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION, .library_error = AMQP_STATUS_UNEXPECTED_STATE}));
+  EXPECT_CALL(amqp, simple_wait_frame_noblock(connPtr, _, Pointee(zeroTv)))
+    .WillOnce(DoAll(SetArgPointee<1>(amqp_frame_t {.frame_type = AMQP_FRAME_METHOD, .payload = { amqp_method_t{.id = AMQP_BASIC_ACK_METHOD, .decoded = &basicAck}}}), Return(AMQP_STATUS_OK)));
+
+  // a publisher confirm serviced by the engine is not dropped silently
+  HeartbeatEngine engine(conn);
+
+  const auto& deadline = steady_clock::now() + std::chrono::seconds(5);
+  while (engine.alive() && steady_clock::now() < deadline)
+    std::this_thread::sleep_for(milliseconds(10));
+
+  EXPECT_FALSE(engine.alive());
+  EXPECT_THROW(engine.check(), ConnectionException);
+  EXPECT_EQ(engine.beats(), 1);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,172 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/EncodedTable.hpp>
+#include <rmqcxx/MethodEncoder.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+vector<uint8_t> written(const WireWriter& out) {
+  return vector<uint8_t>(out.data(), out.data() + out.size());
+}
+
+::amqp_bytes_t text(const char* value) {
+  return ::amqp_bytes_t{::strlen(value), const_cast<char*>(value)};
+}
+
+} // namespace
+
+// The expected frames are the ones rabbitmq-c sends for the same arguments
+
+TEST(MethodEncoderTest, Ack) {
+  WireWriter out;
+  MethodEncoder::ack(out, 5, 0x0102030405060708ULL, true);
+  EXPECT_EQ(written(out), (vector<uint8_t>{
+    AMQP_FRAME_METHOD, 0x00, 0x05, 0x00, 0x00, 0x00, 0x0D,
+    0x00, 0x3C, 0x00, 0x50,
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+    0x01,
+    AMQP_FRAME_END}));
+  EXPECT_EQ(out.size(), MethodEncoder::kAcknowledgementSize);
+}
+
+TEST(MethodEncoderTest, Nack) {
+  WireWriter out;
+  MethodEncoder::nack(out, 1, 7, false, true);
+  MethodEncoder::nack(out, 1, 8, true, false);
+  EXPECT_EQ(written(out), (vector<uint8_t>{
+    AMQP_FRAME_METHOD, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0D,
+    0x00, 0x3C, 0x00, 0x78,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07,
+    0x02,
+    AMQP_FRAME_END,
+    AMQP_FRAME_METHOD, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0D,
+    0x00, 0x3C, 0x00, 0x78,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08,
+    0x01,
+    AMQP_FRAME_END}));
+}
+
+TEST(MethodEncoderTest, Publish) {
+  ::amqp_basic_properties_t properties{};
+  properties._flags = AMQP_BASIC_CONTENT_TYPE_FLAG | AMQP_BASIC_DELIVERY_MODE_FLAG;
+  properties.content_type = text("t");
+  properties.delivery_mode = 2;
+
+  WireWriter out;
+  MethodEncoder::publish(out, 2, text("ex"), text("rk"), true, false, properties, text("hello world"), 13);
+  EXPECT_EQ(written(out), (vector<uint8_t>{
+    AMQP_FRAME_METHOD, 0x00, 0x02, 0x00, 0x00, 0x00, 0x0D,
+    0x00, 0x3C, 0x00, 0x28, 0x00, 0x00, 0x02, 'e', 'x', 0x02, 'r', 'k', 0x01,
+    AMQP_FRAME_END,
+    AMQP_FRAME_HEADER, 0x00, 0x02, 0x00, 0x00, 0x00, 0x11,
+    0x00, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0B, 0x90, 0x00, 0x01, 't', 0x02,
+    AMQP_FRAME_END,
+    AMQP_FRAME_BODY, 0x00, 0x02, 0x00, 0x00, 0x00, 0x05, 'h', 'e', 'l', 'l', 'o', AMQP_FRAME_END,
+    AMQP_FRAME_BODY, 0x00, 0x02, 0x00, 0x00, 0x00, 0x05, ' ', 'w', 'o', 'r', 'l', AMQP_FRAME_END,
+    AMQP_FRAME_BODY, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 'd', AMQP_FRAME_END}));
+}
+
+TEST(MethodEncoderTest, PublishEmptyBody) {
+  WireWriter out;
+  MethodEncoder::publish(out, 1, text(""), text("queue"), false, false, ::amqp_basic_properties_t{}, text(""), 131072);
+
+  WireFrame frame;
+  std::size_t offset = WireReader::frame(out.data(), out.size(), 131072, frame);
+  ASSERT_NE(offset, 0u);
+  EXPECT_EQ(frame.type, AMQP_FRAME_METHOD);
+  WireReader method(frame);
+  EXPECT_EQ(method.u32(), AMQP_BASIC_PUBLISH_METHOD);
+  EXPECT_EQ(method.u16(), 0);
+  EXPECT_EQ(method.shortString(), "");
+  EXPECT_EQ(method.shortString(), "queue");
+  EXPECT_EQ(method.u8(), 0);
+
+  const auto consumed = WireReader::frame(out.data() + offset, out.size() - offset, 131072, frame);
+  ASSERT_NE(consumed, 0u);
+  EXPECT_EQ(frame.type, AMQP_FRAME_HEADER);
+  WireReader header(frame);
+  EXPECT_EQ(header.u16(), AMQP_BASIC_CLASS);
+  EXPECT_EQ(header.u16(), 0);
+  EXPECT_EQ(header.u64(), 0u);
+  EXPECT_EQ(header.u16(), 0); // no properties
+  EXPECT_EQ(offset + consumed, out.size()); // no body frame
+}
+
+TEST(MethodEncoderTest, Properties) {
+  ::amqp_table_entry_t entry{text("k"), ::amqp_field_value_t{}};
+  entry.value.kind = AMQP_FIELD_KIND_I32;
+  entry.value.value.i32 = 3;
+  ::amqp_basic_properties_t properties{};
+  properties._flags = AMQP_BASIC_HEADERS_FLAG | AMQP_BASIC_TIMESTAMP_FLAG | AMQP_BASIC_APP_ID_FLAG;
+  properties.headers = ::amqp_table_t{1, &entry};
+  properties.timestamp = 9;
+  properties.app_id = text("app");
+
+  WireWriter out;
+  MethodEncoder::properties(out, properties);
+  EXPECT_EQ(written(out), (vector<uint8_t>{
+    0x20, 0x48,
+    0x00, 0x00, 0x00, 0x07, 0x01, 'k', 'I', 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+    0x03, 'a', 'p', 'p'}));
+}
+
+TEST(MethodEncoderTest, QueueDeclare) {
+  constexpr auto arguments = encodeTable(encodeField("a", true));
+  WireWriter out;
+  MethodEncoder::queueDeclare(out, 3, text("q"), false, true, false, true, true, arguments.bytes());
+  EXPECT_EQ(written(out), (vector<uint8_t>{
+    AMQP_FRAME_METHOD, 0x00, 0x03, 0x00, 0x00, 0x00, 0x11,
+    0x00, 0x32, 0x00, 0x0A, 0x00, 0x00, 0x01, 'q', 0x1A,
+    0x00, 0x00, 0x00, 0x04, 0x01, 'a', 't', 0x01,
+    AMQP_FRAME_END}));
+}
+
+TEST(MethodEncoderTest, ExchangeDeclare) {
+  constexpr auto arguments = encodeTable();
+  WireWriter out;
+  MethodEncoder::exchangeDeclare(out, 1, text("ex"), text("topic"), false, true, false, false, true, arguments.bytes());
+  EXPECT_EQ(written(out), (vector<uint8_t>{
+    AMQP_FRAME_METHOD, 0x00, 0x01, 0x00, 0x00, 0x00, 0x14,
+    0x00, 0x28, 0x00, 0x0A, 0x00, 0x00, 0x02, 'e', 'x', 0x05, 't', 'o', 'p', 'i', 'c', 0x12,
+    0x00, 0x00, 0x00, 0x00,
+    AMQP_FRAME_END}));
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -39,23 +39,32 @@ using std::string;
 using std::vector;
 
 MockAMQP* MockAMQP::current_ = nullptr;
+int MockAMQP::depth_ = 0;
 
 int amqp_basic_ack(amqp_connection_state_t state, amqp_channel_t channel, uint64_t tag, amqp_boolean_t multiple) {
+  MockAMQP::Scope scope;
   MockAMQP::instance()->lastRPCMethod = "basic_ack";
   return MockAMQP::instance()->basic_ack(state, channel, tag, multiple);
 }
 
+amqp_basic_cancel_ok_t* amqp_basic_cancel(amqp_connection_state_t state, amqp_channel_t channel, amqp_bytes_t consumerTag) {
+  MockAMQP::instance()->lastRPCMethod = "basic_cancel";
+  return MockAMQP::instance()->basic_cancel(state, channel, consumerTag);
+}
+
 amqp_basic_consume_ok_t* amqp_basic_consume(amqp_connection_state_t state, amqp_channel_t channel, amqp_bytes_t queue, amqp_bytes_t consumerTag, amqp_boolean_t noLocal, amqp_boolean_t noAck, amqp_boolean_t exclusive, amqp_table_t arguments) {
   MockAMQP::instance()->lastRPCMethod = "basic_consume";
   return MockAMQP::instance()->basic_consume(state, channel, queue, consumerTag, noLocal, noAck, exclusive, arguments);
 }
 
 int amqp_basic_nack(amqp_connection_state_t state, amqp_channel_t channel, uint64_t deliveryTag, amqp_boolean_t multiple, amqp_boolean_t requeue) {
+  MockAMQP::Scope scope;
   MockAMQP::instance()->lastRPCMethod = "basic_nack";
   return MockAMQP::instance()->basic_nack(state, channel, deliveryTag, multiple, requeue);
 }
 
 int amqp_basic_publish(amqp_connection_state_t state, amqp_channel_t channel, amqp_bytes_t exchange, amqp_bytes_t routingKey, amqp_boolean_t mandatory, amqp_boolean_t immediate, amqp_basic_properties_t const *properties, amqp_bytes_t body) {
+  MockAMQP::Scope scope;
   MockAMQP::instance()->lastRPCMethod = "basic_publish";
   return MockAMQP::instance()->basic_publish(state, channel, exchange, routingKey, mandatory, immediate, properties, body);
 }
@@ -93,14 +102,20 @@ amqp_rpc_reply_t amqp_connection_close(amqp_connection_state_t state, int code)
 }
 
 amqp_rpc_reply_t amqp_consume_message(amqp_connection_state_t state, amqp_envelope_t* envelope, struct timeval* timeout, int flags) {
+  MockAMQP::Scope scope;
   return MockAMQP::instance()->consume_message(state, envelope, timeout, flags);
 }
 
+amqp_boolean_t amqp_data_in_buffer(amqp_connection_state_t state) {
+  return MockAMQP::instance()->data_in_buffer(state);
+}
+
 int amqp_destroy_connection(amqp_connection_state_t state) {
   return MockAMQP::instance()->destroy_connection(state);
 }
 
 void amqp_destroy_envelope(amqp_envelope_t* envelope) {
+  MockAMQP::Scope scope;
   MockAMQP::instance()->destroy_envelope(envelope);
 }
 
@@ -132,7 +147,21 @@ amqp_exchange_unbind_ok_t* amqp_exchange_unbind(amqp_connection_state_t state, a
   return MockAMQP::instance()->exchange_unbind(state, channel, destination, source, routingKey, arguments);
 }
 
+amqp_boolean_t amqp_frames_enqueued(amqp_connection_state_t state) {
+  return MockAMQP::instance()->frames_enqueued(state);
+}
+
+int amqp_get_frame_max(amqp_connection_state_t state) {
+  MockAMQP::Scope scope;
+  return MockAMQP::instance()->get_frame_max(state);
+}
+
+int amqp_get_heartbeat(amqp_connection_state_t state) {
+  return MockAMQP::instance()->get_heartbeat(state);
+}
+
 amqp_rpc_reply_t amqp_get_rpc_reply(amqp_connection_state_t state) {
+  MockAMQP::Scope scope;
   auto tmp = MockAMQP::instance()->lastRPCMethod;
   MockAMQP::instance()->lastRPCMethod = nullptr;
   return MockAMQP::instance()->get_rpc_reply(state, tmp);
@@ -142,6 +171,19 @@ struct timeval* amqp_get_rpc_timeout(amqp_connection_state_t state) {
   return MockAMQP::instance()->get_rpc_timeout(state);
 }
 
+int amqp_get_channel_max(amqp_connection_state_t state) {
+  return MockAMQP::instance()->get_channel_max(state);
+}
+
+amqp_socket_t* amqp_get_socket(amqp_connection_state_t state) {
+  return MockAMQP::instance()->get_socket(state);
+}
+
+int amqp_get_sockfd(amqp_connection_state_t state) {
+  MockAMQP::Scope scope;
+  return MockAMQP::instance()->get_sockfd(state);
+}
+
 amqp_rpc_reply_t amqp_login(amqp_connection_state_t state, char const* vhost, int channelMax, int frameMax, int heartbeat, amqp_sasl_method_enum saslMethod, ...) {
   vector<const char*> arguments;
   va_list vl;
@@ -179,10 +221,12 @@ amqp_rpc_reply_t amqp_login_with_properties(amqp_connection_state_t state, char
 }
 
 void amqp_maybe_release_buffers(amqp_connection_state_t state) {
+  MockAMQP::Scope scope;
   return MockAMQP::instance()->maybe_release_buffers(state);
 }
 
 void amqp_maybe_release_buffers_on_channel(amqp_connection_state_t state, amqp_channel_t channel) {
+  MockAMQP::Scope scope;
   return MockAMQP::instance()->maybe_release_buffers_on_channel(state, channel);
 }
 
@@ -200,6 +244,7 @@ amqp_queue_bind_ok_t* amqp_queue_bind(amqp_connection_state_t state, amqp_channe
 }
 
 amqp_queue_declare_ok_t* amqp_queue_declare(amqp_connection_state_t state, amqp_channel_t channel, amqp_bytes_t queue, amqp_boolean_t passive, amqp_boolean_t durable, amqp_boolean_t exclusive, amqp_boolean_t autoDelete, amqp_table_t arguments) {
+  MockAMQP::Scope scope;
   MockAMQP::instance()->lastRPCMethod = "queue_declare";
   return MockAMQP::instance()->queue_declare(state, channel, queue, passive, durable, exclusive, autoDelete, arguments);
 }
@@ -223,6 +268,10 @@ amqp_rpc_reply_t amqp_read_message(amqp_connection_state_t state, amqp_channel_t
   return MockAMQP::instance()->read_message(state, channel, message, flags);
 }
 
+int amqp_send_method(amqp_connection_state_t state, amqp_channel_t channel, amqp_method_number_t id, void* decoded) {
+  return MockAMQP::instance()->send_method(state, channel, id, decoded);
+}
+
 int amqp_set_handshake_timeout(amqp_connection_state_t state, struct timeval* timeout) {
   return MockAMQP::instance()->set_handshake_timeout(state, timeout);
 }
@@ -239,6 +288,42 @@ int amqp_socket_open_noblock(amqp_socket_t* self, const char* host, int port, st
   return MockAMQP::instance()->socket_open_noblock(self, host, port, timeout);
 }
 
+void* amqp_ssl_socket_get_context(amqp_socket_t* self) {
+  return MockAMQP::instance()->ssl_socket_get_context(self);
+}
+
+amqp_socket_t* amqp_ssl_socket_new(amqp_connection_state_t state) {
+  return MockAMQP::instance()->ssl_socket_new(state);
+}
+
+int amqp_ssl_socket_set_cacert(amqp_socket_t* self, const char* cacert) {
+  return MockAMQP::instance()->ssl_socket_set_cacert(self, cacert);
+}
+
+int amqp_ssl_socket_set_key(amqp_socket_t* self, const char* cert, const char* key) {
+  return MockAMQP::instance()->ssl_socket_set_key(self, cert, key);
+}
+
+int amqp_ssl_socket_set_ssl_versions(amqp_socket_t* self, amqp_tls_version_t min, amqp_tls_version_t max) {
+  return MockAMQP::instance()->ssl_socket_set_ssl_versions(self, min, max);
+}
+
+void amqp_ssl_socket_set_verify_hostname(amqp_socket_t* self, amqp_boolean_t verify) {
+  MockAMQP::instance()->ssl_socket_set_verify_hostname(self, verify);
+}
+
+void amqp_ssl_socket_set_verify_peer(amqp_socket_t* self, amqp_boolean_t verify) {
+  MockAMQP::instance()->ssl_socket_set_verify_peer(self, verify);
+}
+
 amqp_socket_t* amqp_tcp_socket_new(amqp_connection_state_t state) {
   return MockAMQP::instance()->tcp_socket_new(state);
 }
+
+void amqp_tcp_socket_set_sockfd(amqp_socket_t* self, int sockfd) {
+  MockAMQP::instance()->tcp_socket_set_sockfd(self, sockfd);
+}
+
+int amqp_tune_connection(amqp_connection_state_t state, int channelMax, int frameMax, int heartbeat) {
+  return MockAMQP::instance()->tune_connection(state, channelMax, frameMax, heartbeat);
+}
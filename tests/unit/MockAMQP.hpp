@@ -30,6 +30,7 @@ SOFTWARE.
 #include <gmock/gmock.h>
 
 #include <amqp.h>
+#include <amqp_ssl_socket.h>
 
 namespace rmqcxx { namespace unit_tests {
 
@@ -44,6 +45,7 @@ namespace rmqcxx { namespace unit_tests {
 
     ~MockAMQP() noexcept = default;
     MOCK_METHOD4(basic_ack, int(amqp_connection_state_t, amqp_channel_t, uint64_t, amqp_boolean_t));
+    MOCK_METHOD3(basic_cancel, amqp_basic_cancel_ok_t*(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t));
     MOCK_METHOD8(basic_consume, amqp_basic_consume_ok_t*(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t, amqp_bytes_t, amqp_boolean_t, amqp_boolean_t, amqp_boolean_t, amqp_table_t));
     MOCK_METHOD5(basic_nack, int(amqp_connection_state_t, amqp_channel_t, uint64_t, amqp_boolean_t, amqp_boolean_t));
     MOCK_METHOD8(basic_publish, int(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t, amqp_bytes_t, amqp_boolean_t, amqp_boolean_t, amqp_basic_properties_t const*, amqp_bytes_t));
@@ -54,6 +56,7 @@ namespace rmqcxx { namespace unit_tests {
     MOCK_METHOD2(channel_open, amqp_channel_open_ok_t*(amqp_connection_state_t, amqp_channel_t));
     MOCK_METHOD2(connection_close, amqp_rpc_reply_t(amqp_connection_state_t, int));
     MOCK_METHOD4(consume_message, amqp_rpc_reply_t(amqp_connection_state_t, amqp_envelope_t*, struct timeval*, int));
+    MOCK_METHOD1(data_in_buffer, amqp_boolean_t(amqp_connection_state_t));
     MOCK_METHOD1(destroy_connection, int(amqp_connection_state_t));
     MOCK_METHOD1(destroy_envelope, void(amqp_envelope_t*));
     MOCK_METHOD1(destroy_message, void(amqp_message_t*));
@@ -62,8 +65,14 @@ namespace rmqcxx { namespace unit_tests {
     MOCK_METHOD9(exchange_declare, amqp_exchange_declare_ok_t*(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t, amqp_bytes_t, amqp_boolean_t, amqp_boolean_t, amqp_boolean_t, amqp_boolean_t, amqp_table_t));
     MOCK_METHOD4(exchange_delete, amqp_exchange_delete_ok_t*(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t, amqp_boolean_t));
     MOCK_METHOD6(exchange_unbind, amqp_exchange_unbind_ok_t*(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t, amqp_bytes_t, amqp_bytes_t, amqp_table_t));
+    MOCK_METHOD1(frames_enqueued, amqp_boolean_t(amqp_connection_state_t));
+    MOCK_METHOD1(get_frame_max, int(amqp_connection_state_t));
+    MOCK_METHOD1(get_heartbeat, int(amqp_connection_state_t));
     MOCK_METHOD2(get_rpc_reply, amqp_rpc_reply_t(amqp_connection_state_t, const std::string&)); // const std::string& is last rpc name
     MOCK_METHOD1(get_rpc_timeout, struct timeval*(amqp_connection_state_t));
+    MOCK_METHOD1(get_channel_max, int(amqp_connection_state_t));
+    MOCK_METHOD1(get_socket, amqp_socket_t*(amqp_connection_state_t));
+    MOCK_METHOD1(get_sockfd, int(amqp_connection_state_t));
     MOCK_METHOD7(login, amqp_rpc_reply_t(amqp_connection_state_t, char const*, int, int, int, amqp_sasl_method_enum, const std::vector<const char*>&));
     MOCK_METHOD8(login_with_properties, amqp_rpc_reply_t(amqp_connection_state_t, char const*, int, int, int, const amqp_table_t*, amqp_sasl_method_enum, const std::vector<const char*>&));
     MOCK_METHOD1(maybe_release_buffers, void(amqp_connection_state_t));
@@ -76,18 +85,45 @@ namespace rmqcxx { namespace unit_tests {
     MOCK_METHOD3(queue_purge, amqp_queue_purge_ok_t*(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t));
     MOCK_METHOD6(queue_unbind, amqp_queue_unbind_ok_t*(amqp_connection_state_t, amqp_channel_t, amqp_bytes_t, amqp_bytes_t, amqp_bytes_t, amqp_table_t));
     MOCK_METHOD4(read_message, amqp_rpc_reply_t(amqp_connection_state_t, amqp_channel_t, amqp_message_t*, int));
+    MOCK_METHOD4(send_method, int(amqp_connection_state_t, amqp_channel_t, amqp_method_number_t, void*));
     MOCK_METHOD2(set_handshake_timeout, int(amqp_connection_state_t, struct timeval*));
     MOCK_METHOD2(set_rpc_timeout, int(amqp_connection_state_t, struct timeval*));
     MOCK_METHOD3(simple_wait_frame_noblock, int(amqp_connection_state_t, amqp_frame_t*, struct timeval*));
     MOCK_METHOD4(socket_open_noblock, int(amqp_socket_t*, const char*, int, struct timeval*));
+    MOCK_METHOD1(ssl_socket_get_context, void*(amqp_socket_t*));
+    MOCK_METHOD1(ssl_socket_new, amqp_socket_t*(amqp_connection_state_t));
+    MOCK_METHOD2(ssl_socket_set_cacert, int(amqp_socket_t*, const char*));
+    MOCK_METHOD3(ssl_socket_set_key, int(amqp_socket_t*, const char*, const char*));
+    MOCK_METHOD3(ssl_socket_set_ssl_versions, int(amqp_socket_t*, amqp_tls_version_t, amqp_tls_version_t));
+    MOCK_METHOD2(ssl_socket_set_verify_hostname, void(amqp_socket_t*, amqp_boolean_t));
+    MOCK_METHOD2(ssl_socket_set_verify_peer, void(amqp_socket_t*, amqp_boolean_t));
     MOCK_METHOD1(tcp_socket_new, amqp_socket_t*(amqp_connection_state_t));
+    MOCK_METHOD2(tcp_socket_set_sockfd, void(amqp_socket_t*, int));
+    MOCK_METHOD4(tune_connection, int(amqp_connection_state_t, int, int, int));
 
     static MockAMQP* instance() noexcept {
       return current_;
     }
+
+    // set while a mocked function runs, gmock allocates while matching the expectations
+    struct Scope {
+      Scope() noexcept {
+        ++depth_;
+      }
+
+      ~Scope() noexcept {
+        --depth_;
+      }
+    };
+
+    static bool mocking() noexcept {
+      return depth_ > 0;
+    }
+
     const char* lastRPCMethod;
   private:
     static MockAMQP* current_;
+    static int depth_;
   };
 
 }} // namespace rmqcxx.unit_tests
@@ -25,18 +25,28 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <cstring>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 #include "ChannelTest.hpp"
+#include <rmqcxx/EncodedTable.hpp>
 #include <rmqcxx/Queue.hpp>
 #include <rmqcxx/TableEntry.hpp>
 
 namespace rmqcxx { namespace unit_tests {
 
+using ::testing::_;
+using ::testing::Invoke;
 using ::testing::Return;
 
 using std::move;
 using std::string;
+using std::vector;
 
 struct QueueTest : public ChannelTest {
 
@@ -144,6 +154,87 @@ TEST_F(QueueTest, Bind) {
   q.bind("ex1", "rkey1", TableEntry("entry", 1));
 }
 
+TEST_F(QueueTest, DeclareNoWait) {
+  auto ch = createSimpleChannel();
+  Queue q(ch, "q0");
+
+  EXPECT_CALL(amqp, send_method(connPtr, channelId, AMQP_QUEUE_DECLARE_METHOD, _))
+    .WillOnce(Invoke([&] (amqp_connection_state_t, amqp_channel_t, amqp_method_number_t, void* decoded) {
+      auto method = static_cast<amqp_queue_declare_t*>(decoded);
+      EXPECT_EQ(container<string>(method->queue), "q0");
+      EXPECT_FALSE(method->passive);
+      EXPECT_TRUE(method->durable);
+      EXPECT_FALSE(method->exclusive);
+      EXPECT_TRUE(method->auto_delete);
+      EXPECT_TRUE(method->nowait);
+      return AMQP_STATUS_OK;
+    }));
+  q.declareNoWait(true, false, true);
+
+  Queue unnamed(ch, "");
+  EXPECT_THROW(unnamed.declareNoWait(false, true, true), ChannelException);
+}
+
+TEST_F(QueueTest, EncodedArguments) {
+  auto ch = createSimpleChannel();
+  Queue q(ch, "q0");
+  constexpr auto arguments = encodeTable(encodeField("x-queue-type", "quorum"), encodeField("x-message-ttl", int32_t(60000)));
+  TableEntry type("x-queue-type", "quorum"), ttl("x-message-ttl", int32_t(60000));
+  Table table(type, ttl);
+  const amqp_table_t expected = table;
+
+  // rabbitmq-c gets the entries decoded from the encoding
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "queue_declare"))
+    .WillOnce(Return(normalReply));
+  amqp_queue_declare_ok_t result{};
+  EXPECT_CALL(amqp, queue_declare(connPtr, channelId, _, 0, 1, 0, 0, expected))
+    .WillOnce(Return(&result));
+  EXPECT_EQ(q.declare(false, true, false, false, arguments), &result);
+
+  EXPECT_CALL(amqp, send_method(connPtr, channelId, AMQP_QUEUE_DECLARE_METHOD, _))
+    .WillOnce(Invoke([&] (amqp_connection_state_t, amqp_channel_t, amqp_method_number_t, void* decoded) {
+      EXPECT_EQ(static_cast<amqp_queue_declare_t*>(decoded)->arguments, expected);
+      return AMQP_STATUS_OK;
+    }));
+  q.declareNoWait(true, false, false, arguments);
+
+  // the native encoder splices the encoding into the frame
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillRepeatedly(Return(fds[0]));
+  pConn->nativeEncoding(true);
+  q.declareNoWait(true, false, false, arguments);
+
+  WireWriter frame;
+  MethodEncoder::queueDeclare(frame, channelId, bytes(q.name()), false, true, false, false, true, arguments.bytes());
+  vector<uint8_t> received(frame.size() + 1);
+  ASSERT_EQ(::recv(fds[1], received.data(), received.size(), MSG_DONTWAIT), static_cast<ssize_t>(frame.size()));
+  EXPECT_EQ(::memcmp(received.data(), frame.data(), frame.size()), 0);
+
+  pConn->nativeEncoding(false);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_F(QueueTest, BindNoWait) {
+  auto ch = createSimpleChannel();
+  Queue q(ch, "q0");
+
+  EXPECT_CALL(amqp, send_method(connPtr, channelId, AMQP_QUEUE_BIND_METHOD, _))
+    .WillOnce(Invoke([&] (amqp_connection_state_t, amqp_channel_t, amqp_method_number_t, void* decoded) {
+      auto method = static_cast<amqp_queue_bind_t*>(decoded);
+      EXPECT_EQ(container<string>(method->queue), "q0");
+      EXPECT_EQ(container<string>(method->exchange), "ex0");
+      EXPECT_EQ(container<string>(method->routing_key), "rkey0");
+      EXPECT_TRUE(method->nowait);
+      EXPECT_EQ(method->arguments.num_entries, 1);
+      return AMQP_STATUS_OK;
+    }));
+  q.bindNoWait("ex0", "rkey0", TableEntry("entry", 1));
+}
+
 TEST_F(QueueTest, Unbind) {
   auto ch = createSimpleChannel();
   EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId))
@@ -0,0 +1,129 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "ConnectionTest.hpp"
+#include <rmqcxx/RecoveringConnection.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::Return;
+
+using std::chrono::milliseconds;
+
+struct RecoveringConnectionTest : public ConnectionTest {
+  RecoveringConnectionTest() : attempts(0), backoff{ 3, milliseconds(1), milliseconds(2), 2.0, 0.5 } {
+    saslMethod = AMQP_SASL_METHOD_EXTERNAL;
+    EXPECT_CALL(amqp, new_connection())
+      .WillRepeatedly(Return(connPtr));
+    EXPECT_CALL(amqp, tcp_socket_new(connPtr))
+      .WillRepeatedly(Return(socketPtr));
+    EXPECT_CALL(amqp, login_with_properties(connPtr, _, _, _, _, _, _, _))
+      .WillRepeatedly(Return(normalReply));
+    EXPECT_CALL(amqp, connection_close(connPtr, AMQP_REPLY_SUCCESS))
+      .Times(AnyNumber());
+    EXPECT_CALL(amqp, get_rpc_reply(connPtr, "connection_close"))
+      .WillRepeatedly(Return(normalReply));
+    EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+      .Times(AnyNumber());
+    EXPECT_CALL(amqp, destroy_connection(connPtr))
+      .Times(AnyNumber());
+    EXPECT_CALL(amqp, set_rpc_timeout(connPtr, _))
+      .WillRepeatedly(Return(AMQP_STATUS_OK));
+  }
+
+  RecoveringConnection::Factory factory() {
+    return [this] () {
+      ++attempts;
+      return Connection(address, port, vhost, maxChannels, maxFrameSize, heartbeat, connectTimeout, static_cast<const std::chrono::seconds*>(nullptr), nullptr, saslMethod, "external");
+    };
+  }
+
+  int attempts;
+  RecoveringConnection::Backoff backoff;
+};
+
+TEST_F(RecoveringConnectionTest, ConnectsWithBackoff) {
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, _, _, _))
+    .WillOnce(Return(AMQP_STATUS_SOCKET_ERROR))
+    .WillOnce(Return(AMQP_STATUS_SOCKET_ERROR))
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  RecoveringConnection conn(factory(), backoff);
+  EXPECT_EQ(attempts, 3);
+  EXPECT_EQ(conn.generation(), 0);
+  EXPECT_EQ(conn.connection().topology(), &conn.topology());
+}
+
+TEST_F(RecoveringConnectionTest, GivesUp) {
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, _, _, _))
+    .WillRepeatedly(Return(AMQP_STATUS_SOCKET_ERROR));
+  EXPECT_THROW(RecoveringConnection(factory(), backoff), SocketException);
+  EXPECT_EQ(attempts, 3);
+}
+
+TEST_F(RecoveringConnectionTest, Run) {
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, _, _, _))
+    .WillOnce(Return(AMQP_STATUS_OK))
+    .WillOnce(Return(AMQP_STATUS_SOCKET_ERROR))
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  RecoveringConnection conn(factory(), backoff);
+  Connection* first = &conn.connection();
+
+  int calls = 0;
+  EXPECT_EQ(conn.run([&] (Connection& c) {
+    if (1 == ++calls)
+      throw SocketException(c, socketPtr, AMQP_STATUS_SOCKET_ERROR, "lost");
+    return calls;
+  }), 2);
+  EXPECT_EQ(attempts, 3);
+  EXPECT_EQ(conn.generation(), 1);
+  EXPECT_EQ(&conn.connection(), first);
+  EXPECT_EQ(conn.connection().topology(), &conn.topology());
+
+  EXPECT_THROW(conn.run([] (Connection& c) -> int { throw ConnectionException(c, "not recoverable"); }), ConnectionException);
+  EXPECT_THROW(conn.run([] (Connection&) -> int { throw std::logic_error("unrelated"); }), std::logic_error);
+  EXPECT_EQ(conn.generation(), 1);
+}
+
+TEST_F(RecoveringConnectionTest, Backoff) {
+  EXPECT_CALL(amqp, socket_open_noblock(socketPtr, _, _, _))
+    .WillRepeatedly(Return(AMQP_STATUS_OK));
+  RecoveringConnection conn(factory(), RecoveringConnection::Backoff{ 0, milliseconds(10), milliseconds(50), 2.0, 0.0 });
+  EXPECT_EQ(conn.backoff(1), milliseconds(10));
+  EXPECT_EQ(conn.backoff(2), milliseconds(20));
+  EXPECT_EQ(conn.backoff(3), milliseconds(40));
+  EXPECT_EQ(conn.backoff(4), milliseconds(50));
+  EXPECT_EQ(conn.backoff(100), milliseconds(50));
+}
+
+}} // namespace rmqcxx.unit_tests
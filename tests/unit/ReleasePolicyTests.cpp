@@ -0,0 +1,126 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/ReleasePolicy.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using std::chrono::milliseconds;
+
+TEST(ReleasePolicyTest, Always) {
+  ReleasePolicy policy;
+  EXPECT_EQ(policy.every(), 1U);
+  EXPECT_EQ(policy.highWaterMark(), 0U);
+  EXPECT_FALSE(policy.timed());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(policy.due(ReleasePolicy::Clock::time_point()));
+    policy.released();
+  }
+  EXPECT_TRUE(policy.due(ReleasePolicy::Clock::time_point(), false));
+  EXPECT_EQ(policy.stats().operations, 4U);
+  EXPECT_EQ(policy.stats().releases, 3U);
+}
+
+TEST(ReleasePolicyTest, Every) {
+  auto policy = ReleasePolicy().every(3);
+  const ReleasePolicy::Clock::time_point now;
+  EXPECT_FALSE(policy.due(now));
+  EXPECT_FALSE(policy.due(now));
+  EXPECT_TRUE(policy.due(now));
+  policy.skipped(); // still due until released
+  EXPECT_TRUE(policy.due(now));
+  policy.released();
+  EXPECT_FALSE(policy.due(now));
+  EXPECT_EQ(policy.stats().operations, 5U);
+  EXPECT_EQ(policy.stats().releases, 1U);
+  EXPECT_EQ(policy.stats().skipped, 1U);
+}
+
+TEST(ReleasePolicyTest, HighWaterMark) {
+  auto policy = ReleasePolicy().every(0).highWaterMark(1000);
+  const ReleasePolicy::Clock::time_point now;
+  const std::size_t overhead = ReleasePolicy::kOperationOverhead;
+  policy.used(300);
+  EXPECT_FALSE(policy.due(now));
+  policy.used(300);
+  EXPECT_EQ(policy.stats().pooled, 600U + overhead);
+  EXPECT_TRUE(policy.due(now));
+  policy.released();
+  EXPECT_EQ(policy.stats().pooled, 0U);
+  EXPECT_EQ(policy.stats().peak, 600U + 2 * overhead);
+  policy.used(10);
+  EXPECT_FALSE(policy.due(now));
+  EXPECT_EQ(policy.stats().peak, 600U + 2 * overhead);
+}
+
+TEST(ReleasePolicyTest, OperationsWithoutContent) {
+  auto policy = ReleasePolicy().every(0).highWaterMark(3 * ReleasePolicy::kOperationOverhead);
+  const ReleasePolicy::Clock::time_point now;
+  EXPECT_FALSE(policy.due(now));
+  EXPECT_FALSE(policy.due(now));
+  EXPECT_FALSE(policy.due(now, false)); // timed out, nothing was decoded
+  EXPECT_TRUE(policy.due(now));
+}
+
+TEST(ReleasePolicyTest, ReleasedChannel) {
+  auto policy = ReleasePolicy::warm(10000, milliseconds(100)).every(3);
+  const ReleasePolicy::Clock::time_point start;
+  const std::size_t overhead = ReleasePolicy::kOperationOverhead;
+  policy.used(100);
+  EXPECT_FALSE(policy.due(start));
+  EXPECT_FALSE(policy.due(start));
+  EXPECT_TRUE(policy.due(start));
+  policy.releasedChannel();
+  EXPECT_EQ(policy.stats().releases, 1U);
+  EXPECT_EQ(policy.stats().pooled, 100U + 3 * overhead); // the other channels keep their pools
+  EXPECT_FALSE(policy.due(start + milliseconds(50), false));
+  EXPECT_TRUE(policy.due(start + milliseconds(100), false)); // still dirty
+  policy.released();
+  EXPECT_EQ(policy.stats().pooled, 0U);
+  EXPECT_FALSE(policy.due(start + milliseconds(300), false));
+}
+
+TEST(ReleasePolicyTest, Idle) {
+  auto policy = ReleasePolicy::warm(0, milliseconds(100));
+  EXPECT_EQ(policy.every(), 0U);
+  EXPECT_TRUE(policy.timed());
+  const ReleasePolicy::Clock::time_point start;
+  EXPECT_FALSE(policy.due(start + milliseconds(500), false)); // nothing to release yet
+  EXPECT_FALSE(policy.due(start + milliseconds(1000)));
+  EXPECT_FALSE(policy.due(start + milliseconds(1050), false));
+  EXPECT_TRUE(policy.due(start + milliseconds(1100), false));
+  policy.released();
+  EXPECT_FALSE(policy.due(start + milliseconds(1300), false)); // released once per idle period
+  EXPECT_FALSE(policy.due(start + milliseconds(1400)));
+  EXPECT_TRUE(policy.due(start + milliseconds(1600), false));
+}
+
+}} // namespace rmqcxx.unit_tests
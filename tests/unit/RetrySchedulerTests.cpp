@@ -0,0 +1,193 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/RetryScheduler.hpp>
+
+#include "ChannelTest.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::Return;
+
+using std::chrono::milliseconds;
+
+struct RetrySchedulerTest : public ChannelTest {
+  RetryScheduler::Policy policy() const {
+    return RetryScheduler::Policy{3, milliseconds(100), milliseconds(150), 2.0};
+  }
+
+  Envelope delivery(uint64_t tag) {
+    Envelope envelope;
+    envelope->channel = channelId;
+    envelope->delivery_tag = tag;
+    return envelope;
+  }
+};
+
+TEST_F(RetrySchedulerTest, Delay) {
+  auto ch = createSimpleChannel();
+  RetryScheduler scheduler(ch, [] (const Envelope&) { return true; }, RetryScheduler::Policy{5, milliseconds(10), milliseconds(50), 2.0});
+  EXPECT_EQ(scheduler.delay(1), milliseconds(10));
+  EXPECT_EQ(scheduler.delay(2), milliseconds(20));
+  EXPECT_EQ(scheduler.delay(3), milliseconds(40));
+  EXPECT_EQ(scheduler.delay(4), milliseconds(50));
+  EXPECT_EQ(scheduler.delay(100), milliseconds(50));
+}
+
+TEST_F(RetrySchedulerTest, AcknowledgesOnSuccess) {
+  auto ch = createSimpleChannel();
+  std::size_t calls = 0;
+  RetryScheduler scheduler(ch, [&calls] (const Envelope&) { ++calls; return true; }, policy());
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, basic_ack(connPtr, channelId, 5UL, false))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_ack"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+
+  scheduler(delivery(5));
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(scheduler.pending(), 0);
+}
+
+TEST_F(RetrySchedulerTest, RetriesUntilSuccess) {
+  auto ch = createSimpleChannel();
+  std::size_t calls = 0;
+  RetryScheduler scheduler(ch, [&calls] (const Envelope& e) { EXPECT_EQ(e->delivery_tag, 6UL); return ++calls == 2; }, policy(), milliseconds(1));
+  const auto start = RetryScheduler::Clock::now();
+
+  scheduler(delivery(6));
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(scheduler.pending(), 1);
+
+  EXPECT_EQ(scheduler.poll(start), 0);
+  EXPECT_EQ(calls, 1);
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, basic_ack(connPtr, channelId, 6UL, false))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_ack"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+
+  EXPECT_EQ(scheduler.poll(start + milliseconds(200)), 1);
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(scheduler.pending(), 0);
+}
+
+TEST_F(RetrySchedulerTest, BackoffCountsFromFailure) {
+  auto ch = createSimpleChannel();
+  std::size_t calls = 0;
+  RetryScheduler scheduler(ch, [&calls] (const Envelope&) { return ++calls == 2; }, policy(), milliseconds(1));
+  const auto start = RetryScheduler::Clock::now();
+  EXPECT_EQ(scheduler.poll(start), 0);
+
+  // the delivery fails long after the last poll, its backoff still has to pass
+  const auto failed = start + milliseconds(150);
+  scheduler(delivery(8), failed);
+  EXPECT_EQ(scheduler.poll(failed), 0);
+  EXPECT_EQ(scheduler.poll(failed + milliseconds(50)), 0);
+  EXPECT_EQ(calls, 1);
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, basic_ack(connPtr, channelId, 8UL, false))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_ack"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_EQ(scheduler.poll(failed + milliseconds(101)), 1);
+  EXPECT_EQ(calls, 2);
+}
+
+TEST_F(RetrySchedulerTest, ThrowingHandlerCountsAsFailure) {
+  auto ch = createSimpleChannel();
+  std::size_t calls = 0;
+  RetryScheduler scheduler(ch, [&calls] (const Envelope&) -> bool { ++calls; throw std::runtime_error("dependency down"); }, policy(), milliseconds(1));
+  const auto start = RetryScheduler::Clock::now();
+
+  EXPECT_THROW(scheduler(delivery(9), start), std::runtime_error);
+  EXPECT_EQ(scheduler.pending(), 1);
+  EXPECT_THROW(scheduler.poll(start + milliseconds(101)), std::runtime_error);
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(scheduler.pending(), 1);
+
+  // the last attempt dead letters the delivery instead of leaking it
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, basic_nack(connPtr, channelId, 9UL, false, false))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_nack"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+  EXPECT_THROW(scheduler.poll(start + milliseconds(252)), std::runtime_error);
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(scheduler.pending(), 0);
+}
+
+TEST_F(RetrySchedulerTest, DeadLettersAfterMaxAttempts) {
+  auto ch = createSimpleChannel();
+  std::size_t calls = 0;
+  RetryScheduler scheduler(ch, [&calls] (const Envelope&) { ++calls; return false; }, policy(), milliseconds(1));
+  const auto start = RetryScheduler::Clock::now();
+
+  scheduler(delivery(7));
+  EXPECT_EQ(scheduler.poll(start + milliseconds(200)), 1);
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(scheduler.pending(), 1);
+
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+  EXPECT_CALL(amqp, basic_nack(connPtr, channelId, 7UL, false, false))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_nack"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, destroy_envelope(_));
+
+  EXPECT_EQ(scheduler.poll(start + milliseconds(400)), 1);
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(scheduler.pending(), 0);
+}
+
+TEST_F(RetrySchedulerTest, ClearDropsHeldDeliveries) {
+  auto ch = createSimpleChannel();
+  RetryScheduler scheduler(ch, [] (const Envelope&) { return false; }, policy());
+
+  scheduler(delivery(8));
+  scheduler(delivery(9));
+  EXPECT_EQ(scheduler.pending(), 2);
+
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2);
+  scheduler.clear();
+  EXPECT_EQ(scheduler.pending(), 0);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,106 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include <sched.h>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/ShardedRuntime.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using std::chrono::seconds;
+
+struct Tracked {
+  explicit Tracked(std::promise<std::thread::id>& destroyed) : destroyed(destroyed) {}
+  ~Tracked() {
+    destroyed.set_value(std::this_thread::get_id());
+  }
+  std::promise<std::thread::id>& destroyed;
+};
+
+TEST(ShardedRuntimeTest, RunsTasksOnPinnedShards) {
+  const auto& cores = ShardedRuntime::cores();
+  ASSERT_FALSE(cores.empty());
+  const int cpu = cores.front();
+
+  std::promise<std::thread::id> destroyed;
+  std::thread::id shardThread;
+  {
+    ShardedRuntime runtime({cpu, -1});
+    ASSERT_EQ(runtime.size(), 2);
+    EXPECT_EQ(runtime[0].index(), 0);
+    EXPECT_EQ(runtime[0].cpu(), cpu);
+    EXPECT_EQ(runtime[1].cpu(), -1);
+    EXPECT_EQ(runtime[1].node(), -1);
+    EXPECT_LT(runtime.shardFor("queue"), 2);
+    EXPECT_EQ(runtime.shardFor("queue"), runtime.shardFor("queue"));
+
+    std::promise<std::pair<std::thread::id, int>> ran;
+    runtime.post(0, [&ran, &destroyed] (Shard& shard) {
+      shard.keep(std::unique_ptr<Tracked>(new Tracked(destroyed)));
+      ran.set_value(std::make_pair(std::this_thread::get_id(), ::sched_getcpu()));
+    });
+    auto future = ran.get_future();
+    ASSERT_EQ(future.wait_for(seconds(5)), std::future_status::ready);
+    const auto& result = future.get();
+    shardThread = result.first;
+    EXPECT_NE(shardThread, std::this_thread::get_id());
+    EXPECT_EQ(result.second, cpu);
+
+    std::atomic<int> count(0);
+    std::promise<void> both;
+    runtime.broadcast([&count, &both] (Shard&) {
+      if (2 == ++count)
+        both.set_value();
+    });
+    EXPECT_EQ(both.get_future().wait_for(seconds(5)), std::future_status::ready);
+    EXPECT_NO_THROW(runtime.check());
+  }
+  EXPECT_EQ(destroyed.get_future().get(), shardThread);
+}
+
+TEST(ShardedRuntimeTest, TaskErrorStopsShard) {
+  ShardedRuntime runtime({-1});
+  runtime.post(0, [] (Shard&) { throw std::runtime_error("task failed"); });
+  runtime[0].join();
+  EXPECT_THROW(runtime.check(), std::runtime_error);
+}
+
+TEST(ShardedRuntimeTest, InvalidCore) {
+  EXPECT_THROW(ShardedRuntime(std::vector<int>()), Exception);
+  EXPECT_THROW(ShardedRuntime({CPU_SETSIZE}), Exception);
+}
+
+}} // namespace rmqcxx.unit_tests
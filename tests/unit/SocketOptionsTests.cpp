@@ -0,0 +1,92 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/SocketOptions.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+struct SocketOptionsTest : public ::testing::Test {
+  SocketOptionsTest() : fd(::socket(AF_INET, SOCK_STREAM, 0)) {}
+
+  ~SocketOptionsTest() noexcept {
+    ::close(fd);
+  }
+
+  int get(int level, int name) const {
+    int value = -1;
+    socklen_t len = sizeof(value);
+    EXPECT_EQ(::getsockopt(fd, level, name, &value, &len), 0);
+    return value;
+  }
+
+  int fd;
+};
+
+TEST_F(SocketOptionsTest, Empty) {
+  EXPECT_TRUE(SocketOptions().empty());
+  EXPECT_FALSE(SocketOptions().noDelay(false).empty());
+  EXPECT_FALSE(SocketOptions().busyPoll(std::chrono::microseconds(0)).empty());
+  EXPECT_NO_THROW(SocketOptions().apply(-1));
+}
+
+TEST_F(SocketOptionsTest, Apply) {
+  ASSERT_GE(fd, 0);
+  SocketOptions().noDelay(true).sendBuffer(1 << 16).receiveBuffer(1 << 17).apply(fd);
+  EXPECT_NE(get(IPPROTO_TCP, TCP_NODELAY), 0);
+  EXPECT_GE(get(SOL_SOCKET, SO_SNDBUF), 1 << 16);
+  EXPECT_GE(get(SOL_SOCKET, SO_RCVBUF), 1 << 17);
+
+  SocketOptions().noDelay(false).apply(fd);
+  EXPECT_EQ(get(IPPROTO_TCP, TCP_NODELAY), 0);
+
+  EXPECT_THROW(SocketOptions().noDelay(true).apply(-1), Exception);
+}
+
+TEST_F(SocketOptionsTest, Cork) {
+  ASSERT_GE(fd, 0);
+  {
+    Cork cork(fd);
+#ifdef TCP_CORK
+    EXPECT_NE(get(IPPROTO_TCP, TCP_CORK), 0);
+#endif
+  }
+#ifdef TCP_CORK
+  EXPECT_EQ(get(IPPROTO_TCP, TCP_CORK), 0);
+#endif
+  EXPECT_THROW(Cork(-1), Exception);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,122 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "comparison.hpp"
+
+#include <rmqcxx/StaticTable.hpp>
+#include <rmqcxx/Table.hpp>
+#include <rmqcxx/TableEntry.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::Test;
+
+using std::move;
+using std::string;
+
+struct StaticTableTest : public Test {
+};
+
+static string str(::amqp_bytes_t v) {
+  return string(static_cast<const char*>(v.bytes), v.len);
+}
+
+TEST_F(StaticTableTest, Conversion) {
+  StaticTable<2> t;
+  EXPECT_TRUE(t.empty());
+  EXPECT_EQ(static_cast<amqp_table_t>(t).num_entries, 0);
+
+  t.add("x-queue-type", "quorum").add(string("x-message-ttl"), int32_t(1000));
+  EXPECT_EQ(t.size(), 2U);
+  EXPECT_EQ(t.used(), string("x-queue-typequorumx-message-ttl").size());
+
+  TableEntry e0("x-queue-type", "quorum"), e1("x-message-ttl", int32_t(1000));
+  EXPECT_EQ(static_cast<amqp_table_t>(t), static_cast<amqp_table_t>(Table(e0, e1)));
+}
+
+TEST_F(StaticTableTest, OwnsStrings) {
+  StaticTable<1> t;
+  {
+    string key("x-dead-letter-exchange"), value("dead-letters-of-a-long-named-service");
+    t.add(key, value);
+    key.assign(key.size(), '-');
+    value.assign(value.size(), '-');
+  }
+  const amqp_table_t table = t;
+  ASSERT_EQ(table.num_entries, 1);
+  EXPECT_EQ(str(table.entries[0].key), "x-dead-letter-exchange");
+  EXPECT_EQ(table.entries[0].value.kind, AMQP_FIELD_KIND_UTF8);
+  EXPECT_EQ(str(table.entries[0].value.value.bytes), "dead-letters-of-a-long-named-service");
+}
+
+TEST_F(StaticTableTest, CopyAndMove) {
+  StaticTable<2> t0;
+  t0.add("x-queue-type", "quorum").add("x-max-length", int64_t(10));
+
+  StaticTable<2> t1(t0);
+  const amqp_table_t table = t1;
+  EXPECT_EQ(table, static_cast<amqp_table_t>(t0));
+  EXPECT_NE(table.entries[0].key.bytes, static_cast<amqp_table_t>(t0).entries[0].key.bytes);
+
+  StaticTable<2> t2(move(t1));
+  t1.clear();
+  EXPECT_EQ(str(static_cast<amqp_table_t>(t2).entries[0].value.value.bytes), "quorum");
+
+  StaticTable<2> t3;
+  t3 = t2;
+  t2.clear();
+  t2.add("x-queue-type", "classic");
+  EXPECT_EQ(str(static_cast<amqp_table_t>(t3).entries[0].value.value.bytes), "quorum");
+  EXPECT_EQ(static_cast<amqp_table_t>(t3).entries[1].value.value.i64, 10);
+}
+
+TEST_F(StaticTableTest, Limits) {
+  StaticTable<1, 8> t;
+  EXPECT_THROW(t.add("too-long-key", 1), Exception);
+  EXPECT_THROW(t.add("key", "values"), Exception);
+  EXPECT_TRUE(t.empty());
+  EXPECT_EQ(t.used(), 0U);
+
+  TableEntry nested("nested", 1);
+  EXPECT_THROW(t.add("t", Table(nested)), Exception);
+
+  t.add("key", "val");
+  EXPECT_THROW(t.add("k", 1), Exception);
+
+  t.clear();
+  EXPECT_TRUE(t.empty());
+  EXPECT_EQ(t.used(), 0U);
+  t.add("k", 1);
+  EXPECT_EQ(t.size(), 1U);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,83 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/Subscriptions.hpp>
+
+#include "ChannelTest.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+struct SubscriptionsTest : public ChannelTest {};
+
+TEST_F(SubscriptionsTest, ResubscribesOnBrokerCancel) {
+  auto ch = createSimpleChannel();
+  Subscriptions subscriptions;
+  std::size_t calls = 0;
+  EXPECT_EQ(subscriptions.add(ch, [&calls] () { return "ctag" + std::to_string(++calls); }), "ctag1");
+  EXPECT_EQ(subscriptions.size(), 1);
+
+  EXPECT_FALSE(subscriptions(ConsumerCancel(channelId, "other", true)));
+  EXPECT_FALSE(subscriptions(ConsumerCancel(channelId + 1, "ctag1", true)));
+  EXPECT_EQ(calls, 1);
+
+  EXPECT_TRUE(subscriptions(ConsumerCancel(channelId, "ctag1", true)));
+  EXPECT_EQ(calls, 2);
+  EXPECT_TRUE(subscriptions(ConsumerCancel(channelId, "ctag2", true)));
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(subscriptions.size(), 1);
+}
+
+TEST_F(SubscriptionsTest, ClientCancelRemoves) {
+  auto ch = createSimpleChannel();
+  Subscriptions subscriptions;
+  subscriptions.add(ch, [] () { return std::string("ctag"); });
+  EXPECT_FALSE(subscriptions(ConsumerCancel(channelId, "ctag", false)));
+  EXPECT_EQ(subscriptions.size(), 0);
+
+  subscriptions.add(ch, [] () { return std::string("ctag"); });
+  EXPECT_TRUE(subscriptions.remove(ch, "ctag"));
+  EXPECT_FALSE(subscriptions.remove(ch, "ctag"));
+}
+
+TEST_F(SubscriptionsTest, FailedResubscribeDrops) {
+  auto ch = createSimpleChannel();
+  Subscriptions subscriptions;
+  std::size_t calls = 0;
+  subscriptions.add(ch, [&calls] () -> std::string {
+    if (++calls > 1)
+      throw std::runtime_error("queue not found");
+    return "ctag";
+  });
+  EXPECT_THROW(subscriptions(ConsumerCancel(channelId, "ctag", true)), std::runtime_error);
+  EXPECT_EQ(subscriptions.size(), 0);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -25,6 +25,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <memory_resource>
+
 #include <gtest/gtest.h>
 
 #include "comparison.hpp"
@@ -163,5 +165,37 @@ TEST_F(TableEntryTest, Conversions) {
   EXPECT_EQ(static_cast<amqp_table_entry_t>(TableEntry("key16", entries)), entry);
 }
 
+TEST_F(TableEntryTest, ReferencesCString) {
+  const char* value = "value";
+  const amqp_field_value_t& field = FieldValue(value);
+  EXPECT_EQ(field.value.bytes.bytes, value);
+  EXPECT_EQ(field.value.bytes.len, 5u);
+}
+
+TEST_F(TableEntryTest, MemoryResource) {
+  alignas(std::max_align_t) char arena[1024];
+  std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+  auto inArena = [&arena] (const void* p) {
+    return static_cast<const char*>(p) >= arena && static_cast<const char*>(p) < arena + sizeof(arena);
+  };
+
+  const string key(40, 'k'); // longer than the small string buffer
+  pmr::TableEntry e0(std::allocator_arg, &resource, key.c_str(), int32_t(1));
+  pmr::TableEntry e1(std::allocator_arg, &resource, key.c_str(), "value");
+  EXPECT_EQ(e0.get_allocator().resource(), &resource);
+  const auto converted = static_cast<amqp_table_entry_t>(e0);
+  EXPECT_TRUE(inArena(converted.key.bytes));
+  EXPECT_EQ(converted.key, bytes(key.c_str()));
+
+  pmr::Table table(std::allocator_arg, &resource, e0, e1);
+  const amqp_table_t& t = table;
+  EXPECT_EQ(t.num_entries, 2);
+  EXPECT_TRUE(inArena(t.entries));
+  EXPECT_EQ(t.entries[1].value.kind, AMQP_FIELD_KIND_UTF8);
+
+  const amqp_field_value_t& nested = FieldValue(table);
+  EXPECT_EQ(nested.value.table.entries, t.entries);
+}
+
 
 }} // namespace rmqcxx.unit_tests
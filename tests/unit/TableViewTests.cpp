@@ -0,0 +1,208 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/Envelope.hpp>
+#include <rmqcxx/TableView.hpp>
+
+#include "MockAMQP.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+::amqp_bytes_t text(const char* v) noexcept {
+  return ::amqp_bytes_t{::strlen(v), const_cast<char*>(v)};
+}
+
+::amqp_table_entry_t entry(const char* key, ::amqp_field_value_t value) noexcept {
+  return ::amqp_table_entry_t{text(key), value};
+}
+
+::amqp_field_value_t value(uint8_t kind) noexcept {
+  ::amqp_field_value_t v{};
+  v.kind = kind;
+  return v;
+}
+
+} // namespace
+
+TEST(TableViewTest, TypedAccess) {
+  auto i32 = value(AMQP_FIELD_KIND_I32);
+  i32.value.i32 = -7;
+  auto str = value(AMQP_FIELD_KIND_UTF8);
+  str.value.bytes = text("quorum");
+  auto flag = value(AMQP_FIELD_KIND_BOOLEAN);
+  flag.value.boolean = 1;
+  auto stamp = value(AMQP_FIELD_KIND_TIMESTAMP);
+  stamp.value.u64 = 1234567890;
+  ::amqp_table_entry_t entries[] = {entry("count", i32), entry("type", str), entry("redelivered", flag), entry("time", stamp)};
+  const TableView view(::amqp_table_t{4, entries});
+
+  EXPECT_EQ(view.size(), 4U);
+  EXPECT_EQ(view.find("count").as<int32_t>(), -7);
+  EXPECT_EQ(view["type"].as<string>(), "quorum");
+  EXPECT_TRUE(view.find("redelivered").as<bool>());
+  EXPECT_EQ(view.find("time").as<uint64_t>(), 1234567890U);
+
+  // strings are not copied
+  ::amqp_bytes_t bytes{};
+  ASSERT_TRUE(view.find("type").get(bytes));
+  EXPECT_EQ(bytes.bytes, entries[1].value.value.bytes.bytes);
+
+  // kind mismatch and missing keys
+  int64_t wide = 0;
+  EXPECT_FALSE(view.find("count").get(wide));
+  EXPECT_THROW(view.find("count").as<string>(), Exception);
+  EXPECT_FALSE(view.find("missing"));
+  EXPECT_FALSE(view.contains("missing"));
+  EXPECT_EQ(view.find("missing").kind(), 0);
+  EXPECT_THROW(view.find("missing").as<int32_t>(), Exception);
+  EXPECT_FALSE(view.find("coun"));
+  EXPECT_FALSE(view.indexed());
+
+  EXPECT_TRUE(TableView().empty());
+  EXPECT_FALSE(TableView().find("count"));
+}
+
+TEST(TableViewTest, Nested) {
+  auto count = value(AMQP_FIELD_KIND_I64);
+  count.value.i64 = 3;
+  auto queue = value(AMQP_FIELD_KIND_UTF8);
+  queue.value.bytes = text("orders");
+  ::amqp_table_entry_t death[] = {entry("count", count), entry("queue", queue)};
+  auto deathTable = value(AMQP_FIELD_KIND_TABLE);
+  deathTable.value.table = ::amqp_table_t{2, death};
+  ::amqp_field_value_t deaths[] = {deathTable};
+  auto array = value(AMQP_FIELD_KIND_ARRAY);
+  array.value.array = ::amqp_array_t{1, deaths};
+  ::amqp_table_entry_t headers[] = {entry("x-death", array)};
+  const TableView view(::amqp_table_t{1, headers});
+
+  const auto xDeath = view.find("x-death").as<ArrayView>();
+  ASSERT_EQ(xDeath.size(), 1U);
+  EXPECT_FALSE(xDeath[1]);
+  const auto first = xDeath[0].as<TableView>();
+  EXPECT_EQ(first.find("count").as<int64_t>(), 3);
+  ::amqp_bytes_t name{};
+  ASSERT_TRUE(first.find("queue").get(name));
+  EXPECT_EQ(name.bytes, queue.value.bytes.bytes);
+
+  TableView table;
+  EXPECT_FALSE(view.find("x-death").get(table));
+}
+
+TEST(TableViewTest, Index) {
+  const std::size_t threshold = TableView::kIndexThreshold;
+  vector<string> keys;
+  for (std::size_t i = 0; i < 4 * threshold; ++i)
+    keys.push_back("header-" + std::to_string(i));
+  keys.push_back("header-7"); // duplicate, the first occurrence wins
+  vector<::amqp_table_entry_t> entries;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    auto v = value(AMQP_FIELD_KIND_U32);
+    v.value.u32 = static_cast<uint32_t>(i);
+    entries.push_back(::amqp_table_entry_t{::amqp_bytes_t{keys[i].size(), const_cast<char*>(keys[i].data())}, v});
+  }
+  const TableView view(::amqp_table_t{static_cast<int>(entries.size()), entries.data()});
+
+  EXPECT_FALSE(view.indexed());
+  EXPECT_EQ(view.find("header-0").as<uint32_t>(), 0U);
+  EXPECT_TRUE(view.indexed());
+  for (std::size_t i = 0; i < 4 * threshold; ++i)
+    EXPECT_EQ(view.find(keys[i]).as<uint32_t>(), i);
+  EXPECT_EQ(view.find("header-7").as<uint32_t>(), 7U);
+  EXPECT_FALSE(view.find("header-"));
+  EXPECT_FALSE(view.contains(""));
+
+  std::size_t visited = 0;
+  for (const auto& x : view)
+    EXPECT_EQ(x.value.value.u32, visited++);
+  EXPECT_EQ(visited, keys.size());
+}
+
+TEST(TableViewTest, Headers) {
+  MockAMQP amqp;
+  auto str = value(AMQP_FIELD_KIND_UTF8);
+  str.value.bytes = text("v");
+  ::amqp_table_entry_t entries[] = {entry("k", str)};
+  ::amqp_envelope_t raw{};
+  raw.message.properties.headers = ::amqp_table_t{1, entries};
+
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(2);
+  {
+    Envelope envelope(raw);
+    EXPECT_TRUE(envelope.headers().empty()); // the headers flag is not set
+  }
+  raw.message.properties._flags = AMQP_BASIC_HEADERS_FLAG;
+  Envelope envelope(raw);
+  EXPECT_EQ(envelope.headers().find("k").as<string>(), "v");
+}
+
+TEST(TableViewTest, HeadersKeepTheIndex) {
+  MockAMQP amqp;
+  const std::size_t threshold = TableView::kIndexThreshold;
+  vector<string> keys;
+  for (std::size_t i = 0; i < 2 * threshold; ++i)
+    keys.push_back("header-" + std::to_string(i));
+  vector<::amqp_table_entry_t> entries;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    auto v = value(AMQP_FIELD_KIND_U32);
+    v.value.u32 = static_cast<uint32_t>(i);
+    entries.push_back(::amqp_table_entry_t{::amqp_bytes_t{keys[i].size(), const_cast<char*>(keys[i].data())}, v});
+  }
+
+  EXPECT_CALL(amqp, destroy_envelope(_))
+    .Times(1);
+  Envelope envelope;
+  EXPECT_TRUE(envelope.headers().empty());
+  ::amqp_envelope_t& raw = envelope; // the content is set after construction, like a consume does
+  raw.message.properties._flags = AMQP_BASIC_HEADERS_FLAG;
+  raw.message.properties.headers = ::amqp_table_t{static_cast<int>(entries.size()), entries.data()};
+
+  EXPECT_EQ(envelope.headers().find("header-3").as<uint32_t>(), 3U);
+  EXPECT_TRUE(envelope.headers().indexed());
+  EXPECT_EQ(&envelope.headers(), &envelope.headers());
+  EXPECT_EQ(envelope.headers().find("header-20").as<uint32_t>(), 20U);
+
+  const Envelope moved(std::move(envelope));
+  EXPECT_TRUE(moved.headers().indexed());
+  EXPECT_EQ(moved.headers().find("header-31").as<uint32_t>(), 31U);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,186 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/TimingWheel.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using std::chrono::milliseconds;
+using std::string;
+using std::vector;
+
+using Wheel = TimingWheel<string>;
+
+TEST(TimingWheelTest, ExpiresInOrder) {
+  const auto start = Wheel::Clock::now();
+  Wheel wheel(milliseconds(1), start);
+  wheel.schedule(milliseconds(5), "a", start);
+  wheel.schedule(milliseconds(1), "b", start);
+  wheel.schedule(milliseconds(100), "c", start);
+  wheel.schedule(milliseconds(5000), "d", start);
+  EXPECT_EQ(wheel.size(), 4);
+
+  vector<string> expired;
+  auto collect = [&expired] (string v) { expired.emplace_back(std::move(v)); };
+
+  EXPECT_EQ(wheel.advance(start + milliseconds(1), collect), 1);
+  EXPECT_EQ(expired, vector<string>({"b"}));
+
+  EXPECT_EQ(wheel.advance(start + milliseconds(4), collect), 0);
+  EXPECT_EQ(wheel.advance(start + milliseconds(5), collect), 1);
+  EXPECT_EQ(wheel.advance(start + milliseconds(99), collect), 0);
+  EXPECT_EQ(wheel.advance(start + milliseconds(100), collect), 1);
+  EXPECT_EQ(wheel.advance(start + milliseconds(4999), collect), 0);
+  EXPECT_EQ(wheel.advance(start + milliseconds(5000), collect), 1);
+  EXPECT_EQ(expired, vector<string>({"b", "a", "c", "d"}));
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, CascadesAcrossLevels) {
+  const auto start = Wheel::Clock::now();
+  TimingWheel<int> wheel(milliseconds(1), start);
+  std::map<int, int> deadlines;
+  for (int i = 1; i < 3000; ++i) {
+    const int delay = (i * 7919) % 300000 + 1;
+    deadlines[i] = delay;
+    wheel.schedule(milliseconds(delay), i, start);
+  }
+
+  int tick = 0;
+  std::size_t expired = 0;
+  for (tick = 1; tick <= 300001 && !wheel.empty(); tick += (tick % 3) + 1) {
+    expired += wheel.advance(start + milliseconds(tick), [&deadlines, &tick] (int v) {
+      EXPECT_LE(deadlines[v], tick);
+      EXPECT_GT(deadlines[v], tick - 3);
+    });
+  }
+  EXPECT_EQ(expired, 2999);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, RoundsUpToResolution) {
+  const auto start = Wheel::Clock::now();
+  Wheel wheel(milliseconds(10), start);
+  wheel.schedule(milliseconds(0), "zero", start);
+  wheel.schedule(milliseconds(11), "eleven", start);
+
+  vector<string> expired;
+  auto collect = [&expired] (string v) { expired.emplace_back(std::move(v)); };
+  EXPECT_EQ(wheel.advance(start + milliseconds(9), collect), 0);
+  EXPECT_EQ(wheel.advance(start + milliseconds(10), collect), 1);
+  EXPECT_EQ(wheel.advance(start + milliseconds(19), collect), 0);
+  EXPECT_EQ(wheel.advance(start + milliseconds(20), collect), 1);
+  EXPECT_EQ(expired, vector<string>({"zero", "eleven"}));
+}
+
+TEST(TimingWheelTest, RescheduleFromCallback) {
+  const auto start = Wheel::Clock::now();
+  TimingWheel<int> wheel(milliseconds(1), start);
+  wheel.schedule(milliseconds(1), 3, start);
+
+  vector<int> expired;
+  wheel.advance(start + milliseconds(10), [&wheel, &expired, start] (int v) {
+    expired.emplace_back(v);
+    if (v > 0)
+      wheel.schedule(milliseconds(1), v - 1, start + milliseconds(4 - v)); // the point in time the item expired at
+  });
+  EXPECT_EQ(expired, vector<int>({3, 2, 1, 0}));
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, NextExpiry) {
+  const auto start = Wheel::Clock::now();
+  Wheel wheel(milliseconds(1), start);
+  EXPECT_EQ(wheel.nextExpiry(), Wheel::Clock::time_point::max());
+
+  wheel.schedule(milliseconds(100), "a", start);
+  EXPECT_EQ(wheel.nextExpiry(), start + milliseconds(64)); // cascade of the second level
+  wheel.schedule(milliseconds(5), "b", start);
+  EXPECT_EQ(wheel.nextExpiry(), start + milliseconds(5));
+
+  EXPECT_EQ(wheel.advance(start + milliseconds(64), [] (string) {}), 1);
+  EXPECT_EQ(wheel.nextExpiry(), start + milliseconds(100));
+  EXPECT_EQ(wheel.advance(start + milliseconds(100), [] (string) {}), 1);
+  EXPECT_EQ(wheel.nextExpiry(), Wheel::Clock::time_point::max());
+}
+
+TEST(TimingWheelTest, Clear) {
+  const auto start = Wheel::Clock::now();
+  Wheel wheel(milliseconds(1), start);
+  wheel.schedule(milliseconds(1), "a", start);
+  wheel.schedule(milliseconds(100000), "b", start);
+  EXPECT_EQ(wheel.size(), 2);
+  wheel.clear();
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.advance(start + milliseconds(200000), [] (string) { ASSERT_TRUE(false); }), 0);
+}
+
+TEST(TimingWheelTest, DelayCountsFromNow) {
+  const auto start = Wheel::Clock::now();
+  Wheel wheel(milliseconds(1), start);
+  vector<string> expired;
+  auto collect = [&expired] (string v) { expired.emplace_back(std::move(v)); };
+  EXPECT_EQ(wheel.advance(start + milliseconds(10), collect), 0);
+
+  // scheduled long after the last advance, the delay still has to pass
+  wheel.schedule(milliseconds(20), "late", start + milliseconds(500));
+  EXPECT_EQ(wheel.advance(start + milliseconds(519), collect), 0);
+  EXPECT_EQ(wheel.advance(start + milliseconds(520), collect), 1);
+
+  // a point in time before the current tick expires on the next tick
+  wheel.schedule(milliseconds(0), "past", start);
+  EXPECT_EQ(wheel.advance(start + milliseconds(521), collect), 1);
+  EXPECT_EQ(expired, vector<string>({"late", "past"}));
+}
+
+TEST(TimingWheelTest, ThrowingCallbackKeepsRemainingItems) {
+  const auto start = Wheel::Clock::now();
+  Wheel wheel(milliseconds(1), start);
+  wheel.schedule(milliseconds(5), "a", start);
+  wheel.schedule(milliseconds(5), "b", start);
+  wheel.schedule(milliseconds(5), "c", start);
+
+  vector<string> expired;
+  EXPECT_THROW(wheel.advance(start + milliseconds(5), [&expired] (string v) {
+    expired.emplace_back(v);
+    if ("a" == v)
+      throw std::runtime_error("handler failed");
+  }), std::runtime_error);
+  EXPECT_EQ(wheel.size(), 2);
+  EXPECT_EQ(wheel.advance(start + milliseconds(6), [&expired] (string v) { expired.emplace_back(std::move(v)); }), 2);
+  EXPECT_EQ(expired, vector<string>({"a", "b", "c"}));
+  EXPECT_TRUE(wheel.empty());
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,189 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <openssl/ssl.h>
+
+#include <rmqcxx/Tls.hpp>
+
+#include "MockAMQP.hpp"
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::Return;
+using ::testing::StrEq;
+
+struct TlsTest : public ::testing::Test {
+  TlsTest() : connPtr(reinterpret_cast<amqp_connection_state_t>(7)), socketPtr(reinterpret_cast<amqp_socket_t*>(8)), ctx(::SSL_CTX_new(::TLS_client_method())),
+    options{"ca.pem", "client.pem", "client.key", true, true, AMQP_TLSv1_2, AMQP_TLSvLATEST, std::make_shared<TlsSessionCache>()} {}
+
+  ~TlsTest() noexcept {
+    ::SSL_CTX_free(ctx);
+  }
+
+  void prepareSocket() {
+    EXPECT_CALL(amqp, ssl_socket_new(connPtr))
+      .WillOnce(Return(socketPtr));
+    EXPECT_CALL(amqp, ssl_socket_set_cacert(socketPtr, StrEq("ca.pem")))
+      .WillOnce(Return(AMQP_STATUS_OK));
+    EXPECT_CALL(amqp, ssl_socket_set_key(socketPtr, StrEq("client.pem"), StrEq("client.key")))
+      .WillOnce(Return(AMQP_STATUS_OK));
+    EXPECT_CALL(amqp, ssl_socket_set_verify_peer(socketPtr, true));
+    EXPECT_CALL(amqp, ssl_socket_set_verify_hostname(socketPtr, true));
+    EXPECT_CALL(amqp, ssl_socket_set_ssl_versions(socketPtr, AMQP_TLSv1_2, AMQP_TLSvLATEST))
+      .WillOnce(Return(AMQP_STATUS_OK));
+  }
+
+  amqp_connection_state_t connPtr;
+  amqp_socket_t* socketPtr;
+  ::SSL_CTX* ctx;
+  TlsOptions options;
+  MockAMQP amqp;
+};
+
+TEST_F(TlsTest, SecureDefaults) {
+  TlsOptions defaults;
+  EXPECT_TRUE(defaults.caCertificate.empty());
+  EXPECT_TRUE(defaults.certificate.empty());
+  EXPECT_TRUE(defaults.verifyPeer);
+  EXPECT_TRUE(defaults.verifyHostname);
+  EXPECT_EQ(defaults.minVersion, AMQP_TLSv1_2);
+  EXPECT_EQ(defaults.maxVersion, AMQP_TLSvLATEST);
+  EXPECT_EQ(defaults.sessionCache, nullptr);
+
+  EXPECT_CALL(amqp, ssl_socket_new(connPtr))
+    .WillOnce(Return(socketPtr));
+  EXPECT_CALL(amqp, ssl_socket_set_verify_peer(socketPtr, true));
+  EXPECT_CALL(amqp, ssl_socket_set_verify_hostname(socketPtr, true));
+  EXPECT_CALL(amqp, ssl_socket_set_ssl_versions(socketPtr, AMQP_TLSv1_2, AMQP_TLSvLATEST))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_EQ(tlsSocketFactory(defaults, "broker", 5671)(connPtr), socketPtr);
+}
+
+TEST_F(TlsTest, SessionCache) {
+  TlsSessionCache cache;
+  EXPECT_EQ(cache.get("broker:5671"), nullptr);
+
+  auto first = ::SSL_SESSION_new();
+  cache.put("broker:5671", first);
+  EXPECT_EQ(cache.size(), 1);
+  auto session = cache.get("broker:5671");
+  EXPECT_EQ(session, first);
+  ::SSL_SESSION_free(session);
+
+  auto second = ::SSL_SESSION_new();
+  cache.put("broker:5671", second);
+  EXPECT_EQ(cache.size(), 1);
+  session = cache.get("broker:5671");
+  EXPECT_EQ(session, second);
+  ::SSL_SESSION_free(session);
+
+  cache.put("other:5671", ::SSL_SESSION_new());
+  EXPECT_EQ(cache.size(), 2);
+  cache.erase("broker:5671");
+  cache.erase("broker:5671");
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.get("broker:5671"), nullptr);
+}
+
+TEST_F(TlsTest, SocketFactory) {
+  prepareSocket();
+  EXPECT_CALL(amqp, ssl_socket_get_context(socketPtr))
+    .WillOnce(Return(ctx));
+
+  EXPECT_EQ(tlsSocketFactory(options, "broker", 5671)(connPtr), socketPtr);
+  EXPECT_NE(0, ::SSL_CTX_get_session_cache_mode(ctx) & SSL_SESS_CACHE_CLIENT);
+  EXPECT_NE(nullptr, ::SSL_CTX_sess_get_new_cb(ctx));
+  EXPECT_NE(nullptr, ::SSL_CTX_get_info_callback(ctx));
+}
+
+TEST_F(TlsTest, SocketFactoryWithoutResumption) {
+  options.caCertificate.clear();
+  options.certificate.clear();
+  options.verifyHostname = false;
+  options.sessionCache.reset();
+  EXPECT_CALL(amqp, ssl_socket_new(connPtr))
+    .WillOnce(Return(socketPtr));
+  EXPECT_CALL(amqp, ssl_socket_set_verify_peer(socketPtr, true));
+  EXPECT_CALL(amqp, ssl_socket_set_verify_hostname(socketPtr, false));
+  EXPECT_CALL(amqp, ssl_socket_set_ssl_versions(socketPtr, AMQP_TLSv1_2, AMQP_TLSvLATEST))
+    .WillOnce(Return(AMQP_STATUS_OK));
+
+  EXPECT_EQ(tlsSocketFactory(options, "broker", 5671)(connPtr), socketPtr);
+}
+
+TEST_F(TlsTest, SocketFactoryFailure) {
+  EXPECT_CALL(amqp, ssl_socket_new(connPtr))
+    .WillOnce(Return(nullptr))
+    .WillOnce(Return(socketPtr));
+  auto factory = tlsSocketFactory(options, "broker", 5671);
+  EXPECT_EQ(factory(connPtr), nullptr);
+
+  EXPECT_CALL(amqp, ssl_socket_set_cacert(socketPtr, StrEq("ca.pem")))
+    .WillOnce(Return(AMQP_STATUS_SSL_ERROR));
+  EXPECT_CALL(amqp, error_string2(AMQP_STATUS_SSL_ERROR))
+    .WillOnce(Return("SSL error"));
+  EXPECT_THROW(factory(connPtr), Exception);
+}
+
+TEST_F(TlsTest, Resumption) {
+  prepareSocket();
+  EXPECT_CALL(amqp, ssl_socket_get_context(socketPtr))
+    .WillOnce(Return(ctx));
+  tlsSocketFactory(options, "broker", 5671)(connPtr);
+
+  std::unique_ptr<::SSL, void(*)(::SSL*)> ssl(::SSL_new(ctx), ::SSL_free);
+  auto info = ::SSL_CTX_get_info_callback(ctx);
+
+  // nothing cached yet, a full handshake is done
+  info(ssl.get(), SSL_CB_HANDSHAKE_START, 1);
+  EXPECT_EQ(::SSL_get_session(ssl.get()), nullptr);
+
+  // sessions that can't be resumed are not kept
+  auto session = ::SSL_SESSION_new();
+  EXPECT_EQ(::SSL_CTX_sess_get_new_cb(ctx)(ssl.get(), session), 0);
+  ::SSL_SESSION_free(session);
+  EXPECT_EQ(options.sessionCache->size(), 0);
+
+  // the cached session of the peer is offered in the next handshake
+  session = ::SSL_SESSION_new();
+  options.sessionCache->put("broker:5671", session);
+  info(ssl.get(), SSL_CB_HANDSHAKE_START, 1);
+  EXPECT_EQ(::SSL_get_session(ssl.get()), session);
+
+  // other peers don't share sessions
+  options.sessionCache->erase("broker:5671");
+  options.sessionCache->put("other:5671", ::SSL_SESSION_new());
+  std::unique_ptr<::SSL, void(*)(::SSL*)> other(::SSL_new(ctx), ::SSL_free);
+  info(other.get(), SSL_CB_HANDSHAKE_START, 1);
+  EXPECT_EQ(::SSL_get_session(other.get()), nullptr);
+}
+
+}} // namespace rmqcxx.unit_tests
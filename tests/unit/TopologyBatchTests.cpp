@@ -0,0 +1,157 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ChannelTest.hpp"
+#include <rmqcxx/TableEntry.hpp>
+#include <rmqcxx/Topology.hpp>
+#include <rmqcxx/TopologyBatch.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::Invoke;
+using ::testing::Return;
+
+using std::string;
+using std::vector;
+
+struct TopologyBatchTest : public ChannelTest {
+  TopologyBatchTest() : ChannelTest(), barrier("amq.direct") {}
+
+  void expectSends(vector<string>& log) {
+    EXPECT_CALL(amqp, get_sockfd(connPtr))
+      .WillRepeatedly(Return(-1));
+    EXPECT_CALL(amqp, send_method(connPtr, channelId, _, _))
+      .WillRepeatedly(Invoke([&log] (amqp_connection_state_t, amqp_channel_t, amqp_method_number_t id, void* decoded) {
+        switch (id) {
+          case AMQP_EXCHANGE_DECLARE_METHOD: {
+            auto m = static_cast<amqp_exchange_declare_t*>(decoded);
+            EXPECT_TRUE(m->nowait);
+            log.push_back("exchange " + container<string>(m->exchange) + ' ' + container<string>(m->type));
+            break;
+          }
+          case AMQP_QUEUE_DECLARE_METHOD: {
+            auto m = static_cast<amqp_queue_declare_t*>(decoded);
+            EXPECT_TRUE(m->nowait);
+            log.push_back("queue " + container<string>(m->queue));
+            break;
+          }
+          case AMQP_QUEUE_BIND_METHOD: {
+            auto m = static_cast<amqp_queue_bind_t*>(decoded);
+            EXPECT_TRUE(m->nowait);
+            log.push_back("bind " + container<string>(m->queue) + ' ' + container<string>(m->exchange) + ' ' + container<string>(m->routing_key));
+            break;
+          }
+          case AMQP_EXCHANGE_BIND_METHOD: {
+            auto m = static_cast<amqp_exchange_bind_t*>(decoded);
+            EXPECT_TRUE(m->nowait);
+            log.push_back("bind exchange " + container<string>(m->destination) + ' ' + container<string>(m->source) + ' ' + container<string>(m->routing_key));
+            break;
+          }
+        }
+        return AMQP_STATUS_OK;
+      }));
+  }
+
+  string barrier;
+};
+
+TEST_F(TopologyBatchTest, Flush) {
+  Topology topology;
+  auto ch = createSimpleChannel();
+  pConn->record(&topology);
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+
+  vector<string> log;
+  expectSends(log);
+  amqp_exchange_declare_ok_t ok{};
+  EXPECT_CALL(amqp, exchange_declare(connPtr, channelId, amqp_bytes_t{barrier.size(), &barrier[0]}, _, 1, 0, 0, 0, amqp_table_t{0, nullptr}))
+    .WillOnce(Return(&ok));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "exchange_declare"))
+    .WillOnce(Return(normalReply));
+
+  TopologyBatch batch(ch);
+  batch.exchange("ex", "topic", true, false)
+    .queue("q", true, false, false, TableEntry("x-queue-type", "quorum"))
+    .bind("q", "ex", "a.#")
+    .bindExchange("ex2", "ex", "#");
+  EXPECT_EQ(batch.size(), 4);
+  batch.flush();
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(log, vector<string>({ "exchange ex topic", "queue q", "bind q ex a.#", "bind exchange ex2 ex #" }));
+  EXPECT_EQ(topology.bindings(), 2);
+
+  batch.flush(); // nothing to do
+}
+
+TEST_F(TopologyBatchTest, Rejected) {
+  auto ch = createSimpleChannel();
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId));
+
+  vector<string> log;
+  expectSends(log);
+  string text("NOT_FOUND - no exchange 'missing' in vhost '/'");
+  amqp_channel_close_t close{404, amqp_bytes_t{text.size(), &text[0]}, 50, 20};
+  amqp_rpc_reply_t reply{ .reply_type = AMQP_RESPONSE_SERVER_EXCEPTION, .reply = { .id = AMQP_CHANNEL_CLOSE_METHOD, .decoded = &close } };
+  EXPECT_CALL(amqp, exchange_declare(connPtr, channelId, _, _, 1, 0, 0, 0, _))
+    .WillOnce(Return(nullptr));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "exchange_declare"))
+    .WillOnce(Return(reply));
+
+  TopologyBatch batch(ch);
+  batch.queue("q", false, false, false)
+    .bind("q", "ex", "a")
+    .bind("q", "missing", "b")
+    .bind("q", "ex", "c");
+  try {
+    batch.flush();
+    FAIL() << "Expected DeclarationException";
+  } catch(const DeclarationException& e) {
+    EXPECT_EQ(e.index, 2);
+    EXPECT_EQ(e.declaration, "queue.bind(q, missing, b)");
+    EXPECT_EQ(e.replyCode, 404);
+    EXPECT_EQ(e.method, AMQP_QUEUE_BIND_METHOD);
+    EXPECT_EQ(e.replyText, text);
+  }
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(log.size(), 4);
+}
+
+TEST_F(TopologyBatchTest, ServerNamedQueue) {
+  auto ch = createSimpleChannel();
+  TopologyBatch batch(ch);
+  EXPECT_THROW(batch.queue("", false, true, true), ChannelException);
+  EXPECT_TRUE(batch.empty());
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,334 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ChannelTest.hpp"
+#include <rmqcxx/Exchange.hpp>
+#include <rmqcxx/Queue.hpp>
+#include <rmqcxx/TableEntry.hpp>
+#include <rmqcxx/Topology.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::Invoke;
+using ::testing::Return;
+
+using std::string;
+using std::vector;
+
+struct TopologyTest : public ChannelTest {
+  static string str(amqp_bytes_t v) {
+    return string(static_cast<const char*>(v.bytes), v.len);
+  }
+};
+
+TEST_F(TopologyTest, OwnedTable) {
+  OwnedTable copy;
+  {
+    string key("x-key"), value("value"), nestedKey("nested");
+    int32_t number = 5;
+    vector<amqp_field_value_t> array{ FieldValue(value), FieldValue(number) };
+    TableEntry nested(nestedKey, FieldValue(value));
+    Table inner(nested);
+    TableEntry e0(key, FieldValue(value)), e1(nestedKey, FieldValue(inner)), e2(string("array"), FieldValue(array));
+    Table table(e0, e1, e2);
+    copy = OwnedTable(table);
+    std::memset(&key[0], 0, key.size());
+    std::memset(&value[0], 0, value.size());
+  }
+  OwnedTable moved(std::move(copy));
+  const ::amqp_table_t t = moved;
+  ASSERT_EQ(t.num_entries, 3);
+  EXPECT_EQ(str(t.entries[0].key), "x-key");
+  EXPECT_EQ(str(t.entries[0].value.value.bytes), "value");
+  ASSERT_EQ(t.entries[1].value.kind, AMQP_FIELD_KIND_TABLE);
+  EXPECT_EQ(str(t.entries[1].value.value.table.entries[0].value.value.bytes), "value");
+  ASSERT_EQ(t.entries[2].value.value.array.num_entries, 2);
+  EXPECT_EQ(str(t.entries[2].value.value.array.entries[0].value.bytes), "value");
+  EXPECT_EQ(t.entries[2].value.value.array.entries[1].value.i32, 5);
+}
+
+TEST_F(TopologyTest, Records) {
+  channelId = 9;
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(AnyNumber());
+  EXPECT_CALL(amqp, maybe_release_buffers_on_channel(connPtr, channelId))
+    .Times(AnyNumber());
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, _))
+    .WillRepeatedly(Return(normalReply));
+  amqp_channel_open_ok_t openOk{};
+  EXPECT_CALL(amqp, channel_open(connPtr, channelId))
+    .WillOnce(Return(&openOk));
+  EXPECT_CALL(amqp, channel_close(connPtr, channelId, AMQP_REPLY_SUCCESS));
+
+  Topology topology;
+  pConn = new Connection(createSimpleConnection());
+  pConn->record(&topology);
+  EXPECT_EQ(pConn->topology(), &topology);
+  EXPECT_TRUE(topology.empty());
+  Channel ch(*pConn, channelId);
+
+  amqp_exchange_declare_ok_t exchangeOk{};
+  EXPECT_CALL(amqp, exchange_declare(connPtr, channelId, _, _, _, _, _, _, _))
+    .WillRepeatedly(Return(&exchangeOk));
+  amqp_exchange_bind_ok_t exchangeBindOk{};
+  EXPECT_CALL(amqp, exchange_bind(connPtr, channelId, _, _, _, _))
+    .WillOnce(Return(&exchangeBindOk));
+  string generated("amq.gen-1");
+  amqp_queue_declare_ok_t queueOk{ .queue = amqp_bytes_t{generated.size(), &generated[0]} };
+  EXPECT_CALL(amqp, queue_declare(connPtr, channelId, _, _, _, _, _, _))
+    .WillRepeatedly(Return(&queueOk));
+  amqp_queue_bind_ok_t queueBindOk{};
+  EXPECT_CALL(amqp, queue_bind(connPtr, channelId, _, _, _, _))
+    .WillRepeatedly(Return(&queueBindOk));
+  amqp_queue_unbind_ok_t queueUnbindOk{};
+  EXPECT_CALL(amqp, queue_unbind(connPtr, channelId, _, _, _, _))
+    .WillOnce(Return(&queueUnbindOk));
+  string tag("ctag");
+  amqp_basic_consume_ok_t consumeOk{ .consumer_tag = amqp_bytes_t{tag.size(), &tag[0]} };
+  EXPECT_CALL(amqp, basic_consume(connPtr, channelId, _, _, _, _, _, _))
+    .WillRepeatedly(Return(&consumeOk));
+  amqp_basic_cancel_ok_t cancelOk{};
+  EXPECT_CALL(amqp, basic_cancel(connPtr, channelId, _))
+    .WillOnce(Return(&cancelOk));
+  amqp_queue_delete_ok_t deleteOk{};
+  EXPECT_CALL(amqp, queue_delete(connPtr, channelId, _, _, _))
+    .WillOnce(Return(&deleteOk));
+  EXPECT_CALL(amqp, basic_qos(connPtr, channelId, 0, 10, false));
+
+  ch.qos(10);
+  Exchange ex(ch, "ex");
+  ex.declare("topic", false, true, false);
+  ex.declare("topic", true, false, false); // passive declarations are not recorded
+  ex.bind("upstream", "#");
+
+  Queue named(ch, "q");
+  named.declare(false, true, false, false);
+  named.bind("ex", "a");
+  named.bind("ex", "b");
+  named.unbind("ex", "b");
+  EXPECT_EQ(named.consume("", false, false, false), "ctag");
+
+  Queue unnamed(ch, "");
+  unnamed.declare(false, false, true, true);
+  unnamed.bind("ex", "c");
+  EXPECT_EQ(topology.resolve(channelId, ""), "amq.gen-1");
+  EXPECT_EQ(topology.resolve(channelId, "q"), "q");
+
+  EXPECT_EQ(topology.bindings(), 3);
+  EXPECT_EQ(topology.consumers(), 1);
+
+  ch.cancel("ctag");
+  EXPECT_EQ(topology.consumers(), 0);
+  named.remove(false, false);
+  EXPECT_EQ(topology.bindings(), 2);
+
+  EXPECT_FALSE(topology.empty());
+  topology.clear();
+  EXPECT_TRUE(topology.empty());
+}
+
+TEST_F(TopologyTest, AutoDeleteQueueGoesWithItsLastConsumer) {
+  Topology topology;
+  topology.channelOpened(1);
+  topology.channelOpened(2);
+  topology.queueDeclared(1, "q", false, false, false, true, amqp_table_t{0, nullptr});
+  topology.bound(false, "q", "ex", "rk", amqp_table_t{0, nullptr});
+  topology.consumed(1, "q", "c1", false, false, false, amqp_table_t{0, nullptr});
+  topology.consumed(2, "q", "c2", false, false, false, amqp_table_t{0, nullptr});
+
+  topology.cancelled(1, "c1");
+  EXPECT_EQ(topology.bindings(), 1);
+  topology.channelClosed(2);
+  EXPECT_EQ(topology.consumers(), 0);
+  EXPECT_EQ(topology.bindings(), 0);
+}
+
+TEST_F(TopologyTest, Replay) {
+  auto conn = createSimpleConnection();
+  Topology topology;
+  topology.channelOpened(3);
+  topology.qos(3, 0, 10, false);
+  topology.channelOpened(5);
+  topology.exchangeDeclared("ex", "topic", true, false, amqp_table_t{0, nullptr});
+  topology.queueDeclared(3, "q", false, true, false, false, amqp_table_t{0, nullptr});
+  topology.queueDeclared(3, "amq.gen-1", true, false, true, true, amqp_table_t{0, nullptr});
+  topology.bound(true, "ex2", "ex", "#", amqp_table_t{0, nullptr});
+  topology.bound(false, "q", "ex", "a", amqp_table_t{0, nullptr});
+  topology.bound(false, "amq.gen-1", "ex", "b", amqp_table_t{0, nullptr});
+  topology.consumed(5, "q", "ctag", false, false, false, amqp_table_t{0, nullptr});
+  topology.consumed(3, "amq.gen-1", "c2", false, true, true, amqp_table_t{0, nullptr});
+
+  vector<string> log;
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(AnyNumber());
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_open"))
+    .WillRepeatedly(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_qos"))
+    .WillRepeatedly(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "queue_declare"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillRepeatedly(Return(-1));
+  amqp_channel_open_ok_t openOk{};
+  EXPECT_CALL(amqp, channel_open(connPtr, _))
+    .WillRepeatedly(Invoke([&] (amqp_connection_state_t, amqp_channel_t channel) { log.push_back(std::to_string(channel) + " open"); return &openOk; }));
+  EXPECT_CALL(amqp, basic_qos(connPtr, _, _, _, _))
+    .WillRepeatedly(Invoke([&] (amqp_connection_state_t, amqp_channel_t channel, uint32_t, uint16_t count, amqp_boolean_t) { log.push_back(std::to_string(channel) + " qos " + std::to_string(count)); }));
+  string generated("amq.gen-2");
+  amqp_queue_declare_ok_t queueOk{ .queue = amqp_bytes_t{generated.size(), &generated[0]} };
+  EXPECT_CALL(amqp, queue_declare(connPtr, 3, amqp_bytes_t{0, nullptr}, 0, 0, 1, 1, amqp_table_t{0, nullptr}))
+    .WillOnce(Invoke([&] (amqp_connection_state_t, amqp_channel_t, amqp_bytes_t, amqp_boolean_t, amqp_boolean_t, amqp_boolean_t, amqp_boolean_t, amqp_table_t) { log.push_back("3 declare server named"); return &queueOk; }));
+  EXPECT_CALL(amqp, send_method(connPtr, _, _, _))
+    .WillRepeatedly(Invoke([&] (amqp_connection_state_t, amqp_channel_t channel, amqp_method_number_t id, void* decoded) {
+      auto prefix = std::to_string(channel) + ' ';
+      switch (id) {
+        case AMQP_EXCHANGE_DECLARE_METHOD: {
+          auto m = static_cast<amqp_exchange_declare_t*>(decoded);
+          EXPECT_TRUE(m->nowait);
+          log.push_back(prefix + "exchange " + str(m->exchange) + ' ' + str(m->type));
+          break;
+        }
+        case AMQP_QUEUE_DECLARE_METHOD: {
+          auto m = static_cast<amqp_queue_declare_t*>(decoded);
+          EXPECT_TRUE(m->nowait);
+          log.push_back(prefix + "queue " + str(m->queue));
+          break;
+        }
+        case AMQP_EXCHANGE_BIND_METHOD: {
+          auto m = static_cast<amqp_exchange_bind_t*>(decoded);
+          EXPECT_TRUE(m->nowait);
+          log.push_back(prefix + "exchange bind " + str(m->destination) + ' ' + str(m->source) + ' ' + str(m->routing_key));
+          break;
+        }
+        case AMQP_QUEUE_BIND_METHOD: {
+          auto m = static_cast<amqp_queue_bind_t*>(decoded);
+          EXPECT_TRUE(m->nowait);
+          log.push_back(prefix + "queue bind " + str(m->queue) + ' ' + str(m->exchange) + ' ' + str(m->routing_key));
+          break;
+        }
+        case AMQP_BASIC_CONSUME_METHOD: {
+          auto m = static_cast<amqp_basic_consume_t*>(decoded);
+          EXPECT_TRUE(m->nowait);
+          log.push_back(prefix + "consume " + str(m->queue) + ' ' + str(m->consumer_tag));
+          break;
+        }
+        default:
+          ADD_FAILURE() << "Unexpected method " << id;
+      }
+      return AMQP_STATUS_OK;
+    }));
+
+  topology.replay(conn);
+
+  EXPECT_EQ(log, vector<string>({
+    "3 open", "3 qos 10", "5 open",
+    "3 declare server named",
+    "3 exchange ex topic",
+    "3 queue q",
+    "3 exchange bind ex2 ex #",
+    "3 queue bind amq.gen-2 ex b",
+    "3 queue bind q ex a",
+    "3 qos 10",
+    "3 consume amq.gen-2 c2",
+    "5 consume q ctag",
+    "5 qos 0"
+  }));
+  EXPECT_EQ(topology.name("amq.gen-1"), "amq.gen-2");
+  EXPECT_EQ(topology.name("q"), "q");
+}
+
+TEST_F(TopologyTest, ReplayRenamesLastDeclaredQueue) {
+  auto conn = createSimpleConnection();
+  Topology topology;
+  topology.channelOpened(3);
+  topology.queueDeclared(3, "amq.gen-1", true, false, true, true, amqp_table_t{0, nullptr});
+  EXPECT_EQ(topology.resolve(3, ""), "amq.gen-1");
+
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(AnyNumber());
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_open"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "queue_declare"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_qos"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillRepeatedly(Return(-1));
+  EXPECT_CALL(amqp, basic_qos(connPtr, 3, 0, 0, false));
+  amqp_channel_open_ok_t openOk{};
+  EXPECT_CALL(amqp, channel_open(connPtr, 3))
+    .WillOnce(Return(&openOk));
+  string generated("amq.gen-2");
+  amqp_queue_declare_ok_t queueOk{ .queue = amqp_bytes_t{generated.size(), &generated[0]} };
+  EXPECT_CALL(amqp, queue_declare(connPtr, 3, amqp_bytes_t{0, nullptr}, 0, 0, 1, 1, amqp_table_t{0, nullptr}))
+    .WillOnce(Return(&queueOk));
+  topology.replay(conn);
+
+  // an empty queue name keeps referring to the queue declared last on the channel
+  EXPECT_EQ(topology.resolve(3, ""), "amq.gen-2");
+  EXPECT_EQ(topology.resolve(3, "q"), "q");
+  EXPECT_EQ(topology.resolve(5, ""), "");
+}
+
+TEST_F(TopologyTest, ReplayWithoutChannels) {
+  auto conn = createSimpleConnection();
+  Topology topology;
+  topology.replay(conn);
+
+  topology.exchangeDeclared("ex", "fanout", true, false, amqp_table_t{0, nullptr});
+  EXPECT_CALL(amqp, maybe_release_buffers(connPtr))
+    .Times(AnyNumber());
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_open"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "basic_qos"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_rpc_reply(connPtr, "channel_close"))
+    .WillOnce(Return(normalReply));
+  EXPECT_CALL(amqp, get_sockfd(connPtr))
+    .WillOnce(Return(-1));
+  EXPECT_CALL(amqp, get_channel_max(connPtr))
+    .WillOnce(Return(2047));
+  amqp_channel_open_ok_t openOk{};
+  EXPECT_CALL(amqp, channel_open(connPtr, 2047))
+    .WillOnce(Return(&openOk));
+  EXPECT_CALL(amqp, send_method(connPtr, 2047, AMQP_EXCHANGE_DECLARE_METHOD, _))
+    .WillOnce(Return(AMQP_STATUS_OK));
+  EXPECT_CALL(amqp, basic_qos(connPtr, 2047, 0, 0, false));
+  EXPECT_CALL(amqp, channel_close(connPtr, 2047, AMQP_REPLY_SUCCESS))
+    .WillOnce(Return(normalReply));
+  topology.replay(conn);
+}
+
+}} // namespace rmqcxx.unit_tests
@@ -0,0 +1,121 @@
+/*
+Project: rabbitmq-cxx <https://github.com/djsavic1988/rabbitmq-cxx>
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+
+Copyright (c) 2021 Djordje Savic <djordje.savic.1988@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rmqcxx/Wire.hpp>
+
+namespace rmqcxx { namespace unit_tests {
+
+static std::vector<uint8_t> bytes(const WireWriter& writer) {
+  return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+}
+
+TEST(WireTest, Integers) {
+  WireWriter writer;
+  writer.u8(0x01);
+  writer.u16(0x0203);
+  writer.u32(0x04050607);
+  writer.u64(0x08090a0b0c0d0e0fULL);
+  EXPECT_EQ(bytes(writer), (std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}));
+
+  WireReader reader(writer.data(), writer.size());
+  EXPECT_EQ(reader.u8(), 0x01);
+  EXPECT_EQ(reader.u16(), 0x0203);
+  EXPECT_EQ(reader.u32(), 0x04050607U);
+  EXPECT_EQ(reader.u64(), 0x08090a0b0c0d0e0fULL);
+  EXPECT_EQ(reader.remaining(), 0);
+  EXPECT_THROW(reader.u8(), Exception);
+
+  writer.clear();
+  EXPECT_TRUE(writer.empty());
+}
+
+TEST(WireTest, Strings) {
+  WireWriter writer;
+  writer.shortString("ab", 2);
+  writer.longString("cde", 3);
+  EXPECT_EQ(bytes(writer), (std::vector<uint8_t>{2, 'a', 'b', 0, 0, 0, 3, 'c', 'd', 'e'}));
+  EXPECT_THROW(writer.shortString(std::string(256, 'x').data(), 256), Exception);
+
+  WireReader reader(writer.data(), writer.size());
+  EXPECT_EQ(reader.shortString(), "ab");
+  EXPECT_EQ(reader.longString(), "cde");
+}
+
+TEST(WireTest, Table) {
+  amqp_field_value_t inner { .kind = AMQP_FIELD_KIND_I16, .value = { .i16 = -2 } };
+  amqp_table_entry_t entries[] = {
+    { .key = amqp_bytes_t{1, const_cast<char*>("a")}, .value = { .kind = AMQP_FIELD_KIND_BOOLEAN, .value = { .boolean = 1 } } },
+    { .key = amqp_bytes_t{1, const_cast<char*>("b")}, .value = { .kind = AMQP_FIELD_KIND_UTF8, .value = { .bytes = amqp_bytes_t{2, const_cast<char*>("xy")} } } },
+    { .key = amqp_bytes_t{1, const_cast<char*>("c")}, .value = { .kind = AMQP_FIELD_KIND_ARRAY, .value = { .array = amqp_array_t{1, &inner} } } },
+    { .key = amqp_bytes_t{1, const_cast<char*>("d")}, .value = { .kind = AMQP_FIELD_KIND_VOID, .value = { .u64 = 0 } } },
+  };
+  WireWriter writer;
+  writer.table(amqp_table_t{4, entries});
+  EXPECT_EQ(bytes(writer), (std::vector<uint8_t>{
+    0, 0, 0, 26,
+    1, 'a', 't', 1,
+    1, 'b', 'S', 0, 0, 0, 2, 'x', 'y',
+    1, 'c', 'A', 0, 0, 0, 3, 's', 0xff, 0xfe,
+    1, 'd', 'V'}));
+
+  WireReader reader(writer.data(), writer.size());
+  reader.skipTable();
+  EXPECT_EQ(reader.remaining(), 0);
+
+  amqp_table_entry_t unknown { .key = amqp_bytes_t{1, const_cast<char*>("e")}, .value = { .kind = '?', .value = { .u64 = 0 } } };
+  EXPECT_THROW(writer.table(amqp_table_t{1, &unknown}), Exception);
+}
+
+TEST(WireTest, Frame) {
+  WireWriter writer;
+  auto start = writer.beginMethod(3, AMQP_CONNECTION_TUNE_OK_METHOD);
+  writer.u16(1);
+  writer.endFrame(start);
+  EXPECT_EQ(bytes(writer), (std::vector<uint8_t>{AMQP_FRAME_METHOD, 0, 3, 0, 0, 0, 6, 0, 10, 0, 31, 0, 1, AMQP_FRAME_END}));
+
+  WireFrame frame;
+  EXPECT_EQ(WireReader::frame(writer.data(), writer.size() - 1, 100, frame), 0);
+  ASSERT_EQ(WireReader::frame(writer.data(), writer.size(), 100, frame), writer.size());
+  EXPECT_EQ(frame.type, AMQP_FRAME_METHOD);
+  EXPECT_EQ(frame.channel, 3);
+  EXPECT_EQ(frame.size, 6);
+  WireReader reader(frame);
+  EXPECT_EQ(reader.u32(), AMQP_CONNECTION_TUNE_OK_METHOD);
+  EXPECT_EQ(reader.u16(), 1);
+
+  EXPECT_THROW(WireReader::frame(writer.data(), writer.size(), 5, frame), Exception);
+  std::vector<uint8_t> broken(writer.data(), writer.data() + writer.size());
+  broken.back() = 0;
+  EXPECT_THROW(WireReader::frame(broken.data(), broken.size(), 100, frame), Exception);
+}
+
+}} // namespace rmqcxx.unit_tests